@@ -0,0 +1,788 @@
+#include "art.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+// Provide external definitions of inline functions.
+extern inline size_t art_size(const art_t* tree);
+extern inline size_t art_memory_usage(const art_t* tree);
+extern inline bool art_iterator_has_current(const art_iterator_t* iter);
+extern inline void art_iterator_get_current(
+  const art_iterator_t* iter, const char** key, generic_value_t* value);
+
+
+static const size_t ART_NODE_SIZES[] = {
+  0, sizeof(art_node4_t), sizeof(art_node16_t), sizeof(art_node48_t),
+  sizeof(art_node256_t)
+};
+
+static const size_t ART_NODE_CAPACITIES[] = {0, 4, 16, 48, 256};
+
+
+static void* art_alloc(art_t* tree, size_t size) {
+  void* memory = calloc(1, size);
+  if (memory) {
+    tree->memory += size;
+  }
+  return memory;
+}
+
+
+static void art_free(art_t* tree, void* memory, size_t size) {
+  free(memory);
+  tree->memory -= size;
+}
+
+
+static art_leaf_t* art_leaf_create(art_t* tree, const unsigned char* suffix,
+				   size_t length, generic_value_t value) {
+  art_leaf_t* leaf = art_alloc(tree, sizeof(art_leaf_t) + length);
+  if (!leaf) {
+    return 0;
+  }
+  leaf->node.type = ART_LEAF;
+  leaf->suffix_length = length;
+  leaf->value = value;
+  memcpy(leaf->suffix, suffix, length);
+  return leaf;
+}
+
+
+static void art_leaf_delete(art_t* tree, art_leaf_t* leaf) {
+  art_free(tree, leaf, sizeof(art_leaf_t) + leaf->suffix_length);
+}
+
+
+static art_inner_t* art_inner_create(art_t* tree, art_node_type_t type) {
+  art_inner_t* inner = art_alloc(tree, ART_NODE_SIZES[type]);
+  if (inner) {
+    inner->node.type = type;
+  }
+  return inner;
+}
+
+
+static unsigned char* art_prefix(art_inner_t* inner) {
+  return inner->prefix_length > ART_INLINE_PREFIX ?
+    inner->prefix : inner->inline_prefix;
+}
+
+
+// Replaces the prefix of a node. The new prefix may point into the old
+// one; shortening a prefix that way never fails.
+static error_t art_set_prefix(art_t* tree, art_inner_t* inner,
+			      const unsigned char* prefix, size_t length) {
+  size_t old_length = inner->prefix_length;
+  unsigned char* old = old_length > ART_INLINE_PREFIX ? inner->prefix : 0;
+  if (old && length > ART_INLINE_PREFIX && length <= old_length) {
+    memmove(old, prefix, length);
+    unsigned char* shrunk = realloc(old, length);
+    inner->prefix = shrunk ? shrunk : old;
+    inner->prefix_length = length;
+    tree->memory -= old_length - length;
+    return 0;
+  }
+  if (length > ART_INLINE_PREFIX) {
+    unsigned char* copy = art_alloc(tree, length);
+    if (!copy) {
+      return ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(copy, prefix, length);
+    inner->prefix = copy;
+  } else {
+    memmove(inner->inline_prefix, prefix, length);
+  }
+  inner->prefix_length = length;
+  if (old) {
+    art_free(tree, old, old_length);
+  }
+  return 0;
+}
+
+
+// Deletes an inner node without its children.
+static void art_inner_delete(art_t* tree, art_inner_t* inner) {
+  if (inner->prefix_length > ART_INLINE_PREFIX) {
+    art_free(tree, inner->prefix, inner->prefix_length);
+  }
+  art_free(tree, inner, ART_NODE_SIZES[inner->node.type]);
+}
+
+
+// Returns the child slot for a byte, or 0 if there is none.
+static art_node_t** art_find_child(art_inner_t* inner, unsigned char byte) {
+  switch (inner->node.type) {
+  case ART_NODE4: {
+    art_node4_t* node = (art_node4_t*)inner;
+    for (size_t i = 0; i < inner->count; i++) {
+      if (node->keys[i] == byte) {
+	return &node->children[i];
+      }
+    }
+    return 0;
+  }
+  case ART_NODE16: {
+    art_node16_t* node = (art_node16_t*)inner;
+#ifdef __SSE2__
+    // Compare all 16 keys at once.
+    __m128i matches = _mm_cmpeq_epi8(
+      _mm_set1_epi8((char)byte), _mm_loadu_si128((__m128i*)node->keys));
+    unsigned mask =
+      (unsigned)_mm_movemask_epi8(matches) & ((1u << inner->count) - 1);
+    return mask ? &node->children[__builtin_ctz(mask)] : 0;
+#else
+    for (size_t i = 0; i < inner->count; i++) {
+      if (node->keys[i] == byte) {
+	return &node->children[i];
+      }
+    }
+    return 0;
+#endif
+  }
+  case ART_NODE48: {
+    art_node48_t* node = (art_node48_t*)inner;
+    uint8_t index = node->child_index[byte];
+    return index ? &node->children[index - 1] : 0;
+  }
+  default: {
+    art_node256_t* node = (art_node256_t*)inner;
+    return node->children[byte] ? &node->children[byte] : 0;
+  }
+  }
+}
+
+
+// Returns the next child in byte order, or 0 after the last one. position
+// starts at 0 and is advanced by each call.
+static art_node_t* art_next_child(art_inner_t* inner, unsigned* position,
+				  unsigned char* byte) {
+  switch (inner->node.type) {
+  case ART_NODE4:
+  case ART_NODE16: {
+    if (*position >= inner->count) {
+      return 0;
+    }
+    unsigned char* keys = inner->node.type == ART_NODE4 ?
+      ((art_node4_t*)inner)->keys : ((art_node16_t*)inner)->keys;
+    art_node_t** children = inner->node.type == ART_NODE4 ?
+      ((art_node4_t*)inner)->children : ((art_node16_t*)inner)->children;
+    *byte = keys[*position];
+    return children[(*position)++];
+  }
+  case ART_NODE48: {
+    art_node48_t* node = (art_node48_t*)inner;
+    for (; *position < 256; (*position)++) {
+      uint8_t index = node->child_index[*position];
+      if (index) {
+	*byte = (unsigned char)(*position)++;
+	return node->children[index - 1];
+      }
+    }
+    return 0;
+  }
+  default: {
+    art_node256_t* node = (art_node256_t*)inner;
+    for (; *position < 256; (*position)++) {
+      if (node->children[*position]) {
+	*byte = (unsigned char)*position;
+	return node->children[(*position)++];
+      }
+    }
+    return 0;
+  }
+  }
+}
+
+
+// Adds a child to a node with room for it.
+static void art_put_child(art_inner_t* inner, unsigned char byte,
+			  art_node_t* child) {
+  switch (inner->node.type) {
+  case ART_NODE4:
+  case ART_NODE16: {
+    unsigned char* keys = inner->node.type == ART_NODE4 ?
+      ((art_node4_t*)inner)->keys : ((art_node16_t*)inner)->keys;
+    art_node_t** children = inner->node.type == ART_NODE4 ?
+      ((art_node4_t*)inner)->children : ((art_node16_t*)inner)->children;
+    // Keep the keys sorted for ordered iteration.
+    size_t i = inner->count;
+    while (i > 0 && keys[i - 1] > byte) {
+      keys[i] = keys[i - 1];
+      children[i] = children[i - 1];
+      i--;
+    }
+    keys[i] = byte;
+    children[i] = child;
+    break;
+  }
+  case ART_NODE48: {
+    art_node48_t* node = (art_node48_t*)inner;
+    size_t i = 0;
+    while (node->children[i]) {
+      i++;
+    }
+    node->children[i] = child;
+    node->child_index[byte] = (uint8_t)(i + 1);
+    break;
+  }
+  default:
+    ((art_node256_t*)inner)->children[byte] = child;
+    break;
+  }
+  inner->count++;
+}
+
+
+static void art_remove_child(art_inner_t* inner, unsigned char byte) {
+  switch (inner->node.type) {
+  case ART_NODE4:
+  case ART_NODE16: {
+    unsigned char* keys = inner->node.type == ART_NODE4 ?
+      ((art_node4_t*)inner)->keys : ((art_node16_t*)inner)->keys;
+    art_node_t** children = inner->node.type == ART_NODE4 ?
+      ((art_node4_t*)inner)->children : ((art_node16_t*)inner)->children;
+    size_t i = 0;
+    while (keys[i] != byte) {
+      i++;
+    }
+    memmove(&keys[i], &keys[i + 1], inner->count - i - 1);
+    memmove(&children[i], &children[i + 1],
+	    (inner->count - i - 1) * sizeof(art_node_t*));
+    break;
+  }
+  case ART_NODE48: {
+    art_node48_t* node = (art_node48_t*)inner;
+    node->children[node->child_index[byte] - 1] = 0;
+    node->child_index[byte] = 0;
+    break;
+  }
+  default:
+    ((art_node256_t*)inner)->children[byte] = 0;
+    break;
+  }
+  inner->count--;
+}
+
+
+// Moves the contents of a node into a new node of another type.
+static error_t art_resize(art_t* tree, art_node_t** ref,
+			  art_node_type_t type) {
+  art_inner_t* inner = (art_inner_t*)*ref;
+  art_inner_t* resized = art_inner_create(tree, type);
+  if (!resized) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  *resized = *inner;
+  resized->node.type = type;
+  resized->count = 0;
+  unsigned position = 0;
+  unsigned char byte;
+  art_node_t* child;
+  while ((child = art_next_child(inner, &position, &byte))) {
+    art_put_child(resized, byte, child);
+  }
+  // The prefix now belongs to the resized node.
+  art_free(tree, inner, ART_NODE_SIZES[inner->node.type]);
+  *ref = &resized->node;
+  return 0;
+}
+
+
+static error_t art_add_child(art_t* tree, art_node_t** ref,
+			     unsigned char byte, art_node_t* child) {
+  art_inner_t* inner = (art_inner_t*)*ref;
+  if (inner->count == ART_NODE_CAPACITIES[inner->node.type]) {
+    if (art_resize(tree, ref, inner->node.type + 1)) {
+      return ERROR_OUT_OF_MEMORY;
+    }
+    inner = (art_inner_t*)*ref;
+  }
+  art_put_child(inner, byte, child);
+  return 0;
+}
+
+
+static void art_node_delete(art_t* tree, art_node_t* node) {
+  if (node->type == ART_LEAF) {
+    art_leaf_t* leaf = (art_leaf_t*)node;
+    if (tree->value_deallocator) {
+      tree->value_deallocator(leaf->value.p);
+    }
+    art_leaf_delete(tree, leaf);
+    return;
+  }
+  art_inner_t* inner = (art_inner_t*)node;
+  if (inner->has_value && tree->value_deallocator) {
+    tree->value_deallocator(inner->value.p);
+  }
+  unsigned position = 0;
+  unsigned char byte;
+  art_node_t* child;
+  while ((child = art_next_child(inner, &position, &byte))) {
+    art_node_delete(tree, child);
+  }
+  art_inner_delete(tree, inner);
+}
+
+
+error_t art_create(art_t** tree) {
+  return art_create_with_value_deallocator(tree, 0);
+}
+
+
+error_t art_create_with_value_deallocator(
+  art_t** tree, void (*value_deallocator)(void*)) {
+  art_t* tmp = calloc(1, sizeof(art_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->value_deallocator = value_deallocator;
+  *tree = tmp;
+  return 0;
+}
+
+
+void art_delete(art_t* tree) {
+  if (!tree) {
+    return;
+  }
+  if (tree->root) {
+    art_node_delete(tree, tree->root);
+  }
+  free(tree);
+}
+
+
+static size_t art_common_prefix(const unsigned char* a, size_t a_length,
+				const unsigned char* b, size_t b_length) {
+  size_t length = a_length < b_length ? a_length : b_length;
+  size_t i = 0;
+  while (i < length && a[i] == b[i]) {
+    i++;
+  }
+  return i;
+}
+
+
+// Creates a node4 with the given prefix holding the old node or value
+// (after the prefix) and the new key at key[depth]. The old subtree is
+// either an existing child reached by old_byte, or a value if old is 0.
+static error_t art_split(
+  art_t* tree, art_node_t** ref, const unsigned char* prefix,
+  size_t prefix_length, art_node_t* old, unsigned char old_byte,
+  generic_value_t old_value, const unsigned char* key, size_t length,
+  size_t depth, generic_value_t value) {
+  art_inner_t* inner = art_inner_create(tree, ART_NODE4);
+  if (!inner) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  if (art_set_prefix(tree, inner, prefix, prefix_length)) {
+    art_inner_delete(tree, inner);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  if (depth < length) {
+    art_leaf_t* leaf =
+      art_leaf_create(tree, key + depth + 1, length - depth - 1, value);
+    if (!leaf) {
+      art_inner_delete(tree, inner);
+      return ERROR_OUT_OF_MEMORY;
+    }
+    art_put_child(inner, key[depth], &leaf->node);
+  } else {
+    inner->has_value = true;
+    inner->value = value;
+  }
+  if (old) {
+    art_put_child(inner, old_byte, old);
+  } else {
+    inner->has_value = true;
+    inner->value = old_value;
+  }
+  *ref = &inner->node;
+  return 0;
+}
+
+
+static error_t art_insert_at(
+  art_t* tree, art_node_t** ref, const unsigned char* key, size_t length,
+  size_t depth, generic_value_t value) {
+  art_node_t* node = *ref;
+  if (!node) {
+    art_leaf_t* leaf =
+      art_leaf_create(tree, key + depth, length - depth, value);
+    if (!leaf) {
+      return ERROR_OUT_OF_MEMORY;
+    }
+    *ref = &leaf->node;
+    tree->size++;
+    return 0;
+  }
+
+  if (node->type == ART_LEAF) {
+    art_leaf_t* leaf = (art_leaf_t*)node;
+    size_t common = art_common_prefix(
+      leaf->suffix, leaf->suffix_length, key + depth, length - depth);
+    if (common == leaf->suffix_length && common == length - depth) {
+      leaf->value = value;
+      return 0;
+    }
+    // Split the leaf below a node holding the bytes both keys share.
+    art_leaf_t* old = 0;
+    if (common < leaf->suffix_length) {
+      old = art_leaf_create(
+	tree, leaf->suffix + common + 1, leaf->suffix_length - common - 1,
+	leaf->value);
+      if (!old) {
+	return ERROR_OUT_OF_MEMORY;
+      }
+    }
+    if (art_split(tree, ref, leaf->suffix, common, old ? &old->node : 0,
+		  old ? leaf->suffix[common] : 0, leaf->value, key, length,
+		  depth + common, value)) {
+      if (old) {
+	art_leaf_delete(tree, old);
+      }
+      return ERROR_OUT_OF_MEMORY;
+    }
+    art_leaf_delete(tree, leaf);
+    tree->size++;
+    return 0;
+  }
+
+  art_inner_t* inner = (art_inner_t*)node;
+  unsigned char* prefix = art_prefix(inner);
+  size_t common = art_common_prefix(
+    prefix, inner->prefix_length, key + depth, length - depth);
+  if (common < inner->prefix_length) {
+    // The key leaves the compressed path: split it, keeping this node
+    // below a new one with the shared bytes.
+    unsigned char byte = prefix[common];
+    size_t old_length = inner->prefix_length;
+    if (art_split(tree, ref, prefix, common, node, byte,
+		  (generic_value_t)0.0, key, length, depth + common, value)) {
+      return ERROR_OUT_OF_MEMORY;
+    }
+    art_set_prefix(tree, inner, prefix + common + 1, old_length - common - 1);
+    tree->size++;
+    return 0;
+  }
+
+  depth += inner->prefix_length;
+  if (depth == length) {
+    if (!inner->has_value) {
+      inner->has_value = true;
+      tree->size++;
+    }
+    inner->value = value;
+    return 0;
+  }
+  art_node_t** child = art_find_child(inner, key[depth]);
+  if (child) {
+    return art_insert_at(tree, child, key, length, depth + 1, value);
+  }
+  art_leaf_t* leaf =
+    art_leaf_create(tree, key + depth + 1, length - depth - 1, value);
+  if (!leaf) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  if (art_add_child(tree, ref, key[depth], &leaf->node)) {
+    art_leaf_delete(tree, leaf);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tree->size++;
+  return 0;
+}
+
+
+error_t art_insert(art_t* tree, const char* key, generic_value_t value) {
+  size_t length = strlen(key);
+  if (length > ART_MAX_KEY_LENGTH) {
+    return ERROR_INVALID_ARGS;
+  }
+  return art_insert_at(tree, &tree->root, (const unsigned char*)key, length,
+		       0, value);
+}
+
+
+bool art_get(art_t* tree, const char* key, generic_value_t* value) {
+  const unsigned char* bytes = (const unsigned char*)key;
+  size_t length = strlen(key);
+  size_t depth = 0;
+  art_node_t* node = tree->root;
+  while (node) {
+    if (node->type == ART_LEAF) {
+      art_leaf_t* leaf = (art_leaf_t*)node;
+      if (leaf->suffix_length != length - depth ||
+	  memcmp(leaf->suffix, bytes + depth, leaf->suffix_length)) {
+	return false;
+      }
+      *value = leaf->value;
+      return true;
+    }
+    art_inner_t* inner = (art_inner_t*)node;
+    if (inner->prefix_length > length - depth ||
+	memcmp(art_prefix(inner), bytes + depth, inner->prefix_length)) {
+      return false;
+    }
+    depth += inner->prefix_length;
+    if (depth == length) {
+      if (inner->has_value) {
+	*value = inner->value;
+      }
+      return inner->has_value;
+    }
+    art_node_t** child = art_find_child(inner, bytes[depth]);
+    if (!child) {
+      return false;
+    }
+    node = *child;
+    depth++;
+  }
+  return false;
+}
+
+
+// Restores the shape of a node after a removal below it: removes or
+// collapses nodes left with no children or a single one, and moves nodes
+// to a smaller type when mostly empty. Nothing changes if memory for the
+// new shape cannot be allocated, which leaves a valid but larger tree.
+static void art_compact(art_t* tree, art_node_t** ref) {
+  art_inner_t* inner = (art_inner_t*)*ref;
+  if (!inner->count) {
+    if (!inner->has_value) {
+      art_inner_delete(tree, inner);
+      *ref = 0;
+      return;
+    }
+    art_leaf_t* leaf = art_leaf_create(tree, art_prefix(inner),
+				       inner->prefix_length, inner->value);
+    if (leaf) {
+      art_inner_delete(tree, inner);
+      *ref = &leaf->node;
+    }
+    return;
+  }
+
+  if (inner->count == 1 && !inner->has_value) {
+    // Merge the node's prefix and byte into its only child.
+    unsigned position = 0;
+    unsigned char byte;
+    art_node_t* child = art_next_child(inner, &position, &byte);
+    if (child->type == ART_LEAF) {
+      art_leaf_t* leaf = (art_leaf_t*)child;
+      size_t length = inner->prefix_length + 1 + leaf->suffix_length;
+      art_leaf_t* merged = art_alloc(tree, sizeof(art_leaf_t) + length);
+      if (!merged) {
+	return;
+      }
+      merged->node.type = ART_LEAF;
+      merged->suffix_length = length;
+      merged->value = leaf->value;
+      memcpy(merged->suffix, art_prefix(inner), inner->prefix_length);
+      merged->suffix[inner->prefix_length] = byte;
+      memcpy(merged->suffix + inner->prefix_length + 1, leaf->suffix,
+	     leaf->suffix_length);
+      art_leaf_delete(tree, leaf);
+      child = &merged->node;
+    } else {
+      art_inner_t* child_inner = (art_inner_t*)child;
+      size_t length = inner->prefix_length + 1 + child_inner->prefix_length;
+      unsigned char buffer[ART_INLINE_PREFIX];
+      unsigned char* merged =
+	length > ART_INLINE_PREFIX ? malloc(length) : buffer;
+      if (!merged) {
+	return;
+      }
+      memcpy(merged, art_prefix(inner), inner->prefix_length);
+      merged[inner->prefix_length] = byte;
+      memcpy(merged + inner->prefix_length + 1, art_prefix(child_inner),
+	     child_inner->prefix_length);
+      error_t error = art_set_prefix(tree, child_inner, merged, length);
+      if (merged != buffer) {
+	free(merged);
+      }
+      if (error) {
+	return;
+      }
+    }
+    art_inner_delete(tree, inner);
+    *ref = child;
+    return;
+  }
+
+  // Shrink with some slack so alternating inserts and removals do not
+  // resize every time.
+  if ((inner->node.type == ART_NODE256 && inner->count <= 37) ||
+      (inner->node.type == ART_NODE48 && inner->count <= 12) ||
+      (inner->node.type == ART_NODE16 && inner->count <= 3)) {
+    art_resize(tree, ref, inner->node.type - 1);
+  }
+}
+
+
+static bool art_remove_at(art_t* tree, art_node_t** ref,
+			  const unsigned char* key, size_t length,
+			  size_t depth, generic_value_t* value) {
+  art_node_t* node = *ref;
+  if (!node) {
+    return false;
+  }
+  if (node->type == ART_LEAF) {
+    art_leaf_t* leaf = (art_leaf_t*)node;
+    if (leaf->suffix_length != length - depth ||
+	memcmp(leaf->suffix, key + depth, leaf->suffix_length)) {
+      return false;
+    }
+    *value = leaf->value;
+    art_leaf_delete(tree, leaf);
+    *ref = 0;
+    return true;
+  }
+
+  art_inner_t* inner = (art_inner_t*)node;
+  if (inner->prefix_length > length - depth ||
+      memcmp(art_prefix(inner), key + depth, inner->prefix_length)) {
+    return false;
+  }
+  depth += inner->prefix_length;
+  if (depth == length) {
+    if (!inner->has_value) {
+      return false;
+    }
+    *value = inner->value;
+    inner->has_value = false;
+  } else {
+    art_node_t** child = art_find_child(inner, key[depth]);
+    if (!child ||
+	!art_remove_at(tree, child, key, length, depth + 1, value)) {
+      return false;
+    }
+    if (!*child) {
+      art_remove_child(inner, key[depth]);
+    }
+  }
+  art_compact(tree, ref);
+  return true;
+}
+
+
+bool art_remove(art_t* tree, const char* key, generic_value_t* value) {
+  if (!art_remove_at(tree, &tree->root, (const unsigned char*)key,
+		     strlen(key), 0, value)) {
+    return false;
+  }
+  tree->size--;
+  return true;
+}
+
+
+bool art_longest_prefix(art_t* tree, const char* key, size_t* length,
+			generic_value_t* value) {
+  const unsigned char* bytes = (const unsigned char*)key;
+  size_t key_length = strlen(key);
+  size_t depth = 0;
+  bool found = false;
+  art_node_t* node = tree->root;
+  while (node) {
+    if (node->type == ART_LEAF) {
+      art_leaf_t* leaf = (art_leaf_t*)node;
+      if (leaf->suffix_length <= key_length - depth &&
+	  !memcmp(leaf->suffix, bytes + depth, leaf->suffix_length)) {
+	*length = depth + leaf->suffix_length;
+	*value = leaf->value;
+	found = true;
+      }
+      break;
+    }
+    art_inner_t* inner = (art_inner_t*)node;
+    if (inner->prefix_length > key_length - depth ||
+	memcmp(art_prefix(inner), bytes + depth, inner->prefix_length)) {
+      break;
+    }
+    depth += inner->prefix_length;
+    if (inner->has_value) {
+      *length = depth;
+      *value = inner->value;
+      found = true;
+    }
+    if (depth == key_length) {
+      break;
+    }
+    art_node_t** child = art_find_child(inner, bytes[depth]);
+    if (!child) {
+      break;
+    }
+    node = *child;
+    depth++;
+  }
+  return found;
+}
+
+
+// Descends from node, whose key so far is key_length bytes long, to the
+// first entry below it and makes it current.
+static void art_iterator_descend(art_iterator_t* iter, art_node_t* node,
+				 size_t key_length) {
+  for (;;) {
+    if (node->type == ART_LEAF) {
+      art_leaf_t* leaf = (art_leaf_t*)node;
+      memcpy(iter->key + key_length, leaf->suffix, leaf->suffix_length);
+      iter->key[key_length + leaf->suffix_length] = 0;
+      iter->value = leaf->value;
+      iter->has_current = true;
+      return;
+    }
+    art_inner_t* inner = (art_inner_t*)node;
+    memcpy(iter->key + key_length, art_prefix(inner), inner->prefix_length);
+    key_length += inner->prefix_length;
+    iter->path[iter->depth].node = inner;
+    iter->path[iter->depth].position = 0;
+    iter->path[iter->depth].key_length = key_length;
+    iter->depth++;
+    // A key ending here sorts before the longer keys below.
+    if (inner->has_value) {
+      iter->key[key_length] = 0;
+      iter->value = inner->value;
+      iter->has_current = true;
+      return;
+    }
+    unsigned char byte;
+    node = art_next_child(inner, &iter->path[iter->depth - 1].position,
+			  &byte);
+    iter->key[key_length++] = (char)byte;
+  }
+}
+
+
+art_iterator_t art_iterator_create(art_t* tree) {
+  art_iterator_t iter;
+  iter.depth = 0;
+  iter.has_current = false;
+  if (tree->root) {
+    art_iterator_descend(&iter, tree->root, 0);
+  }
+  return iter;
+}
+
+
+void art_iterator_next(art_iterator_t* iter) {
+  while (iter->depth) {
+    unsigned char byte;
+    size_t key_length = iter->path[iter->depth - 1].key_length;
+    art_node_t* child = art_next_child(
+      iter->path[iter->depth - 1].node, &iter->path[iter->depth - 1].position,
+      &byte);
+    if (child) {
+      iter->key[key_length] = (char)byte;
+      art_iterator_descend(iter, child, key_length + 1);
+      return;
+    }
+    iter->depth--;
+  }
+  iter->has_current = false;
+}
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "errors.h"
+#include "generic.h"
+
+
+// Prefix bytes stored in the node itself; longer prefixes are allocated.
+#define ART_INLINE_PREFIX 8
+// Longest key the tree accepts. Each inner node on a path consumes at
+// least one key byte, so this also bounds the depth of the tree.
+#define ART_MAX_KEY_LENGTH 255
+
+typedef enum {
+  ART_LEAF,
+  ART_NODE4,
+  ART_NODE16,
+  ART_NODE48,
+  ART_NODE256
+} art_node_type_t;
+
+// Common header of all nodes.
+typedef struct {
+  uint8_t type;
+} art_node_t;
+
+typedef struct {
+  art_node_t node;
+  uint32_t suffix_length;
+  generic_value_t value;
+  // Key bytes following the branch byte that leads to the leaf. Keys are
+  // never stored whole; the path from the root spells out the rest.
+  unsigned char suffix[];
+} art_leaf_t;
+
+typedef struct {
+  art_node_t node;
+  bool has_value;
+  uint16_t count;
+  // Compressed path: bytes shared by every key below this node.
+  uint32_t prefix_length;
+  union {
+    unsigned char inline_prefix[ART_INLINE_PREFIX];
+    unsigned char* prefix;
+  };
+  // Value of the key ending at this node, if has_value.
+  generic_value_t value;
+} art_inner_t;
+
+typedef struct {
+  art_inner_t inner;
+  unsigned char keys[4];
+  art_node_t* children[4];
+} art_node4_t;
+
+typedef struct {
+  art_inner_t inner;
+  unsigned char keys[16];
+  art_node_t* children[16];
+} art_node16_t;
+
+typedef struct {
+  art_inner_t inner;
+  // One plus the index into children of each byte, or 0.
+  uint8_t child_index[256];
+  art_node_t* children[48];
+} art_node48_t;
+
+typedef struct {
+  art_inner_t inner;
+  art_node_t* children[256];
+} art_node256_t;
+
+typedef struct {
+  void (*value_deallocator)(void*);
+  size_t size;
+  // Bytes allocated for nodes, leaves and prefixes.
+  size_t memory;
+  art_node_t* root;
+} art_t;
+
+typedef struct {
+  // Inner nodes above the current entry, with the position of the next
+  // child to visit in each and the length of the key through its prefix.
+  struct {
+    art_inner_t* node;
+    unsigned position;
+    size_t key_length;
+  } path[ART_MAX_KEY_LENGTH + 1];
+  size_t depth;
+  bool has_current;
+  // Current key, rebuilt from the path, and its value.
+  char key[ART_MAX_KEY_LENGTH + 1];
+  generic_value_t value;
+} art_iterator_t;
+
+
+/**
+ * Creates a new adaptive radix tree.
+ *
+ * The tree maps strings to values. Keys are split into bytes along the
+ * path from the root: inner nodes grow from 4 to 16, 48 and 256 children
+ * as needed, and chains of single-child nodes are compressed into a
+ * prefix, so keys sharing long prefixes store those bytes once.
+ *
+ * Args:
+ *  tree: Set to the newly allocated tree.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create tree because of memory error.
+ */
+error_t art_create(art_t** tree);
+
+
+/**
+ * Creates a new adaptive radix tree with a value deallocator.
+ *
+ * The deallocation function is used to delete void* values
+ * (generic_value_t.p) when art_delete is called.
+ *
+ * Args:
+ *  tree: Set to the newly allocated tree.
+ *  deallocated: Function used to delete values.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create tree because of memory error.
+ */
+error_t art_create_with_value_deallocator(
+  art_t** tree, void (*value_deallocator)(void*));
+
+
+/**
+ * Deletes an adaptive radix tree.
+ *
+ * If a deallocation function was provided during creation, tree values
+ * will be treated as void* (generic_value_t.p) and sent to the function.
+ *
+ * Args:
+ *  tree: Tree to be deleted.
+ */
+void art_delete(art_t* tree);
+
+
+/**
+ * Inserts a key and value into the tree.
+ *
+ * If the key already exists in the tree, the value is updated.
+ *
+ * Args:
+ *  tree: Tree to update.
+ *  key: Key for tree entry.
+ *  value: Value for tree entry.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_INVALID_ARGS: The key is longer than ART_MAX_KEY_LENGTH.
+ *  ERROR_OUT_OF_MEMORY: Could not insert into tree because of memory errors.
+ */
+error_t art_insert(art_t* tree, const char* key, generic_value_t value);
+
+
+/**
+ * Gets a value from the tree.
+ *
+ * Args:
+ *  tree: The tree to examine.
+ *  key: The key to look up.
+ *  value: Set to any value found.
+ *
+ * Returns:
+ *  true if the value is found.
+ */
+bool art_get(art_t* tree, const char* key, generic_value_t* value);
+
+
+/**
+ * Removes a key and value from the tree.
+ *
+ * Args:
+ *  tree: The tree to examine.
+ *  key: The key to look up.
+ *  value: Set to any value found.
+ *
+ * Returns:
+ *  true if the value is found.
+ */
+bool art_remove(art_t* tree, const char* key, generic_value_t* value);
+
+
+/**
+ * Finds the longest key in the tree that is a prefix of a string.
+ *
+ * Args:
+ *  tree: The tree to examine.
+ *  key: The string to match.
+ *  length: Set to the length of the matching key.
+ *  value: Set to the value of the matching key.
+ *
+ * Returns:
+ *  true if a key matched.
+ */
+bool art_longest_prefix(art_t* tree, const char* key, size_t* length,
+			generic_value_t* value);
+
+
+/**
+ * Creates an iterator over the whole tree, in strcmp key order.
+ *
+ * Keys are rebuilt into the iterator from the path to each entry, so
+ * iterating never allocates. The tree must not be modified while the
+ * iterator is in use.
+ *
+ * Args:
+ *  tree: Tree to create iterator for.
+ *
+ * Returns:
+ *  Iterator for the given tree.
+ */
+art_iterator_t art_iterator_create(art_t* tree);
+
+
+/**
+ * Returns true if the iterator has a current element.
+ *
+ * If this function returns true, it is safe to call art_iterator_get_current
+ * and art_iterator_next.
+ *
+ * Args:
+ *  iter: Iterator to examine
+ *
+ * Returns:
+ *  true if the iterator has a current element.
+ */
+inline bool art_iterator_has_current(const art_iterator_t* iter) {
+  return iter->has_current;
+}
+
+
+/**
+ * Gets the current element for the iterator.
+ *
+ * This call should be proceeded by a successful call to
+ * art_iterator_has_current.
+ *
+ * Args:
+ *  iter: Iterator to examine.
+ *  key: Set to the key for the current element (owned by the iterator and
+ *   valid until it moves).
+ *  value: Set to the value for the current element.
+ */
+inline void art_iterator_get_current(
+  const art_iterator_t* iter, const char** key, generic_value_t* value) {
+  *key = iter->key;
+  *value = iter->value;
+}
+
+
+/**
+ * Moves the iterator to the next value.
+ *
+ * This call should be proceeded by a successful call to
+ * art_iterator_has_current.
+ *
+ * Args:
+ *  iter: Iterator to update.
+ */
+void art_iterator_next(art_iterator_t* iter);
+
+
+/**
+ * Returns the size of the tree.
+ *
+ * Args:
+ *  tree: The tree to examine.
+ *
+ * Returns:
+ *  Size of the tree.
+ */
+inline size_t art_size(const art_t* tree) { return tree->size; }
+
+
+/**
+ * Returns the memory used by the tree.
+ *
+ * Args:
+ *  tree: The tree to examine.
+ *
+ * Returns:
+ *  Bytes allocated for the tree's nodes, leaves and key prefixes.
+ */
+inline size_t art_memory_usage(const art_t* tree) {
+  return sizeof(art_t) + tree->memory;
+}
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "art.h"
+#include "bench.h"
+#include "map.h"
+
+
+// map_t has a fixed number of buckets, which limits the key count that
+// can be built in reasonable time.
+#define BENCH_KEYS 50000
+#define BENCH_GETS 1000000
+#define BENCH_MAP_GETS 20000
+
+
+static char bench_keys[BENCH_KEYS][64];
+
+
+// Returns the bytes currently allocated from the heap, or 0 if unknown.
+static size_t bench_heap_usage(void) {
+#ifdef __GLIBC__
+  return mallinfo2().uordblks;
+#else
+  return 0;
+#endif
+}
+
+
+int main(int argc, char** argv) {
+  // Routing-table style keys with long shared prefixes.
+  size_t key_bytes = 0;
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    snprintf(bench_keys[i], sizeof(bench_keys[i]),
+	     "/api/v1/tenants/%d/services/%d/routes/%d", i % 50, i % 1000, i);
+    key_bytes += strlen(bench_keys[i]) + 1;
+  }
+
+  art_t* tree;
+  if (art_create(&tree)) {
+    abort();
+  }
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_KEYS; i++) {
+    if (art_insert(tree, bench_keys[i], (generic_value_t)i)) {
+      abort();
+    }
+  }
+  bench_report("art_insert", BENCH_KEYS, bench_now_ns() - start);
+
+  map_t* map;
+  size_t heap_before = bench_heap_usage();
+  if (map_create(&map)) {
+    abort();
+  }
+  start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_KEYS; i++) {
+    if (map_insert(map, bench_keys[i], (generic_value_t)i)) {
+      abort();
+    }
+  }
+  bench_report("map_insert", BENCH_KEYS, bench_now_ns() - start);
+  size_t map_memory = bench_heap_usage() - heap_before;
+
+  uint64_t seed = 1;
+  uint64_t sum = 0;
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_GETS; i++) {
+    generic_value_t value;
+    if (art_get(tree, bench_keys[bench_random(&seed) % BENCH_KEYS],
+		&value)) {
+      sum += value.ui64;
+    }
+  }
+  bench_report("art_get", BENCH_GETS, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_MAP_GETS; i++) {
+    generic_value_t value;
+    if (map_get(map, bench_keys[bench_random(&seed) % BENCH_KEYS], &value)) {
+      sum += value.ui64;
+    }
+  }
+  bench_report("map_get", BENCH_MAP_GETS, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_GETS; i++) {
+    size_t length;
+    generic_value_t value;
+    char key[80];
+    snprintf(key, sizeof(key), "%s/extra",
+	     bench_keys[bench_random(&seed) % BENCH_KEYS]);
+    if (art_longest_prefix(tree, key, &length, &value)) {
+      sum += length;
+    }
+  }
+  bench_report("art_longest_prefix", BENCH_GETS, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (art_iterator_t iter = art_iterator_create(tree);
+       art_iterator_has_current(&iter); art_iterator_next(&iter)) {
+    const char* key;
+    generic_value_t value;
+    art_iterator_get_current(&iter, &key, &value);
+    sum += value.ui64 + (unsigned char)key[0];
+  }
+  bench_report("art_iterate", BENCH_KEYS, bench_now_ns() - start);
+  bench_use(sum);
+
+  bench_report_value("key_bytes", (double)key_bytes / BENCH_KEYS,
+		     "bytes/key");
+  bench_report_value("art_memory",
+		     (double)art_memory_usage(tree) / BENCH_KEYS, "bytes/key");
+  if (map_memory) {
+    bench_report_value("map_memory", (double)map_memory / BENCH_KEYS,
+		       "bytes/key");
+  }
+  art_delete(tree);
+  map_delete(map);
+  return 0;
+}
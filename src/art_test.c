@@ -0,0 +1,284 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "art.h"
+
+
+static void test_art_create() {
+  art_t* tree;
+  assert(!art_create(&tree));
+  assert(!art_size(tree));
+  generic_value_t value;
+  assert(!art_get(tree, "a", &value));
+  assert(!art_get(tree, "", &value));
+  art_delete(tree);
+}
+
+
+static void test_art_insert_get() {
+  art_t* tree;
+  assert(!art_create(&tree));
+  // Keys that are prefixes of each other, share long compressed paths and
+  // split nodes at every depth.
+  const char* keys[] = {
+    "", "a", "ab", "abc", "abd", "b", "route/v1/users/12/orders",
+    "route/v1/users/12/orders/7", "route/v1/users/12/items",
+    "route/v1/users/13", "route/v2", "route"
+  };
+  size_t count = sizeof(keys) / sizeof(keys[0]);
+  for (uint64_t i = 0; i < count; i++) {
+    assert(!art_insert(tree, keys[i], (generic_value_t)i));
+    assert(i + 1 == art_size(tree));
+    for (uint64_t j = 0; j <= i; j++) {
+      generic_value_t value;
+      assert(art_get(tree, keys[j], &value));
+      assert(j == value.ui64);
+    }
+  }
+  generic_value_t value;
+  assert(!art_get(tree, "abe", &value));
+  assert(!art_get(tree, "route/v1", &value));
+  assert(!art_get(tree, "route/v1/users/12/orders/", &value));
+  assert(!art_get(tree, "c", &value));
+
+  // Inserting an existing key updates its value.
+  assert(!art_insert(tree, "route/v1/users/13", (generic_value_t)0.5));
+  assert(count == art_size(tree));
+  assert(art_get(tree, "route/v1/users/13", &value));
+  assert(0.5 == value.d);
+  art_delete(tree);
+}
+
+
+static void test_art_node_growth() {
+  art_t* tree;
+  assert(!art_create(&tree));
+  // Fan out a single node through every node type.
+  char key[3] = "x";
+  for (uint64_t i = 1; i < 256; i++) {
+    key[1] = (char)i;
+    assert(!art_insert(tree, key, (generic_value_t)i));
+    if (i == 4 || i == 16 || i == 48 || i == 255) {
+      for (uint64_t j = 1; j <= i; j++) {
+	generic_value_t value;
+	key[1] = (char)j;
+	assert(art_get(tree, key, &value));
+	assert(j == value.ui64);
+      }
+    }
+  }
+  assert(255 == art_size(tree));
+  // And shrink it back.
+  for (uint64_t i = 255; i > 0; i--) {
+    generic_value_t value;
+    key[1] = (char)i;
+    assert(art_remove(tree, key, &value));
+    assert(i == value.ui64);
+    assert(!art_get(tree, key, &value));
+    key[1] = 1;
+    assert(i == 1 || art_get(tree, key, &value));
+  }
+  assert(!art_size(tree));
+  assert(!tree->root);
+  assert(art_memory_usage(tree) == sizeof(art_t));
+  art_delete(tree);
+}
+
+
+static void test_art_remove() {
+  art_t* tree;
+  assert(!art_create(&tree));
+  const char* keys[] = {
+    "a", "ab", "abc", "abcdefghijklmnop", "abcdefghijklmnoq", "abcx", "",
+    "b", "ba"
+  };
+  size_t count = sizeof(keys) / sizeof(keys[0]);
+  for (uint64_t i = 0; i < count; i++) {
+    assert(!art_insert(tree, keys[i], (generic_value_t)i));
+  }
+  generic_value_t value;
+  assert(!art_remove(tree, "abcd", &value));
+  assert(!art_remove(tree, "zzz", &value));
+  for (uint64_t i = 0; i < count; i++) {
+    assert(art_remove(tree, keys[i], &value));
+    assert(i == value.ui64);
+    assert(!art_remove(tree, keys[i], &value));
+    for (uint64_t j = i + 1; j < count; j++) {
+      assert(art_get(tree, keys[j], &value));
+      assert(j == value.ui64);
+    }
+  }
+  assert(!art_size(tree));
+  assert(art_memory_usage(tree) == sizeof(art_t));
+  art_delete(tree);
+}
+
+
+static void test_art_random() {
+  art_t* tree;
+  assert(!art_create(&tree));
+  bool present[2000] = {0};
+  char key[64];
+  srand(3);
+  for (int i = 0; i < 50000; i++) {
+    int k = rand() % 2000;
+    // Long shared prefixes and keys that are prefixes of others.
+    sprintf(key, "/service/%d/%d/%d", k % 7, k % 97, k);
+    if (k % 10 == 0) {
+      sprintf(key, "/service/%d", k);
+    }
+    generic_value_t value;
+    if (rand() % 2) {
+      assert(!art_insert(tree, key, (generic_value_t)(uint64_t)k));
+      present[k] = true;
+    } else {
+      assert(present[k] == art_remove(tree, key, &value));
+      present[k] = false;
+    }
+  }
+  size_t size = 0;
+  for (int k = 0; k < 2000; k++) {
+    generic_value_t value;
+    sprintf(key, "/service/%d/%d/%d", k % 7, k % 97, k);
+    if (k % 10 == 0) {
+      sprintf(key, "/service/%d", k);
+    }
+    assert(present[k] == art_get(tree, key, &value));
+    assert(!present[k] || k == value.i64);
+    size += present[k];
+  }
+  assert(size == art_size(tree));
+  art_delete(tree);
+}
+
+
+static void test_art_longest_prefix() {
+  art_t* tree;
+  assert(!art_create(&tree));
+  assert(!art_insert(tree, "10.", (generic_value_t)(uint64_t)1));
+  assert(!art_insert(tree, "10.1.", (generic_value_t)(uint64_t)2));
+  assert(!art_insert(tree, "10.1.2.", (generic_value_t)(uint64_t)3));
+  assert(!art_insert(tree, "10.1.3.4", (generic_value_t)(uint64_t)4));
+  size_t length;
+  generic_value_t value;
+  assert(art_longest_prefix(tree, "10.1.2.3", &length, &value));
+  assert(7 == length && 3 == value.ui64);
+  assert(art_longest_prefix(tree, "10.1.3.4", &length, &value));
+  assert(8 == length && 4 == value.ui64);
+  assert(art_longest_prefix(tree, "10.1.3.5", &length, &value));
+  assert(5 == length && 2 == value.ui64);
+  assert(art_longest_prefix(tree, "10.2", &length, &value));
+  assert(3 == length && 1 == value.ui64);
+  assert(!art_longest_prefix(tree, "11.", &length, &value));
+  assert(!art_longest_prefix(tree, "10", &length, &value));
+  assert(!art_insert(tree, "", (generic_value_t)(uint64_t)0));
+  assert(art_longest_prefix(tree, "11.", &length, &value));
+  assert(0 == length && 0 == value.ui64);
+  art_delete(tree);
+}
+
+
+static int compare_strings(const void* a, const void* b) {
+  return strcmp(a, b);
+}
+
+
+static void test_art_iterator() {
+  art_t* tree;
+  assert(!art_create(&tree));
+  art_iterator_t iter = art_iterator_create(tree);
+  assert(!art_iterator_has_current(&iter));
+
+  char expected[64][16];
+  srand(4);
+  for (int i = 0; i < 64; i++) {
+    // Include bytes above 127, which must sort after ASCII.
+    sprintf(expected[i], "%c%d", "ab\xe9"[i % 3], rand() % 1000);
+    if (i == 10) {
+      strcpy(expected[i], "a");
+    }
+    assert(!art_insert(tree, expected[i], (generic_value_t)(uint64_t)i));
+  }
+  qsort(expected, 64, sizeof(expected[0]), compare_strings);
+  size_t count = 0;
+  size_t next = 0;
+  const char* key;
+  generic_value_t value;
+  for (iter = art_iterator_create(tree); art_iterator_has_current(&iter);
+       art_iterator_next(&iter)) {
+    art_iterator_get_current(&iter, &key, &value);
+    // Skip duplicates from rand.
+    while (next && !strcmp(expected[next], expected[next - 1])) {
+      next++;
+    }
+    assert(!strcmp(expected[next++], key));
+    generic_value_t found;
+    assert(art_get(tree, key, &found));
+    assert(found.ui64 == value.ui64);
+    count++;
+  }
+  assert(art_size(tree) == count);
+  art_delete(tree);
+}
+
+
+static void test_art_iterator_deep() {
+  art_t* tree;
+  assert(!art_create(&tree));
+  // Every key is a prefix of the next, so each one adds a level.
+  char key[ART_MAX_KEY_LENGTH + 2];
+  for (size_t length = 0; length <= ART_MAX_KEY_LENGTH; length++) {
+    memset(key, 'a', length);
+    key[length] = 0;
+    assert(!art_insert(tree, key, (generic_value_t)(uint64_t)length));
+  }
+  memset(key, 'a', ART_MAX_KEY_LENGTH + 1);
+  key[ART_MAX_KEY_LENGTH + 1] = 0;
+  assert(ERROR_INVALID_ARGS ==
+	 art_insert(tree, key, (generic_value_t)(uint64_t)0));
+  assert(ART_MAX_KEY_LENGTH + 1 == art_size(tree));
+
+  size_t length = 0;
+  for (art_iterator_t iter = art_iterator_create(tree);
+       art_iterator_has_current(&iter); art_iterator_next(&iter)) {
+    const char* current;
+    generic_value_t value;
+    art_iterator_get_current(&iter, &current, &value);
+    assert(length == strlen(current));
+    assert(length == value.ui64);
+    assert(strspn(current, "a") == length);
+    length++;
+  }
+  assert(ART_MAX_KEY_LENGTH + 1 == length);
+  art_delete(tree);
+}
+
+
+static void test_art_value_deallocator() {
+  art_t* tree;
+  assert(!art_create_with_value_deallocator(&tree, free));
+  assert(!art_insert(tree, "a", (generic_value_t)malloc(10)));
+  assert(!art_insert(tree, "ab", (generic_value_t)malloc(10)));
+  assert(!art_insert(tree, "abc", (generic_value_t)malloc(10)));
+  assert(!art_insert(tree, "b", (generic_value_t)malloc(10)));
+  generic_value_t value;
+  assert(art_remove(tree, "ab", &value));
+  free(value.p);
+  art_delete(tree);
+}
+
+
+int main(int argc, char** argv) {
+  test_art_create();
+  test_art_insert_get();
+  test_art_node_growth();
+  test_art_remove();
+  test_art_random();
+  test_art_longest_prefix();
+  test_art_iterator();
+  test_art_iterator_deep();
+  test_art_value_deallocator();
+  return 0;
+}
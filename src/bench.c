@@ -0,0 +1,177 @@
+#define _XOPEN_SOURCE 600
+
+#include "bench.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+
+// Ranks whose zeta terms are summed exactly; the rest of the sum is
+// approximated, which keeps bench_zipf_init fast for 100M ranks.
+static const size_t ZETA_EXACT_TERMS = 1000000;
+
+
+static volatile uint64_t bench_sink;
+
+
+// Provide external definitions of inline functions.
+extern inline uint64_t bench_random(uint64_t* seed);
+
+
+uint64_t bench_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+void bench_use(uint64_t value) {
+  bench_sink += value;
+}
+
+
+char* bench_make_keys(const char* prefix, size_t count, size_t key_size) {
+  char* keys = malloc(count * key_size);
+  if (!keys) {
+    abort();
+  }
+  for (size_t i = 0; i < count; i++) {
+    snprintf(keys + i * key_size, key_size, "%s%zu", prefix, i);
+  }
+  return keys;
+}
+
+
+static int bench_json(void) {
+  const char* format = getenv("BENCH_FORMAT");
+  return format && !strcmp(format, "json");
+}
+
+
+void bench_report(const char* name, size_t ops, uint64_t elapsed_ns) {
+  double ns_per_op = ops ? (double)elapsed_ns / ops : 0;
+  double ops_per_sec = elapsed_ns ? ops * 1e9 / elapsed_ns : 0;
+  if (bench_json()) {
+    printf("{\"name\": \"%s\", \"ops\": %zu, \"ns_per_op\": %.2f, "
+	   "\"ops_per_sec\": %.0f, \"peak_rss_kb\": %zu}\n",
+	   name, ops, ns_per_op, ops_per_sec, bench_peak_rss_kb());
+  } else {
+    printf("%-40s %12zu ops %10.2f ns/op %14.0f ops/sec %10zu KB rss\n",
+	   name, ops, ns_per_op, ops_per_sec, bench_peak_rss_kb());
+  }
+}
+
+
+void bench_report_value(const char* name, double value, const char* unit) {
+  if (bench_json()) {
+    printf("{\"name\": \"%s\", \"value\": %.4f, \"unit\": \"%s\", "
+	   "\"peak_rss_kb\": %zu}\n", name, value, unit, bench_peak_rss_kb());
+  } else {
+    printf("%-40s %16.4f %s\n", name, value, unit);
+  }
+}
+
+
+size_t bench_peak_rss_kb(void) {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage)) {
+    return 0;
+  }
+  // Linux reports kilobytes.
+  return usage.ru_maxrss;
+}
+
+
+static int bench_compare_samples(const void* a, const void* b) {
+  uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+  return (x > y) - (x < y);
+}
+
+
+uint64_t bench_percentile(uint64_t* samples, size_t count,
+			  double percentile) {
+  qsort(samples, count, sizeof(uint64_t), bench_compare_samples);
+  size_t rank = ceil(percentile / 100 * count);
+  return samples[rank ? rank - 1 : 0];
+}
+
+
+void bench_report_latencies(const char* name, uint64_t* samples,
+			    size_t count) {
+  uint64_t total = 0;
+  for (size_t i = 0; i < count; i++) {
+    total += samples[i];
+  }
+  bench_report(name, count, total);
+  double percentiles[] = {50, 99, 99.9, 100};
+  const char* labels[] = {"p50", "p99", "p999", "max"};
+  for (int i = 0; i < 4; i++) {
+    char label[96];
+    snprintf(label, sizeof(label), "%s/%s", name, labels[i]);
+    bench_report_value(
+      label, bench_percentile(samples, count, percentiles[i]), "ns");
+  }
+}
+
+
+size_t bench_sizes(size_t* sizes, size_t default_max) {
+  size_t max = default_max;
+  const char* env = getenv("BENCH_MAX_SIZE");
+  if (env && *env) {
+    max = strtoull(env, 0, 10);
+  }
+  size_t count = 0;
+  for (size_t size = 1000; size <= max && count < BENCH_MAX_SIZES;
+       size *= 10) {
+    sizes[count++] = size;
+  }
+  return count;
+}
+
+
+// Returns the sum of 1 / i^theta for i from 1 to n.
+static double bench_zeta(size_t n, double theta) {
+  size_t exact = n < ZETA_EXACT_TERMS ? n : ZETA_EXACT_TERMS;
+  double sum = 0;
+  for (size_t i = 1; i <= exact; i++) {
+    sum += pow((double)i, -theta);
+  }
+  if (n > exact) {
+    // Euler-Maclaurin: the integral of the tail plus the endpoint terms.
+    double a = exact, b = n;
+    sum += (pow(b, 1 - theta) - pow(a, 1 - theta)) / (1 - theta) +
+      (pow(b, -theta) - pow(a, -theta)) / 2;
+  }
+  return sum;
+}
+
+
+void bench_zipf_init(bench_zipf_t* zipf, size_t n, double theta,
+		     uint64_t seed) {
+  zipf->n = n;
+  zipf->theta = theta;
+  zipf->alpha = 1 / (1 - theta);
+  zipf->zeta_n = bench_zeta(n, theta);
+  zipf->eta = (1 - pow(2.0 / n, 1 - theta)) /
+    (1 - bench_zeta(2, theta) / zipf->zeta_n);
+  zipf->seed = seed;
+}
+
+
+uint64_t bench_zipf_next(bench_zipf_t* zipf) {
+  zipf->seed = zipf->seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  double u = (zipf->seed >> 11) * (1.0 / 9007199254740992.0);
+  double uz = u * zipf->zeta_n;
+  if (uz < 1) {
+    return 0;
+  }
+  if (uz < 1 + pow(0.5, zipf->theta)) {
+    return 1;
+  }
+  uint64_t rank = zipf->n * pow(zipf->eta * u - zipf->eta + 1, zipf->alpha);
+  return rank < zipf->n ? rank : zipf->n - 1;
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// Largest number of sizes returned by bench_sizes: 1K to 100M.
+#define BENCH_MAX_SIZES 6
+
+// Draws Zipfian ranks; see bench_zipf_init.
+typedef struct {
+  size_t n;
+  double theta;
+  double alpha;
+  double zeta_n;
+  double eta;
+  uint64_t seed;
+} bench_zipf_t;
+
+
+/**
+ * Returns a monotonic timestamp.
+ *
+ * Returns:
+ *  Current time in nanoseconds from an arbitrary starting point.
+ */
+uint64_t bench_now_ns(void);
+
+
+/**
+ * Consumes a value so the compiler cannot optimize away its computation.
+ *
+ * Args:
+ *  value: Value to consume.
+ */
+void bench_use(uint64_t value);
+
+
+/**
+ * Draws a pseudo-random number from a linear congruential generator.
+ *
+ * Cheap enough to call inside timed loops; not for anything but picking
+ * benchmark inputs.
+ *
+ * Args:
+ *  seed: Generator state, updated by the call.
+ *
+ * Returns:
+ *  Random number below 2^31.
+ */
+inline uint64_t bench_random(uint64_t* seed) {
+  *seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return *seed >> 33;
+}
+
+
+/**
+ * Formats keys with a prefix and their index, e.g. "key:42", into
+ * fixed-size slots, so key i is at keys + i * key_size. Aborts if memory
+ * runs out.
+ *
+ * Args:
+ *  prefix: Prefix of every key.
+ *  count: Number of keys.
+ *  key_size: Size of each slot, including the terminating null.
+ *
+ * Returns:
+ *  The keys, to be freed by the caller.
+ */
+char* bench_make_keys(const char* prefix, size_t count, size_t key_size);
+
+
+/**
+ * Prints the result of a benchmark.
+ *
+ * Each line includes the peak resident set size of the process so far.
+ * If the BENCH_FORMAT environment variable is "json", results are printed
+ * as one JSON object per line for tracking over time.
+ *
+ * Args:
+ *  name: Name of the benchmark.
+ *  ops: Number of operations performed.
+ *  elapsed_ns: Time taken by the operations in nanoseconds.
+ */
+void bench_report(const char* name, size_t ops, uint64_t elapsed_ns);
+
+
+/**
+ * Prints a measurement other than a timing, in the format of
+ * bench_report.
+ *
+ * Args:
+ *  name: Name of the measurement.
+ *  value: Measured value.
+ *  unit: Unit of the value, e.g. "bytes/key".
+ */
+void bench_report_value(const char* name, double value, const char* unit);
+
+
+/**
+ * Returns the peak resident set size of the process.
+ *
+ * Returns:
+ *  Peak resident set size in kilobytes, or 0 if unknown.
+ */
+size_t bench_peak_rss_kb(void);
+
+
+/**
+ * Returns a percentile of a set of samples, such as operation latencies.
+ *
+ * Args:
+ *  samples: Samples to examine. Sorted in place.
+ *  count: Number of samples; at least 1.
+ *  percentile: Percentile to return, from 0 to 100.
+ *
+ * Returns:
+ *  The smallest sample not below the given percentage of the samples.
+ */
+uint64_t bench_percentile(uint64_t* samples, size_t count,
+			  double percentile);
+
+
+/**
+ * Prints the mean of a set of latency samples, as bench_report does, then
+ * their p50, p99, p999 and maximum.
+ *
+ * Samples timing one operation each also include the cost of reading the
+ * clock.
+ *
+ * Args:
+ *  name: Name of the benchmark.
+ *  samples: Latencies in nanoseconds. Sorted in place.
+ *  count: Number of samples; at least 1.
+ */
+void bench_report_latencies(const char* name, uint64_t* samples,
+			    size_t count);
+
+
+/**
+ * Returns the sizes a benchmark should run at.
+ *
+ * Sizes are powers of ten from 1000 up to a maximum, which is taken from
+ * the BENCH_MAX_SIZE environment variable when set, so the same binary
+ * can run quick checks or sweeps up to 100M elements.
+ *
+ * Args:
+ *  sizes: Set to the sizes, in increasing order. Must have room for
+ *   BENCH_MAX_SIZES.
+ *  default_max: Maximum size when BENCH_MAX_SIZE is not set.
+ *
+ * Returns:
+ *  Number of sizes.
+ */
+size_t bench_sizes(size_t* sizes, size_t default_max);
+
+
+/**
+ * Prepares to draw ranks from a Zipfian distribution.
+ *
+ * Rank 0 is the most frequent, then rank 1 and so on, as in the skewed
+ * key popularity of real caches. Uses the method of Gray et al., as in
+ * YCSB, so each draw takes O(1) time.
+ *
+ * Args:
+ *  zipf: Generator to initialize.
+ *  n: Number of ranks.
+ *  theta: Skew, between 0 and 1 exclusive; YCSB uses 0.99.
+ *  seed: Seed for the underlying uniform generator.
+ */
+void bench_zipf_init(bench_zipf_t* zipf, size_t n, double theta,
+		     uint64_t seed);
+
+
+/**
+ * Draws a Zipfian rank.
+ *
+ * Args:
+ *  zipf: Generator to draw from.
+ *
+ * Returns:
+ *  Rank between 0 and n - 1.
+ */
+uint64_t bench_zipf_next(bench_zipf_t* zipf);
@@ -0,0 +1,52 @@
+#include "bloom_filter.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+// Bits per key, which with 8 bits set per key keeps the false positive
+// rate of 512 bit blocks below 1%.
+static const size_t BITS_PER_KEY = 12;
+
+
+// Provide external definitions of inline functions.
+extern inline unsigned bloom_filter_bit(uint64_t bits, int i);
+extern inline void bloom_filter_add(bloom_filter_t* filter,
+				    uint64_t hash_code);
+extern inline bool bloom_filter_may_contain(const bloom_filter_t* filter,
+					    uint64_t hash_code);
+extern inline double bloom_filter_false_positive_rate(
+  const bloom_filter_t* filter);
+
+
+error_t bloom_filter_create(bloom_filter_t** filter, size_t capacity) {
+  size_t block_bits = sizeof(bloom_filter_block_t) * 8;
+  size_t blocks = 1;
+  while (blocks * block_bits < capacity * BITS_PER_KEY) {
+    blocks *= 2;
+  }
+  bloom_filter_t* tmp = calloc(1, sizeof(bloom_filter_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->blocks = aligned_alloc(_Alignof(bloom_filter_block_t),
+			      blocks * sizeof(bloom_filter_block_t));
+  if (!tmp->blocks) {
+    free(tmp);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  memset(tmp->blocks, 0, blocks * sizeof(bloom_filter_block_t));
+  tmp->capacity = capacity;
+  tmp->mask = blocks - 1;
+  *filter = tmp;
+  return 0;
+}
+
+
+void bloom_filter_delete(bloom_filter_t* filter) {
+  if (!filter) {
+    return;
+  }
+  free(filter->blocks);
+  free(filter);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "errors.h"
+#include "hash.h"
+
+
+// Words per block; each key sets one bit in every word of its block.
+#define BLOOM_FILTER_BLOCK_WORDS 8
+
+// One cache line.
+typedef struct {
+  _Alignas(64) uint64_t words[BLOOM_FILTER_BLOCK_WORDS];
+} bloom_filter_block_t;
+
+typedef struct {
+  // Number of keys the filter was sized for.
+  size_t capacity;
+  // Number of blocks minus one (a power of two minus one).
+  size_t mask;
+  bloom_filter_block_t* blocks;
+  // Number of keys added.
+  size_t count;
+  // Lookup outcomes recorded by the filter's owner: absent keys rejected
+  // by the filter, and absent keys it let through.
+  size_t negatives;
+  size_t false_positives;
+} bloom_filter_t;
+
+
+/**
+ * Returns the bit set in word i of a block for a remixed hash.
+ *
+ * Multiplying by a different odd constant per word spreads the low 32
+ * bits of the hash into independent 6 bit positions.
+ */
+inline unsigned bloom_filter_bit(uint64_t bits, int i) {
+  static const uint32_t salts[BLOOM_FILTER_BLOCK_WORDS] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+  };
+  return ((uint32_t)bits * salts[i]) >> 26;
+}
+
+
+/**
+ * Creates a new blocked Bloom filter.
+ *
+ * A Bloom filter answers "definitely absent" or "maybe present" for keys
+ * identified by their 64 bit hash. All bits for a key live in one cache
+ * line, so a lookup costs a single cache miss. Keys cannot be removed.
+ *
+ * Args:
+ *  filter: Set to the newly allocated filter.
+ *  capacity: Number of keys to size the filter for; about 12 bits are
+ *   used per key, for a false positive rate below 1% up to capacity.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create filter because of memory error.
+ */
+error_t bloom_filter_create(bloom_filter_t** filter, size_t capacity);
+
+
+/**
+ * Deletes a Bloom filter.
+ *
+ * Args:
+ *  filter: Filter to be deleted.
+ */
+void bloom_filter_delete(bloom_filter_t* filter);
+
+
+/**
+ * Adds a key to the filter.
+ *
+ * Args:
+ *  filter: Filter to update.
+ *  hash_code: Hash of the key, e.g. from hash_string.
+ */
+inline void bloom_filter_add(bloom_filter_t* filter, uint64_t hash_code) {
+  // Remix, since callers' hashes may be weak in some bits. The high half
+  // picks the block and the low half the bit in each word.
+  uint64_t bits = hash_uint64(hash_code);
+  uint64_t* words = filter->blocks[(bits >> 32) & filter->mask].words;
+  for (int i = 0; i < BLOOM_FILTER_BLOCK_WORDS; i++) {
+    words[i] |= (uint64_t)1 << bloom_filter_bit(bits, i);
+  }
+  filter->count++;
+}
+
+
+/**
+ * Checks whether a key may have been added to the filter.
+ *
+ * Args:
+ *  filter: Filter to examine.
+ *  hash_code: Hash of the key.
+ *
+ * Returns:
+ *  false if the key was never added; true if it may have been.
+ */
+inline bool bloom_filter_may_contain(const bloom_filter_t* filter,
+				     uint64_t hash_code) {
+  uint64_t bits = hash_uint64(hash_code);
+  const uint64_t* words = filter->blocks[(bits >> 32) & filter->mask].words;
+  uint64_t missing = 0;
+  for (int i = 0; i < BLOOM_FILTER_BLOCK_WORDS; i++) {
+    missing |= ~words[i] & ((uint64_t)1 << bloom_filter_bit(bits, i));
+  }
+  return !missing;
+}
+
+
+/**
+ * Returns the measured false positive rate of the filter.
+ *
+ * Args:
+ *  filter: Filter to examine.
+ *
+ * Returns:
+ *  Fraction of the recorded lookups of absent keys that the filter let
+ *  through, or 0 if none were recorded.
+ */
+inline double bloom_filter_false_positive_rate(const bloom_filter_t* filter) {
+  size_t absent = filter->negatives + filter->false_positives;
+  return absent ? (double)filter->false_positives / absent : 0;
+}
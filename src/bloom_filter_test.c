@@ -0,0 +1,65 @@
+#include <assert.h>
+#include <stdio.h>
+
+#include "bloom_filter.h"
+#include "hash.h"
+
+
+static void test_bloom_filter_create() {
+  bloom_filter_t* filter;
+  assert(!bloom_filter_create(&filter, 1000));
+  assert(1000 == filter->capacity);
+  assert(!filter->count);
+  // At least 12 bits per key, in whole 512 bit blocks.
+  assert((filter->mask + 1) * 512 >= 12000);
+  assert(!bloom_filter_may_contain(filter, hash_string("a")));
+  assert(0 == bloom_filter_false_positive_rate(filter));
+  bloom_filter_delete(filter);
+
+  assert(!bloom_filter_create(&filter, 0));
+  assert(!filter->mask);
+  bloom_filter_delete(filter);
+}
+
+
+static void test_bloom_filter_add() {
+  bloom_filter_t* filter;
+  assert(!bloom_filter_create(&filter, 10000));
+  char key[32];
+  for (int i = 0; i < 10000; i++) {
+    sprintf(key, "key:%d", i);
+    bloom_filter_add(filter, hash_string(key));
+  }
+  assert(10000 == filter->count);
+  // No false negatives.
+  for (int i = 0; i < 10000; i++) {
+    sprintf(key, "key:%d", i);
+    assert(bloom_filter_may_contain(filter, hash_string(key)));
+  }
+  // Few false positives at capacity.
+  size_t false_positives = 0;
+  for (int i = 0; i < 100000; i++) {
+    sprintf(key, "absent:%d", i);
+    false_positives += bloom_filter_may_contain(filter, hash_string(key));
+  }
+  assert(false_positives < 1000);
+  bloom_filter_delete(filter);
+}
+
+
+static void test_bloom_filter_false_positive_rate() {
+  bloom_filter_t* filter;
+  assert(!bloom_filter_create(&filter, 10));
+  filter->negatives = 90;
+  filter->false_positives = 10;
+  assert(0.1 == bloom_filter_false_positive_rate(filter));
+  bloom_filter_delete(filter);
+}
+
+
+int main(int argc, char** argv) {
+  test_bloom_filter_create();
+  test_bloom_filter_add();
+  test_bloom_filter_false_positive_rate();
+  return 0;
+}
@@ -0,0 +1,536 @@
+#include "btree.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_util.h"
+
+
+// Minimum number of keys in any node but the root. Splitting a full inner
+// node moves its middle key up, leaving one key less for the halves.
+#define BTREE_MIN_KEYS (BTREE_NODE_KEYS / 2)
+#define BTREE_MIN_INNER_KEYS ((BTREE_NODE_KEYS - 1) / 2)
+#define BTREE_CACHE_LINE_SIZE 64
+
+
+// Provide external definitions of inline functions.
+extern inline size_t btree_size(const btree_t* tree);
+extern inline bool btree_iterator_has_current(btree_iterator_t* iter);
+extern inline void btree_iterator_get_current(
+  btree_iterator_t* iter, const char** key, generic_value_t* value);
+extern inline void btree_iterator_next(btree_iterator_t* iter);
+
+
+static uint64_t btree_key_prefix(const char* key) {
+  uint64_t prefix = 0;
+  for (int i = 0; i < 8; i++) {
+    prefix <<= 8;
+    if (*key) {
+      prefix |= (unsigned char)*key++;
+    }
+  }
+  return prefix;
+}
+
+
+// Compares a key with key i of a node, like strcmp.
+static int btree_compare(const btree_node_t* node, size_t i, const char* key,
+			 uint64_t prefix) {
+  if (prefix != node->prefixes[i]) {
+    return prefix < node->prefixes[i] ? -1 : 1;
+  }
+  if (!(prefix & 0xff)) {
+    // Both keys end within the prefix.
+    return 0;
+  }
+  return strcmp(key + 8, node->keys[i] + 8);
+}
+
+
+// Returns the index of the first key of a node not less than key.
+static size_t btree_lower_bound_index(const btree_node_t* node,
+				      const char* key, uint64_t prefix) {
+  size_t low = 0;
+  size_t high = node->count;
+  while (low < high) {
+    size_t middle = (low + high) / 2;
+    if (btree_compare(node, middle, key, prefix) > 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+
+// Returns the index of the first key of a node greater than key, which is
+// also the index of the child of an inner node that may hold key.
+static size_t btree_upper_bound_index(const btree_node_t* node,
+				      const char* key, uint64_t prefix) {
+  size_t low = 0;
+  size_t high = node->count;
+  while (low < high) {
+    size_t middle = (low + high) / 2;
+    if (btree_compare(node, middle, key, prefix) >= 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+
+static btree_node_t* btree_node_create(bool leaf) {
+  size_t size = leaf ? sizeof(btree_leaf_t) : sizeof(btree_inner_t);
+  size = (size + BTREE_CACHE_LINE_SIZE - 1) / BTREE_CACHE_LINE_SIZE *
+    BTREE_CACHE_LINE_SIZE;
+  btree_node_t* node = aligned_alloc(BTREE_CACHE_LINE_SIZE, size);
+  if (!node) {
+    return 0;
+  }
+  memset(node, 0, size);
+  node->leaf = leaf;
+  return node;
+}
+
+
+static void btree_node_delete(btree_t* tree, btree_node_t* node) {
+  for (size_t i = 0; i < node->count; i++) {
+    free(node->keys[i]);
+  }
+  if (node->leaf) {
+    if (tree->value_deallocator) {
+      btree_leaf_t* leaf = (btree_leaf_t*)node;
+      for (size_t i = 0; i < node->count; i++) {
+	tree->value_deallocator(leaf->values[i].p);
+      }
+    }
+  } else {
+    btree_inner_t* inner = (btree_inner_t*)node;
+    for (size_t i = 0; i <= node->count; i++) {
+      btree_node_delete(tree, inner->children[i]);
+    }
+  }
+  free(node);
+}
+
+
+error_t btree_create(btree_t** tree) {
+  return btree_create_with_value_deallocator(tree, 0);
+}
+
+
+error_t btree_create_with_value_deallocator(
+  btree_t** tree, void (*value_deallocator)(void*)) {
+  btree_t* tmp = calloc(1, sizeof(btree_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->root = btree_node_create(true);
+  if (!tmp->root) {
+    free(tmp);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->value_deallocator = value_deallocator;
+  *tree = tmp;
+  return 0;
+}
+
+
+void btree_delete(btree_t* tree) {
+  if (!tree) {
+    return;
+  }
+  btree_node_delete(tree, tree->root);
+  free(tree);
+}
+
+
+// Moves count keys of a node from index from to index to.
+static void btree_move_keys(btree_node_t* node, size_t to, size_t from,
+			    size_t count) {
+  memmove(&node->keys[to], &node->keys[from], count * sizeof(char*));
+  memmove(&node->prefixes[to], &node->prefixes[from],
+	  count * sizeof(uint64_t));
+}
+
+
+// Copies count keys from index from of one node to index to of another.
+static void btree_copy_keys(btree_node_t* dst, size_t to,
+			    const btree_node_t* src, size_t from,
+			    size_t count) {
+  memcpy(&dst->keys[to], &src->keys[from], count * sizeof(char*));
+  memcpy(&dst->prefixes[to], &src->prefixes[from], count * sizeof(uint64_t));
+}
+
+
+static void btree_set_key(btree_node_t* node, size_t i, char* key) {
+  node->keys[i] = key;
+  node->prefixes[i] = btree_key_prefix(key);
+}
+
+
+// Inserts a key and the child to its right into an inner node.
+static void btree_inner_insert(btree_inner_t* inner, size_t i, char* key,
+			       btree_node_t* child) {
+  btree_node_t* node = &inner->node;
+  btree_move_keys(node, i + 1, i, node->count - i);
+  memmove(&inner->children[i + 2], &inner->children[i + 1],
+	  (node->count - i) * sizeof(btree_node_t*));
+  btree_set_key(node, i, key);
+  inner->children[i + 1] = child;
+  node->count++;
+}
+
+
+// Removes key i and the child to its right from an inner node.
+static void btree_inner_erase(btree_inner_t* inner, size_t i) {
+  btree_node_t* node = &inner->node;
+  btree_move_keys(node, i, i + 1, node->count - i - 1);
+  memmove(&inner->children[i + 1], &inner->children[i + 2],
+	  (node->count - i - 1) * sizeof(btree_node_t*));
+  node->count--;
+}
+
+
+// Splits the full child i of an inner node in two.
+static error_t btree_split_child(btree_inner_t* parent, size_t i) {
+  btree_node_t* child = parent->children[i];
+  btree_node_t* right = btree_node_create(child->leaf);
+  if (!right) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  char* separator;
+  if (child->leaf) {
+    // The right half keeps all its keys; the parent gets a copy of the
+    // first one.
+    size_t count = child->count - BTREE_MIN_KEYS;
+    if (string_copy(child->keys[BTREE_MIN_KEYS], &separator)) {
+      free(right);
+      return ERROR_OUT_OF_MEMORY;
+    }
+    btree_leaf_t* left_leaf = (btree_leaf_t*)child;
+    btree_leaf_t* right_leaf = (btree_leaf_t*)right;
+    btree_copy_keys(right, 0, child, BTREE_MIN_KEYS, count);
+    memcpy(right_leaf->values, &left_leaf->values[BTREE_MIN_KEYS],
+	   count * sizeof(generic_value_t));
+    right->count = count;
+    right_leaf->next = left_leaf->next;
+    left_leaf->next = right_leaf;
+  } else {
+    // The middle key moves up to the parent.
+    size_t count = child->count - BTREE_MIN_KEYS - 1;
+    separator = child->keys[BTREE_MIN_KEYS];
+    btree_copy_keys(right, 0, child, BTREE_MIN_KEYS + 1, count);
+    memcpy(((btree_inner_t*)right)->children,
+	   &((btree_inner_t*)child)->children[BTREE_MIN_KEYS + 1],
+	   (count + 1) * sizeof(btree_node_t*));
+    right->count = count;
+  }
+  child->count = BTREE_MIN_KEYS;
+  btree_inner_insert(parent, i, separator, right);
+  return 0;
+}
+
+
+// Finds the leaf and index of the first key not less than key.
+static btree_leaf_t* btree_find(btree_t* tree, const char* key,
+				uint64_t prefix, size_t* index) {
+  btree_node_t* node = tree->root;
+  while (!node->leaf) {
+    node = ((btree_inner_t*)node)->children[
+      btree_upper_bound_index(node, key, prefix)];
+  }
+  *index = btree_lower_bound_index(node, key, prefix);
+  return (btree_leaf_t*)node;
+}
+
+
+error_t btree_insert(btree_t* tree, const char* key, generic_value_t value) {
+  uint64_t prefix = btree_key_prefix(key);
+  size_t index;
+  btree_leaf_t* leaf = btree_find(tree, key, prefix, &index);
+  if (index < leaf->node.count &&
+      !btree_compare(&leaf->node, index, key, prefix)) {
+    leaf->values[index] = value;
+    return 0;
+  }
+
+  char* copy;
+  if (string_copy(key, &copy)) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  if (tree->root->count == BTREE_NODE_KEYS) {
+    btree_inner_t* root = (btree_inner_t*)btree_node_create(false);
+    if (!root) {
+      free(copy);
+      return ERROR_OUT_OF_MEMORY;
+    }
+    root->children[0] = tree->root;
+    if (btree_split_child(root, 0)) {
+      free(root);
+      free(copy);
+      return ERROR_OUT_OF_MEMORY;
+    }
+    tree->root = &root->node;
+  }
+
+  // Split full nodes on the way down so there is always room for a key
+  // coming up from below.
+  btree_node_t* node = tree->root;
+  while (!node->leaf) {
+    btree_inner_t* inner = (btree_inner_t*)node;
+    size_t i = btree_upper_bound_index(node, key, prefix);
+    if (inner->children[i]->count == BTREE_NODE_KEYS) {
+      if (btree_split_child(inner, i)) {
+	free(copy);
+	return ERROR_OUT_OF_MEMORY;
+      }
+      if (btree_compare(node, i, key, prefix) >= 0) {
+	i++;
+      }
+    }
+    node = inner->children[i];
+  }
+
+  leaf = (btree_leaf_t*)node;
+  index = btree_lower_bound_index(node, key, prefix);
+  btree_move_keys(node, index + 1, index, node->count - index);
+  memmove(&leaf->values[index + 1], &leaf->values[index],
+	  (node->count - index) * sizeof(generic_value_t));
+  node->keys[index] = copy;
+  node->prefixes[index] = prefix;
+  leaf->values[index] = value;
+  node->count++;
+  tree->size++;
+  return 0;
+}
+
+
+bool btree_get(btree_t* tree, const char* key, generic_value_t* value) {
+  uint64_t prefix = btree_key_prefix(key);
+  size_t index;
+  btree_leaf_t* leaf = btree_find(tree, key, prefix, &index);
+  if (index < leaf->node.count &&
+      !btree_compare(&leaf->node, index, key, prefix)) {
+    *value = leaf->values[index];
+    return true;
+  }
+  return false;
+}
+
+
+// Moves the last key of the left sibling of child i into it.
+static error_t btree_borrow_from_left(btree_inner_t* parent, size_t i) {
+  btree_node_t* child = parent->children[i];
+  btree_node_t* left = parent->children[i - 1];
+  if (child->leaf) {
+    char* separator;
+    if (string_copy(left->keys[left->count - 1], &separator)) {
+      return ERROR_OUT_OF_MEMORY;
+    }
+    btree_leaf_t* child_leaf = (btree_leaf_t*)child;
+    btree_move_keys(child, 1, 0, child->count);
+    memmove(&child_leaf->values[1], &child_leaf->values[0],
+	    child->count * sizeof(generic_value_t));
+    btree_copy_keys(child, 0, left, left->count - 1, 1);
+    child_leaf->values[0] = ((btree_leaf_t*)left)->values[left->count - 1];
+    free(parent->node.keys[i - 1]);
+    btree_set_key(&parent->node, i - 1, separator);
+  } else {
+    // Rotate through the parent.
+    btree_inner_t* child_inner = (btree_inner_t*)child;
+    btree_move_keys(child, 1, 0, child->count);
+    memmove(&child_inner->children[1], &child_inner->children[0],
+	    (child->count + 1) * sizeof(btree_node_t*));
+    btree_copy_keys(child, 0, &parent->node, i - 1, 1);
+    child_inner->children[0] = ((btree_inner_t*)left)->children[left->count];
+    btree_copy_keys(&parent->node, i - 1, left, left->count - 1, 1);
+  }
+  left->count--;
+  child->count++;
+  return 0;
+}
+
+
+// Moves the first key of the right sibling of child i into it.
+static error_t btree_borrow_from_right(btree_inner_t* parent, size_t i) {
+  btree_node_t* child = parent->children[i];
+  btree_node_t* right = parent->children[i + 1];
+  if (child->leaf) {
+    char* separator;
+    if (string_copy(right->keys[1], &separator)) {
+      return ERROR_OUT_OF_MEMORY;
+    }
+    btree_leaf_t* right_leaf = (btree_leaf_t*)right;
+    btree_copy_keys(child, child->count, right, 0, 1);
+    ((btree_leaf_t*)child)->values[child->count] = right_leaf->values[0];
+    btree_move_keys(right, 0, 1, right->count - 1);
+    memmove(&right_leaf->values[0], &right_leaf->values[1],
+	    (right->count - 1) * sizeof(generic_value_t));
+    free(parent->node.keys[i]);
+    btree_set_key(&parent->node, i, separator);
+  } else {
+    // Rotate through the parent.
+    btree_inner_t* right_inner = (btree_inner_t*)right;
+    btree_copy_keys(child, child->count, &parent->node, i, 1);
+    ((btree_inner_t*)child)->children[child->count + 1] =
+      right_inner->children[0];
+    btree_copy_keys(&parent->node, i, right, 0, 1);
+    btree_move_keys(right, 0, 1, right->count - 1);
+    memmove(&right_inner->children[0], &right_inner->children[1],
+	    right->count * sizeof(btree_node_t*));
+  }
+  right->count--;
+  child->count++;
+  return 0;
+}
+
+
+// Merges child i + 1 of an inner node into child i.
+static void btree_merge(btree_inner_t* parent, size_t i) {
+  btree_node_t* left = parent->children[i];
+  btree_node_t* right = parent->children[i + 1];
+  if (left->leaf) {
+    btree_leaf_t* left_leaf = (btree_leaf_t*)left;
+    btree_leaf_t* right_leaf = (btree_leaf_t*)right;
+    btree_copy_keys(left, left->count, right, 0, right->count);
+    memcpy(&left_leaf->values[left->count], right_leaf->values,
+	   right->count * sizeof(generic_value_t));
+    left_leaf->next = right_leaf->next;
+    free(parent->node.keys[i]);
+  } else {
+    // The separator moves down between the two halves.
+    btree_copy_keys(left, left->count, &parent->node, i, 1);
+    left->count++;
+    btree_copy_keys(left, left->count, right, 0, right->count);
+    memcpy(&((btree_inner_t*)left)->children[left->count],
+	   ((btree_inner_t*)right)->children,
+	   (right->count + 1) * sizeof(btree_node_t*));
+  }
+  left->count += right->count;
+  btree_inner_erase(parent, i);
+  free(right);
+}
+
+
+static size_t btree_min_keys(const btree_node_t* node) {
+  return node->leaf ? BTREE_MIN_KEYS : BTREE_MIN_INNER_KEYS;
+}
+
+
+// Restores the minimum size of child i of an inner node.
+static void btree_rebalance(btree_inner_t* parent, size_t i) {
+  btree_node_t* child = parent->children[i];
+  btree_node_t* left = i > 0 ? parent->children[i - 1] : 0;
+  btree_node_t* right =
+    i < parent->node.count ? parent->children[i + 1] : 0;
+  size_t min_keys = btree_min_keys(child);
+  if (left && left->count > min_keys) {
+    if (!btree_borrow_from_left(parent, i)) {
+      return;
+    }
+  } else if (right && right->count > min_keys) {
+    if (!btree_borrow_from_right(parent, i)) {
+      return;
+    }
+  }
+  // Merge if the nodes fit together. This only fails when borrowing a
+  // leaf key could not allocate its new separator, in which case the
+  // child is left short of keys (but never empty) until a later removal.
+  size_t extra = child->leaf ? 0 : 1;
+  if (left && left->count + child->count + extra <= BTREE_NODE_KEYS) {
+    btree_merge(parent, i - 1);
+  } else if (right &&
+	     child->count + right->count + extra <= BTREE_NODE_KEYS) {
+    btree_merge(parent, i);
+  }
+}
+
+
+static bool btree_remove_from(btree_node_t* node, const char* key,
+			      uint64_t prefix, generic_value_t* value) {
+  if (node->leaf) {
+    size_t i = btree_lower_bound_index(node, key, prefix);
+    if (i == node->count || btree_compare(node, i, key, prefix)) {
+      return false;
+    }
+    btree_leaf_t* leaf = (btree_leaf_t*)node;
+    *value = leaf->values[i];
+    free(node->keys[i]);
+    btree_move_keys(node, i, i + 1, node->count - i - 1);
+    memmove(&leaf->values[i], &leaf->values[i + 1],
+	    (node->count - i - 1) * sizeof(generic_value_t));
+    node->count--;
+    return true;
+  }
+
+  btree_inner_t* inner = (btree_inner_t*)node;
+  size_t i = btree_upper_bound_index(node, key, prefix);
+  if (!btree_remove_from(inner->children[i], key, prefix, value)) {
+    return false;
+  }
+  if (inner->children[i]->count < btree_min_keys(inner->children[i])) {
+    btree_rebalance(inner, i);
+  }
+  return true;
+}
+
+
+bool btree_remove(btree_t* tree, const char* key, generic_value_t* value) {
+  if (!btree_remove_from(tree->root, key, btree_key_prefix(key), value)) {
+    return false;
+  }
+  tree->size--;
+  if (!tree->root->leaf && !tree->root->count) {
+    // The root's children were merged; the tree gets shorter.
+    btree_node_t* root = tree->root;
+    tree->root = ((btree_inner_t*)root)->children[0];
+    free(root);
+  }
+  return true;
+}
+
+
+btree_iterator_t btree_iterator_create(btree_t* tree) {
+  btree_node_t* node = tree->root;
+  while (!node->leaf) {
+    node = ((btree_inner_t*)node)->children[0];
+  }
+  btree_iterator_t iter = {(btree_leaf_t*)node, 0};
+  if (!node->count) {
+    iter.leaf = 0;
+  }
+  return iter;
+}
+
+
+btree_iterator_t btree_lower_bound(btree_t* tree, const char* key) {
+  btree_iterator_t iter = {0};
+  iter.leaf = btree_find(tree, key, btree_key_prefix(key), &iter.index);
+  if (iter.index == iter.leaf->node.count) {
+    // The key is past the end of the leaf; only the root leaf can be
+    // empty, so the next leaf (if any) has a first key.
+    iter.leaf = iter.leaf->next;
+    iter.index = 0;
+  }
+  return iter;
+}
+
+
+btree_iterator_t btree_range(btree_t* tree, const char* start,
+			     const char* end) {
+  btree_iterator_t iter = btree_lower_bound(tree, start);
+  iter.end = end;
+  return iter;
+}
+
+
+btree_iterator_t btree_prefix(btree_t* tree, const char* prefix) {
+  btree_iterator_t iter = btree_lower_bound(tree, prefix);
+  iter.prefix = prefix;
+  iter.prefix_length = strlen(prefix);
+  return iter;
+}
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "errors.h"
+#include "generic.h"
+
+
+// Maximum number of keys per node. The key prefixes searched first fill
+// exactly two cache lines.
+#define BTREE_NODE_KEYS 16
+
+typedef struct {
+  // First 8 bytes of each key, big-endian and zero padded, so that most
+  // comparisons are integer compares within the node.
+  uint64_t prefixes[BTREE_NODE_KEYS];
+  char* keys[BTREE_NODE_KEYS];
+  uint32_t count;
+  bool leaf;
+} btree_node_t;
+
+typedef struct {
+  btree_node_t node;
+  // Child i holds the keys less than keys[i] and not less than keys[i - 1].
+  btree_node_t* children[BTREE_NODE_KEYS + 1];
+} btree_inner_t;
+
+typedef struct btree_leaf_t {
+  btree_node_t node;
+  generic_value_t values[BTREE_NODE_KEYS];
+  // Next leaf in key order.
+  struct btree_leaf_t* next;
+} btree_leaf_t;
+
+typedef struct {
+  void (*value_deallocator)(void*);
+  size_t size;
+  btree_node_t* root;
+} btree_t;
+
+typedef struct {
+  btree_leaf_t* leaf;
+  size_t index;
+  // Iteration stops at the first key not less than end, if set.
+  const char* end;
+  // Iteration stops at the first key not starting with prefix, if set.
+  const char* prefix;
+  size_t prefix_length;
+} btree_iterator_t;
+
+
+/**
+ * Creates a new B+ tree.
+ *
+ * The tree maps strings to values in strcmp order. Values live in leaves
+ * chained in key order, so range and prefix scans walk consecutive leaves.
+ *
+ * Args:
+ *  tree: Set to the newly allocated tree.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create tree because of memory error.
+ */
+error_t btree_create(btree_t** tree);
+
+
+/**
+ * Creates a new B+ tree with a value deallocator.
+ *
+ * The deallocation function is used to delete void* values
+ * (generic_value_t.p) when btree_delete is called.
+ *
+ * Args:
+ *  tree: Set to the newly allocated tree.
+ *  deallocated: Function used to delete values.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create tree because of memory error.
+ */
+error_t btree_create_with_value_deallocator(
+  btree_t** tree, void (*value_deallocator)(void*));
+
+
+/**
+ * Deletes a B+ tree.
+ *
+ * If a deallocation function was provided during creation, tree values
+ * will be treated as void* (generic_value_t.p) and sent to the function.
+ *
+ * Args:
+ *  tree: Tree to be deleted.
+ */
+void btree_delete(btree_t* tree);
+
+
+/**
+ * Inserts a key and value into the tree.
+ *
+ * If the key already exists in the tree, the value is updated.
+ *
+ * Args:
+ *  tree: Tree to update.
+ *  key: Key for tree entry.
+ *  value: Value for tree entry.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not insert into tree because of memory errors.
+ */
+error_t btree_insert(btree_t* tree, const char* key, generic_value_t value);
+
+
+/**
+ * Gets a value from the tree.
+ *
+ * Args:
+ *  tree: The tree to examine.
+ *  key: The key to look up.
+ *  value: Set to any value found.
+ *
+ * Returns:
+ *  true if the value is found.
+ */
+bool btree_get(btree_t* tree, const char* key, generic_value_t* value);
+
+
+/**
+ * Removes a key and value from the tree.
+ *
+ * Args:
+ *  tree: The tree to examine.
+ *  key: The key to look up.
+ *  value: Set to any value found.
+ *
+ * Returns:
+ *  true if the value is found.
+ */
+bool btree_remove(btree_t* tree, const char* key, generic_value_t* value);
+
+
+/**
+ * Returns the size of the tree.
+ *
+ * Args:
+ *  tree: The tree to examine.
+ *
+ * Returns:
+ *  Size of the tree.
+ */
+inline size_t btree_size(const btree_t* tree) { return tree->size; }
+
+
+/**
+ * Creates an iterator over the whole tree, in key order.
+ *
+ * Iterators are invalidated by any change to the tree.
+ *
+ * Args:
+ *  tree: Tree to create iterator for.
+ *
+ * Returns:
+ *  Iterator for the given tree.
+ */
+btree_iterator_t btree_iterator_create(btree_t* tree);
+
+
+/**
+ * Creates an iterator starting at the first key not less than a key.
+ *
+ * Args:
+ *  tree: Tree to create iterator for.
+ *  key: Key to start from.
+ *
+ * Returns:
+ *  Iterator over the keys from the given key to the end of the tree.
+ */
+btree_iterator_t btree_lower_bound(btree_t* tree, const char* key);
+
+
+/**
+ * Creates an iterator over the keys in [start, end).
+ *
+ * Args:
+ *  tree: Tree to create iterator for.
+ *  start: First key of the range.
+ *  end: Key ending the range (not owned by the iterator and must remain
+ *   valid while it is used).
+ *
+ * Returns:
+ *  Iterator over the keys in the range.
+ */
+btree_iterator_t btree_range(btree_t* tree, const char* start,
+			     const char* end);
+
+
+/**
+ * Creates an iterator over the keys starting with a prefix.
+ *
+ * Args:
+ *  tree: Tree to create iterator for.
+ *  prefix: Prefix of the keys (not owned by the iterator and must remain
+ *   valid while it is used).
+ *
+ * Returns:
+ *  Iterator over the keys with the given prefix.
+ */
+btree_iterator_t btree_prefix(btree_t* tree, const char* prefix);
+
+
+/**
+ * Returns true if the iterator has a current element.
+ *
+ * If this function returns true, it is safe to call
+ * btree_iterator_get_current and btree_iterator_next.
+ *
+ * Args:
+ *  iter: Iterator to examine
+ *
+ * Returns:
+ *  true if the iterator has a current element.
+ */
+inline bool btree_iterator_has_current(btree_iterator_t* iter) {
+  if (!iter->leaf) {
+    return false;
+  }
+  const char* key = iter->leaf->node.keys[iter->index];
+  if (iter->end && strcmp(key, iter->end) >= 0) {
+    return false;
+  }
+  return !iter->prefix ||
+    !strncmp(key, iter->prefix, iter->prefix_length);
+}
+
+
+/**
+ * Gets the current element for the iterator.
+ *
+ * This call should be proceeded by a successful call to
+ * btree_iterator_has_current.
+ *
+ * Args:
+ *  iter: Iterator to examine.
+ *  key: Set to the key for the current element (owned by tree and only
+ *   valid while tree has not been modified).
+ *  value: Set to the value for the current element.
+ */
+inline void btree_iterator_get_current(
+  btree_iterator_t* iter, const char** key, generic_value_t* value) {
+  *key = iter->leaf->node.keys[iter->index];
+  *value = iter->leaf->values[iter->index];
+}
+
+
+/**
+ * Moves the iterator to the next value.
+ *
+ * This call should be proceeded by a successful call to
+ * btree_iterator_has_current.
+ *
+ * Args:
+ *  iter: Iterator to update.
+ */
+inline void btree_iterator_next(btree_iterator_t* iter) {
+  if (++iter->index == iter->leaf->node.count) {
+    iter->leaf = iter->leaf->next;
+    iter->index = 0;
+  }
+}
@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "btree.h"
+#include "map.h"
+
+
+#define BENCH_KEYS 100000
+#define BENCH_GETS 1000000
+// map_t has a fixed number of buckets, so its lookups are much slower at
+// this size; time fewer of them.
+#define BENCH_MAP_GETS 10000
+#define BENCH_USERS 1000
+#define BENCH_PREFIX_SCANS 1000
+
+
+static char bench_keys[BENCH_KEYS][24];
+static const char* bench_sorted[BENCH_KEYS];
+
+
+static int bench_compare(const void* a, const void* b) {
+  return strcmp(*(const char**)a, *(const char**)b);
+}
+
+
+// Returns the index of the first sorted key not less than key.
+static size_t bench_sorted_lower_bound(const char* key) {
+  size_t low = 0;
+  size_t high = BENCH_KEYS;
+  while (low < high) {
+    size_t middle = (low + high) / 2;
+    if (strcmp(bench_sorted[middle], key) < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+
+static void bench_gets(btree_t* tree, map_t* map) {
+  uint64_t seed = 1;
+  uint64_t sum = 0;
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < BENCH_GETS; i++) {
+    generic_value_t value;
+    if (btree_get(tree, bench_keys[bench_random(&seed) % BENCH_KEYS],
+		  &value)) {
+      sum += value.ui64;
+    }
+  }
+  bench_report("btree_get", BENCH_GETS, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_GETS; i++) {
+    const char* key = bench_keys[bench_random(&seed) % BENCH_KEYS];
+    size_t index = bench_sorted_lower_bound(key);
+    if (index < BENCH_KEYS && !strcmp(bench_sorted[index], key)) {
+      sum += index;
+    }
+  }
+  bench_report("sorted_array_get", BENCH_GETS, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_MAP_GETS; i++) {
+    generic_value_t value;
+    if (map_get(map, bench_keys[bench_random(&seed) % BENCH_KEYS], &value)) {
+      sum += value.ui64;
+    }
+  }
+  bench_report("map_get", BENCH_MAP_GETS, bench_now_ns() - start);
+  bench_use(sum);
+}
+
+
+static void bench_prefix_scans(btree_t* tree, map_t* map) {
+  uint64_t seed = 2;
+  uint64_t sum = 0;
+  char prefix[24];
+  size_t visited = 0;
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < BENCH_PREFIX_SCANS; i++) {
+    snprintf(prefix, sizeof(prefix), "user:%lu:",
+	     (unsigned long)(bench_random(&seed) % BENCH_USERS));
+    for (btree_iterator_t iter = btree_prefix(tree, prefix);
+	 btree_iterator_has_current(&iter); btree_iterator_next(&iter)) {
+      const char* key;
+      generic_value_t value;
+      btree_iterator_get_current(&iter, &key, &value);
+      sum += value.ui64;
+      visited++;
+    }
+  }
+  bench_report("btree_prefix_scan", BENCH_PREFIX_SCANS,
+	       bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_PREFIX_SCANS; i++) {
+    snprintf(prefix, sizeof(prefix), "user:%lu:",
+	     (unsigned long)(bench_random(&seed) % BENCH_USERS));
+    size_t length = strlen(prefix);
+    for (size_t index = bench_sorted_lower_bound(prefix);
+	 index < BENCH_KEYS && !strncmp(bench_sorted[index], prefix, length);
+	 index++) {
+      sum += index;
+    }
+  }
+  bench_report("sorted_array_prefix_scan", BENCH_PREFIX_SCANS,
+	       bench_now_ns() - start);
+
+  // Without ordering, a prefix query has to visit every key.
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_PREFIX_SCANS / 100; i++) {
+    snprintf(prefix, sizeof(prefix), "user:%lu:",
+	     (unsigned long)(bench_random(&seed) % BENCH_USERS));
+    size_t length = strlen(prefix);
+    for (map_iterator_t iter = map_iterator_create(map);
+	 map_iterator_has_current(&iter); map_iterator_next(&iter)) {
+      const char* key;
+      generic_value_t value;
+      map_iterator_get_current(&iter, &key, &value);
+      if (!strncmp(key, prefix, length)) {
+	sum += value.ui64;
+      }
+    }
+  }
+  bench_report("map_prefix_scan", BENCH_PREFIX_SCANS / 100,
+	       bench_now_ns() - start);
+  bench_use(sum + visited);
+}
+
+
+int main(int argc, char** argv) {
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    snprintf(bench_keys[i], sizeof(bench_keys[i]), "user:%d:%d",
+	     i % BENCH_USERS, i / BENCH_USERS);
+    bench_sorted[i] = bench_keys[i];
+  }
+  btree_t* tree;
+  map_t* map;
+  if (btree_create(&tree) || map_create(&map)) {
+    abort();
+  }
+
+  // Insert in a scattered order.
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_KEYS; i++) {
+    uint64_t k = i * 7919 % BENCH_KEYS;
+    if (btree_insert(tree, bench_keys[k], (generic_value_t)k)) {
+      abort();
+    }
+  }
+  bench_report("btree_insert", BENCH_KEYS, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  qsort(bench_sorted, BENCH_KEYS, sizeof(char*), bench_compare);
+  bench_report("sorted_array_build", BENCH_KEYS, bench_now_ns() - start);
+
+  for (uint64_t i = 0; i < BENCH_KEYS; i++) {
+    if (map_insert(map, bench_keys[i], (generic_value_t)i)) {
+      abort();
+    }
+  }
+
+  bench_gets(tree, map);
+  bench_prefix_scans(tree, map);
+  btree_delete(tree);
+  map_delete(map);
+  return 0;
+}
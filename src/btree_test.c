@@ -0,0 +1,284 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btree.h"
+
+
+// Checks the node invariants of a subtree, returning its height and
+// number of keys. Keys must lie in [low, high) where given.
+static size_t check_node(btree_t* tree, btree_node_t* node, const char* low,
+			 const char* high, size_t* size) {
+  if (node != tree->root) {
+    assert(node->count >= (node->leaf ? BTREE_NODE_KEYS / 2
+			   : (BTREE_NODE_KEYS - 1) / 2));
+  }
+  assert(node->count <= BTREE_NODE_KEYS);
+  for (size_t i = 0; i < node->count; i++) {
+    if (i > 0) {
+      assert(strcmp(node->keys[i - 1], node->keys[i]) < 0);
+    }
+    assert(!low || strcmp(low, node->keys[i]) <= 0);
+    assert(!high || strcmp(node->keys[i], high) < 0);
+  }
+  if (node->leaf) {
+    *size += node->count;
+    return 1;
+  }
+  btree_inner_t* inner = (btree_inner_t*)node;
+  size_t height = 0;
+  for (size_t i = 0; i <= node->count; i++) {
+    size_t child_height = check_node(
+      tree, inner->children[i], i > 0 ? node->keys[i - 1] : low,
+      i < node->count ? node->keys[i] : high, size);
+    assert(!height || height == child_height);
+    height = child_height;
+  }
+  return height + 1;
+}
+
+
+static void check_tree(btree_t* tree) {
+  size_t size = 0;
+  check_node(tree, tree->root, 0, 0, &size);
+  assert(size == btree_size(tree));
+  // The leaf chain visits every key in order.
+  size_t count = 0;
+  const char* previous = 0;
+  for (btree_iterator_t iter = btree_iterator_create(tree);
+       btree_iterator_has_current(&iter); btree_iterator_next(&iter)) {
+    const char* key;
+    generic_value_t value;
+    btree_iterator_get_current(&iter, &key, &value);
+    assert(!previous || strcmp(previous, key) < 0);
+    previous = key;
+    count++;
+  }
+  assert(count == size);
+}
+
+
+static void test_btree_create() {
+  btree_t* tree;
+  assert(!btree_create(&tree));
+  assert(!btree_size(tree));
+  btree_iterator_t iter = btree_iterator_create(tree);
+  assert(!btree_iterator_has_current(&iter));
+  iter = btree_lower_bound(tree, "a");
+  assert(!btree_iterator_has_current(&iter));
+  btree_delete(tree);
+}
+
+
+static void test_btree_insert_get() {
+  btree_t* tree;
+  assert(!btree_create(&tree));
+  char key[32];
+  for (uint64_t i = 0; i < 1000; i++) {
+    sprintf(key, "key:%lu", (unsigned long)(i * 7919 % 1000));
+    assert(!btree_insert(tree, key, (generic_value_t)(i * 7919 % 1000)));
+  }
+  assert(1000 == btree_size(tree));
+  check_tree(tree);
+  for (uint64_t i = 0; i < 1000; i++) {
+    generic_value_t value;
+    sprintf(key, "key:%lu", (unsigned long)i);
+    assert(btree_get(tree, key, &value));
+    assert(i == value.ui64);
+  }
+  generic_value_t value;
+  assert(!btree_get(tree, "key:1000", &value));
+  assert(!btree_get(tree, "", &value));
+
+  // Inserting an existing key updates its value.
+  assert(!btree_insert(tree, "key:5", (generic_value_t)(uint64_t)12345));
+  assert(1000 == btree_size(tree));
+  assert(btree_get(tree, "key:5", &value));
+  assert(12345 == value.ui64);
+  btree_delete(tree);
+}
+
+
+static void test_btree_short_and_long_keys() {
+  btree_t* tree;
+  assert(!btree_create(&tree));
+  // Keys sharing the 8 byte prefix, or shorter than it.
+  const char* keys[] = {
+    "", "a", "ab", "abcdefg", "abcdefgh", "abcdefgh0", "abcdefgh1",
+    "abcdefgh10", "abcdefghi", "b", "\xff"
+  };
+  size_t count = sizeof(keys) / sizeof(keys[0]);
+  for (size_t i = count; i-- > 0;) {
+    assert(!btree_insert(tree, keys[i], (generic_value_t)(uint64_t)i));
+  }
+  check_tree(tree);
+  size_t i = 0;
+  for (btree_iterator_t iter = btree_iterator_create(tree);
+       btree_iterator_has_current(&iter); btree_iterator_next(&iter), i++) {
+    const char* key;
+    generic_value_t value;
+    btree_iterator_get_current(&iter, &key, &value);
+    assert(!strcmp(keys[i], key));
+    assert(i == value.ui64);
+  }
+  assert(count == i);
+  btree_delete(tree);
+}
+
+
+static void test_btree_remove() {
+  btree_t* tree;
+  assert(!btree_create(&tree));
+  char key[32];
+  for (uint64_t i = 0; i < 2000; i++) {
+    sprintf(key, "%05lu", (unsigned long)i);
+    assert(!btree_insert(tree, key, (generic_value_t)i));
+  }
+  generic_value_t value;
+  assert(!btree_remove(tree, "missing", &value));
+  // Remove in a scattered order, checking the structure as it shrinks.
+  for (uint64_t i = 0; i < 2000; i++) {
+    uint64_t k = i * 1237 % 2000;
+    sprintf(key, "%05lu", (unsigned long)k);
+    assert(btree_remove(tree, key, &value));
+    assert(k == value.ui64);
+    assert(!btree_remove(tree, key, &value));
+    assert(2000 - i - 1 == btree_size(tree));
+    if (i % 97 == 0) {
+      check_tree(tree);
+    }
+  }
+  check_tree(tree);
+  assert(tree->root->leaf);
+
+  // The tree is usable again after being emptied.
+  assert(!btree_insert(tree, "a", (generic_value_t)(uint64_t)1));
+  assert(btree_get(tree, "a", &value));
+  btree_delete(tree);
+}
+
+
+static void test_btree_random() {
+  btree_t* tree;
+  assert(!btree_create(&tree));
+  bool present[500] = {0};
+  char key[32];
+  srand(2);
+  for (int i = 0; i < 20000; i++) {
+    int k = rand() % 500;
+    sprintf(key, "k%d", k);
+    generic_value_t value;
+    if (rand() % 2) {
+      assert(!btree_insert(tree, key, (generic_value_t)(uint64_t)k));
+      present[k] = true;
+    } else {
+      assert(present[k] == btree_remove(tree, key, &value));
+      present[k] = false;
+    }
+  }
+  check_tree(tree);
+  for (int k = 0; k < 500; k++) {
+    generic_value_t value;
+    sprintf(key, "k%d", k);
+    assert(present[k] == btree_get(tree, key, &value));
+  }
+  btree_delete(tree);
+}
+
+
+static void test_btree_lower_bound_and_range() {
+  btree_t* tree;
+  assert(!btree_create(&tree));
+  char key[32];
+  for (uint64_t i = 0; i < 1000; i += 2) {
+    sprintf(key, "%04lu", (unsigned long)i);
+    assert(!btree_insert(tree, key, (generic_value_t)i));
+  }
+  const char* found;
+  generic_value_t value;
+  btree_iterator_t iter = btree_lower_bound(tree, "0101");
+  assert(btree_iterator_has_current(&iter));
+  btree_iterator_get_current(&iter, &found, &value);
+  assert(!strcmp("0102", found));
+  iter = btree_lower_bound(tree, "0102");
+  btree_iterator_get_current(&iter, &found, &value);
+  assert(102 == value.ui64);
+  iter = btree_lower_bound(tree, "0999");
+  assert(!btree_iterator_has_current(&iter));
+
+  uint64_t expected = 100;
+  for (iter = btree_range(tree, "0099", "0200");
+       btree_iterator_has_current(&iter); btree_iterator_next(&iter)) {
+    btree_iterator_get_current(&iter, &found, &value);
+    assert(expected == value.ui64);
+    expected += 2;
+  }
+  assert(200 == expected);
+  iter = btree_range(tree, "0300", "0300");
+  assert(!btree_iterator_has_current(&iter));
+  btree_delete(tree);
+}
+
+
+static void test_btree_prefix() {
+  btree_t* tree;
+  assert(!btree_create(&tree));
+  char key[32];
+  for (uint64_t user = 0; user < 50; user++) {
+    for (uint64_t item = 0; item < 20; item++) {
+      sprintf(key, "user:%lu:%lu", (unsigned long)user, (unsigned long)item);
+      assert(!btree_insert(tree, key, (generic_value_t)(user * 100 + item)));
+    }
+  }
+  size_t count = 0;
+  for (btree_iterator_t iter = btree_prefix(tree, "user:12:");
+       btree_iterator_has_current(&iter); btree_iterator_next(&iter)) {
+    const char* found;
+    generic_value_t value;
+    btree_iterator_get_current(&iter, &found, &value);
+    assert(!strncmp("user:12:", found, 8));
+    assert(12 == value.ui64 / 100);
+    count++;
+  }
+  assert(20 == count);
+
+  // "user:1" also covers users 10-19.
+  count = 0;
+  for (btree_iterator_t iter = btree_prefix(tree, "user:1");
+       btree_iterator_has_current(&iter); btree_iterator_next(&iter)) {
+    count++;
+  }
+  assert(220 == count);
+  btree_iterator_t iter = btree_prefix(tree, "user:50:");
+  assert(!btree_iterator_has_current(&iter));
+  btree_delete(tree);
+}
+
+
+static void test_btree_value_deallocator() {
+  btree_t* tree;
+  assert(!btree_create_with_value_deallocator(&tree, free));
+  char key[32];
+  for (int i = 0; i < 100; i++) {
+    sprintf(key, "%d", i);
+    assert(!btree_insert(tree, key, (generic_value_t)malloc(10)));
+  }
+  generic_value_t value;
+  assert(btree_remove(tree, "50", &value));
+  free(value.p);
+  btree_delete(tree);
+}
+
+
+int main(int argc, char** argv) {
+  test_btree_create();
+  test_btree_insert_get();
+  test_btree_short_and_long_keys();
+  test_btree_remove();
+  test_btree_random();
+  test_btree_lower_bound_and_range();
+  test_btree_prefix();
+  test_btree_value_deallocator();
+  return 0;
+}
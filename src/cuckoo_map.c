@@ -0,0 +1,388 @@
+#include "cuckoo_map.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+#include "string_util.h"
+
+
+static const size_t INITIAL_BUCKET_COUNT = 4;
+// Keys displaced by an insert before the last one is stashed.
+static const int MAX_DISPLACEMENTS = 256;
+// Share of the ways cuckoo_map_reserve expects to fill; inserts rarely
+// need the stash below it.
+static const double RESERVE_LOAD_FACTOR = 0.9;
+
+_Static_assert(sizeof(cuckoo_map_bucket_t) == 64,
+	       "buckets should fill one cache line");
+_Static_assert(offsetof(cuckoo_map_t, stash) <= 64,
+	       "lookup fields should fit in the map's first cache line");
+
+
+// Provide external definitions of inline functions.
+extern inline size_t cuckoo_map_size(const cuckoo_map_t* map);
+extern inline bool cuckoo_map_iterator_has_current(
+  cuckoo_map_iterator_t* iter);
+extern inline void cuckoo_map_iterator_get_current(
+  cuckoo_map_iterator_t* iter, const char** key, generic_value_t* value);
+
+
+// Returns the other bucket of a key with the given tag stored in bucket.
+// Both buckets are found from either one and the tag, so displaced keys
+// never need rehashing. The odd mask keeps the two buckets distinct.
+static size_t cuckoo_map_other_bucket(
+  const cuckoo_map_t* map, size_t bucket, uint32_t tag) {
+  return (bucket ^ (hash_uint64(tag) | 1)) & (map->bucket_count - 1);
+}
+
+
+// Allocates zeroed buckets and values for bucket_count buckets.
+static error_t cuckoo_map_allocate(
+  size_t bucket_count, cuckoo_map_bucket_t** buckets,
+  generic_value_t** values) {
+  *buckets = aligned_alloc(64, bucket_count * sizeof(cuckoo_map_bucket_t));
+  if (!*buckets) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  memset(*buckets, 0, bucket_count * sizeof(cuckoo_map_bucket_t));
+  *values = calloc(bucket_count * CUCKOO_MAP_BUCKET_WAYS,
+		   sizeof(generic_value_t));
+  if (!*values) {
+    free(*buckets);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  return 0;
+}
+
+
+error_t cuckoo_map_create(cuckoo_map_t** map) {
+  return cuckoo_map_create_with_value_deallocator(map, 0);
+}
+
+
+error_t cuckoo_map_create_with_value_deallocator(
+  cuckoo_map_t** map, void (*value_deallocator)(void*)) {
+  // Start on a cache line so lookups read the fields they need, stash
+  // tags included, from one line.
+  size_t size = (sizeof(cuckoo_map_t) + 63) / 64 * 64;
+  cuckoo_map_t* tmp = aligned_alloc(64, size);
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  memset(tmp, 0, size);
+  tmp->value_deallocator = value_deallocator;
+  tmp->bucket_count = INITIAL_BUCKET_COUNT;
+  tmp->seed = 1;
+  if (cuckoo_map_allocate(tmp->bucket_count, &tmp->buckets, &tmp->values)) {
+    free(tmp);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  *map = tmp;
+  return 0;
+}
+
+
+void cuckoo_map_delete(cuckoo_map_t* map) {
+  if (!map) {
+    return;
+  }
+  for (size_t i = 0; i < map->bucket_count * CUCKOO_MAP_BUCKET_WAYS; i++) {
+    char* key = map->buckets[i / CUCKOO_MAP_BUCKET_WAYS].keys[
+      i % CUCKOO_MAP_BUCKET_WAYS];
+    if (!key) {
+      continue;
+    }
+    if (map->value_deallocator) {
+      map->value_deallocator(map->values[i].p);
+    }
+    free(key);
+  }
+  for (size_t i = 0; i < map->stash_size; i++) {
+    if (map->value_deallocator) {
+      map->value_deallocator(map->stash[i].value.p);
+    }
+    free(map->stash[i].key);
+  }
+  free(map->buckets);
+  free(map->values);
+  free(map);
+}
+
+
+// Stores entry in a free way of its bucket, returning false if there is
+// none.
+static bool cuckoo_map_bucket_add(
+  cuckoo_map_t* map, const cuckoo_map_entry_t* entry) {
+  cuckoo_map_bucket_t* bucket = &map->buckets[entry->bucket];
+  for (int way = 0; way < CUCKOO_MAP_BUCKET_WAYS; way++) {
+    if (!bucket->keys[way]) {
+      bucket->tags[way] = entry->tag;
+      bucket->key_lengths[way] = entry->key_length;
+      bucket->keys[way] = entry->key;
+      map->values[entry->bucket * CUCKOO_MAP_BUCKET_WAYS + way] =
+	entry->value;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// Stores entry in a free way of either of its buckets, returning false,
+// with entry->bucket set to the second, if both are full.
+static bool cuckoo_map_add(cuckoo_map_t* map, cuckoo_map_entry_t* entry) {
+  if (cuckoo_map_bucket_add(map, entry)) {
+    return true;
+  }
+  entry->bucket = cuckoo_map_other_bucket(map, entry->bucket, entry->tag);
+  return cuckoo_map_bucket_add(map, entry);
+}
+
+
+// Stores entry in either of its buckets, displacing keys to their other
+// buckets if both are full. If that fails the last key displaced, which
+// is left in entry, is stashed. Returns false, with the keys moved, if the
+// stash is also full.
+static bool cuckoo_map_place(cuckoo_map_t* map, cuckoo_map_entry_t* entry) {
+  if (cuckoo_map_add(map, entry)) {
+    return true;
+  }
+  for (int i = 0; i < MAX_DISPLACEMENTS; i++) {
+    // Swap entry with a random way of its bucket, then try to store the
+    // displaced key in its other bucket.
+    map->seed = map->seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    int way = (map->seed >> 33) % CUCKOO_MAP_BUCKET_WAYS;
+    cuckoo_map_bucket_t* bucket = &map->buckets[entry->bucket];
+    size_t index = entry->bucket * CUCKOO_MAP_BUCKET_WAYS + way;
+    cuckoo_map_entry_t displaced = {
+      bucket->keys[way], bucket->key_lengths[way], bucket->tags[way],
+      entry->bucket, map->values[index]
+    };
+    bucket->tags[way] = entry->tag;
+    bucket->key_lengths[way] = entry->key_length;
+    bucket->keys[way] = entry->key;
+    map->values[index] = entry->value;
+    *entry = displaced;
+    entry->bucket = cuckoo_map_other_bucket(map, entry->bucket, entry->tag);
+    if (cuckoo_map_bucket_add(map, entry)) {
+      return true;
+    }
+  }
+  if (map->stash_size == CUCKOO_MAP_STASH_SIZE) {
+    return false;
+  }
+  map->stash_tags[map->stash_size] = entry->tag;
+  map->stash[map->stash_size++] = *entry;
+  return true;
+}
+
+
+// Moves the keys, and extra if given, into at least bucket_count buckets,
+// doubling them until no more than fit in the stash are left over.
+static error_t cuckoo_map_rebuild(
+  cuckoo_map_t* map, size_t bucket_count, const cuckoo_map_entry_t* extra) {
+  size_t slots = map->bucket_count * CUCKOO_MAP_BUCKET_WAYS;
+  for (;; bucket_count *= 2) {
+    cuckoo_map_t rebuilt = *map;
+    rebuilt.bucket_count = bucket_count;
+    rebuilt.stash_size = 0;
+    if (cuckoo_map_allocate(bucket_count, &rebuilt.buckets,
+			    &rebuilt.values)) {
+      return ERROR_OUT_OF_MEMORY;
+    }
+    bool placed = true;
+    for (size_t i = 0; placed && i < slots + map->stash_size + !!extra;
+	 i++) {
+      cuckoo_map_entry_t entry;
+      if (i < slots) {
+	cuckoo_map_bucket_t* bucket = &map->buckets[
+	  i / CUCKOO_MAP_BUCKET_WAYS];
+	int way = i % CUCKOO_MAP_BUCKET_WAYS;
+	if (!bucket->keys[way]) {
+	  continue;
+	}
+	entry = (cuckoo_map_entry_t){bucket->keys[way],
+				     bucket->key_lengths[way],
+				     bucket->tags[way], 0, map->values[i]};
+      } else if (i < slots + map->stash_size) {
+	entry = map->stash[i - slots];
+      } else {
+	entry = *extra;
+      }
+      // The first bucket comes from hash bits not kept in the map.
+      entry.bucket = hash_string_mixed(entry.key) & (bucket_count - 1);
+      placed = cuckoo_map_place(&rebuilt, &entry);
+    }
+    if (placed) {
+      free(map->buckets);
+      free(map->values);
+      *map = rebuilt;
+      return 0;
+    }
+    free(rebuilt.buckets);
+    free(rebuilt.values);
+  }
+}
+
+
+error_t cuckoo_map_reserve(cuckoo_map_t* map, size_t count) {
+  size_t bucket_count = map->bucket_count;
+  while (count > bucket_count * CUCKOO_MAP_BUCKET_WAYS * RESERVE_LOAD_FACTOR) {
+    bucket_count *= 2;
+  }
+  if (bucket_count == map->bucket_count) {
+    return 0;
+  }
+  return cuckoo_map_rebuild(map, bucket_count, 0);
+}
+
+
+// Returns the slot holding key, counting the stash after the buckets, or
+// SIZE_MAX if key is absent.
+static size_t cuckoo_map_find(
+  const cuckoo_map_t* map, const char* key, size_t key_length,
+  uint64_t hash) {
+  uint32_t tag = hash >> 32;
+  size_t buckets[2];
+  buckets[0] = hash & (map->bucket_count - 1);
+  buckets[1] = cuckoo_map_other_bucket(map, buckets[0], tag);
+  for (int i = 0; i < 2; i++) {
+    const cuckoo_map_bucket_t* bucket = &map->buckets[buckets[i]];
+    for (int way = 0; way < CUCKOO_MAP_BUCKET_WAYS; way++) {
+      if (bucket->tags[way] == tag && bucket->keys[way] &&
+	  string_equal(bucket->keys[way], bucket->key_lengths[way], key,
+		       key_length)) {
+	return buckets[i] * CUCKOO_MAP_BUCKET_WAYS + way;
+      }
+    }
+  }
+  for (size_t i = 0; i < map->stash_size; i++) {
+    if (map->stash_tags[i] == tag &&
+	string_equal(map->stash[i].key, map->stash[i].key_length, key,
+		     key_length)) {
+      return map->bucket_count * CUCKOO_MAP_BUCKET_WAYS + i;
+    }
+  }
+  return SIZE_MAX;
+}
+
+
+// Returns the value at a slot found by cuckoo_map_find.
+static generic_value_t* cuckoo_map_value(cuckoo_map_t* map, size_t slot) {
+  size_t slots = map->bucket_count * CUCKOO_MAP_BUCKET_WAYS;
+  return slot < slots ? &map->values[slot] : &map->stash[slot - slots].value;
+}
+
+
+error_t cuckoo_map_insert(
+  cuckoo_map_t* map, const char* key, generic_value_t value) {
+  uint64_t hash = hash_string_mixed(key);
+  size_t key_length = string_length(key);
+  if (key_length > UINT32_MAX) {
+    return ERROR_INVALID_ARGS;
+  }
+  size_t slot = cuckoo_map_find(map, key, key_length, hash);
+  if (slot != SIZE_MAX) {
+    *cuckoo_map_value(map, slot) = value;
+    return 0;
+  }
+  cuckoo_map_entry_t entry = {
+    malloc(key_length + 1), key_length, hash >> 32,
+    hash & (map->bucket_count - 1), value
+  };
+  if (!entry.key) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  memcpy(entry.key, key, key_length + 1);
+  if (map->stash_size < CUCKOO_MAP_STASH_SIZE) {
+    // With room in the stash every key displaced finds a place.
+    cuckoo_map_place(map, &entry);
+  } else if (!cuckoo_map_add(map, &entry) &&
+	     cuckoo_map_rebuild(map, map->bucket_count * 2, &entry)) {
+    free(entry.key);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  map->size++;
+  return 0;
+}
+
+
+bool cuckoo_map_get(
+  const cuckoo_map_t* map, const char* key, generic_value_t* value) {
+  size_t slot = cuckoo_map_find(map, key, string_length(key),
+				hash_string_mixed(key));
+  if (slot == SIZE_MAX) {
+    return false;
+  }
+  *value = *cuckoo_map_value((cuckoo_map_t*)map, slot);
+  return true;
+}
+
+
+bool cuckoo_map_remove(
+  cuckoo_map_t* map, const char* key, generic_value_t* value) {
+  size_t slot = cuckoo_map_find(map, key, string_length(key),
+				hash_string_mixed(key));
+  if (slot == SIZE_MAX) {
+    return false;
+  }
+  *value = *cuckoo_map_value(map, slot);
+  map->size--;
+  size_t slots = map->bucket_count * CUCKOO_MAP_BUCKET_WAYS;
+  if (slot >= slots) {
+    free(map->stash[slot - slots].key);
+    map->stash_size--;
+    map->stash_tags[slot - slots] = map->stash_tags[map->stash_size];
+    map->stash[slot - slots] = map->stash[map->stash_size];
+    return true;
+  }
+  cuckoo_map_bucket_t* bucket = &map->buckets[slot / CUCKOO_MAP_BUCKET_WAYS];
+  int way = slot % CUCKOO_MAP_BUCKET_WAYS;
+  free(bucket->keys[way]);
+  bucket->keys[way] = 0;
+  bucket->tags[way] = 0;
+  bucket->key_lengths[way] = 0;
+
+  // Move stashed keys into the free way when it is one of their buckets.
+  for (size_t i = 0; i < map->stash_size; i++) {
+    cuckoo_map_entry_t* entry = &map->stash[i];
+    size_t other_bucket =
+      cuckoo_map_other_bucket(map, entry->bucket, entry->tag);
+    if (entry->bucket != slot / CUCKOO_MAP_BUCKET_WAYS &&
+	other_bucket != slot / CUCKOO_MAP_BUCKET_WAYS) {
+      continue;
+    }
+    entry->bucket = slot / CUCKOO_MAP_BUCKET_WAYS;
+    cuckoo_map_bucket_add(map, entry);
+    map->stash_size--;
+    map->stash_tags[i] = map->stash_tags[map->stash_size];
+    *entry = map->stash[map->stash_size];
+    break;
+  }
+  return true;
+}
+
+
+// Moves the iterator to the first key from its index on.
+static void cuckoo_map_iterator_find_key(cuckoo_map_iterator_t* iter) {
+  size_t slots = iter->map->bucket_count * CUCKOO_MAP_BUCKET_WAYS;
+  while (iter->index < slots &&
+	 !iter->map->buckets[iter->index / CUCKOO_MAP_BUCKET_WAYS].keys[
+	   iter->index % CUCKOO_MAP_BUCKET_WAYS]) {
+    iter->index++;
+  }
+}
+
+
+cuckoo_map_iterator_t cuckoo_map_iterator_create(cuckoo_map_t* map) {
+  cuckoo_map_iterator_t iter = {map, 0};
+  cuckoo_map_iterator_find_key(&iter);
+  return iter;
+}
+
+
+void cuckoo_map_iterator_next(cuckoo_map_iterator_t* iter) {
+  iter->index++;
+  cuckoo_map_iterator_find_key(iter);
+}
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "errors.h"
+#include "generic.h"
+
+
+// Keys per bucket. A bucket's tags, key lengths and key pointers fill one
+// 64 byte cache line.
+#define CUCKOO_MAP_BUCKET_WAYS 4
+// Keys that may wait outside the buckets before the map grows.
+#define CUCKOO_MAP_STASH_SIZE 8
+
+typedef struct {
+  // High 32 bits of each key's hash, compared before the key itself.
+  uint32_t tags[CUCKOO_MAP_BUCKET_WAYS];
+  uint32_t key_lengths[CUCKOO_MAP_BUCKET_WAYS];
+  // Keys, or NULL for empty ways.
+  char* keys[CUCKOO_MAP_BUCKET_WAYS];
+} cuckoo_map_bucket_t;
+
+typedef struct {
+  char* key;
+  uint32_t key_length;
+  uint32_t tag;
+  // One of the key's two buckets.
+  size_t bucket;
+  generic_value_t value;
+} cuckoo_map_entry_t;
+
+typedef struct {
+  // Everything a lookup reads besides its buckets comes first, in the
+  // map's first cache line.
+  // Number of buckets, a power of two.
+  size_t bucket_count;
+  cuckoo_map_bucket_t* buckets;
+  // Value of the key in way i of bucket b at values[b *
+  // CUCKOO_MAP_BUCKET_WAYS + i], so values are only touched on a match.
+  generic_value_t* values;
+  size_t stash_size;
+  // Tag of each stashed key, so lookups only read a stash entry whose tag
+  // matches.
+  uint32_t stash_tags[CUCKOO_MAP_STASH_SIZE];
+  // Keys whose buckets were full.
+  cuckoo_map_entry_t stash[CUCKOO_MAP_STASH_SIZE];
+  void (*value_deallocator)(void*);
+  size_t size;
+  // Chooses which key to displace when both buckets are full.
+  uint64_t seed;
+} cuckoo_map_t;
+
+typedef struct {
+  cuckoo_map_t* map;
+  // Slot in the buckets, then in the stash.
+  size_t index;
+} cuckoo_map_iterator_t;
+
+
+/**
+ * Creates a new cuckoo map.
+ *
+ * Each key may only be stored in one of two buckets of four keys, chosen
+ * from its hash, so a lookup examines at most two cache lines of buckets
+ * however full the map is, plus the map's own first line, which holds the
+ * tags of any stashed keys. An insert into two full buckets moves one of
+ * their keys to its other bucket, and so on, until a key lands in a free
+ * way; after too many moves the last key displaced is stashed, and the map
+ * doubles when the stash is full and neither bucket of a new key has a
+ * free way.
+ *
+ * Args:
+ *  map: Set to the newly allocated map.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create map because of memory error.
+ */
+error_t cuckoo_map_create(cuckoo_map_t** map);
+
+
+/**
+ * Creates a new cuckoo map with a value deallocator.
+ *
+ * The deallocation function is used to delete void* values
+ * (generic_value_t.p) when cuckoo_map_delete is called.
+ *
+ * Args:
+ *  map: Set to the newly allocated map.
+ *  deallocated: Function used to delete values.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create map because of memory error.
+ */
+error_t cuckoo_map_create_with_value_deallocator(
+  cuckoo_map_t** map, void (*value_deallocator)(void*));
+
+
+/**
+ * Deletes a cuckoo map.
+ *
+ * If a deallocation function was provided during creation, map values
+ * will be treated as void* (generic_value_t.p) and sent to the function.
+ *
+ * Args:
+ *  map: Map to be deleted.
+ */
+void cuckoo_map_delete(cuckoo_map_t* map);
+
+
+/**
+ * Grows the map so it has room for at least count keys.
+ *
+ * Args:
+ *  map: Map to update.
+ *  count: Number of keys to make room for.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not grow map because of memory error.
+ */
+error_t cuckoo_map_reserve(cuckoo_map_t* map, size_t count);
+
+
+/**
+ * Inserts a key and value into the map.
+ *
+ * If the key already exists in the map, the value is updated.
+ *
+ * Args:
+ *  map: Map to update.
+ *  key: Key for map entry.
+ *  value: Value for map entry.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_INVALID_ARGS: Key is 4 GB or longer.
+ *  ERROR_OUT_OF_MEMORY: Could not insert into map because of memory errors.
+ */
+error_t cuckoo_map_insert(
+  cuckoo_map_t* map, const char* key, generic_value_t value);
+
+
+/**
+ * Gets a value from the map.
+ *
+ * Args:
+ *  map: The map to examine.
+ *  key: The key to look up.
+ *  value: Set to any value found.
+ *
+ * Returns:
+ *  true if the value is found.
+ */
+bool cuckoo_map_get(
+  const cuckoo_map_t* map, const char* key, generic_value_t* value);
+
+
+/**
+ * Removes a key and value from the map.
+ *
+ * Args:
+ *  map: The map to examine.
+ *  key: The key to look up.
+ *  value: Set to any value found.
+ *
+ * Returns:
+ *  true if the value is found.
+ */
+bool cuckoo_map_remove(
+  cuckoo_map_t* map, const char* key, generic_value_t* value);
+
+
+/**
+ * Returns the size of the map.
+ *
+ * Args:
+ *  map: The map to examine.
+ *
+ * Returns:
+ *  Size of the map.
+ */
+inline size_t cuckoo_map_size(const cuckoo_map_t* map) { return map->size; }
+
+
+/**
+ * Creates an iterator for a map.
+ *
+ * Removing a key may move stashed keys into the buckets, so the map must
+ * not be modified while it is being iterated.
+ *
+ * Args:
+ *  map: Map to create iterator for.
+ *
+ * Returns:
+ *  Iterator for the given map.
+ */
+cuckoo_map_iterator_t cuckoo_map_iterator_create(cuckoo_map_t* map);
+
+
+/**
+ * Returns true if the iterator has a current element.
+ *
+ * If this function returns true, it is safe to call
+ * cuckoo_map_iterator_get_current and cuckoo_map_iterator_next.
+ *
+ * Args:
+ *  iter: Iterator to examine
+ *
+ * Returns:
+ *  true if the iterator has a current element.
+ */
+inline bool cuckoo_map_iterator_has_current(cuckoo_map_iterator_t* iter) {
+  return iter->index < iter->map->bucket_count * CUCKOO_MAP_BUCKET_WAYS +
+    iter->map->stash_size;
+}
+
+
+/**
+ * Gets the current element for the iterator.
+ *
+ * This call should be proceeded by a successful call to
+ * cuckoo_map_iterator_has_current.
+ *
+ * Args:
+ *  iter: Iterator to examine.
+ *  key: Set to the key for the current element (owned by map and only valid
+ *   while map has not been modified).
+ *  value: Set to the value for the current element.
+ */
+inline void cuckoo_map_iterator_get_current(
+  cuckoo_map_iterator_t* iter, const char** key, generic_value_t* value) {
+  cuckoo_map_t* map = iter->map;
+  size_t slots = map->bucket_count * CUCKOO_MAP_BUCKET_WAYS;
+  if (iter->index < slots) {
+    *key = map->buckets[iter->index / CUCKOO_MAP_BUCKET_WAYS].keys[
+      iter->index % CUCKOO_MAP_BUCKET_WAYS];
+    *value = map->values[iter->index];
+  } else {
+    *key = map->stash[iter->index - slots].key;
+    *value = map->stash[iter->index - slots].value;
+  }
+}
+
+
+/**
+ * Moves the iterator to the next value.
+ *
+ * This call should be proceeded by a successful call to
+ * cuckoo_map_iterator_has_current.
+ *
+ * Args:
+ *  iter: Iterator to update.
+ */
+void cuckoo_map_iterator_next(cuckoo_map_iterator_t* iter);
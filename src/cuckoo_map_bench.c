@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "cuckoo_map.h"
+#include "robin_hood_map.h"
+
+
+#define BENCH_DEFAULT_MAX_SIZE 1000000
+#define BENCH_SAMPLES 100000
+#define BENCH_KEY_SIZE 24
+
+
+static bool bench_cuckoo_map_get(
+  void* map, const char* key, generic_value_t* value) {
+  return cuckoo_map_get(map, key, value);
+}
+
+
+static bool bench_robin_hood_map_get(
+  void* map, const char* key, generic_value_t* value) {
+  return robin_hood_map_get(map, key, value);
+}
+
+
+// Times single hits and misses on a map holding the first size keys.
+static void bench_gets(
+  const char* name, bool (*get)(void*, const char*, generic_value_t*),
+  void* map, const char* keys, const char* absent_keys, size_t size) {
+  uint64_t* samples = malloc(BENCH_SAMPLES * sizeof(uint64_t));
+  if (!samples) {
+    abort();
+  }
+  char label[64];
+  uint64_t seed = 1;
+  uint64_t sum = 0;
+  generic_value_t value;
+  for (int i = 0; i < BENCH_SAMPLES; i++) {
+    const char* key = keys + bench_random(&seed) % size * BENCH_KEY_SIZE;
+    uint64_t start = bench_now_ns();
+    sum += get(map, key, &value);
+    samples[i] = bench_now_ns() - start;
+  }
+  snprintf(label, sizeof(label), "%s_get_hit/%zu", name, size);
+  bench_report_latencies(label, samples, BENCH_SAMPLES);
+
+  for (int i = 0; i < BENCH_SAMPLES; i++) {
+    const char* key = absent_keys + i * BENCH_KEY_SIZE;
+    uint64_t start = bench_now_ns();
+    sum += get(map, key, &value);
+    samples[i] = bench_now_ns() - start;
+  }
+  snprintf(label, sizeof(label), "%s_get_miss/%zu", name, size);
+  bench_report_latencies(label, samples, BENCH_SAMPLES);
+  bench_use(sum);
+  free(samples);
+}
+
+
+int main(int argc, char** argv) {
+  size_t sizes[BENCH_MAX_SIZES];
+  size_t count = bench_sizes(sizes, BENCH_DEFAULT_MAX_SIZE);
+  char* keys = bench_make_keys("key:", sizes[count - 1], BENCH_KEY_SIZE);
+  char* absent_keys =
+    bench_make_keys("absent:", BENCH_SAMPLES, BENCH_KEY_SIZE);
+  char name[64];
+
+  for (size_t i = 0; i < count; i++) {
+    size_t size = sizes[i];
+    cuckoo_map_t* cuckoo_map;
+    robin_hood_map_t* robin_hood_map;
+    if (cuckoo_map_create(&cuckoo_map) ||
+	robin_hood_map_create(&robin_hood_map)) {
+      abort();
+    }
+    uint64_t start = bench_now_ns();
+    for (size_t j = 0; j < size; j++) {
+      if (cuckoo_map_insert(cuckoo_map, keys + j * BENCH_KEY_SIZE,
+			    (generic_value_t)j)) {
+	abort();
+      }
+    }
+    snprintf(name, sizeof(name), "cuckoo_map_insert/%zu", size);
+    bench_report(name, size, bench_now_ns() - start);
+    snprintf(name, sizeof(name), "cuckoo_map_load_factor/%zu", size);
+    bench_report_value(
+      name,
+      (double)size / (cuckoo_map->bucket_count * CUCKOO_MAP_BUCKET_WAYS),
+      "ratio");
+    snprintf(name, sizeof(name), "cuckoo_map_stash_size/%zu", size);
+    bench_report_value(name, cuckoo_map->stash_size, "keys");
+
+    start = bench_now_ns();
+    for (size_t j = 0; j < size; j++) {
+      if (robin_hood_map_insert(robin_hood_map, keys + j * BENCH_KEY_SIZE,
+				(generic_value_t)j)) {
+	abort();
+      }
+    }
+    snprintf(name, sizeof(name), "robin_hood_map_insert/%zu", size);
+    bench_report(name, size, bench_now_ns() - start);
+
+    bench_gets("cuckoo_map", bench_cuckoo_map_get, cuckoo_map, keys,
+	       absent_keys, size);
+    bench_gets("robin_hood_map", bench_robin_hood_map_get, robin_hood_map,
+	       keys, absent_keys, size);
+    cuckoo_map_delete(cuckoo_map);
+    robin_hood_map_delete(robin_hood_map);
+  }
+  free(keys);
+  free(absent_keys);
+  return 0;
+}
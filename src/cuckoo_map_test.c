@@ -0,0 +1,297 @@
+#include "cuckoo_map.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+
+
+// Checks that every key is in one of the two buckets its hash allows, that
+// stashed keys can be found by their tags and that the map's size matches
+// its keys.
+static void check_invariants(cuckoo_map_t* map) {
+  size_t size = map->stash_size;
+  for (size_t i = 0; i < map->bucket_count; i++) {
+    cuckoo_map_bucket_t* bucket = &map->buckets[i];
+    for (int way = 0; way < CUCKOO_MAP_BUCKET_WAYS; way++) {
+      if (!bucket->keys[way]) {
+	continue;
+      }
+      size++;
+      assert(strlen(bucket->keys[way]) == bucket->key_lengths[way]);
+      // Only the key's own buckets are searched, so finding it shows it is
+      // in one of them.
+      generic_value_t value;
+      assert(cuckoo_map_get(map, bucket->keys[way], &value));
+      assert(value.i64 == map->values[i * CUCKOO_MAP_BUCKET_WAYS + way].i64);
+    }
+  }
+  assert(size == map->size);
+  assert(map->stash_size <= CUCKOO_MAP_STASH_SIZE);
+  for (size_t i = 0; i < map->stash_size; i++) {
+    assert(map->stash_tags[i] == map->stash[i].tag);
+    generic_value_t value;
+    assert(cuckoo_map_get(map, map->stash[i].key, &value));
+    assert(value.i64 == map->stash[i].value.i64);
+  }
+}
+
+
+static void test_cuckoo_map_create() {
+  cuckoo_map_t* map;
+  assert(!cuckoo_map_create(&map));
+  assert(!map->value_deallocator);
+  assert(!cuckoo_map_size(map));
+  assert(!((uintptr_t)map % 64));
+  assert(!((uintptr_t)map->buckets % 64));
+  cuckoo_map_delete(map);
+}
+
+
+static void test_cuckoo_map_insert_get() {
+  cuckoo_map_t* map;
+  assert(!cuckoo_map_create(&map));
+  generic_value_t value;
+  assert(!cuckoo_map_get(map, "a", &value));
+  assert(!cuckoo_map_insert(map, "a", (generic_value_t)1.0));
+  assert(!cuckoo_map_insert(map, "", (generic_value_t)2.0));
+  assert(2 == cuckoo_map_size(map));
+  assert(cuckoo_map_get(map, "a", &value));
+  assert(1.0 == value.d);
+  assert(cuckoo_map_get(map, "", &value));
+  assert(2.0 == value.d);
+
+  // Inserting an existing key updates its value.
+  assert(!cuckoo_map_insert(map, "a", (generic_value_t)3.0));
+  assert(2 == cuckoo_map_size(map));
+  assert(cuckoo_map_get(map, "a", &value));
+  assert(3.0 == value.d);
+  cuckoo_map_delete(map);
+}
+
+
+static void test_cuckoo_map_grow() {
+  cuckoo_map_t* map;
+  assert(!cuckoo_map_create(&map));
+  size_t max_stash_size = 0;
+  for (int64_t i = 0; i < 10000; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    assert(!cuckoo_map_insert(map, key, (generic_value_t)i));
+    if (map->stash_size > max_stash_size) {
+      max_stash_size = map->stash_size;
+    }
+    if (i < 100) {
+      check_invariants(map);
+    }
+  }
+  assert(10000 == cuckoo_map_size(map));
+  // The small maps fill their buckets before growing.
+  assert(max_stash_size > 0);
+  check_invariants(map);
+  for (int64_t i = 0; i < 10000; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    generic_value_t value;
+    assert(cuckoo_map_get(map, key, &value));
+    assert(i == value.i64);
+    sprintf(key, "absent:%d", (int)i);
+    assert(!cuckoo_map_get(map, key, &value));
+  }
+  cuckoo_map_delete(map);
+}
+
+
+static void test_cuckoo_map_remove() {
+  cuckoo_map_t* map;
+  assert(!cuckoo_map_create(&map));
+  bool present[1000] = {false};
+  srand(1);
+  for (int i = 0; i < 20000; i++) {
+    int k = rand() % 1000;
+    char key[16];
+    sprintf(key, "key:%d", k);
+    generic_value_t value;
+    if (present[k]) {
+      assert(cuckoo_map_remove(map, key, &value));
+      assert(k == value.i64);
+    } else {
+      assert(!cuckoo_map_remove(map, key, &value));
+      assert(!cuckoo_map_insert(map, key, (generic_value_t)(int64_t)k));
+    }
+    present[k] = !present[k];
+    if (i % 1000 == 0) {
+      check_invariants(map);
+    }
+  }
+  check_invariants(map);
+  for (int k = 0; k < 1000; k++) {
+    char key[16];
+    sprintf(key, "key:%d", k);
+    generic_value_t value;
+    assert(present[k] == cuckoo_map_get(map, key, &value));
+  }
+  cuckoo_map_delete(map);
+}
+
+
+static void test_cuckoo_map_remove_stashed() {
+  cuckoo_map_t* map;
+  assert(!cuckoo_map_create(&map));
+  char key[16];
+  int count = 0;
+  while (!map->stash_size) {
+    sprintf(key, "key:%d", count);
+    assert(!cuckoo_map_insert(map, key, (generic_value_t)(int64_t)count++));
+  }
+  // Removing every other key makes room for the stashed keys.
+  generic_value_t value;
+  for (int i = 0; i < count; i++) {
+    sprintf(key, "key:%d", i);
+    if (i % 2) {
+      assert(cuckoo_map_remove(map, key, &value));
+    }
+  }
+  assert(!map->stash_size);
+  check_invariants(map);
+  for (int i = 0; i < count; i += 2) {
+    sprintf(key, "key:%d", i);
+    assert(cuckoo_map_remove(map, key, &value));
+    assert(i == value.i64);
+  }
+  assert(!cuckoo_map_size(map));
+  cuckoo_map_delete(map);
+}
+
+
+static void test_cuckoo_map_insert_full_stash() {
+  cuckoo_map_t* map;
+  assert(!cuckoo_map_create(&map));
+  char key[16];
+  int count = 0;
+  // Fill the stash, then free a way that no stashed key can move into.
+  size_t free_bucket = SIZE_MAX;
+  while (free_bucket == SIZE_MAX) {
+    while (map->stash_size < CUCKOO_MAP_STASH_SIZE) {
+      sprintf(key, "key:%d", count);
+      assert(!cuckoo_map_insert(map, key, (generic_value_t)(int64_t)count++));
+    }
+    size_t bucket = count % map->bucket_count;
+    for (int way = 0; way < CUCKOO_MAP_BUCKET_WAYS; way++) {
+      if (!map->buckets[bucket].keys[way]) {
+	free_bucket = bucket;
+      }
+    }
+    if (free_bucket == SIZE_MAX) {
+      generic_value_t value;
+      strcpy(key, map->buckets[bucket].keys[0]);
+      assert(cuckoo_map_remove(map, key, &value));
+      if (map->stash_size == CUCKOO_MAP_STASH_SIZE) {
+	free_bucket = bucket;
+      }
+    }
+  }
+
+  // A new key whose bucket has a free way is stored without growing.
+  size_t bucket_count = map->bucket_count;
+  size_t size = cuckoo_map_size(map);
+  for (int i = 0;; i++) {
+    sprintf(key, "new:%d", i);
+    if ((hash_uint64(hash_string(key)) & (bucket_count - 1)) == free_bucket) {
+      break;
+    }
+  }
+  assert(!cuckoo_map_insert(map, key, (generic_value_t)(int64_t)-1));
+  assert(bucket_count == map->bucket_count);
+  assert(CUCKOO_MAP_STASH_SIZE == map->stash_size);
+  assert(size + 1 == cuckoo_map_size(map));
+  generic_value_t value;
+  assert(cuckoo_map_get(map, key, &value));
+  assert(-1 == value.i64);
+  check_invariants(map);
+  cuckoo_map_delete(map);
+}
+
+
+static void test_cuckoo_map_reserve() {
+  cuckoo_map_t* map;
+  assert(!cuckoo_map_create(&map));
+  assert(!cuckoo_map_insert(map, "key", (generic_value_t)1.0));
+  assert(!cuckoo_map_reserve(map, 1000));
+  size_t bucket_count = map->bucket_count;
+  assert(1000 <= bucket_count * CUCKOO_MAP_BUCKET_WAYS);
+  generic_value_t value;
+  assert(cuckoo_map_get(map, "key", &value));
+  assert(1.0 == value.d);
+  for (int64_t i = 0; i < 999; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    assert(!cuckoo_map_insert(map, key, (generic_value_t)i));
+  }
+  assert(bucket_count == map->bucket_count);
+  cuckoo_map_delete(map);
+}
+
+
+static void test_cuckoo_map_with_value_deallocator() {
+  cuckoo_map_t* map;
+  assert(!cuckoo_map_create_with_value_deallocator(&map, free));
+  // Enough keys to grow the map several times.
+  for (int i = 0; i < 100; i++) {
+    char key[16];
+    sprintf(key, "key:%d", i);
+    assert(!cuckoo_map_insert(map, key, (generic_value_t)malloc(8)));
+  }
+  // Removed values belong to the caller.
+  generic_value_t value;
+  assert(cuckoo_map_remove(map, "key:7", &value));
+  free(value.p);
+  cuckoo_map_delete(map);
+}
+
+
+static void test_cuckoo_map_iterator() {
+  cuckoo_map_t* map;
+  assert(!cuckoo_map_create(&map));
+  cuckoo_map_iterator_t iter = cuckoo_map_iterator_create(map);
+  assert(!cuckoo_map_iterator_has_current(&iter));
+
+  bool seen[100] = {false};
+  for (int64_t i = 0; i < 100; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    assert(!cuckoo_map_insert(map, key, (generic_value_t)i));
+  }
+  size_t count = 0;
+  for (iter = cuckoo_map_iterator_create(map);
+       cuckoo_map_iterator_has_current(&iter);
+       cuckoo_map_iterator_next(&iter)) {
+    const char* key;
+    generic_value_t value;
+    cuckoo_map_iterator_get_current(&iter, &key, &value);
+    char expected[16];
+    sprintf(expected, "key:%d", (int)value.i64);
+    assert(!strcmp(expected, key));
+    assert(!seen[value.i64]);
+    seen[value.i64] = true;
+    count++;
+  }
+  assert(100 == count);
+  cuckoo_map_delete(map);
+}
+
+
+int main(int argc, char** argv) {
+  test_cuckoo_map_create();
+  test_cuckoo_map_insert_get();
+  test_cuckoo_map_grow();
+  test_cuckoo_map_remove();
+  test_cuckoo_map_remove_stashed();
+  test_cuckoo_map_insert_full_stash();
+  test_cuckoo_map_reserve();
+  test_cuckoo_map_with_value_deallocator();
+  test_cuckoo_map_iterator();
+  return 0;
+}
@@ -0,0 +1,114 @@
+#include "deque.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const size_t INITIAL_CAPACITY = 16;
+
+
+// Provide external definitions of inline functions.
+extern inline generic_value_t deque_get(const deque_t* deque, size_t index);
+extern inline void deque_set(
+  deque_t* deque, size_t index, generic_value_t value);
+extern inline generic_value_t deque_get_front(const deque_t* deque);
+extern inline generic_value_t deque_get_back(const deque_t* deque);
+extern inline generic_value_t deque_pop_front(deque_t* deque);
+extern inline generic_value_t deque_pop_back(deque_t* deque);
+extern inline size_t deque_size(const deque_t* deque);
+extern inline bool deque_empty(const deque_t* deque);
+
+
+error_t deque_create(deque_t** deque) {
+  return deque_create_with_value_deallocator(deque, 0);
+}
+
+
+error_t deque_create_with_value_deallocator(
+  deque_t** deque, void (*value_deallocator)(void*)) {
+  deque_t* tmp = calloc(1, sizeof(deque_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->value_deallocator = value_deallocator;
+  *deque = tmp;
+  return 0;
+}
+
+
+void deque_delete(deque_t* deque) {
+  if (!deque) {
+    return;
+  }
+  if (deque->value_deallocator) {
+    for (size_t i = 0; i < deque->size; i++) {
+      deque->value_deallocator(deque_get(deque, i).p);
+    }
+  }
+  free(deque->values);
+  free(deque);
+}
+
+
+error_t deque_reserve(deque_t* deque, size_t capacity) {
+  if (capacity <= deque->capacity) {
+    return 0;
+  }
+  size_t new_capacity = deque->capacity ? deque->capacity : INITIAL_CAPACITY;
+  while (new_capacity < capacity) {
+    // Doubling again would overflow the capacity or its size in bytes.
+    if (new_capacity > SIZE_MAX / 2 / sizeof(generic_value_t)) {
+      return ERROR_OUT_OF_MEMORY;
+    }
+    new_capacity *= 2;
+  }
+  generic_value_t* values = malloc(new_capacity * sizeof(generic_value_t));
+  if (!values) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+
+  // Unwrap the ring so the values start at index 0.
+  size_t first = deque->capacity - deque->head;
+  if (first > deque->size) {
+    first = deque->size;
+  }
+  if (deque->size) {
+    memcpy(values, deque->values + deque->head,
+	   first * sizeof(generic_value_t));
+    memcpy(values + first, deque->values,
+	   (deque->size - first) * sizeof(generic_value_t));
+  }
+  free(deque->values);
+  deque->values = values;
+  deque->capacity = new_capacity;
+  deque->head = 0;
+  return 0;
+}
+
+
+error_t deque_push_back(deque_t* deque, generic_value_t value) {
+  if (deque->size == deque->capacity) {
+    error_t result = deque_reserve(deque, deque->size + 1);
+    if (result) {
+      return result;
+    }
+  }
+  deque->values[(deque->head + deque->size) & (deque->capacity - 1)] = value;
+  deque->size++;
+  return 0;
+}
+
+
+error_t deque_push_front(deque_t* deque, generic_value_t value) {
+  if (deque->size == deque->capacity) {
+    error_t result = deque_reserve(deque, deque->size + 1);
+    if (result) {
+      return result;
+    }
+  }
+  deque->head = (deque->head - 1) & (deque->capacity - 1);
+  deque->values[deque->head] = value;
+  deque->size++;
+  return 0;
+}
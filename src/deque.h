@@ -0,0 +1,233 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "errors.h"
+#include "generic.h"
+
+
+typedef struct {
+  void (*value_deallocator)(void*);
+  // Ring buffer of values; capacity is zero or a power of two.
+  generic_value_t* values;
+  size_t capacity;
+  // Index of the first value in values.
+  size_t head;
+  size_t size;
+} deque_t;
+
+
+/**
+ * Creates a new deque.
+ *
+ * A deque stores its values in a single growable ring buffer, so pushing
+ * and popping at either end is amortized O(1) and needs no per-element
+ * allocation.
+ *
+ * Args:
+ *  deque: Set to the newly allocated deque.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create deque because of memory error.
+ */
+error_t deque_create(deque_t** deque);
+
+
+/**
+ * Creates a new deque with a value deallocator.
+ *
+ * The deallocation function is used to delete void* values
+ * (generic_value_t.p) when deque_delete is called.
+ *
+ * Args:
+ *  deque: Set to the newly allocated deque.
+ *  deallocated: Function used to delete values.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create deque because of memory error.
+ */
+error_t deque_create_with_value_deallocator(
+  deque_t** deque, void (*value_deallocator)(void*));
+
+
+/**
+ * Deletes a deque.
+ *
+ * If a deallocation function was provided during creation, deque values
+ * will be treated as void* (generic_value_t.p) and sent to the function.
+ *
+ * Args:
+ *  deque: Deque to be deleted.
+ */
+void deque_delete(deque_t* deque);
+
+
+/**
+ * Ensures the deque can hold a number of values without reallocating.
+ *
+ * Args:
+ *  deque: Deque to update.
+ *  capacity: Number of values the deque should be able to hold.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not grow deque because of memory error, or
+ *   capacity is too large to allocate. The deque is unchanged.
+ */
+error_t deque_reserve(deque_t* deque, size_t capacity);
+
+
+/**
+ * Adds a value to the end of the deque.
+ *
+ * Args:
+ *  deque: Deque to add value to.
+ *  value: Value to add to deque.
+ *
+ * Returns:
+ *  0 on success
+ *  ERROR_OUT_OF_MEMORY: Could not add value because of memory error.
+ */
+error_t deque_push_back(deque_t* deque, generic_value_t value);
+
+
+/**
+ * Adds a value to the beginning of the deque.
+ *
+ * Args:
+ *  deque: Deque to add value to.
+ *  value: Value to add to deque.
+ *
+ * Returns:
+ *  0 on success
+ *  ERROR_OUT_OF_MEMORY: Could not add value because of memory error.
+ */
+error_t deque_push_front(deque_t* deque, generic_value_t value);
+
+
+/**
+ * Gets a value by its position in the deque.
+ *
+ * Calling this with an index outside of the deque is undefined.
+ *
+ * Args:
+ *  deque: The deque to examine.
+ *  index: Position of the value, counting from the front.
+ *
+ * Returns:
+ *  The value at the given position.
+ */
+inline generic_value_t deque_get(const deque_t* deque, size_t index) {
+  return deque->values[(deque->head + index) & (deque->capacity - 1)];
+}
+
+
+/**
+ * Replaces a value by its position in the deque.
+ *
+ * Calling this with an index outside of the deque is undefined.
+ *
+ * Args:
+ *  deque: The deque to update.
+ *  index: Position of the value, counting from the front.
+ *  value: New value.
+ */
+inline void deque_set(deque_t* deque, size_t index, generic_value_t value) {
+  deque->values[(deque->head + index) & (deque->capacity - 1)] = value;
+}
+
+
+/**
+ * Gets the first value in the deque.
+ *
+ * Calling this on an empty deque is undefined.
+ *
+ * Args:
+ *  deque: The deque to examine.
+ *
+ * Returns:
+ *  This first value in the deque.
+ */
+inline generic_value_t deque_get_front(const deque_t* deque) {
+  return deque->values[deque->head];
+}
+
+
+/**
+ * Gets the last value in the deque.
+ *
+ * Calling this on an empty deque is undefined.
+ *
+ * Args:
+ *  deque: The deque to examine.
+ *
+ * Returns:
+ *  This last value in the deque.
+ */
+inline generic_value_t deque_get_back(const deque_t* deque) {
+  return deque_get(deque, deque->size - 1);
+}
+
+
+/**
+ * Removes the first value from the deque.
+ *
+ * Calling this on an empty deque is undefined.
+ *
+ * Args:
+ *  deque: The deque to pop value from.
+ *
+ * Returns:
+ *  The first value in the deque.
+ */
+inline generic_value_t deque_pop_front(deque_t* deque) {
+  generic_value_t value = deque->values[deque->head];
+  deque->head = (deque->head + 1) & (deque->capacity - 1);
+  deque->size--;
+  return value;
+}
+
+
+/**
+ * Removes the last value from the deque.
+ *
+ * Calling this on an empty deque is undefined.
+ *
+ * Args:
+ *  deque: The deque to pop value from.
+ *
+ * Returns:
+ *  The last value in the deque.
+ */
+inline generic_value_t deque_pop_back(deque_t* deque) {
+  generic_value_t value = deque_get(deque, deque->size - 1);
+  deque->size--;
+  return value;
+}
+
+
+/**
+ * Returns the size of the deque.
+ *
+ * Args:
+ *  deque: Deque to examine.
+ *
+ * Returns:
+ *  Size of the deque.
+ */
+inline size_t deque_size(const deque_t* deque) { return deque->size; }
+
+
+/**
+ * Returns true if deque is empty.
+ *
+ * Args:
+ *  deque: Deque to examine.
+ *
+ * Returns:
+ *  true if deque is empty.
+ */
+inline bool deque_empty(const deque_t* deque) { return !deque->size; }
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "deque.h"
+#include "list.h"
+
+
+#define BENCH_SIZE 1000000
+// Queue length kept while measuring steady-state push/pop pairs.
+#define BENCH_QUEUE_LENGTH 1000
+
+
+static void bench_list_fifo() {
+  list_t* list;
+  if (list_create(&list)) {
+    abort();
+  }
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_SIZE; i++) {
+    if (list_push_back(list, (generic_value_t)i)) {
+      abort();
+    }
+  }
+  while (!list_empty(list)) {
+    bench_use(list_pop_front(list).ui64);
+  }
+  bench_report("list_fifo_fill_drain", BENCH_SIZE, bench_now_ns() - start);
+
+  for (uint64_t i = 0; i < BENCH_QUEUE_LENGTH; i++) {
+    if (list_push_back(list, (generic_value_t)i)) {
+      abort();
+    }
+  }
+  start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_SIZE; i++) {
+    if (list_push_back(list, (generic_value_t)i)) {
+      abort();
+    }
+    bench_use(list_pop_front(list).ui64);
+  }
+  bench_report("list_fifo_steady", BENCH_SIZE, bench_now_ns() - start);
+  list_delete(list);
+}
+
+
+static void bench_deque_fifo() {
+  deque_t* deque;
+  if (deque_create(&deque)) {
+    abort();
+  }
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_SIZE; i++) {
+    if (deque_push_back(deque, (generic_value_t)i)) {
+      abort();
+    }
+  }
+  while (!deque_empty(deque)) {
+    bench_use(deque_pop_front(deque).ui64);
+  }
+  bench_report("deque_fifo_fill_drain", BENCH_SIZE, bench_now_ns() - start);
+
+  for (uint64_t i = 0; i < BENCH_QUEUE_LENGTH; i++) {
+    if (deque_push_back(deque, (generic_value_t)i)) {
+      abort();
+    }
+  }
+  start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_SIZE; i++) {
+    if (deque_push_back(deque, (generic_value_t)i)) {
+      abort();
+    }
+    bench_use(deque_pop_front(deque).ui64);
+  }
+  bench_report("deque_fifo_steady", BENCH_SIZE, bench_now_ns() - start);
+  deque_delete(deque);
+}
+
+
+int main(int argc, char** argv) {
+  bench_list_fifo();
+  bench_deque_fifo();
+  return 0;
+}
@@ -0,0 +1,165 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "deque.h"
+
+
+static void test_deque_create() {
+  deque_t* deque;
+  assert(!deque_create(&deque));
+  assert(!deque->value_deallocator);
+  assert(!deque_size(deque));
+  assert(deque_empty(deque));
+  deque_delete(deque);
+}
+
+
+static void test_deque_push_back() {
+  deque_t* deque;
+  assert(!deque_create(&deque));
+  for (uint64_t i = 0; i < 100; i++) {
+    assert(!deque_push_back(deque, (generic_value_t)i));
+  }
+  assert(100 == deque_size(deque));
+  assert(0 == deque_get_front(deque).i64);
+  assert(99 == deque_get_back(deque).i64);
+  for (uint64_t i = 0; i < 100; i++) {
+    assert(i == deque_get(deque, i).i64);
+  }
+  deque_delete(deque);
+}
+
+
+static void test_deque_push_front() {
+  deque_t* deque;
+  assert(!deque_create(&deque));
+  for (uint64_t i = 0; i < 100; i++) {
+    assert(!deque_push_front(deque, (generic_value_t)i));
+  }
+  assert(100 == deque_size(deque));
+  assert(99 == deque_get_front(deque).i64);
+  assert(0 == deque_get_back(deque).i64);
+  for (uint64_t i = 0; i < 100; i++) {
+    assert(99 - i == deque_get(deque, i).i64);
+  }
+  deque_delete(deque);
+}
+
+
+static void test_deque_pop_front() {
+  deque_t* deque;
+  assert(!deque_create(&deque));
+  for (uint64_t i = 0; i < 100; i++) {
+    assert(!deque_push_back(deque, (generic_value_t)i));
+  }
+  uint64_t value = 0;
+  while (!deque_empty(deque)) {
+    assert(value == deque_pop_front(deque).i64);
+    value++;
+  }
+  assert(100 == value);
+  deque_delete(deque);
+}
+
+
+static void test_deque_pop_back() {
+  deque_t* deque;
+  assert(!deque_create(&deque));
+  for (uint64_t i = 0; i < 100; i++) {
+    assert(!deque_push_front(deque, (generic_value_t)i));
+  }
+  uint64_t value = 0;
+  while (!deque_empty(deque)) {
+    assert(value == deque_pop_back(deque).i64);
+    value++;
+  }
+  assert(100 == value);
+  deque_delete(deque);
+}
+
+
+static void test_deque_wrap_around() {
+  deque_t* deque;
+  assert(!deque_create(&deque));
+  // Use the deque as a FIFO so the ring wraps many times, growing while
+  // the values are split across the end of the buffer.
+  uint64_t next_push = 0;
+  uint64_t next_pop = 0;
+  for (int round = 0; round < 10; round++) {
+    for (int i = 0; i < 7 + round * 3; i++) {
+      assert(!deque_push_back(deque, (generic_value_t)next_push++));
+    }
+    for (int i = 0; i < 5; i++) {
+      assert(next_pop++ == deque_pop_front(deque).i64);
+    }
+    for (size_t i = 0; i < deque_size(deque); i++) {
+      assert(next_pop + i == deque_get(deque, i).i64);
+    }
+  }
+  assert(next_push - next_pop == deque_size(deque));
+  deque_delete(deque);
+}
+
+
+static void test_deque_set() {
+  deque_t* deque;
+  assert(!deque_create(&deque));
+  for (uint64_t i = 0; i < 10; i++) {
+    assert(!deque_push_front(deque, (generic_value_t)i));
+  }
+  deque_set(deque, 3, (generic_value_t)(uint64_t)100);
+  assert(100 == deque_get(deque, 3).i64);
+  assert(9 == deque_get_front(deque).i64);
+  deque_delete(deque);
+}
+
+
+static void test_deque_reserve() {
+  deque_t* deque;
+  assert(!deque_create(&deque));
+  assert(!deque_reserve(deque, 100));
+  assert(deque->capacity >= 100);
+  generic_value_t* values = deque->values;
+  for (uint64_t i = 0; i < 100; i++) {
+    assert(!deque_push_back(deque, (generic_value_t)i));
+  }
+  // No reallocation was needed.
+  assert(values == deque->values);
+
+  // Capacities whose doubling would overflow fail, leaving the deque as
+  // it was.
+  size_t capacity = deque->capacity;
+  assert(ERROR_OUT_OF_MEMORY == deque_reserve(deque, SIZE_MAX));
+  assert(ERROR_OUT_OF_MEMORY == deque_reserve(deque, SIZE_MAX / 2 + 1));
+  assert(capacity == deque->capacity);
+  assert(values == deque->values);
+  assert(99 == deque_get(deque, 99).ui64);
+  deque_delete(deque);
+}
+
+
+static void test_deque_with_value_deallocator() {
+  deque_t* deque;
+  assert(!deque_create_with_value_deallocator(&deque, free));
+  for (uint64_t i = 0; i < 10; i++) {
+    void* p = malloc(100);
+    assert(p);
+    assert(!deque_push_front(deque, (generic_value_t)p));
+  }
+  assert(10 == deque_size(deque));
+  deque_delete(deque);
+}
+
+
+int main(int argc, char** argv) {
+  test_deque_create();
+  test_deque_push_back();
+  test_deque_push_front();
+  test_deque_pop_front();
+  test_deque_pop_back();
+  test_deque_wrap_around();
+  test_deque_set();
+  test_deque_reserve();
+  test_deque_with_value_deallocator();
+  return 0;
+}
@@ -0,0 +1,278 @@
+#include "expiring_map.h"
+
+#include <stdlib.h>
+
+
+// Provide external definitions of inline functions.
+extern inline size_t expiring_map_size(const expiring_map_t* map);
+
+
+error_t expiring_map_create(expiring_map_t** map, uint64_t now) {
+  return expiring_map_create_with_value_deallocator(map, now, 0);
+}
+
+
+error_t expiring_map_create_with_value_deallocator(
+  expiring_map_t** map, uint64_t now, void (*value_deallocator)(void*)) {
+  expiring_map_t* tmp = calloc(1, sizeof(expiring_map_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  if (map_create(&tmp->entries)) {
+    free(tmp);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->value_deallocator = value_deallocator;
+  tmp->time = now;
+  for (size_t level = 0; level < EXPIRING_MAP_WHEEL_LEVELS; level++) {
+    for (size_t i = 0; i < EXPIRING_MAP_WHEEL_SIZE; i++) {
+      intrusive_list_init(&tmp->wheel[level][i]);
+    }
+  }
+  *map = tmp;
+  return 0;
+}
+
+
+void expiring_map_delete(expiring_map_t* map) {
+  if (!map) {
+    return;
+  }
+  for (size_t level = 0; level < EXPIRING_MAP_WHEEL_LEVELS; level++) {
+    for (size_t i = 0; i < EXPIRING_MAP_WHEEL_SIZE; i++) {
+      intrusive_list_link_t* link;
+      while ((link = intrusive_list_pop_front(&map->wheel[level][i]))) {
+	expiring_map_entry_t* entry =
+	  INTRUSIVE_LIST_ENTRY(link, expiring_map_entry_t, link);
+	if (map->value_deallocator) {
+	  map->value_deallocator(entry->value.p);
+	}
+	free(entry);
+      }
+    }
+  }
+  map_delete(map->entries);
+  free(map);
+}
+
+
+// Places an entry in the wheel relative to the current time.
+static void expiring_map_schedule(expiring_map_t* map,
+				  expiring_map_entry_t* entry) {
+  // Entries already due go in the current slot, which the next tick
+  // processes.
+  uint64_t expires_at =
+    entry->expires_at < map->time ? map->time : entry->expires_at;
+  // Use the lowest level whose span covers the time left; slots are
+  // indexed cyclically, so the entry's slot comes round and is cascaded
+  // down before it is due.
+  uint64_t delta = expires_at - map->time;
+  size_t level = 0;
+  while (level < EXPIRING_MAP_WHEEL_LEVELS - 1 &&
+	 delta >> (EXPIRING_MAP_WHEEL_BITS * (level + 1))) {
+    level++;
+  }
+  if (delta >> (EXPIRING_MAP_WHEEL_BITS * EXPIRING_MAP_WHEEL_LEVELS)) {
+    // Too far ahead: place it as late as the top level reaches. It is
+    // scheduled again, from its real expiry, when that slot is cascaded.
+    expires_at = map->time +
+      ((uint64_t)1 << (EXPIRING_MAP_WHEEL_BITS * EXPIRING_MAP_WHEEL_LEVELS)) -
+      1;
+  }
+  size_t slot = (expires_at >> (EXPIRING_MAP_WHEEL_BITS * level)) &
+    (EXPIRING_MAP_WHEEL_SIZE - 1);
+  entry->slot = &map->wheel[level][slot];
+  intrusive_list_push_back(entry->slot, &entry->link);
+  map->level_sizes[level]++;
+}
+
+
+static void expiring_map_unschedule(expiring_map_t* map,
+				    expiring_map_entry_t* entry) {
+  size_t level = (size_t)(entry->slot - &map->wheel[0][0]) /
+    EXPIRING_MAP_WHEEL_SIZE;
+  map->level_sizes[level]--;
+  intrusive_list_remove(entry->slot, &entry->link);
+}
+
+
+// Removes an entry from the map and deletes it along with its value.
+static void expiring_map_expire(expiring_map_t* map,
+				expiring_map_entry_t* entry) {
+  map_remove_element(map->entries, entry->element);
+  expiring_map_unschedule(map, entry);
+  if (map->value_deallocator) {
+    map->value_deallocator(entry->value.p);
+  }
+  free(entry);
+}
+
+
+error_t expiring_map_insert(
+  expiring_map_t* map, const char* key, generic_value_t value, uint64_t now,
+  uint64_t ttl) {
+  uint64_t expires_at = ttl > UINT64_MAX - now ? UINT64_MAX : now + ttl;
+  generic_value_t found;
+  if (map_get(map->entries, key, &found)) {
+    expiring_map_entry_t* entry = found.p;
+    if (map->value_deallocator && entry->value.p != value.p) {
+      map->value_deallocator(entry->value.p);
+    }
+    entry->value = value;
+    entry->expires_at = expires_at;
+    expiring_map_unschedule(map, entry);
+    expiring_map_schedule(map, entry);
+    return 0;
+  }
+
+  expiring_map_entry_t* entry = calloc(1, sizeof(expiring_map_entry_t));
+  if (!entry) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  if (map_insert_element(map->entries, key, (generic_value_t)(void*)entry,
+			 &entry->element)) {
+    free(entry);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  entry->value = value;
+  entry->expires_at = expires_at;
+  expiring_map_schedule(map, entry);
+  return 0;
+}
+
+
+// Finds the entry for a key, expiring it if it is due.
+static expiring_map_entry_t* expiring_map_find(
+  expiring_map_t* map, const char* key, uint64_t now) {
+  generic_value_t found;
+  if (!map_get(map->entries, key, &found)) {
+    return 0;
+  }
+  expiring_map_entry_t* entry = found.p;
+  if (entry->expires_at <= now) {
+    expiring_map_expire(map, entry);
+    return 0;
+  }
+  return entry;
+}
+
+
+bool expiring_map_get(
+  expiring_map_t* map, const char* key, uint64_t now, generic_value_t* value) {
+  expiring_map_entry_t* entry = expiring_map_find(map, key, now);
+  if (!entry) {
+    return false;
+  }
+  *value = entry->value;
+  return true;
+}
+
+
+bool expiring_map_remove(
+  expiring_map_t* map, const char* key, uint64_t now, generic_value_t* value) {
+  expiring_map_entry_t* entry = expiring_map_find(map, key, now);
+  if (!entry) {
+    return false;
+  }
+  map_remove_element(map->entries, entry->element);
+  expiring_map_unschedule(map, entry);
+  *value = entry->value;
+  free(entry);
+  return true;
+}
+
+
+// Moves the entries of the slots reached at the current time down to
+// lower levels, at most max_moves of them. Entries never go back to the
+// slot they came from, so a call that stops early can be repeated to
+// finish. Sets done if every slot was emptied. Returns the number of
+// entries moved.
+static size_t expiring_map_cascade(
+  expiring_map_t* map, size_t max_moves, bool* done) {
+  size_t moved = 0;
+  for (size_t level = EXPIRING_MAP_WHEEL_LEVELS - 1; level > 0; level--) {
+    unsigned shift = EXPIRING_MAP_WHEEL_BITS * level;
+    if (map->time & (((uint64_t)1 << shift) - 1)) {
+      continue;
+    }
+    intrusive_list_t* slot = &map->wheel[level][
+      (map->time >> shift) & (EXPIRING_MAP_WHEEL_SIZE - 1)];
+    intrusive_list_link_t* link;
+    while ((link = intrusive_list_get_front(slot))) {
+      if (moved == max_moves) {
+	*done = false;
+	return moved;
+      }
+      expiring_map_entry_t* entry =
+	INTRUSIVE_LIST_ENTRY(link, expiring_map_entry_t, link);
+      expiring_map_unschedule(map, entry);
+      expiring_map_schedule(map, entry);
+      moved++;
+    }
+  }
+  *done = true;
+  return moved;
+}
+
+
+// Returns the time to skip ahead to when the lowest levels of the wheel
+// are empty and nothing can happen until the next cascade.
+static uint64_t expiring_map_skip_target(const expiring_map_t* map) {
+  size_t level = 0;
+  while (level < EXPIRING_MAP_WHEEL_LEVELS && !map->level_sizes[level]) {
+    level++;
+  }
+  if (level == 0) {
+    return map->time;
+  }
+  if (level == EXPIRING_MAP_WHEEL_LEVELS) {
+    return UINT64_MAX;
+  }
+  uint64_t mask = ((uint64_t)1 << (EXPIRING_MAP_WHEEL_BITS * level)) - 1;
+  if (map->time > UINT64_MAX - mask) {
+    return UINT64_MAX;
+  }
+  return (map->time + mask) & ~mask;
+}
+
+
+size_t expiring_map_tick(expiring_map_t* map, uint64_t now, size_t max_work) {
+  size_t expired = 0;
+  size_t work = 0;
+  while (map->time <= now && work < max_work) {
+    if (!map->cascaded) {
+      uint64_t target = expiring_map_skip_target(map);
+      if (target > map->time) {
+	if (target > now) {
+	  // Nothing is due up to now.
+	  map->time = now;
+	  break;
+	}
+	map->time = target;
+      }
+      // A step that moves nothing still counts as work.
+      bool done;
+      size_t moved = expiring_map_cascade(map, max_work - work, &done);
+      work += moved ? moved : 1;
+      if (!done) {
+	break;
+      }
+      map->cascaded = true;
+    }
+    intrusive_list_t* slot =
+      &map->wheel[0][map->time & (EXPIRING_MAP_WHEEL_SIZE - 1)];
+    intrusive_list_link_t* link;
+    while (work < max_work && (link = intrusive_list_get_front(slot))) {
+      expiring_map_expire(
+	map, INTRUSIVE_LIST_ENTRY(link, expiring_map_entry_t, link));
+      expired++;
+      work++;
+    }
+    if (!intrusive_list_empty(slot) || map->time == now) {
+      break;
+    }
+    map->time++;
+    map->cascaded = false;
+  }
+  return expired;
+}
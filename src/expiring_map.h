@@ -0,0 +1,191 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "errors.h"
+#include "generic.h"
+#include "intrusive_list.h"
+#include "map.h"
+
+
+// The timing wheel has EXPIRING_MAP_WHEEL_LEVELS levels of
+// 2^EXPIRING_MAP_WHEEL_BITS slots. Level n slots cover 2^(bits * n) ticks,
+// so entries expiring up to 2^(bits * levels) ticks ahead are placed
+// directly; later ones are parked in the top level until they come close.
+#define EXPIRING_MAP_WHEEL_BITS 6
+#define EXPIRING_MAP_WHEEL_SIZE (1 << EXPIRING_MAP_WHEEL_BITS)
+#define EXPIRING_MAP_WHEEL_LEVELS 4
+
+typedef struct {
+  intrusive_list_link_t link;
+  // Wheel slot holding the entry.
+  intrusive_list_t* slot;
+  // The entry's element in expiring_map_t.entries, which holds the key.
+  map_element_t* element;
+  generic_value_t value;
+  uint64_t expires_at;
+} expiring_map_entry_t;
+
+typedef struct {
+  void (*value_deallocator)(void*);
+  // Maps keys to their expiring_map_entry_t.
+  map_t* entries;
+  // Tick being processed by expiring_map_tick. It stays at the last now
+  // passed in, and entries already due are placed in its slot, so the
+  // next call expires them.
+  uint64_t time;
+  // True if the wheel has been fully cascaded for time.
+  bool cascaded;
+  size_t level_sizes[EXPIRING_MAP_WHEEL_LEVELS];
+  intrusive_list_t wheel[EXPIRING_MAP_WHEEL_LEVELS][EXPIRING_MAP_WHEEL_SIZE];
+} expiring_map_t;
+
+
+/**
+ * Creates a new expiring map.
+ *
+ * Every entry has a time to live. Entries are placed on a hierarchical
+ * timing wheel, so inserting one and expiring it are O(1) amortized.
+ * Expired entries are removed lazily when accessed, and in bounded batches
+ * by expiring_map_tick.
+ *
+ * Times are in caller-defined ticks (e.g. milliseconds) and must never
+ * go backwards between calls.
+ *
+ * Args:
+ *  map: Set to the newly allocated map.
+ *  now: Current time.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create map because of memory error.
+ */
+error_t expiring_map_create(expiring_map_t** map, uint64_t now);
+
+
+/**
+ * Creates a new expiring map with a value deallocator.
+ *
+ * The deallocation function is used to delete void* values
+ * (generic_value_t.p) when they expire, are replaced by
+ * expiring_map_insert, or are left in the map when expiring_map_delete is
+ * called.
+ *
+ * Args:
+ *  map: Set to the newly allocated map.
+ *  now: Current time.
+ *  deallocated: Function used to delete values.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create map because of memory error.
+ */
+error_t expiring_map_create_with_value_deallocator(
+  expiring_map_t** map, uint64_t now, void (*value_deallocator)(void*));
+
+
+/**
+ * Deletes an expiring map.
+ *
+ * If a deallocation function was provided during creation, map values
+ * will be treated as void* (generic_value_t.p) and sent to the function.
+ *
+ * Args:
+ *  map: Map to be deleted.
+ */
+void expiring_map_delete(expiring_map_t* map);
+
+
+/**
+ * Inserts a key and value into the map.
+ *
+ * If the key already exists in the map, its value and expiry are replaced.
+ *
+ * Args:
+ *  map: Map to update.
+ *  key: Key for map entry.
+ *  value: Value for map entry.
+ *  now: Current time.
+ *  ttl: Number of ticks until the entry expires.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not insert into map because of memory errors.
+ */
+error_t expiring_map_insert(
+  expiring_map_t* map, const char* key, generic_value_t value, uint64_t now,
+  uint64_t ttl);
+
+
+/**
+ * Gets a value from the map.
+ *
+ * An entry found to have expired is removed.
+ *
+ * Args:
+ *  map: The map to examine.
+ *  key: The key to look up.
+ *  now: Current time.
+ *  value: Set to any value found.
+ *
+ * Returns:
+ *  true if an unexpired value is found.
+ */
+bool expiring_map_get(
+  expiring_map_t* map, const char* key, uint64_t now, generic_value_t* value);
+
+
+/**
+ * Removes a key and value from the map.
+ *
+ * An unexpired value is returned to the caller and not deallocated; an
+ * expired one is removed as if it had expired.
+ *
+ * Args:
+ *  map: The map to examine.
+ *  key: The key to look up.
+ *  now: Current time.
+ *  value: Set to any value found.
+ *
+ * Returns:
+ *  true if an unexpired value is found.
+ */
+bool expiring_map_remove(
+  expiring_map_t* map, const char* key, uint64_t now, generic_value_t* value);
+
+
+/**
+ * Removes expired entries.
+ *
+ * Advances the timing wheel towards now, expiring entries as it goes, but
+ * stops once max_work units of work (wheel steps plus entries moved down
+ * the wheel or expired) have been done; the next call resumes where this
+ * one stopped, even in the middle of moving a slot's entries down.
+ *
+ * Args:
+ *  map: The map to update.
+ *  now: Current time.
+ *  max_work: Bound on the work done by this call.
+ *
+ * Returns:
+ *  Number of entries expired.
+ */
+size_t expiring_map_tick(expiring_map_t* map, uint64_t now, size_t max_work);
+
+
+/**
+ * Returns the size of the map.
+ *
+ * This includes expired entries that have not been removed yet.
+ *
+ * Args:
+ *  map: The map to examine.
+ *
+ * Returns:
+ *  Size of the map.
+ */
+inline size_t expiring_map_size(const expiring_map_t* map) {
+  return map_size(map->entries);
+}
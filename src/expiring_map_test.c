@@ -0,0 +1,248 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "expiring_map.h"
+
+
+static void test_expiring_map_create() {
+  expiring_map_t* map;
+  assert(!expiring_map_create(&map, 1000));
+  assert(!expiring_map_size(map));
+  assert(!expiring_map_tick(map, 2000, 100));
+  expiring_map_delete(map);
+}
+
+
+static void test_expiring_map_insert_get() {
+  expiring_map_t* map;
+  assert(!expiring_map_create(&map, 0));
+  generic_value_t value;
+  assert(!expiring_map_insert(map, "a", (generic_value_t)(uint64_t)1, 0, 10));
+  assert(!expiring_map_insert(map, "b", (generic_value_t)(uint64_t)2, 0, 20));
+  assert(2 == expiring_map_size(map));
+  assert(expiring_map_get(map, "a", 9, &value));
+  assert(1 == value.i64);
+  assert(!expiring_map_get(map, "c", 9, &value));
+
+  // Entries expire lazily on access, without any tick.
+  assert(!expiring_map_get(map, "a", 10, &value));
+  assert(1 == expiring_map_size(map));
+  assert(expiring_map_get(map, "b", 19, &value));
+  assert(2 == value.i64);
+
+  // Inserting an existing key replaces its value and expiry.
+  assert(!expiring_map_insert(map, "b", (generic_value_t)(uint64_t)3, 19, 5));
+  assert(1 == expiring_map_size(map));
+  assert(expiring_map_get(map, "b", 23, &value));
+  assert(3 == value.i64);
+  assert(!expiring_map_get(map, "b", 24, &value));
+  assert(!expiring_map_size(map));
+  expiring_map_delete(map);
+}
+
+
+static void test_expiring_map_remove() {
+  expiring_map_t* map;
+  assert(!expiring_map_create(&map, 0));
+  generic_value_t value;
+  assert(!expiring_map_insert(map, "a", (generic_value_t)(uint64_t)1, 0, 10));
+  assert(!expiring_map_insert(map, "b", (generic_value_t)(uint64_t)2, 0, 10));
+  assert(expiring_map_remove(map, "a", 5, &value));
+  assert(1 == value.i64);
+  assert(!expiring_map_remove(map, "a", 5, &value));
+  // Removing an expired entry finds nothing.
+  assert(!expiring_map_remove(map, "b", 10, &value));
+  assert(!expiring_map_size(map));
+  // Removed entries are no longer on the wheel.
+  assert(!expiring_map_tick(map, 100, 1000));
+  expiring_map_delete(map);
+}
+
+
+static void test_expiring_map_tick() {
+  expiring_map_t* map;
+  assert(!expiring_map_create(&map, 100));
+  // TTLs landing on every level of the wheel, and beyond it.
+  uint64_t ttls[] = {
+    0, 1, 63, 64, 65, 4000, 4096, 5000, 262143, 262144, 300000,
+    16777215, 16777216, 20000000, 1000000000
+  };
+  size_t count = sizeof(ttls) / sizeof(ttls[0]);
+  for (size_t i = 0; i < count; i++) {
+    char key[2] = {(char)i + 'a'};
+    assert(!expiring_map_insert(map, key, (generic_value_t)ttls[i], 100,
+				ttls[i]));
+  }
+  for (size_t i = 0; i < count; i++) {
+    // Nothing may expire before its time, and everything due must go.
+    assert(!expiring_map_tick(map, 100 + ttls[i] - 1, SIZE_MAX));
+    assert(count - i == expiring_map_size(map));
+    assert(1 == expiring_map_tick(map, 100 + ttls[i], SIZE_MAX));
+    assert(count - i - 1 == expiring_map_size(map));
+  }
+  expiring_map_delete(map);
+}
+
+
+static void test_expiring_map_tick_across_boundaries() {
+  // Entries due just after each level of the wheel rolls over.
+  for (unsigned level = 1; level <= EXPIRING_MAP_WHEEL_LEVELS; level++) {
+    uint64_t boundary = (uint64_t)1 << (EXPIRING_MAP_WHEEL_BITS * level);
+    expiring_map_t* map;
+    assert(!expiring_map_create(&map, 0));
+    assert(!expiring_map_tick(map, boundary - 2, SIZE_MAX));
+    uint64_t now = boundary - 1;
+    assert(!expiring_map_insert(map, "a", (generic_value_t)1.0, now, 10));
+    assert(!expiring_map_insert(map, "b", (generic_value_t)2.0, now, 200));
+    assert(!expiring_map_tick(map, now + 9, SIZE_MAX));
+    assert(1 == expiring_map_tick(map, now + 10, SIZE_MAX));
+    assert(!expiring_map_tick(map, now + 199, SIZE_MAX));
+    assert(1 == expiring_map_tick(map, now + 200, SIZE_MAX));
+    assert(!expiring_map_size(map));
+    expiring_map_delete(map);
+  }
+}
+
+
+static void test_expiring_map_tick_bounded_work() {
+  expiring_map_t* map;
+  assert(!expiring_map_create(&map, 0));
+  char key[16];
+  for (uint64_t i = 0; i < 1000; i++) {
+    sprintf(key, "%lu", (unsigned long)i);
+    assert(!expiring_map_insert(map, key, (generic_value_t)i, 0, i % 200));
+  }
+  size_t expired = 0;
+  size_t calls = 0;
+  while (expiring_map_size(map)) {
+    size_t n = expiring_map_tick(map, 1000, 10);
+    assert(n <= 10);
+    expired += n;
+    calls++;
+  }
+  assert(1000 == expired);
+  assert(calls >= 100);
+
+  // Later inserts still expire on time.
+  generic_value_t value;
+  assert(!expiring_map_insert(map, "a", (generic_value_t)(uint64_t)1, 1000,
+			      50));
+  assert(!expiring_map_tick(map, 1049, 100));
+  assert(expiring_map_get(map, "a", 1049, &value));
+  assert(1 == expiring_map_tick(map, 1050, 100));
+  assert(!expiring_map_size(map));
+  expiring_map_delete(map);
+}
+
+
+static void test_expiring_map_tick_bounded_cascade() {
+  expiring_map_t* map;
+  assert(!expiring_map_create(&map, 0));
+  char key[16];
+  // All in one level 1 slot, which must be moved down before any expire.
+  for (uint64_t i = 0; i < 1000; i++) {
+    sprintf(key, "%lu", (unsigned long)i);
+    assert(!expiring_map_insert(map, key, (generic_value_t)i, 0,
+				64 + i % 64));
+  }
+  size_t calls = 0;
+  while (!expiring_map_tick(map, 64, 10)) {
+    calls++;
+  }
+  // Moving the slot down is spread over calls too.
+  assert(calls >= 99);
+  while (expiring_map_size(map) > 1000 - 16) {
+    expiring_map_tick(map, 64, 10);
+  }
+  assert(1000 - 16 == expiring_map_size(map));
+  assert(1000 - 16 == expiring_map_tick(map, 127, SIZE_MAX));
+  assert(!expiring_map_size(map));
+  expiring_map_delete(map);
+}
+
+
+static void test_expiring_map_tick_past_due() {
+  expiring_map_t* map;
+  assert(!expiring_map_create(&map, 0));
+  generic_value_t value;
+  assert(!expiring_map_tick(map, 100, SIZE_MAX));
+  // Already due when inserted, so the next tick at the same time expires
+  // them.
+  assert(!expiring_map_insert(map, "a", (generic_value_t)(uint64_t)1, 100,
+			      0));
+  assert(!expiring_map_insert(map, "b", (generic_value_t)(uint64_t)2, 90, 5));
+  assert(!expiring_map_insert(map, "c", (generic_value_t)(uint64_t)3, 100,
+			      1));
+  assert(2 == expiring_map_tick(map, 100, SIZE_MAX));
+  assert(expiring_map_get(map, "c", 100, &value));
+  assert(1 == expiring_map_tick(map, 101, SIZE_MAX));
+  assert(!expiring_map_size(map));
+  expiring_map_delete(map);
+}
+
+
+static void test_expiring_map_tick_random() {
+  expiring_map_t* map;
+  assert(!expiring_map_create(&map, 0));
+  uint64_t expiries[500];
+  char key[16];
+  srand(1);
+  uint64_t now = 0;
+  for (size_t i = 0; i < 500; i++) {
+    uint64_t ttl = (uint64_t)rand() % 100000;
+    expiries[i] = now + ttl;
+    sprintf(key, "%lu", (unsigned long)i);
+    assert(!expiring_map_insert(map, key, (generic_value_t)(uint64_t)i, now,
+				ttl));
+    now += (uint64_t)rand() % 50;
+    expiring_map_tick(map, now, SIZE_MAX);
+  }
+  while (expiring_map_size(map)) {
+    now += (uint64_t)rand() % 2000;
+    expiring_map_tick(map, now, SIZE_MAX);
+    // Everything due is gone, and everything else remains.
+    for (size_t i = 0; i < 500; i++) {
+      generic_value_t value;
+      sprintf(key, "%lu", (unsigned long)i);
+      size_t size = expiring_map_size(map);
+      bool found = expiring_map_get(map, key, now, &value);
+      assert(found == (expiries[i] > now));
+      assert(size == expiring_map_size(map));
+    }
+  }
+  expiring_map_delete(map);
+}
+
+
+static void test_expiring_map_value_deallocator() {
+  expiring_map_t* map;
+  assert(!expiring_map_create_with_value_deallocator(&map, 0, free));
+  generic_value_t value;
+  assert(!expiring_map_insert(map, "a", (generic_value_t)malloc(10), 0, 10));
+  assert(!expiring_map_insert(map, "a", (generic_value_t)malloc(10), 0, 10));
+  assert(!expiring_map_insert(map, "b", (generic_value_t)malloc(10), 0, 10));
+  assert(!expiring_map_insert(map, "c", (generic_value_t)malloc(10), 0, 20));
+  assert(!expiring_map_insert(map, "d", (generic_value_t)malloc(10), 0, 30));
+  assert(!expiring_map_insert(map, "e", (generic_value_t)malloc(10), 0, 40));
+  assert(2 == expiring_map_tick(map, 10, 100));
+  assert(!expiring_map_get(map, "c", 20, &value));
+  assert(expiring_map_remove(map, "d", 20, &value));
+  free(value.p);
+  expiring_map_delete(map);
+}
+
+
+int main(int argc, char** argv) {
+  test_expiring_map_create();
+  test_expiring_map_insert_get();
+  test_expiring_map_remove();
+  test_expiring_map_tick();
+  test_expiring_map_tick_across_boundaries();
+  test_expiring_map_tick_bounded_work();
+  test_expiring_map_tick_bounded_cascade();
+  test_expiring_map_tick_past_due();
+  test_expiring_map_tick_random();
+  test_expiring_map_value_deallocator();
+  return 0;
+}
@@ -0,0 +1,507 @@
+#include "hamt.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+#include "string_util.h"
+
+
+static const uint32_t LEVEL_MASK = (1 << HAMT_BITS) - 1;
+
+
+// Provide external definitions of inline functions.
+extern inline size_t hamt_size(const hamt_t* map);
+extern inline bool hamt_iterator_has_current(const hamt_iterator_t* iter);
+extern inline void hamt_iterator_get_current(
+  const hamt_iterator_t* iter, const char** key, generic_value_t* value);
+
+
+static hamt_node_t* hamt_node_retain(hamt_node_t* node) {
+  atomic_fetch_add_explicit(&node->refcount, 1, memory_order_relaxed);
+  return node;
+}
+
+
+// Drops a reference to node, freeing it and releasing its children if it
+// was the last. Values are not the map's, so leaves are simply freed.
+static void hamt_node_release(hamt_node_t* node) {
+  if (!node || atomic_fetch_sub_explicit(&node->refcount, 1,
+					 memory_order_acq_rel) != 1) {
+    return;
+  }
+  if (node->type == HAMT_BRANCH) {
+    hamt_branch_t* branch = (hamt_branch_t*)node;
+    int count = __builtin_popcount(branch->bitmap);
+    for (int i = 0; i < count; i++) {
+      hamt_node_release(branch->children[i]);
+    }
+  } else if (node->type == HAMT_COLLISION) {
+    hamt_collision_t* collision = (hamt_collision_t*)node;
+    for (size_t i = 0; i < collision->count; i++) {
+      hamt_node_release(&collision->leaves[i]->node);
+    }
+  }
+  free(node);
+}
+
+
+static hamt_leaf_t* hamt_leaf_create(
+  const char* key, size_t key_length, uint64_t hash, generic_value_t value) {
+  hamt_leaf_t* leaf = malloc(sizeof(hamt_leaf_t) + key_length + 1);
+  if (!leaf) {
+    return 0;
+  }
+  atomic_init(&leaf->node.refcount, 1);
+  leaf->node.type = HAMT_LEAF;
+  leaf->hash = hash;
+  leaf->value = value;
+  leaf->key_length = key_length;
+  memcpy(leaf->key, key, key_length + 1);
+  return leaf;
+}
+
+
+// Creates a branch with room for the children in bitmap, which the caller
+// fills in.
+static hamt_branch_t* hamt_branch_create(uint32_t bitmap) {
+  hamt_branch_t* branch = malloc(
+    sizeof(hamt_branch_t) +
+    __builtin_popcount(bitmap) * sizeof(hamt_node_t*));
+  if (!branch) {
+    return 0;
+  }
+  atomic_init(&branch->node.refcount, 1);
+  branch->node.type = HAMT_BRANCH;
+  branch->bitmap = bitmap;
+  return branch;
+}
+
+
+// Creates a collision node for count leaves, which the caller fills in.
+static hamt_collision_t* hamt_collision_create(uint64_t hash, size_t count) {
+  hamt_collision_t* collision =
+    malloc(sizeof(hamt_collision_t) + count * sizeof(hamt_leaf_t*));
+  if (!collision) {
+    return 0;
+  }
+  atomic_init(&collision->node.refcount, 1);
+  collision->node.type = HAMT_COLLISION;
+  collision->hash = hash;
+  collision->count = count;
+  return collision;
+}
+
+
+// Returns the hash of the keys under a leaf or collision node.
+static uint64_t hamt_node_hash(const hamt_node_t* node) {
+  return node->type == HAMT_LEAF ? ((const hamt_leaf_t*)node)->hash :
+    ((const hamt_collision_t*)node)->hash;
+}
+
+
+// Returns the index in branch->children of the child for bit, which must
+// be set.
+static int hamt_branch_index(const hamt_branch_t* branch, uint32_t bit) {
+  return __builtin_popcount(branch->bitmap & (bit - 1));
+}
+
+
+// Returns new branches holding node, a leaf or collision node, and leaf,
+// whose hashes differ, from the given level down.
+static hamt_node_t* hamt_merge(
+  hamt_node_t* node, hamt_leaf_t* leaf, int shift) {
+  uint32_t node_bits = (hamt_node_hash(node) >> shift) & LEVEL_MASK;
+  uint32_t leaf_bits = (leaf->hash >> shift) & LEVEL_MASK;
+  if (node_bits == leaf_bits) {
+    hamt_node_t* child = hamt_merge(node, leaf, shift + HAMT_BITS);
+    if (!child) {
+      return 0;
+    }
+    hamt_branch_t* branch = hamt_branch_create(1u << node_bits);
+    if (!branch) {
+      hamt_node_release(child);
+      return 0;
+    }
+    branch->children[0] = child;
+    return &branch->node;
+  }
+  hamt_branch_t* branch =
+    hamt_branch_create((1u << node_bits) | (1u << leaf_bits));
+  if (!branch) {
+    return 0;
+  }
+  int leaf_index = leaf_bits > node_bits;
+  branch->children[leaf_index] = hamt_node_retain(&leaf->node);
+  branch->children[!leaf_index] = hamt_node_retain(node);
+  return &branch->node;
+}
+
+
+// Returns a copy of node with leaf inserted, sharing everything else with
+// node, or NULL on memory errors. If the key already has leaf's value,
+// returns node itself, retained. Neither node nor leaf is consumed.
+static hamt_node_t* hamt_node_insert(
+  hamt_node_t* node, hamt_leaf_t* leaf, int shift, bool* added) {
+  if (node->type == HAMT_BRANCH) {
+    hamt_branch_t* branch = (hamt_branch_t*)node;
+    uint32_t bit = 1u << ((leaf->hash >> shift) & LEVEL_MASK);
+    int index = hamt_branch_index(branch, bit);
+    int count = __builtin_popcount(branch->bitmap);
+    hamt_node_t* child;
+    hamt_branch_t* copy;
+    if (branch->bitmap & bit) {
+      child = hamt_node_insert(branch->children[index], leaf,
+			       shift + HAMT_BITS, added);
+      if (!child) {
+	return 0;
+      }
+      if (child == branch->children[index]) {
+	hamt_node_release(child);
+	return hamt_node_retain(node);
+      }
+      if (!(copy = hamt_branch_create(branch->bitmap))) {
+	hamt_node_release(child);
+	return 0;
+      }
+      for (int i = 0; i < count; i++) {
+	copy->children[i] = i == index ? child :
+	  hamt_node_retain(branch->children[i]);
+      }
+    } else {
+      if (!(copy = hamt_branch_create(branch->bitmap | bit))) {
+	return 0;
+      }
+      for (int i = 0; i < count; i++) {
+	copy->children[i + (i >= index)] =
+	  hamt_node_retain(branch->children[i]);
+      }
+      copy->children[index] = hamt_node_retain(&leaf->node);
+      *added = true;
+    }
+    return &copy->node;
+  }
+
+  if (hamt_node_hash(node) != leaf->hash) {
+    *added = true;
+    return hamt_merge(node, leaf, shift);
+  }
+  if (node->type == HAMT_LEAF) {
+    hamt_leaf_t* old = (hamt_leaf_t*)node;
+    if (string_equal(old->key, old->key_length, leaf->key,
+		     leaf->key_length)) {
+      // Replace the value, keeping the old leaf, and so the whole path,
+      // when the value is the same.
+      return hamt_node_retain(
+	old->value.ui64 == leaf->value.ui64 ? node : &leaf->node);
+    }
+    hamt_collision_t* collision = hamt_collision_create(leaf->hash, 2);
+    if (!collision) {
+      return 0;
+    }
+    collision->leaves[0] = (hamt_leaf_t*)hamt_node_retain(node);
+    collision->leaves[1] = (hamt_leaf_t*)hamt_node_retain(&leaf->node);
+    *added = true;
+    return &collision->node;
+  }
+
+  // Replace the leaf with the same key, or add one.
+  hamt_collision_t* collision = (hamt_collision_t*)node;
+  size_t index = 0;
+  while (index < collision->count &&
+	 !string_equal(collision->leaves[index]->key,
+		       collision->leaves[index]->key_length, leaf->key,
+		       leaf->key_length)) {
+    index++;
+  }
+  *added = index == collision->count;
+  if (!*added && collision->leaves[index]->value.ui64 == leaf->value.ui64) {
+    return hamt_node_retain(node);
+  }
+  hamt_collision_t* copy =
+    hamt_collision_create(leaf->hash, collision->count + *added);
+  if (!copy) {
+    return 0;
+  }
+  for (size_t i = 0; i < collision->count; i++) {
+    copy->leaves[i] = (hamt_leaf_t*)hamt_node_retain(
+      i == index ? &leaf->node : &collision->leaves[i]->node);
+  }
+  if (*added) {
+    copy->leaves[index] = (hamt_leaf_t*)hamt_node_retain(&leaf->node);
+  }
+  return &copy->node;
+}
+
+
+// Sets result to a copy of node without key, sharing everything else with
+// node, or NULL if nothing is left. If key is absent, sets removed to NULL
+// and leaves result unset. Nothing is consumed.
+static error_t hamt_node_remove(
+  hamt_node_t* node, const char* key, size_t key_length, uint64_t hash,
+  int shift, hamt_node_t** result, hamt_leaf_t** removed) {
+  *removed = 0;
+  if (node->type == HAMT_LEAF) {
+    hamt_leaf_t* leaf = (hamt_leaf_t*)node;
+    if (leaf->hash == hash &&
+	string_equal(leaf->key, leaf->key_length, key, key_length)) {
+      *removed = leaf;
+      *result = 0;
+    }
+    return 0;
+  }
+
+  if (node->type == HAMT_COLLISION) {
+    hamt_collision_t* collision = (hamt_collision_t*)node;
+    if (collision->hash != hash) {
+      return 0;
+    }
+    size_t index = 0;
+    while (index < collision->count &&
+	   !string_equal(collision->leaves[index]->key,
+			 collision->leaves[index]->key_length, key,
+			 key_length)) {
+      index++;
+    }
+    if (index == collision->count) {
+      return 0;
+    }
+    if (collision->count == 2) {
+      // A single leaf needs no collision node.
+      *result = hamt_node_retain(&collision->leaves[!index]->node);
+    } else {
+      hamt_collision_t* copy =
+	hamt_collision_create(hash, collision->count - 1);
+      if (!copy) {
+	return ERROR_OUT_OF_MEMORY;
+      }
+      for (size_t i = 0, j = 0; i < collision->count; i++) {
+	if (i != index) {
+	  copy->leaves[j++] =
+	    (hamt_leaf_t*)hamt_node_retain(&collision->leaves[i]->node);
+	}
+      }
+      *result = &copy->node;
+    }
+    *removed = collision->leaves[index];
+    return 0;
+  }
+
+  hamt_branch_t* branch = (hamt_branch_t*)node;
+  uint32_t bit = 1u << ((hash >> shift) & LEVEL_MASK);
+  if (!(branch->bitmap & bit)) {
+    return 0;
+  }
+  int index = hamt_branch_index(branch, bit);
+  int count = __builtin_popcount(branch->bitmap);
+  hamt_node_t* child;
+  if (hamt_node_remove(branch->children[index], key, key_length, hash,
+		       shift + HAMT_BITS, &child, removed)) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  if (!*removed) {
+    return 0;
+  }
+  // Keep the trie canonical: a branch whose only child is a leaf or
+  // collision node is replaced by the child.
+  if (!child && count == 1) {
+    *result = 0;
+    return 0;
+  }
+  if (!child && count == 2 &&
+      branch->children[!index]->type != HAMT_BRANCH) {
+    *result = hamt_node_retain(branch->children[!index]);
+    return 0;
+  }
+  if (child && count == 1 && child->type != HAMT_BRANCH) {
+    *result = child;
+    return 0;
+  }
+  hamt_branch_t* copy =
+    hamt_branch_create(child ? branch->bitmap : branch->bitmap & ~bit);
+  if (!copy) {
+    hamt_node_release(child);
+    *removed = 0;
+    return ERROR_OUT_OF_MEMORY;
+  }
+  for (int i = 0, j = 0; i < count; i++) {
+    if (i != index) {
+      copy->children[j++] = hamt_node_retain(branch->children[i]);
+    } else if (child) {
+      copy->children[j++] = child;
+    }
+  }
+  *result = &copy->node;
+  return 0;
+}
+
+
+error_t hamt_create(hamt_t** map) {
+  hamt_t* tmp = calloc(1, sizeof(hamt_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  *map = tmp;
+  return 0;
+}
+
+
+void hamt_delete(hamt_t* map) {
+  if (!map) {
+    return;
+  }
+  hamt_node_release(map->root);
+  free(map);
+}
+
+
+error_t hamt_snapshot(const hamt_t* map, hamt_t** snapshot) {
+  hamt_t* tmp = malloc(sizeof(hamt_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  *tmp = *map;
+  if (tmp->root) {
+    hamt_node_retain(tmp->root);
+  }
+  *snapshot = tmp;
+  return 0;
+}
+
+
+error_t hamt_insert(hamt_t* map, const char* key, generic_value_t value) {
+  hamt_leaf_t* leaf =
+    hamt_leaf_create(key, string_length(key), hash_string_mixed(key), value);
+  if (!leaf) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  if (!map->root) {
+    map->root = &leaf->node;
+    map->size = 1;
+    return 0;
+  }
+  bool added = false;
+  hamt_node_t* root = hamt_node_insert(map->root, leaf, 0, &added);
+  // The new nodes hold their own references to the leaf. On failure this
+  // frees it.
+  hamt_node_release(&leaf->node);
+  if (!root) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  hamt_node_release(map->root);
+  map->root = root;
+  map->size += added;
+  return 0;
+}
+
+
+bool hamt_get(const hamt_t* map, const char* key, generic_value_t* value) {
+  uint64_t hash = hash_string_mixed(key);
+  size_t key_length = string_length(key);
+  const hamt_node_t* node = map->root;
+  for (int shift = 0; node; shift += HAMT_BITS) {
+    if (node->type == HAMT_BRANCH) {
+      const hamt_branch_t* branch = (const hamt_branch_t*)node;
+      uint32_t bit = 1u << ((hash >> shift) & LEVEL_MASK);
+      if (!(branch->bitmap & bit)) {
+	return false;
+      }
+      node = branch->children[hamt_branch_index(branch, bit)];
+      continue;
+    }
+    if (hamt_node_hash(node) != hash) {
+      return false;
+    }
+    if (node->type == HAMT_LEAF) {
+      const hamt_leaf_t* leaf = (const hamt_leaf_t*)node;
+      if (!string_equal(leaf->key, leaf->key_length, key, key_length)) {
+	return false;
+      }
+      *value = leaf->value;
+      return true;
+    }
+    const hamt_collision_t* collision = (const hamt_collision_t*)node;
+    for (size_t i = 0; i < collision->count; i++) {
+      const hamt_leaf_t* leaf = collision->leaves[i];
+      if (string_equal(leaf->key, leaf->key_length, key, key_length)) {
+	*value = leaf->value;
+	return true;
+      }
+    }
+    return false;
+  }
+  return false;
+}
+
+
+error_t hamt_remove(
+  hamt_t* map, const char* key, generic_value_t* value, bool* removed) {
+  *removed = false;
+  if (!map->root) {
+    return 0;
+  }
+  hamt_node_t* root;
+  hamt_leaf_t* leaf;
+  if (hamt_node_remove(map->root, key, string_length(key),
+		       hash_string_mixed(key), 0, &root, &leaf)) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  if (!leaf) {
+    return 0;
+  }
+  // Read the value before releasing the old root, which may free the leaf.
+  *value = leaf->value;
+  *removed = true;
+  hamt_node_release(map->root);
+  map->root = root;
+  map->size--;
+  return 0;
+}
+
+
+// Descends from node to its first leaf, recording the path.
+static void hamt_iterator_descend(
+  hamt_iterator_t* iter, const hamt_node_t* node) {
+  while (node->type != HAMT_LEAF) {
+    iter->path[iter->depth].node = node;
+    iter->path[iter->depth++].index = 0;
+    node = node->type == HAMT_BRANCH ?
+      ((const hamt_branch_t*)node)->children[0] :
+      &((const hamt_collision_t*)node)->leaves[0]->node;
+  }
+  iter->leaf = (const hamt_leaf_t*)node;
+}
+
+
+hamt_iterator_t hamt_iterator_create(const hamt_t* map) {
+  hamt_iterator_t iter;
+  iter.depth = 0;
+  iter.leaf = 0;
+  if (map->root) {
+    hamt_iterator_descend(&iter, map->root);
+  }
+  return iter;
+}
+
+
+void hamt_iterator_next(hamt_iterator_t* iter) {
+  while (iter->depth) {
+    const hamt_node_t* node = iter->path[iter->depth - 1].node;
+    size_t index = ++iter->path[iter->depth - 1].index;
+    if (node->type == HAMT_BRANCH) {
+      const hamt_branch_t* branch = (const hamt_branch_t*)node;
+      if (index < (size_t)__builtin_popcount(branch->bitmap)) {
+	hamt_iterator_descend(iter, branch->children[index]);
+	return;
+      }
+    } else {
+      const hamt_collision_t* collision = (const hamt_collision_t*)node;
+      if (index < collision->count) {
+	iter->leaf = collision->leaves[index];
+	return;
+      }
+    }
+    iter->depth--;
+  }
+  iter->leaf = 0;
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "errors.h"
+#include "generic.h"
+
+
+// Hash bits consumed by each level of the trie.
+#define HAMT_BITS 5
+// Levels needed to consume a 64 bit hash, plus one for keys whose hashes
+// are equal.
+#define HAMT_MAX_DEPTH ((64 + HAMT_BITS - 1) / HAMT_BITS + 1)
+
+typedef enum {
+  HAMT_LEAF,
+  HAMT_BRANCH,
+  HAMT_COLLISION
+} hamt_node_type_t;
+
+// Nodes never change once built, so they are shared by every version of a
+// map that contains them and freed when the last one lets go.
+typedef struct {
+  atomic_size_t refcount;
+  hamt_node_type_t type;
+} hamt_node_t;
+
+typedef struct {
+  hamt_node_t node;
+  uint64_t hash;
+  generic_value_t value;
+  size_t key_length;
+  char key[];
+} hamt_leaf_t;
+
+typedef struct {
+  hamt_node_t node;
+  // Bit i is set if there is a child for hash bits i at this level.
+  uint32_t bitmap;
+  // One child per bit set, in bit order.
+  hamt_node_t* children[];
+} hamt_branch_t;
+
+typedef struct {
+  hamt_node_t node;
+  // Hash shared by all the leaves.
+  uint64_t hash;
+  size_t count;
+  hamt_leaf_t* leaves[];
+} hamt_collision_t;
+
+typedef struct {
+  size_t size;
+  hamt_node_t* root;
+} hamt_t;
+
+typedef struct {
+  // Nodes above the current leaf and the index of the child taken in each.
+  struct {
+    const hamt_node_t* node;
+    size_t index;
+  } path[HAMT_MAX_DEPTH];
+  size_t depth;
+  const hamt_leaf_t* leaf;
+} hamt_iterator_t;
+
+
+/**
+ * Creates a new persistent map.
+ *
+ * The map is a hash array mapped trie: each level indexes its children by
+ * five more bits of the key's hash. Updates copy only the nodes on the
+ * path to the key, O(log n) of them, and share the rest with earlier
+ * versions, so hamt_snapshot can capture the map in O(1) time.
+ *
+ * Versions may be read and deleted from different threads; each version
+ * must only be updated by one thread at a time.
+ *
+ * The map does not own its values. A value may be held by any number of
+ * versions, even after being replaced or removed in one of them, so the
+ * caller must keep void* values (generic_value_t.p) alive until every
+ * version that may hold them has been deleted.
+ *
+ * Args:
+ *  map: Set to the newly allocated map.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create map because of memory error.
+ */
+error_t hamt_create(hamt_t** map);
+
+
+/**
+ * Deletes a version of a map.
+ *
+ * Nodes still used by other versions are kept.
+ *
+ * Args:
+ *  map: Map to be deleted.
+ */
+void hamt_delete(hamt_t* map);
+
+
+/**
+ * Captures the current contents of a map in O(1) time.
+ *
+ * The snapshot is an independent map sharing all of its nodes with the
+ * original; later updates to either leave the other unchanged. It must be
+ * deleted with hamt_delete.
+ *
+ * Args:
+ *  map: Map to capture.
+ *  snapshot: Set to the newly allocated snapshot.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create snapshot because of memory error.
+ */
+error_t hamt_snapshot(const hamt_t* map, hamt_t** snapshot);
+
+
+/**
+ * Inserts a key and value into the map.
+ *
+ * If the key already exists in the map, the value is updated. Inserting
+ * the value a key already has leaves the map unchanged.
+ *
+ * Args:
+ *  map: Map to update.
+ *  key: Key for map entry.
+ *  value: Value for map entry.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not insert into map because of memory errors.
+ *   The map is unchanged.
+ */
+error_t hamt_insert(hamt_t* map, const char* key, generic_value_t value);
+
+
+/**
+ * Gets a value from the map.
+ *
+ * Args:
+ *  map: The map to examine.
+ *  key: The key to look up.
+ *  value: Set to any value found.
+ *
+ * Returns:
+ *  true if the value is found.
+ */
+bool hamt_get(const hamt_t* map, const char* key, generic_value_t* value);
+
+
+/**
+ * Removes a key and value from the map.
+ *
+ * The value is returned to the caller, but snapshots may still hold it.
+ *
+ * Args:
+ *  map: The map to update.
+ *  key: The key to look up.
+ *  value: Set to any value found.
+ *  removed: Set to true if the key was found and removed.
+ *
+ * Returns:
+ *  0 on success, whether or not the key was found.
+ *  ERROR_OUT_OF_MEMORY: Could not remove from map because of memory errors.
+ *   The map is unchanged.
+ */
+error_t hamt_remove(
+  hamt_t* map, const char* key, generic_value_t* value, bool* removed);
+
+
+/**
+ * Returns the size of the map.
+ *
+ * Args:
+ *  map: The map to examine.
+ *
+ * Returns:
+ *  Size of the map.
+ */
+inline size_t hamt_size(const hamt_t* map) { return map->size; }
+
+
+/**
+ * Creates an iterator for a map.
+ *
+ * The iterator sees the map as it was when created, even if it is
+ * updated afterwards, as long as the map or a snapshot of it is kept.
+ *
+ * Args:
+ *  map: Map to create iterator for.
+ *
+ * Returns:
+ *  Iterator for the given map.
+ */
+hamt_iterator_t hamt_iterator_create(const hamt_t* map);
+
+
+/**
+ * Returns true if the iterator has a current element.
+ *
+ * If this function returns true, it is safe to call hamt_iterator_get_current
+ * and hamt_iterator_next.
+ *
+ * Args:
+ *  iter: Iterator to examine
+ *
+ * Returns:
+ *  true if the iterator has a current element.
+ */
+inline bool hamt_iterator_has_current(const hamt_iterator_t* iter) {
+  return iter->leaf;
+}
+
+
+/**
+ * Gets the current element for the iterator.
+ *
+ * This call should be proceeded by a successful call to
+ * hamt_iterator_has_current.
+ *
+ * Args:
+ *  iter: Iterator to examine.
+ *  key: Set to the key for the current element (owned by the map and valid
+ *   while any version containing it is kept).
+ *  value: Set to the value for the current element.
+ */
+inline void hamt_iterator_get_current(
+  const hamt_iterator_t* iter, const char** key, generic_value_t* value) {
+  *key = iter->leaf->key;
+  *value = iter->leaf->value;
+}
+
+
+/**
+ * Moves the iterator to the next value.
+ *
+ * This call should be proceeded by a successful call to
+ * hamt_iterator_has_current.
+ *
+ * Args:
+ *  iter: Iterator to update.
+ */
+void hamt_iterator_next(hamt_iterator_t* iter);
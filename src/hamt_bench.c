@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "hamt.h"
+#include "map.h"
+
+
+// Copying a map_t reinserts every key into its fixed buckets, so by default
+// the size sweep stops where that still finishes quickly.
+#define BENCH_DEFAULT_MAX_SIZE 10000
+#define BENCH_GETS 100000
+#define BENCH_SNAPSHOTS 100000
+#define BENCH_COPIES 10
+#define BENCH_KEY_SIZE 24
+
+
+// Compares taking a snapshot of a HAMT with deep-copying a map_t.
+static void bench_snapshots(size_t size) {
+  char* keys = bench_make_keys("key:", size, BENCH_KEY_SIZE);
+  char name[64];
+  hamt_t* hamt;
+  map_t* map;
+  if (hamt_create(&hamt) || map_create(&map)) {
+    abort();
+  }
+  uint64_t start = bench_now_ns();
+  for (size_t i = 0; i < size; i++) {
+    if (hamt_insert(hamt, keys + i * BENCH_KEY_SIZE, (generic_value_t)i)) {
+      abort();
+    }
+  }
+  snprintf(name, sizeof(name), "hamt_insert/%zu", size);
+  bench_report(name, size, bench_now_ns() - start);
+  for (size_t i = 0; i < size; i++) {
+    if (map_insert(map, keys + i * BENCH_KEY_SIZE, (generic_value_t)i)) {
+      abort();
+    }
+  }
+
+  uint64_t seed = 1;
+  uint64_t sum = 0;
+  generic_value_t value;
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_GETS; i++) {
+    size_t index = bench_random(&seed) % size;
+    sum += hamt_get(hamt, keys + index * BENCH_KEY_SIZE, &value);
+  }
+  snprintf(name, sizeof(name), "hamt_get_hit/%zu", size);
+  bench_report(name, BENCH_GETS, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_COPIES; i++) {
+    map_t* copy;
+    if (map_create(&copy)) {
+      abort();
+    }
+    for (map_iterator_t iter = map_iterator_create(map);
+	 map_iterator_has_current(&iter); map_iterator_next(&iter)) {
+      const char* key;
+      map_iterator_get_current(&iter, &key, &value);
+      if (map_insert(copy, key, value)) {
+	abort();
+      }
+    }
+    sum += map_size(copy);
+    map_delete(copy);
+  }
+  snprintf(name, sizeof(name), "map_copy/%zu", size);
+  bench_report(name, BENCH_COPIES, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_SNAPSHOTS; i++) {
+    hamt_t* snapshot;
+    if (hamt_snapshot(hamt, &snapshot)) {
+      abort();
+    }
+    sum += hamt_size(snapshot);
+    hamt_delete(snapshot);
+  }
+  snprintf(name, sizeof(name), "hamt_snapshot/%zu", size);
+  bench_report(name, BENCH_SNAPSHOTS, bench_now_ns() - start);
+
+  // Each update while a snapshot is held copies the path to its key.
+  hamt_t* snapshot;
+  if (hamt_snapshot(hamt, &snapshot)) {
+    abort();
+  }
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_SNAPSHOTS; i++) {
+    size_t index = bench_random(&seed) % size;
+    if (hamt_insert(hamt, keys + index * BENCH_KEY_SIZE,
+		    (generic_value_t)(uint64_t)i)) {
+      abort();
+    }
+  }
+  snprintf(name, sizeof(name), "hamt_update_with_snapshot/%zu", size);
+  bench_report(name, BENCH_SNAPSHOTS, bench_now_ns() - start);
+  hamt_delete(snapshot);
+
+  bench_use(sum);
+  hamt_delete(hamt);
+  map_delete(map);
+  free(keys);
+}
+
+
+int main(int argc, char** argv) {
+  size_t sizes[BENCH_MAX_SIZES];
+  size_t count = bench_sizes(sizes, BENCH_DEFAULT_MAX_SIZE);
+  for (size_t i = 0; i < count; i++) {
+    bench_snapshots(sizes[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,318 @@
+#include "hamt.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+
+
+// Keys whose hashes are equal, to exercise collision nodes.
+static const char* colliding_keys[] = {"#; ", "$8 ", "(. "};
+
+static void test_hamt_create() {
+  hamt_t* map;
+  assert(!hamt_create(&map));
+  assert(!hamt_size(map));
+  generic_value_t value;
+  assert(!hamt_get(map, "a", &value));
+  hamt_delete(map);
+}
+
+
+static void test_hamt_insert_get() {
+  hamt_t* map;
+  assert(!hamt_create(&map));
+  generic_value_t value;
+  assert(!hamt_insert(map, "a", (generic_value_t)1.0));
+  assert(!hamt_insert(map, "", (generic_value_t)2.0));
+  assert(2 == hamt_size(map));
+  assert(hamt_get(map, "a", &value));
+  assert(1.0 == value.d);
+  assert(hamt_get(map, "", &value));
+  assert(2.0 == value.d);
+  assert(!hamt_get(map, "b", &value));
+
+  // Inserting an existing key updates its value.
+  assert(!hamt_insert(map, "a", (generic_value_t)3.0));
+  assert(2 == hamt_size(map));
+  assert(hamt_get(map, "a", &value));
+  assert(3.0 == value.d);
+  hamt_delete(map);
+}
+
+
+static void test_hamt_many() {
+  hamt_t* map;
+  assert(!hamt_create(&map));
+  for (int64_t i = 0; i < 10000; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    assert(!hamt_insert(map, key, (generic_value_t)i));
+  }
+  assert(10000 == hamt_size(map));
+  for (int64_t i = 0; i < 10000; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    generic_value_t value;
+    assert(hamt_get(map, key, &value));
+    assert(i == value.i64);
+    sprintf(key, "absent:%d", (int)i);
+    assert(!hamt_get(map, key, &value));
+  }
+  hamt_delete(map);
+}
+
+
+static void test_hamt_remove() {
+  hamt_t* map;
+  assert(!hamt_create(&map));
+  bool present[1000] = {false};
+  size_t size = 0;
+  srand(1);
+  for (int i = 0; i < 20000; i++) {
+    int k = rand() % 1000;
+    char key[16];
+    sprintf(key, "key:%d", k);
+    generic_value_t value;
+    bool removed;
+    assert(!hamt_remove(map, key, &value, &removed));
+    assert(present[k] == removed);
+    if (removed) {
+      assert(k == value.i64);
+      size--;
+    } else {
+      assert(!hamt_insert(map, key, (generic_value_t)(int64_t)k));
+      size++;
+    }
+    present[k] = !present[k];
+    assert(size == hamt_size(map));
+  }
+  for (int k = 0; k < 1000; k++) {
+    char key[16];
+    sprintf(key, "key:%d", k);
+    generic_value_t value;
+    assert(present[k] == hamt_get(map, key, &value));
+    bool removed;
+    assert(!hamt_remove(map, key, &value, &removed));
+    assert(present[k] == removed);
+  }
+  assert(!hamt_size(map));
+  assert(!map->root);
+  hamt_delete(map);
+}
+
+
+static void test_hamt_snapshot() {
+  hamt_t* map;
+  assert(!hamt_create(&map));
+  for (int64_t i = 0; i < 1000; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    assert(!hamt_insert(map, key, (generic_value_t)i));
+  }
+  hamt_t* snapshot;
+  assert(!hamt_snapshot(map, &snapshot));
+  assert(snapshot->root == map->root);
+
+  // Updates copy only the path to the key; the rest of the root's children
+  // are shared.
+  assert(!hamt_insert(map, "key:5", (generic_value_t)(int64_t)-5));
+  assert(snapshot->root != map->root);
+  hamt_branch_t* old_root = (hamt_branch_t*)snapshot->root;
+  hamt_branch_t* new_root = (hamt_branch_t*)map->root;
+  assert(HAMT_BRANCH == new_root->node.type);
+  assert(old_root->bitmap == new_root->bitmap);
+  int count = __builtin_popcount(new_root->bitmap);
+  int shared = 0;
+  for (int i = 0; i < count; i++) {
+    shared += old_root->children[i] == new_root->children[i];
+  }
+  assert(count - 1 == shared);
+
+  assert(!hamt_insert(map, "new", (generic_value_t)1.0));
+  generic_value_t value;
+  bool removed;
+  assert(!hamt_remove(map, "key:7", &value, &removed));
+  assert(removed);
+
+  // The snapshot still has the old contents.
+  assert(1000 == hamt_size(snapshot));
+  assert(hamt_get(snapshot, "key:5", &value));
+  assert(5 == value.i64);
+  assert(hamt_get(snapshot, "key:7", &value));
+  assert(!hamt_get(snapshot, "new", &value));
+  assert(1000 == hamt_size(map));
+  assert(hamt_get(map, "key:5", &value));
+  assert(-5 == value.i64);
+  assert(!hamt_get(map, "key:7", &value));
+
+  // Either version may be deleted first.
+  hamt_delete(map);
+  for (int64_t i = 0; i < 1000; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    assert(hamt_get(snapshot, key, &value));
+    assert(i == value.i64);
+  }
+  hamt_delete(snapshot);
+}
+
+
+static void test_hamt_collisions() {
+  assert(hash_string(colliding_keys[0]) == hash_string(colliding_keys[1]));
+  assert(hash_string(colliding_keys[0]) == hash_string(colliding_keys[2]));
+  hamt_t* map;
+  assert(!hamt_create(&map));
+  // Other keys around the collision node.
+  for (int64_t i = 0; i < 100; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    assert(!hamt_insert(map, key, (generic_value_t)i));
+  }
+  for (int64_t i = 0; i < 3; i++) {
+    assert(!hamt_insert(map, colliding_keys[i], (generic_value_t)(i + 100)));
+  }
+  assert(103 == hamt_size(map));
+  generic_value_t value;
+  for (int64_t i = 0; i < 3; i++) {
+    assert(hamt_get(map, colliding_keys[i], &value));
+    assert(i + 100 == value.i64);
+  }
+  assert(!hamt_insert(map, colliding_keys[1], (generic_value_t)(int64_t)0));
+  assert(103 == hamt_size(map));
+  assert(hamt_get(map, colliding_keys[1], &value));
+  assert(0 == value.i64);
+
+  hamt_t* snapshot;
+  assert(!hamt_snapshot(map, &snapshot));
+  bool removed;
+  for (int i = 0; i < 3; i++) {
+    assert(!hamt_remove(map, colliding_keys[i], &value, &removed));
+    assert(removed);
+    for (int j = i + 1; j < 3; j++) {
+      assert(hamt_get(map, colliding_keys[j], &value));
+    }
+  }
+  assert(100 == hamt_size(map));
+  assert(hamt_get(snapshot, colliding_keys[2], &value));
+  assert(102 == value.i64);
+  hamt_delete(map);
+  hamt_delete(snapshot);
+}
+
+
+static void test_hamt_pointer_values() {
+  // The map never frees values, so a value may go back into a key that a
+  // snapshot still holds it under.
+  char* values[3];
+  for (int i = 0; i < 3; i++) {
+    assert((values[i] = malloc(8)));
+    sprintf(values[i], "value%d", i);
+  }
+  hamt_t* map;
+  assert(!hamt_create(&map));
+  assert(!hamt_insert(map, "k", (generic_value_t)(void*)values[0]));
+  hamt_t* snapshot;
+  assert(!hamt_snapshot(map, &snapshot));
+  generic_value_t value;
+  bool removed;
+  assert(!hamt_remove(map, "k", &value, &removed));
+  assert(removed);
+  assert(values[0] == value.p);
+  assert(!hamt_insert(map, "k", value));
+  hamt_delete(snapshot);
+  assert(hamt_get(map, "k", &value));
+  assert(!strcmp("value0", value.p));
+
+  // Roll a key back to an earlier value, with and without a snapshot, and
+  // the same in a collision node.
+  for (int i = 0; i < 2; i++) {
+    const char* key = i ? colliding_keys[1] : "k";
+    if (i) {
+      assert(!hamt_insert(map, colliding_keys[0],
+			  (generic_value_t)(void*)values[2]));
+      assert(!hamt_insert(map, key, (generic_value_t)(void*)values[0]));
+    }
+    assert(!hamt_snapshot(map, &snapshot));
+    assert(!hamt_insert(map, key, (generic_value_t)(void*)values[1]));
+    assert(!hamt_insert(map, key, (generic_value_t)(void*)values[0]));
+    hamt_delete(snapshot);
+    assert(!hamt_insert(map, key, (generic_value_t)(void*)values[1]));
+    assert(!hamt_insert(map, key, (generic_value_t)(void*)values[0]));
+    assert(hamt_get(map, key, &value));
+    assert(!strcmp("value0", value.p));
+  }
+
+  // Inserting the value a key already has leaves the map unchanged.
+  hamt_node_t* root = map->root;
+  assert(!hamt_insert(map, "k", (generic_value_t)(void*)values[0]));
+  assert(root == map->root);
+  assert(!hamt_insert(map, colliding_keys[1],
+		      (generic_value_t)(void*)values[0]));
+  assert(root == map->root);
+  assert(3 == hamt_size(map));
+  hamt_delete(map);
+  for (int i = 0; i < 3; i++) {
+    assert('v' == values[i][0]);
+    free(values[i]);
+  }
+}
+
+
+static void test_hamt_iterator() {
+  hamt_t* map;
+  assert(!hamt_create(&map));
+  hamt_iterator_t iter = hamt_iterator_create(map);
+  assert(!hamt_iterator_has_current(&iter));
+
+  for (int64_t i = 0; i < 1000; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    assert(!hamt_insert(map, key, (generic_value_t)i));
+  }
+  for (int64_t i = 0; i < 3; i++) {
+    assert(!hamt_insert(map, colliding_keys[i], (generic_value_t)(i + 1000)));
+  }
+  hamt_t* snapshot;
+  assert(!hamt_snapshot(map, &snapshot));
+  // Iterating the snapshot ignores later updates to the map.
+  assert(!hamt_insert(map, "new", (generic_value_t)(int64_t)2000));
+
+  bool seen[1003] = {false};
+  size_t count = 0;
+  for (iter = hamt_iterator_create(snapshot); hamt_iterator_has_current(&iter);
+       hamt_iterator_next(&iter)) {
+    const char* key;
+    generic_value_t value;
+    hamt_iterator_get_current(&iter, &key, &value);
+    assert(value.i64 < 1003);
+    if (value.i64 < 1000) {
+      char expected[16];
+      sprintf(expected, "key:%d", (int)value.i64);
+      assert(!strcmp(expected, key));
+    } else {
+      assert(!strcmp(colliding_keys[value.i64 - 1000], key));
+    }
+    assert(!seen[value.i64]);
+    seen[value.i64] = true;
+    count++;
+  }
+  assert(1003 == count);
+  hamt_delete(map);
+  hamt_delete(snapshot);
+}
+
+
+int main(int argc, char** argv) {
+  test_hamt_create();
+  test_hamt_insert_get();
+  test_hamt_many();
+  test_hamt_remove();
+  test_hamt_snapshot();
+  test_hamt_collisions();
+  test_hamt_pointer_values();
+  test_hamt_iterator();
+  return 0;
+}
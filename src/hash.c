@@ -1,6 +1,12 @@
 #include "hash.h"
 
 
+// Provide external definitions of inline functions.
+extern inline uint64_t hash_uint64(uint64_t x);
+extern inline uint64_t hash_string_mixed(const char* s);
+extern inline uint64_t hash_pointer(const void* p);
+
+
 uint64_t hash_string(const char* s) {
   // TODO: Use better hash here.
   uint64_t hash = 0;
@@ -13,3 +13,56 @@
  *  Hash value for string.
  */
 uint64_t hash_string(const char* s);
+
+
+/**
+ * Hashes a 64 bit integer value.
+ *
+ * Uses a multiply-shift mixer so every bit of the input affects every bit
+ * of the result; the low bits may be used directly as a table index.
+ *
+ * Args:
+ *  x: Value to hash.
+ *
+ * Returns:
+ *  Hash value for the integer.
+ */
+inline uint64_t hash_uint64(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+
+/**
+ * Hashes a string value for tables indexed by the hash's low bits.
+ *
+ * hash_string leaves its low bits poorly mixed, so its result is mixed
+ * again with hash_uint64.
+ *
+ * Args:
+ *  s: String to hash.
+ *
+ * Returns:
+ *  Hash value for string, with every bit usable as an index.
+ */
+inline uint64_t hash_string_mixed(const char* s) {
+  return hash_uint64(hash_string(s));
+}
+
+
+/**
+ * Hashes a pointer value.
+ *
+ * Args:
+ *  p: Pointer to hash.
+ *
+ * Returns:
+ *  Hash value for the pointer.
+ */
+inline uint64_t hash_pointer(const void* p) {
+  return hash_uint64((uint64_t)(uintptr_t)p);
+}
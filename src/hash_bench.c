@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "hash.h"
+
+
+#define BENCH_KEYS 1024
+#define BENCH_OPS 4000000
+
+
+static void bench_hash_string(size_t length) {
+  // Distinct keys so the hashes cannot be hoisted out of the loop.
+  char (*keys)[1025] = malloc(BENCH_KEYS * sizeof(*keys));
+  if (!keys) {
+    abort();
+  }
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    memset(keys[i], 'k', length);
+    snprintf(keys[i], length + 1, "%d:", i);
+    keys[i][strlen(keys[i])] = 'k';
+    keys[i][length] = 0;
+  }
+  uint64_t sum = 0;
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < BENCH_OPS; i++) {
+    sum += hash_string(keys[i % BENCH_KEYS]);
+  }
+  uint64_t elapsed = bench_now_ns() - start;
+  bench_use(sum);
+
+  char name[64];
+  snprintf(name, sizeof(name), "hash_string/%zu", length);
+  bench_report(name, BENCH_OPS, elapsed);
+  snprintf(name, sizeof(name), "hash_string_throughput/%zu", length);
+  bench_report_value(name, (double)BENCH_OPS * length * 1e3 / elapsed,
+		     "MB/s");
+  free(keys);
+}
+
+
+static void bench_hash_uint64() {
+  uint64_t sum = 0;
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_OPS; i++) {
+    sum += hash_uint64(i);
+  }
+  bench_report("hash_uint64", BENCH_OPS, bench_now_ns() - start);
+  bench_use(sum);
+}
+
+
+int main(int argc, char** argv) {
+  size_t lengths[] = {8, 16, 32, 64, 256, 1024};
+  for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+    bench_hash_string(lengths[i]);
+  }
+  bench_hash_uint64();
+  return 0;
+}
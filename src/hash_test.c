@@ -14,7 +14,19 @@ static void test_hash_string() {
 }
 
 
+static void test_hash_uint64() {
+  assert(hash_uint64(1) == hash_uint64(1));
+  assert(hash_uint64(1) != hash_uint64(2));
+  // Consecutive keys should not map to consecutive low bits.
+  assert((hash_uint64(1) & 0xff) + 1 != (hash_uint64(2) & 0xff));
+  assert(hash_pointer(&test_hash_uint64) ==
+	 hash_uint64((uint64_t)(uintptr_t)&test_hash_uint64));
+  assert(hash_string_mixed("abc123") == hash_uint64(hash_string("abc123")));
+}
+
+
 int main(int argc, char** argv) {
   test_hash_string();
+  test_hash_uint64();
   return 0;
 }
@@ -0,0 +1,324 @@
+#include "heap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+static const size_t INITIAL_CAPACITY = 16;
+
+
+// Provide external definitions of inline functions.
+extern inline generic_value_t heap_peek(const heap_t* heap);
+extern inline size_t heap_size(const heap_t* heap);
+extern inline bool heap_empty(const heap_t* heap);
+extern inline generic_value_t indexed_heap_peek(const indexed_heap_t* heap);
+extern inline generic_value_t indexed_heap_get(
+  const indexed_heap_t* heap, size_t handle);
+extern inline size_t indexed_heap_size(const indexed_heap_t* heap);
+extern inline bool indexed_heap_empty(const indexed_heap_t* heap);
+
+
+// Both sifts move a hole rather than swapping, so each level costs one
+// store instead of three.
+static void heap_sift_up(heap_t* heap, size_t index, generic_value_t value) {
+  while (index) {
+    size_t parent = (index - 1) / HEAP_ARITY;
+    if (heap->compare(value, heap->values[parent]) >= 0) {
+      break;
+    }
+    heap->values[index] = heap->values[parent];
+    index = parent;
+  }
+  heap->values[index] = value;
+}
+
+
+static void heap_sift_down(heap_t* heap, size_t index, generic_value_t value) {
+  for (;;) {
+    size_t first = HEAP_ARITY * index + 1;
+    if (first >= heap->size) {
+      break;
+    }
+    size_t last = first + HEAP_ARITY;
+    if (last > heap->size) {
+      last = heap->size;
+    }
+    size_t best = first;
+    for (size_t child = first + 1; child < last; child++) {
+      if (heap->compare(heap->values[child], heap->values[best]) < 0) {
+	best = child;
+      }
+    }
+    if (heap->compare(heap->values[best], value) >= 0) {
+      break;
+    }
+    heap->values[index] = heap->values[best];
+    index = best;
+  }
+  heap->values[index] = value;
+}
+
+
+error_t heap_create(
+  heap_t** heap, int (*compare)(generic_value_t a, generic_value_t b)) {
+  return heap_create_with_value_deallocator(heap, compare, 0);
+}
+
+
+error_t heap_create_with_value_deallocator(
+  heap_t** heap, int (*compare)(generic_value_t a, generic_value_t b),
+  void (*value_deallocator)(void*)) {
+  heap_t* tmp = calloc(1, sizeof(heap_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->compare = compare;
+  tmp->value_deallocator = value_deallocator;
+  *heap = tmp;
+  return 0;
+}
+
+
+error_t heap_create_from_array(
+  heap_t** heap, int (*compare)(generic_value_t a, generic_value_t b),
+  const generic_value_t* values, size_t count) {
+  heap_t* tmp;
+  error_t error = heap_create(&tmp, compare);
+  if (error) {
+    return error;
+  }
+  if ((error = heap_reserve(tmp, count))) {
+    heap_delete(tmp);
+    return error;
+  }
+  if (count) {
+    memcpy(tmp->values, values, count * sizeof(generic_value_t));
+  }
+  tmp->size = count;
+  // Sift down every parent, from the last one up to the root.
+  for (size_t i = count > 1 ? (count - 2) / HEAP_ARITY + 1 : 0; i-- > 0;) {
+    heap_sift_down(tmp, i, tmp->values[i]);
+  }
+  *heap = tmp;
+  return 0;
+}
+
+
+void heap_delete(heap_t* heap) {
+  if (!heap) {
+    return;
+  }
+  if (heap->value_deallocator) {
+    for (size_t i = 0; i < heap->size; i++) {
+      heap->value_deallocator(heap->values[i].p);
+    }
+  }
+  free(heap->values);
+  free(heap);
+}
+
+
+error_t heap_reserve(heap_t* heap, size_t capacity) {
+  if (capacity <= heap->capacity) {
+    return 0;
+  }
+  size_t new_capacity = heap->capacity ? heap->capacity : INITIAL_CAPACITY;
+  while (new_capacity < capacity) {
+    new_capacity *= 2;
+  }
+  generic_value_t* values = realloc(
+    heap->values, new_capacity * sizeof(generic_value_t));
+  if (!values) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  heap->values = values;
+  heap->capacity = new_capacity;
+  return 0;
+}
+
+
+error_t heap_push(heap_t* heap, generic_value_t value) {
+  if (heap->size == heap->capacity) {
+    error_t error = heap_reserve(heap, heap->size + 1);
+    if (error) {
+      return error;
+    }
+  }
+  heap_sift_up(heap, heap->size++, value);
+  return 0;
+}
+
+
+generic_value_t heap_pop(heap_t* heap) {
+  generic_value_t value = heap->values[0];
+  if (--heap->size) {
+    heap_sift_down(heap, 0, heap->values[heap->size]);
+  }
+  return value;
+}
+
+
+static void indexed_heap_place(
+  indexed_heap_t* heap, size_t index, indexed_heap_node_t node) {
+  heap->nodes[index] = node;
+  heap->positions[node.handle] = index;
+}
+
+
+static void indexed_heap_sift_up(
+  indexed_heap_t* heap, size_t index, indexed_heap_node_t node) {
+  while (index) {
+    size_t parent = (index - 1) / HEAP_ARITY;
+    if (heap->compare(node.value, heap->nodes[parent].value) >= 0) {
+      break;
+    }
+    indexed_heap_place(heap, index, heap->nodes[parent]);
+    index = parent;
+  }
+  indexed_heap_place(heap, index, node);
+}
+
+
+static void indexed_heap_sift_down(
+  indexed_heap_t* heap, size_t index, indexed_heap_node_t node) {
+  for (;;) {
+    size_t first = HEAP_ARITY * index + 1;
+    if (first >= heap->size) {
+      break;
+    }
+    size_t last = first + HEAP_ARITY;
+    if (last > heap->size) {
+      last = heap->size;
+    }
+    size_t best = first;
+    for (size_t child = first + 1; child < last; child++) {
+      if (heap->compare(heap->nodes[child].value,
+			heap->nodes[best].value) < 0) {
+	best = child;
+      }
+    }
+    if (heap->compare(heap->nodes[best].value, node.value) >= 0) {
+      break;
+    }
+    indexed_heap_place(heap, index, heap->nodes[best]);
+    index = best;
+  }
+  indexed_heap_place(heap, index, node);
+}
+
+
+// Moves a node to a position whose old node has gone, in whichever
+// direction restores the order.
+static void indexed_heap_fix(
+  indexed_heap_t* heap, size_t index, indexed_heap_node_t node) {
+  if (index &&
+      heap->compare(node.value,
+		    heap->nodes[(index - 1) / HEAP_ARITY].value) < 0) {
+    indexed_heap_sift_up(heap, index, node);
+  } else {
+    indexed_heap_sift_down(heap, index, node);
+  }
+}
+
+
+error_t indexed_heap_create(
+  indexed_heap_t** heap, int (*compare)(generic_value_t a, generic_value_t b)) {
+  return indexed_heap_create_with_value_deallocator(heap, compare, 0);
+}
+
+
+error_t indexed_heap_create_with_value_deallocator(
+  indexed_heap_t** heap, int (*compare)(generic_value_t a, generic_value_t b),
+  void (*value_deallocator)(void*)) {
+  indexed_heap_t* tmp = calloc(1, sizeof(indexed_heap_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->compare = compare;
+  tmp->value_deallocator = value_deallocator;
+  *heap = tmp;
+  return 0;
+}
+
+
+void indexed_heap_delete(indexed_heap_t* heap) {
+  if (!heap) {
+    return;
+  }
+  if (heap->value_deallocator) {
+    for (size_t i = 0; i < heap->size; i++) {
+      heap->value_deallocator(heap->nodes[i].value.p);
+    }
+  }
+  free(heap->nodes);
+  free(heap->positions);
+  free(heap);
+}
+
+
+static error_t indexed_heap_grow(indexed_heap_t* heap) {
+  size_t new_capacity = heap->capacity ? heap->capacity * 2 : INITIAL_CAPACITY;
+  indexed_heap_node_t* nodes = realloc(
+    heap->nodes, new_capacity * sizeof(indexed_heap_node_t));
+  if (!nodes) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  heap->nodes = nodes;
+  size_t* positions = realloc(heap->positions, new_capacity * sizeof(size_t));
+  if (!positions) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  heap->positions = positions;
+  heap->capacity = new_capacity;
+  return 0;
+}
+
+
+error_t indexed_heap_push(
+  indexed_heap_t* heap, generic_value_t value, size_t* handle) {
+  // Live handles never outnumber the values, so handle_count only reaches
+  // capacity when the heap is full.
+  if (heap->size == heap->capacity) {
+    error_t error = indexed_heap_grow(heap);
+    if (error) {
+      return error;
+    }
+  }
+  indexed_heap_node_t node = {value};
+  if (heap->size < heap->handle_count) {
+    node.handle = heap->free_handle;
+    heap->free_handle = heap->positions[node.handle];
+  } else {
+    node.handle = heap->handle_count++;
+  }
+  indexed_heap_sift_up(heap, heap->size++, node);
+  *handle = node.handle;
+  return 0;
+}
+
+
+generic_value_t indexed_heap_remove(indexed_heap_t* heap, size_t handle) {
+  size_t index = heap->positions[handle];
+  generic_value_t value = heap->nodes[index].value;
+  heap->positions[handle] = heap->free_handle;
+  heap->free_handle = handle;
+  if (index != --heap->size) {
+    indexed_heap_fix(heap, index, heap->nodes[heap->size]);
+  }
+  return value;
+}
+
+
+generic_value_t indexed_heap_pop(indexed_heap_t* heap, size_t* handle) {
+  if (handle) {
+    *handle = heap->nodes[0].handle;
+  }
+  return indexed_heap_remove(heap, heap->nodes[0].handle);
+}
+
+
+void indexed_heap_update(
+  indexed_heap_t* heap, size_t handle, generic_value_t value) {
+  indexed_heap_fix(heap, heap->positions[handle],
+		   (indexed_heap_node_t){value, handle});
+}
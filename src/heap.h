@@ -0,0 +1,370 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "errors.h"
+#include "generic.h"
+
+
+// Children per node. Four children of 8 byte values fill half a cache
+// line, and the tree is half as deep as a binary heap's.
+#define HEAP_ARITY 4
+
+typedef struct {
+  int (*compare)(generic_value_t a, generic_value_t b);
+  void (*value_deallocator)(void*);
+  // Implicit tree: the children of values[i] are values[HEAP_ARITY * i + 1]
+  // to values[HEAP_ARITY * i + HEAP_ARITY].
+  generic_value_t* values;
+  size_t capacity;
+  size_t size;
+} heap_t;
+
+typedef struct {
+  generic_value_t value;
+  size_t handle;
+} indexed_heap_node_t;
+
+typedef struct {
+  int (*compare)(generic_value_t a, generic_value_t b);
+  void (*value_deallocator)(void*);
+  // Implicit tree laid out as in heap_t.
+  indexed_heap_node_t* nodes;
+  // Position in nodes of each live handle. Free handles are chained
+  // through their entries, starting at free_handle.
+  size_t* positions;
+  size_t capacity;
+  size_t size;
+  // Number of handles ever given out.
+  size_t handle_count;
+  size_t free_handle;
+} indexed_heap_t;
+
+
+/**
+ * Creates a new heap.
+ *
+ * A heap is a priority queue stored in a single growable array. Pushing
+ * and popping are O(log n) and peeking is O(1), with no per-value
+ * allocation.
+ *
+ * Args:
+ *  heap: Set to the newly allocated heap.
+ *  compare: Function returning a negative number if a should be popped
+ *   before b, a positive number if after and 0 if either may come first.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create heap because of memory error.
+ */
+error_t heap_create(
+  heap_t** heap, int (*compare)(generic_value_t a, generic_value_t b));
+
+
+/**
+ * Creates a new heap with a value deallocator.
+ *
+ * The deallocation function is used to delete void* values
+ * (generic_value_t.p) when heap_delete is called.
+ *
+ * Args:
+ *  heap: Set to the newly allocated heap.
+ *  compare: Function ordering the values, as for heap_create.
+ *  deallocated: Function used to delete values.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create heap because of memory error.
+ */
+error_t heap_create_with_value_deallocator(
+  heap_t** heap, int (*compare)(generic_value_t a, generic_value_t b),
+  void (*value_deallocator)(void*));
+
+
+/**
+ * Creates a new heap holding copies of an array of values.
+ *
+ * The heap is built in O(n), which is faster than pushing the values one
+ * by one.
+ *
+ * Args:
+ *  heap: Set to the newly allocated heap.
+ *  compare: Function ordering the values, as for heap_create.
+ *  values: Values to add.
+ *  count: Number of values.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create heap because of memory error.
+ */
+error_t heap_create_from_array(
+  heap_t** heap, int (*compare)(generic_value_t a, generic_value_t b),
+  const generic_value_t* values, size_t count);
+
+
+/**
+ * Deletes a heap.
+ *
+ * If a deallocation function was provided during creation, heap values
+ * will be treated as void* (generic_value_t.p) and sent to the function.
+ *
+ * Args:
+ *  heap: Heap to be deleted.
+ */
+void heap_delete(heap_t* heap);
+
+
+/**
+ * Ensures the heap can hold a number of values without reallocating.
+ *
+ * Args:
+ *  heap: Heap to update.
+ *  capacity: Number of values the heap should be able to hold.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not grow heap because of memory error.
+ */
+error_t heap_reserve(heap_t* heap, size_t capacity);
+
+
+/**
+ * Adds a value to the heap.
+ *
+ * Args:
+ *  heap: Heap to add value to.
+ *  value: Value to add to heap.
+ *
+ * Returns:
+ *  0 on success
+ *  ERROR_OUT_OF_MEMORY: Could not add value because of memory error.
+ */
+error_t heap_push(heap_t* heap, generic_value_t value);
+
+
+/**
+ * Removes the first value from the heap.
+ *
+ * Calling this on an empty heap is undefined.
+ *
+ * Args:
+ *  heap: The heap to pop value from.
+ *
+ * Returns:
+ *  The value that compares before all others.
+ */
+generic_value_t heap_pop(heap_t* heap);
+
+
+/**
+ * Returns the first value of the heap without removing it.
+ *
+ * Calling this on an empty heap is undefined.
+ *
+ * Args:
+ *  heap: The heap to examine.
+ *
+ * Returns:
+ *  The value that compares before all others.
+ */
+inline generic_value_t heap_peek(const heap_t* heap) {
+  return heap->values[0];
+}
+
+
+/**
+ * Returns the number of values in the heap.
+ *
+ * Args:
+ *  heap: The heap to examine.
+ *
+ * Returns:
+ *  Number of values in heap.
+ */
+inline size_t heap_size(const heap_t* heap) { return heap->size; }
+
+
+/**
+ * Returns true if the heap is empty.
+ *
+ * Args:
+ *  heap: The heap to examine.
+ *
+ * Returns:
+ *  true if the heap is empty.
+ */
+inline bool heap_empty(const heap_t* heap) { return !heap->size; }
+
+
+/**
+ * Creates a new indexed heap.
+ *
+ * An indexed heap is a heap that gives every pushed value a handle, which
+ * can be used to change or remove the value while it is in the heap, e.g.
+ * the decrease-key step of Dijkstra's algorithm. Handles are small
+ * integers that are reused once their value leaves the heap, so they can
+ * index a caller's array.
+ *
+ * Args:
+ *  heap: Set to the newly allocated heap.
+ *  compare: Function ordering the values, as for heap_create.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create heap because of memory error.
+ */
+error_t indexed_heap_create(
+  indexed_heap_t** heap, int (*compare)(generic_value_t a, generic_value_t b));
+
+
+/**
+ * Creates a new indexed heap with a value deallocator.
+ *
+ * The deallocation function is used to delete void* values
+ * (generic_value_t.p) when indexed_heap_delete is called.
+ *
+ * Args:
+ *  heap: Set to the newly allocated heap.
+ *  compare: Function ordering the values, as for heap_create.
+ *  deallocated: Function used to delete values.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create heap because of memory error.
+ */
+error_t indexed_heap_create_with_value_deallocator(
+  indexed_heap_t** heap, int (*compare)(generic_value_t a, generic_value_t b),
+  void (*value_deallocator)(void*));
+
+
+/**
+ * Deletes an indexed heap.
+ *
+ * If a deallocation function was provided during creation, heap values
+ * will be treated as void* (generic_value_t.p) and sent to the function.
+ *
+ * Args:
+ *  heap: Heap to be deleted.
+ */
+void indexed_heap_delete(indexed_heap_t* heap);
+
+
+/**
+ * Adds a value to the indexed heap.
+ *
+ * Args:
+ *  heap: Heap to add value to.
+ *  value: Value to add to heap.
+ *  handle: Set to the handle of the value, valid until the value is
+ *   popped or removed.
+ *
+ * Returns:
+ *  0 on success
+ *  ERROR_OUT_OF_MEMORY: Could not add value because of memory error.
+ */
+error_t indexed_heap_push(
+  indexed_heap_t* heap, generic_value_t value, size_t* handle);
+
+
+/**
+ * Removes the first value from the indexed heap.
+ *
+ * Calling this on an empty heap is undefined.
+ *
+ * Args:
+ *  heap: The heap to pop value from.
+ *  handle: If not NULL, set to the handle the value had.
+ *
+ * Returns:
+ *  The value that compares before all others.
+ */
+generic_value_t indexed_heap_pop(indexed_heap_t* heap, size_t* handle);
+
+
+/**
+ * Replaces the value of a handle and restores the heap order.
+ *
+ * This is decrease-key when the new value compares before the old one,
+ * and increase-key otherwise. Either takes O(log n).
+ *
+ * Args:
+ *  heap: Heap to update.
+ *  handle: Handle of a value in the heap.
+ *  value: New value.
+ */
+void indexed_heap_update(
+  indexed_heap_t* heap, size_t handle, generic_value_t value);
+
+
+/**
+ * Removes the value of a handle from the indexed heap.
+ *
+ * Args:
+ *  heap: Heap to update.
+ *  handle: Handle of a value in the heap.
+ *
+ * Returns:
+ *  The removed value.
+ */
+generic_value_t indexed_heap_remove(indexed_heap_t* heap, size_t handle);
+
+
+/**
+ * Returns the first value of the indexed heap without removing it.
+ *
+ * Calling this on an empty heap is undefined.
+ *
+ * Args:
+ *  heap: The heap to examine.
+ *
+ * Returns:
+ *  The value that compares before all others.
+ */
+inline generic_value_t indexed_heap_peek(const indexed_heap_t* heap) {
+  return heap->nodes[0].value;
+}
+
+
+/**
+ * Gets the value of a handle.
+ *
+ * Args:
+ *  heap: The heap to examine.
+ *  handle: Handle of a value in the heap.
+ *
+ * Returns:
+ *  The value of the handle.
+ */
+inline generic_value_t indexed_heap_get(
+  const indexed_heap_t* heap, size_t handle) {
+  return heap->nodes[heap->positions[handle]].value;
+}
+
+
+/**
+ * Returns the number of values in the indexed heap.
+ *
+ * Args:
+ *  heap: The heap to examine.
+ *
+ * Returns:
+ *  Number of values in heap.
+ */
+inline size_t indexed_heap_size(const indexed_heap_t* heap) {
+  return heap->size;
+}
+
+
+/**
+ * Returns true if the indexed heap is empty.
+ *
+ * Args:
+ *  heap: The heap to examine.
+ *
+ * Returns:
+ *  true if the heap is empty.
+ */
+inline bool indexed_heap_empty(const indexed_heap_t* heap) {
+  return !heap->size;
+}
@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "heap.h"
+#include "list.h"
+
+
+#define BENCH_SIZE 1000000
+// Queue length kept while measuring steady-state push/pop pairs.
+#define BENCH_QUEUE_LENGTH 1000
+
+
+static int bench_compare(generic_value_t a, generic_value_t b) {
+  return a.i64 < b.i64 ? -1 : a.i64 > b.i64;
+}
+
+
+// Gives the front element of a sorted list a new value and moves it after
+// any equal values, walking from the front as the schedulers do. The
+// element is reused, as the heap reuses its slots, so only the walk is
+// measured.
+static void bench_list_requeue_front(list_t* list, generic_value_t value) {
+  list_element_t* element = list->head;
+  list->head = element->next;
+  element->value = value;
+  list_element_t** link = &list->head;
+  while (*link && bench_compare((*link)->value, value) <= 0) {
+    link = &(*link)->next;
+  }
+  element->next = *link;
+  *link = element;
+  if (!element->next) {
+    list->tail = element;
+  }
+}
+
+
+static void bench_list_priority_queue() {
+  list_t* list;
+  if (list_create(&list)) {
+    abort();
+  }
+  uint64_t seed = 1;
+  for (uint64_t i = 0; i < BENCH_QUEUE_LENGTH; i++) {
+    if (list_push_back(list, (generic_value_t)bench_random(&seed))) {
+      abort();
+    }
+  }
+  list_sort(list, bench_compare);
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_SIZE; i++) {
+    uint64_t value = list_get_front(list).ui64;
+    bench_list_requeue_front(
+      list, (generic_value_t)(value + bench_random(&seed)));
+  }
+  bench_report("list_priority_queue_steady", BENCH_SIZE,
+	       bench_now_ns() - start);
+  list_delete(list);
+}
+
+
+static void bench_heap() {
+  heap_t* heap;
+  if (heap_create(&heap, bench_compare)) {
+    abort();
+  }
+  uint64_t seed = 1;
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_SIZE; i++) {
+    if (heap_push(heap, (generic_value_t)bench_random(&seed))) {
+      abort();
+    }
+  }
+  while (!heap_empty(heap)) {
+    bench_use(heap_pop(heap).ui64);
+  }
+  bench_report("heap_fill_drain", BENCH_SIZE, bench_now_ns() - start);
+
+  for (uint64_t i = 0; i < BENCH_QUEUE_LENGTH; i++) {
+    if (heap_push(heap, (generic_value_t)bench_random(&seed))) {
+      abort();
+    }
+  }
+  // Timer-queue pattern: pop the earliest and schedule a later one.
+  start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_SIZE; i++) {
+    uint64_t value = heap_pop(heap).ui64;
+    if (heap_push(heap, (generic_value_t)(value + bench_random(&seed)))) {
+      abort();
+    }
+  }
+  bench_report("heap_priority_queue_steady", BENCH_SIZE,
+	       bench_now_ns() - start);
+  heap_delete(heap);
+
+  generic_value_t* values = malloc(BENCH_SIZE * sizeof(generic_value_t));
+  if (!values) {
+    abort();
+  }
+  for (size_t i = 0; i < BENCH_SIZE; i++) {
+    values[i].ui64 = bench_random(&seed);
+  }
+  start = bench_now_ns();
+  if (heap_create_from_array(&heap, bench_compare, values, BENCH_SIZE)) {
+    abort();
+  }
+  bench_report("heap_create_from_array", BENCH_SIZE, bench_now_ns() - start);
+  bench_use(heap_peek(heap).ui64);
+  heap_delete(heap);
+  free(values);
+}
+
+
+static void bench_indexed_heap() {
+  indexed_heap_t* heap;
+  if (indexed_heap_create(&heap, bench_compare)) {
+    abort();
+  }
+  size_t* handles = malloc(BENCH_SIZE * sizeof(size_t));
+  if (!handles) {
+    abort();
+  }
+  uint64_t seed = 1;
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_SIZE; i++) {
+    if (indexed_heap_push(heap, (generic_value_t)bench_random(&seed),
+			  &handles[i])) {
+      abort();
+    }
+  }
+  bench_report("indexed_heap_push", BENCH_SIZE, bench_now_ns() - start);
+
+  // Dijkstra-style relaxation: lower the key of a random entry.
+  start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_SIZE; i++) {
+    size_t handle = handles[bench_random(&seed) % BENCH_SIZE];
+    uint64_t value = indexed_heap_get(heap, handle).ui64;
+    indexed_heap_update(heap, handle, (generic_value_t)(value / 2));
+  }
+  bench_report("indexed_heap_decrease_key", BENCH_SIZE,
+	       bench_now_ns() - start);
+
+  start = bench_now_ns();
+  while (!indexed_heap_empty(heap)) {
+    bench_use(indexed_heap_pop(heap, 0).ui64);
+  }
+  bench_report("indexed_heap_pop", BENCH_SIZE, bench_now_ns() - start);
+  indexed_heap_delete(heap);
+  free(handles);
+}
+
+
+int main(int argc, char** argv) {
+  bench_list_priority_queue();
+  bench_heap();
+  bench_indexed_heap();
+  return 0;
+}
@@ -0,0 +1,258 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "heap.h"
+
+
+static int compare(generic_value_t a, generic_value_t b) {
+  return a.i64 < b.i64 ? -1 : a.i64 > b.i64;
+}
+
+
+static int compare_strings_by_first(generic_value_t a, generic_value_t b) {
+  return *(char*)a.p - *(char*)b.p;
+}
+
+
+static void test_heap_create() {
+  heap_t* heap;
+  assert(!heap_create(&heap, compare));
+  assert(!heap->value_deallocator);
+  assert(!heap_size(heap));
+  assert(heap_empty(heap));
+  heap_delete(heap);
+}
+
+
+static void test_heap_push_pop() {
+  heap_t* heap;
+  assert(!heap_create(&heap, compare));
+  srand(1);
+  int64_t counts[100] = {0};
+  for (int i = 0; i < 1000; i++) {
+    int64_t value = rand() % 100;
+    counts[value]++;
+    assert(!heap_push(heap, (generic_value_t)value));
+    assert(i + 1 == heap_size(heap));
+  }
+  int64_t previous = -1;
+  while (!heap_empty(heap)) {
+    int64_t value = heap_peek(heap).i64;
+    assert(value == heap_pop(heap).i64);
+    assert(previous <= value);
+    counts[value]--;
+    previous = value;
+  }
+  for (int i = 0; i < 100; i++) {
+    assert(!counts[i]);
+  }
+  heap_delete(heap);
+}
+
+
+static void test_heap_interleaved() {
+  heap_t* heap;
+  assert(!heap_create(&heap, compare));
+  // Keep a sorted shadow copy and compare every pop against it.
+  int64_t sorted[200];
+  size_t size = 0;
+  srand(2);
+  for (int i = 0; i < 10000; i++) {
+    if (size < 200 && (rand() % 3 || !size)) {
+      int64_t value = rand() % 1000;
+      assert(!heap_push(heap, (generic_value_t)value));
+      size_t j = size++;
+      for (; j > 0 && sorted[j - 1] > value; j--) {
+	sorted[j] = sorted[j - 1];
+      }
+      sorted[j] = value;
+    } else {
+      assert(sorted[0] == heap_pop(heap).i64);
+      for (size_t j = 1; j < size; j++) {
+	sorted[j - 1] = sorted[j];
+      }
+      size--;
+    }
+    assert(size == heap_size(heap));
+    assert(!size || sorted[0] == heap_peek(heap).i64);
+  }
+  heap_delete(heap);
+}
+
+
+static void test_heap_create_from_array() {
+  for (size_t count = 0; count < 40; count++) {
+    generic_value_t values[40];
+    for (size_t i = 0; i < count; i++) {
+      values[i].i64 = (i * 7919) % 41;
+    }
+    heap_t* heap;
+    assert(!heap_create_from_array(&heap, compare, values, count));
+    assert(count == heap_size(heap));
+    int64_t previous = -1;
+    while (!heap_empty(heap)) {
+      int64_t value = heap_pop(heap).i64;
+      assert(previous < value);
+      previous = value;
+    }
+    heap_delete(heap);
+  }
+}
+
+
+static void test_heap_reserve() {
+  heap_t* heap;
+  assert(!heap_create(&heap, compare));
+  assert(!heap_reserve(heap, 100));
+  assert(100 <= heap->capacity);
+  generic_value_t* values = heap->values;
+  for (int64_t i = 0; i < 100; i++) {
+    assert(!heap_push(heap, (generic_value_t)(100 - i)));
+  }
+  assert(values == heap->values);
+  assert(1 == heap_peek(heap).i64);
+  heap_delete(heap);
+}
+
+
+static void test_heap_with_value_deallocator() {
+  heap_t* heap;
+  assert(!heap_create_with_value_deallocator(
+    &heap, compare_strings_by_first, free));
+  for (int i = 0; i < 10; i++) {
+    char* value = malloc(2);
+    value[0] = 'a' + (i * 3) % 10;
+    value[1] = 0;
+    assert(!heap_push(heap, (generic_value_t)(void*)value));
+  }
+  char* first = heap_pop(heap).p;
+  assert('a' == *first);
+  free(first);
+  heap_delete(heap);
+}
+
+
+static void test_indexed_heap_push_pop() {
+  indexed_heap_t* heap;
+  assert(!indexed_heap_create(&heap, compare));
+  assert(indexed_heap_empty(heap));
+  size_t handles[100];
+  for (int64_t i = 0; i < 100; i++) {
+    assert(!indexed_heap_push(heap, (generic_value_t)((i * 37) % 100),
+			      &handles[i]));
+    assert(i + 1 == indexed_heap_size(heap));
+  }
+  for (int64_t i = 0; i < 100; i++) {
+    assert((i * 37) % 100 == indexed_heap_get(heap, handles[i]).i64);
+  }
+  for (int64_t i = 0; i < 100; i++) {
+    size_t handle;
+    assert(i == indexed_heap_peek(heap).i64);
+    assert(i == indexed_heap_pop(heap, &handle).i64);
+    assert(i == (handle * 37) % 100);
+  }
+  assert(indexed_heap_empty(heap));
+  indexed_heap_delete(heap);
+}
+
+
+static void test_indexed_heap_update() {
+  indexed_heap_t* heap;
+  assert(!indexed_heap_create(&heap, compare));
+  int64_t values[300];
+  size_t handles[300];
+  bool present[300] = {0};
+  srand(3);
+  for (int i = 0; i < 300; i++) {
+    values[i] = rand() % 10000;
+    assert(!indexed_heap_push(heap, (generic_value_t)values[i], &handles[i]));
+    present[i] = true;
+  }
+  for (int i = 0; i < 5000; i++) {
+    int k = rand() % 300;
+    if (!present[k]) {
+      continue;
+    }
+    if (rand() % 10) {
+      // Both decrease-key and increase-key.
+      values[k] += rand() % 2000 - 1000;
+      indexed_heap_update(heap, handles[k], (generic_value_t)values[k]);
+    } else {
+      assert(values[k] == indexed_heap_remove(heap, handles[k]).i64);
+      present[k] = false;
+    }
+    assert(!present[k] ||
+	   values[k] == indexed_heap_get(heap, handles[k]).i64);
+  }
+  int64_t previous = INT64_MIN;
+  while (!indexed_heap_empty(heap)) {
+    size_t handle;
+    int64_t value = indexed_heap_pop(heap, &handle).i64;
+    assert(previous <= value);
+    previous = value;
+    int k = 0;
+    while (k < 300 && (!present[k] || handles[k] != handle)) {
+      k++;
+    }
+    assert(k < 300 && values[k] == value);
+    present[k] = false;
+  }
+  for (int i = 0; i < 300; i++) {
+    assert(!present[i]);
+  }
+  indexed_heap_delete(heap);
+}
+
+
+static void test_indexed_heap_handle_reuse() {
+  indexed_heap_t* heap;
+  assert(!indexed_heap_create(&heap, compare));
+  size_t handles[16];
+  for (int64_t i = 0; i < 16; i++) {
+    assert(!indexed_heap_push(heap, (generic_value_t)i, &handles[i]));
+  }
+  // Freed handles are reused, so they stay below the peak size.
+  for (int round = 0; round < 100; round++) {
+    assert(round == indexed_heap_remove(heap, handles[round % 16]).i64);
+    assert(!indexed_heap_push(heap, (generic_value_t)(int64_t)(round + 16),
+			      &handles[round % 16]));
+    assert(handles[round % 16] < 16);
+  }
+  assert(16 == heap->handle_count);
+  assert(16 == heap->capacity);
+  indexed_heap_delete(heap);
+}
+
+
+static void test_indexed_heap_with_value_deallocator() {
+  indexed_heap_t* heap;
+  assert(!indexed_heap_create_with_value_deallocator(
+    &heap, compare_strings_by_first, free));
+  size_t handle;
+  for (int i = 0; i < 10; i++) {
+    char* value = malloc(2);
+    value[0] = 'j' - i;
+    value[1] = 0;
+    assert(!indexed_heap_push(heap, (generic_value_t)(void*)value, &handle));
+  }
+  // The last value pushed was the first in order.
+  assert('a' == *(char*)indexed_heap_get(heap, handle).p);
+  free(indexed_heap_remove(heap, handle).p);
+  assert('b' == *(char*)indexed_heap_peek(heap).p);
+  indexed_heap_delete(heap);
+}
+
+
+int main(int argc, char** argv) {
+  test_heap_create();
+  test_heap_push_pop();
+  test_heap_interleaved();
+  test_heap_create_from_array();
+  test_heap_reserve();
+  test_heap_with_value_deallocator();
+  test_indexed_heap_push_pop();
+  test_indexed_heap_update();
+  test_indexed_heap_handle_reuse();
+  test_indexed_heap_with_value_deallocator();
+  return 0;
+}
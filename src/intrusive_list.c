@@ -0,0 +1,36 @@
+#include "intrusive_list.h"
+
+
+// Provide external definitions of inline functions.
+extern inline void intrusive_list_init(intrusive_list_t* list);
+extern inline void intrusive_list_link_init(intrusive_list_link_t* link);
+extern inline bool intrusive_list_link_is_linked(
+  const intrusive_list_link_t* link);
+extern inline size_t intrusive_list_size(const intrusive_list_t* list);
+extern inline bool intrusive_list_empty(const intrusive_list_t* list);
+extern inline void intrusive_list_insert_after(
+  intrusive_list_t* list, intrusive_list_link_t* position,
+  intrusive_list_link_t* link);
+extern inline void intrusive_list_insert_before(
+  intrusive_list_t* list, intrusive_list_link_t* position,
+  intrusive_list_link_t* link);
+extern inline void intrusive_list_push_back(
+  intrusive_list_t* list, intrusive_list_link_t* link);
+extern inline void intrusive_list_push_front(
+  intrusive_list_t* list, intrusive_list_link_t* link);
+extern inline void intrusive_list_remove(
+  intrusive_list_t* list, intrusive_list_link_t* link);
+extern inline intrusive_list_link_t* intrusive_list_get_front(
+  intrusive_list_t* list);
+extern inline intrusive_list_link_t* intrusive_list_get_back(
+  intrusive_list_t* list);
+extern inline intrusive_list_link_t* intrusive_list_next(
+  intrusive_list_t* list, intrusive_list_link_t* link);
+extern inline intrusive_list_link_t* intrusive_list_prev(
+  intrusive_list_t* list, intrusive_list_link_t* link);
+extern inline intrusive_list_link_t* intrusive_list_pop_front(
+  intrusive_list_t* list);
+extern inline intrusive_list_link_t* intrusive_list_pop_back(
+  intrusive_list_t* list);
+extern inline void intrusive_list_splice(
+  intrusive_list_t* dst, intrusive_list_t* src);
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/**
+ * Intrusive doubly linked list.
+ *
+ * Callers embed an intrusive_list_link_t in their own structures and link
+ * those structures directly, so no operation allocates memory and an
+ * object may sit on several lists at once (one link per list). The list
+ * is circular around a sentinel link stored in intrusive_list_t.
+ *
+ * For example:
+ *
+ *   typedef struct {
+ *     int fd;
+ *     intrusive_list_link_t idle_link;
+ *   } connection_t;
+ *
+ *   for (intrusive_list_link_t* link = intrusive_list_get_front(&idle);
+ *        link; link = intrusive_list_next(&idle, link)) {
+ *     connection_t* connection =
+ *       INTRUSIVE_LIST_ENTRY(link, connection_t, idle_link);
+ *     ...
+ *   }
+ */
+
+typedef struct intrusive_list_link {
+  struct intrusive_list_link* next;
+  struct intrusive_list_link* prev;
+} intrusive_list_link_t;
+
+typedef struct {
+  intrusive_list_link_t head;
+  size_t size;
+} intrusive_list_t;
+
+
+/**
+ * Gets the structure containing a link.
+ *
+ * Args:
+ *  link: Pointer to the embedded link.
+ *  type: Type of the containing structure.
+ *  member: Name of the link member within type.
+ *
+ * Returns:
+ *  Pointer to the containing structure.
+ */
+#define INTRUSIVE_LIST_ENTRY(link, type, member)	\
+  ((type*)((char*)(link) - offsetof(type, member)))
+
+
+/**
+ * Initializes an empty list.
+ *
+ * Args:
+ *  list: List to initialize.
+ */
+inline void intrusive_list_init(intrusive_list_t* list) {
+  list->head.next = list->head.prev = &list->head;
+  list->size = 0;
+}
+
+
+/**
+ * Initializes a link that is not on any list.
+ *
+ * Links are also reset when removed from a list, so
+ * intrusive_list_link_is_linked can be used to check for membership.
+ *
+ * Args:
+ *  link: Link to initialize.
+ */
+inline void intrusive_list_link_init(intrusive_list_link_t* link) {
+  link->next = link->prev = 0;
+}
+
+
+/**
+ * Returns true if a link is on a list.
+ *
+ * Args:
+ *  link: Link to examine. Must have been initialized.
+ *
+ * Returns:
+ *  true if the link is on a list.
+ */
+inline bool intrusive_list_link_is_linked(const intrusive_list_link_t* link) {
+  return link->next;
+}
+
+
+/**
+ * Returns the size of the list.
+ *
+ * Args:
+ *  list: List to examine.
+ *
+ * Returns:
+ *  Size of the list.
+ */
+inline size_t intrusive_list_size(const intrusive_list_t* list) {
+  return list->size;
+}
+
+
+/**
+ * Returns true if list is empty.
+ *
+ * Args:
+ *  list: List to examine.
+ *
+ * Returns:
+ *  true if list is empty.
+ */
+inline bool intrusive_list_empty(const intrusive_list_t* list) {
+  return !list->size;
+}
+
+
+/**
+ * Inserts a link after a position in the list.
+ *
+ * Args:
+ *  list: List to add link to.
+ *  position: Link already on the list, or &list->head to insert at the
+ *   front.
+ *  link: Link to add. Must not be on any list.
+ */
+inline void intrusive_list_insert_after(
+  intrusive_list_t* list, intrusive_list_link_t* position,
+  intrusive_list_link_t* link) {
+  link->prev = position;
+  link->next = position->next;
+  position->next->prev = link;
+  position->next = link;
+  list->size++;
+}
+
+
+/**
+ * Inserts a link before a position in the list.
+ *
+ * Args:
+ *  list: List to add link to.
+ *  position: Link already on the list, or &list->head to insert at the
+ *   back.
+ *  link: Link to add. Must not be on any list.
+ */
+inline void intrusive_list_insert_before(
+  intrusive_list_t* list, intrusive_list_link_t* position,
+  intrusive_list_link_t* link) {
+  intrusive_list_insert_after(list, position->prev, link);
+}
+
+
+/**
+ * Adds a link to the end of the list.
+ *
+ * Args:
+ *  list: List to add link to.
+ *  link: Link to add. Must not be on any list.
+ */
+inline void intrusive_list_push_back(
+  intrusive_list_t* list, intrusive_list_link_t* link) {
+  intrusive_list_insert_after(list, list->head.prev, link);
+}
+
+
+/**
+ * Adds a link to the beginning of the list.
+ *
+ * Args:
+ *  list: List to add link to.
+ *  link: Link to add. Must not be on any list.
+ */
+inline void intrusive_list_push_front(
+  intrusive_list_t* list, intrusive_list_link_t* link) {
+  intrusive_list_insert_after(list, &list->head, link);
+}
+
+
+/**
+ * Removes a link from the list, wherever it is.
+ *
+ * Args:
+ *  list: List the link is on.
+ *  link: Link to remove.
+ */
+inline void intrusive_list_remove(
+  intrusive_list_t* list, intrusive_list_link_t* link) {
+  link->prev->next = link->next;
+  link->next->prev = link->prev;
+  link->next = link->prev = 0;
+  list->size--;
+}
+
+
+/**
+ * Gets the first link in the list.
+ *
+ * Args:
+ *  list: The list to examine.
+ *
+ * Returns:
+ *  The first link in the list, or NULL if the list is empty.
+ */
+inline intrusive_list_link_t* intrusive_list_get_front(
+  intrusive_list_t* list) {
+  return list->size ? list->head.next : 0;
+}
+
+
+/**
+ * Gets the last link in the list.
+ *
+ * Args:
+ *  list: The list to examine.
+ *
+ * Returns:
+ *  The last link in the list, or NULL if the list is empty.
+ */
+inline intrusive_list_link_t* intrusive_list_get_back(
+  intrusive_list_t* list) {
+  return list->size ? list->head.prev : 0;
+}
+
+
+/**
+ * Gets the link following another link in the list.
+ *
+ * Args:
+ *  list: The list to examine.
+ *  link: Link on the list.
+ *
+ * Returns:
+ *  The next link, or NULL if link is the last in the list.
+ */
+inline intrusive_list_link_t* intrusive_list_next(
+  intrusive_list_t* list, intrusive_list_link_t* link) {
+  return link->next != &list->head ? link->next : 0;
+}
+
+
+/**
+ * Gets the link preceding another link in the list.
+ *
+ * Args:
+ *  list: The list to examine.
+ *  link: Link on the list.
+ *
+ * Returns:
+ *  The previous link, or NULL if link is the first in the list.
+ */
+inline intrusive_list_link_t* intrusive_list_prev(
+  intrusive_list_t* list, intrusive_list_link_t* link) {
+  return link->prev != &list->head ? link->prev : 0;
+}
+
+
+/**
+ * Removes the first link from the list.
+ *
+ * Args:
+ *  list: The list to pop link from.
+ *
+ * Returns:
+ *  The first link in the list, or NULL if the list is empty.
+ */
+inline intrusive_list_link_t* intrusive_list_pop_front(
+  intrusive_list_t* list) {
+  intrusive_list_link_t* link = intrusive_list_get_front(list);
+  if (link) {
+    intrusive_list_remove(list, link);
+  }
+  return link;
+}
+
+
+/**
+ * Removes the last link from the list.
+ *
+ * Args:
+ *  list: The list to pop link from.
+ *
+ * Returns:
+ *  The last link in the list, or NULL if the list is empty.
+ */
+inline intrusive_list_link_t* intrusive_list_pop_back(
+  intrusive_list_t* list) {
+  intrusive_list_link_t* link = intrusive_list_get_back(list);
+  if (link) {
+    intrusive_list_remove(list, link);
+  }
+  return link;
+}
+
+
+/**
+ * Moves every link from one list to the end of another.
+ *
+ * Args:
+ *  dst: List to add links to.
+ *  src: List to take links from. Left empty.
+ */
+inline void intrusive_list_splice(
+  intrusive_list_t* dst, intrusive_list_t* src) {
+  if (!src->size) {
+    return;
+  }
+  src->head.next->prev = dst->head.prev;
+  dst->head.prev->next = src->head.next;
+  src->head.prev->next = &dst->head;
+  dst->head.prev = src->head.prev;
+  dst->size += src->size;
+  intrusive_list_init(src);
+}
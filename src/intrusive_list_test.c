@@ -0,0 +1,220 @@
+#include <assert.h>
+#include <stdint.h>
+
+#include "intrusive_list.h"
+
+
+typedef struct {
+  int64_t value;
+  intrusive_list_link_t link;
+  intrusive_list_link_t other_link;
+} test_item_t;
+
+
+static int64_t test_item_value(intrusive_list_link_t* link) {
+  return INTRUSIVE_LIST_ENTRY(link, test_item_t, link)->value;
+}
+
+
+static void test_items_init(test_item_t* items, int count) {
+  for (int i = 0; i < count; i++) {
+    items[i].value = i;
+    intrusive_list_link_init(&items[i].link);
+    intrusive_list_link_init(&items[i].other_link);
+  }
+}
+
+
+static void test_intrusive_list_init() {
+  intrusive_list_t list;
+  intrusive_list_init(&list);
+  assert(!intrusive_list_size(&list));
+  assert(intrusive_list_empty(&list));
+  assert(!intrusive_list_get_front(&list));
+  assert(!intrusive_list_get_back(&list));
+  assert(!intrusive_list_pop_front(&list));
+  assert(!intrusive_list_pop_back(&list));
+}
+
+
+static void test_intrusive_list_push_back() {
+  test_item_t items[10];
+  test_items_init(items, 10);
+  intrusive_list_t list;
+  intrusive_list_init(&list);
+  for (int i = 0; i < 10; i++) {
+    intrusive_list_push_back(&list, &items[i].link);
+    assert(intrusive_list_link_is_linked(&items[i].link));
+  }
+  assert(10 == intrusive_list_size(&list));
+
+  int64_t expected = 0;
+  for (intrusive_list_link_t* link = intrusive_list_get_front(&list);
+       link; link = intrusive_list_next(&list, link)) {
+    assert(expected++ == test_item_value(link));
+  }
+  assert(10 == expected);
+
+  for (intrusive_list_link_t* link = intrusive_list_get_back(&list);
+       link; link = intrusive_list_prev(&list, link)) {
+    assert(--expected == test_item_value(link));
+  }
+  assert(0 == expected);
+}
+
+
+static void test_intrusive_list_push_front() {
+  test_item_t items[10];
+  test_items_init(items, 10);
+  intrusive_list_t list;
+  intrusive_list_init(&list);
+  for (int i = 0; i < 10; i++) {
+    intrusive_list_push_front(&list, &items[i].link);
+  }
+  assert(9 == test_item_value(intrusive_list_get_front(&list)));
+  assert(0 == test_item_value(intrusive_list_get_back(&list)));
+}
+
+
+static void test_intrusive_list_pop() {
+  test_item_t items[10];
+  test_items_init(items, 10);
+  intrusive_list_t list;
+  intrusive_list_init(&list);
+  for (int i = 0; i < 10; i++) {
+    intrusive_list_push_back(&list, &items[i].link);
+  }
+  for (int i = 0; i < 5; i++) {
+    intrusive_list_link_t* front = intrusive_list_pop_front(&list);
+    assert(i == test_item_value(front));
+    assert(!intrusive_list_link_is_linked(front));
+    intrusive_list_link_t* back = intrusive_list_pop_back(&list);
+    assert(9 - i == test_item_value(back));
+    assert(!intrusive_list_link_is_linked(back));
+  }
+  assert(intrusive_list_empty(&list));
+  assert(!intrusive_list_get_front(&list));
+}
+
+
+static void test_intrusive_list_remove() {
+  test_item_t items[10];
+  test_items_init(items, 10);
+  intrusive_list_t list;
+  intrusive_list_init(&list);
+  for (int i = 0; i < 10; i++) {
+    intrusive_list_push_back(&list, &items[i].link);
+  }
+
+  // Remove odd numbers while iterating.
+  for (intrusive_list_link_t* link = intrusive_list_get_front(&list);
+       link; ) {
+    intrusive_list_link_t* next = intrusive_list_next(&list, link);
+    if (test_item_value(link) % 2) {
+      intrusive_list_remove(&list, link);
+    }
+    link = next;
+  }
+  assert(5 == intrusive_list_size(&list));
+  assert(0 == test_item_value(intrusive_list_get_front(&list)));
+  assert(8 == test_item_value(intrusive_list_get_back(&list)));
+  int64_t expected = 0;
+  for (intrusive_list_link_t* link = intrusive_list_get_front(&list);
+       link; link = intrusive_list_next(&list, link)) {
+    assert(expected == test_item_value(link));
+    expected += 2;
+  }
+  assert(10 == expected);
+}
+
+
+static void test_intrusive_list_insert() {
+  test_item_t items[3];
+  test_items_init(items, 3);
+  intrusive_list_t list;
+  intrusive_list_init(&list);
+  intrusive_list_push_back(&list, &items[1].link);
+  intrusive_list_insert_before(&list, &items[1].link, &items[0].link);
+  intrusive_list_insert_after(&list, &items[1].link, &items[2].link);
+  int64_t expected = 0;
+  for (intrusive_list_link_t* link = intrusive_list_get_front(&list);
+       link; link = intrusive_list_next(&list, link)) {
+    assert(expected++ == test_item_value(link));
+  }
+  assert(3 == expected);
+}
+
+
+static void test_intrusive_list_splice() {
+  test_item_t items[10];
+  test_items_init(items, 10);
+  intrusive_list_t first;
+  intrusive_list_t second;
+  intrusive_list_init(&first);
+  intrusive_list_init(&second);
+
+  // Splicing an empty list is a no-op.
+  intrusive_list_splice(&first, &second);
+  assert(intrusive_list_empty(&first));
+
+  for (int i = 0; i < 10; i++) {
+    intrusive_list_push_back(i < 4 ? &first : &second, &items[i].link);
+  }
+  intrusive_list_splice(&first, &second);
+  assert(10 == intrusive_list_size(&first));
+  assert(intrusive_list_empty(&second));
+  assert(!intrusive_list_get_front(&second));
+
+  int64_t expected = 0;
+  for (intrusive_list_link_t* link = intrusive_list_get_front(&first);
+       link; link = intrusive_list_next(&first, link)) {
+    assert(expected++ == test_item_value(link));
+  }
+  assert(10 == expected);
+  assert(9 == test_item_value(intrusive_list_pop_back(&first)));
+
+  // Splicing into an empty list moves everything.
+  intrusive_list_splice(&second, &first);
+  assert(9 == intrusive_list_size(&second));
+  assert(0 == test_item_value(intrusive_list_get_front(&second)));
+  assert(8 == test_item_value(intrusive_list_get_back(&second)));
+}
+
+
+static void test_intrusive_list_multiple_lists() {
+  test_item_t items[10];
+  test_items_init(items, 10);
+  intrusive_list_t all;
+  intrusive_list_t even;
+  intrusive_list_init(&all);
+  intrusive_list_init(&even);
+  for (int i = 0; i < 10; i++) {
+    intrusive_list_push_back(&all, &items[i].link);
+    if (!(i % 2)) {
+      intrusive_list_push_back(&even, &items[i].other_link);
+    }
+  }
+  assert(10 == intrusive_list_size(&all));
+  assert(5 == intrusive_list_size(&even));
+
+  // Removing from one list leaves the other untouched.
+  intrusive_list_remove(&all, &items[4].link);
+  assert(intrusive_list_link_is_linked(&items[4].other_link));
+  test_item_t* item = INTRUSIVE_LIST_ENTRY(
+    intrusive_list_next(&even, intrusive_list_get_front(&even))->next,
+    test_item_t, other_link);
+  assert(item == &items[4]);
+}
+
+
+int main(int argc, char** argv) {
+  test_intrusive_list_init();
+  test_intrusive_list_push_back();
+  test_intrusive_list_push_front();
+  test_intrusive_list_pop();
+  test_intrusive_list_remove();
+  test_intrusive_list_insert();
+  test_intrusive_list_splice();
+  test_intrusive_list_multiple_lists();
+  return 0;
+}
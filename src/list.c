@@ -3,6 +3,8 @@
 #include <stddef.h>
 #include <stdlib.h>
 
+#include "node_cache.h"
+
 
 // Provide external definitions of inline functions.
 extern inline generic_value_t list_get_back(list_t* list);
@@ -23,16 +25,22 @@ error_t list_create(list_t** list) {
 
 error_t list_create_with_value_deallocator(
   list_t** list, void (*value_deallocator)(void*)) {
-  list_t* tmp = calloc(1, sizeof(list_t));
+  list_t* tmp = node_cache_alloc(sizeof(list_t));
   if (!tmp) {
     return ERROR_OUT_OF_MEMORY;
   }
-  tmp->value_deallocator = value_deallocator;
+  *tmp = (list_t){.value_deallocator = value_deallocator};
   *list = tmp;
   return 0;
 }
 
 
+static void list_element_free(list_t* list, list_element_t* element) {
+  list->node_bytes -= sizeof(list_element_t);
+  node_cache_free(element, sizeof(list_element_t));
+}
+
+
 void list_delete(list_t* list) {
   if (!list) {
     return;
@@ -43,18 +51,19 @@ void list_delete(list_t* list) {
       list->value_deallocator(current->value.p);
     }
     list->head = current->next;
-    free(current);
+    list_element_free(list, current);
   }
-  free(list);
+  node_cache_free(list, sizeof(list_t));
 }
 
 
 static error_t list_element_create(
   list_element_t** element, generic_value_t value) {
-  list_element_t* tmp = calloc(1, sizeof(list_element_t));
+  list_element_t* tmp = node_cache_alloc(sizeof(list_element_t));
   if (!tmp) {
     return ERROR_OUT_OF_MEMORY;
   }
+  tmp->next = 0;
   tmp->value = value;
   *element = tmp;
   return 0;
@@ -73,10 +82,134 @@ error_t list_push_back(list_t* list, generic_value_t value) {
     list->tail = element;
   }
   list->size++;
+  list->node_bytes += sizeof(list_element_t);
   return 0;
 }
 
 
+error_t list_push_back_array(
+  list_t* list, const generic_value_t* values, size_t count) {
+  if (!count) {
+    return 0;
+  }
+  // Chain the new elements, linking them to the list only once all of
+  // them have been allocated.
+  list_element_t* head = 0;
+  list_element_t** next = &head;
+  list_element_t* tail = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (list_element_create(&tail, values[i])) {
+      while (head) {
+	list_element_t* tmp = head;
+	head = head->next;
+	node_cache_free(tmp, sizeof(list_element_t));
+      }
+      return ERROR_OUT_OF_MEMORY;
+    }
+    *next = tail;
+    next = &tail->next;
+  }
+  list->node_bytes += count * sizeof(list_element_t);
+
+  if (!list->head) {
+    list->head = head;
+  } else {
+    list->tail->next = head;
+  }
+  list->tail = tail;
+  list->size += count;
+  return 0;
+}
+
+
+void list_splice(list_t* dst, list_t* src) {
+  if (!src->head) {
+    return;
+  }
+  if (!dst->head) {
+    dst->head = src->head;
+  } else {
+    dst->tail->next = src->head;
+  }
+  dst->tail = src->tail;
+  dst->size += src->size;
+  dst->node_bytes += src->node_bytes;
+  src->head = src->tail = 0;
+  src->size = 0;
+  src->node_bytes = 0;
+}
+
+
+void list_memory_usage(const list_t* list, list_memory_usage_t* usage) {
+  usage->metadata = sizeof(list_t);
+  usage->nodes = list->node_bytes;
+  usage->total = usage->metadata + usage->nodes;
+}
+
+
+// Merges two sorted, null terminated chains of elements. Elements from
+// left come first on ties, which keeps the sort stable.
+static list_element_t* list_merge(
+  list_element_t* left, list_element_t* right,
+  int (*compare)(generic_value_t a, generic_value_t b),
+  list_element_t** tail) {
+  list_element_t* head;
+  list_element_t** next = &head;
+  while (left && right) {
+    if (compare(left->value, right->value) <= 0) {
+      *next = left;
+      next = &left->next;
+      left = left->next;
+    } else {
+      *next = right;
+      next = &right->next;
+      right = right->next;
+    }
+  }
+  *next = left ? left : right;
+  while (*next) {
+    next = &(*next)->next;
+  }
+  *tail = (list_element_t*)((char*)next - offsetof(list_element_t, next));
+  return head;
+}
+
+
+void list_sort(
+  list_t* list, int (*compare)(generic_value_t a, generic_value_t b)) {
+  if (list->size < 2) {
+    return;
+  }
+  // runs[i] is either empty or a sorted run of 2^i elements. Elements are
+  // added one at a time like incrementing a binary counter, so most merges
+  // involve short runs that are still in cache.
+  list_element_t* runs[64] = {0};
+  list_element_t* tail;
+  list_element_t* element = list->head;
+  while (element) {
+    list_element_t* run = element;
+    element = element->next;
+    run->next = 0;
+    size_t i = 0;
+    for (; runs[i]; i++) {
+      run = list_merge(runs[i], run, compare, &tail);
+      runs[i] = 0;
+    }
+    runs[i] = run;
+  }
+
+  // Merge the remaining runs; higher runs hold earlier elements.
+  list_element_t* result = 0;
+  for (size_t i = 0; i < 64; i++) {
+    if (runs[i]) {
+      result = result ? list_merge(runs[i], result, compare, &tail) : runs[i];
+    }
+  }
+  list->head = result;
+  list->tail = tail;
+}
+
+
 error_t list_push_front(list_t* list, generic_value_t value) {
   list_element_t* element;
   error_t result = list_element_create(&element, value);
@@ -90,6 +223,7 @@ error_t list_push_front(list_t* list, generic_value_t value) {
     list->head = element;
   }
   list->size++;
+  list->node_bytes += sizeof(list_element_t);
   return 0;
 }
 
@@ -101,7 +235,7 @@ generic_value_t list_pop_front(list_t* list) {
   if (!list->head) {
     list->tail = 0;
   }
-  free(tmp);
+  list_element_free(list, tmp);
   list->size--;
   return value;
 }
@@ -125,7 +259,7 @@ generic_value_t list_iterator_remove_current(list_iterator_t* iter) {
   }
 
   generic_value_t value = tmp->value;
-  free(tmp);
+  list_element_free(iter->list, tmp);
   iter->list->size--;
   return value;
 }
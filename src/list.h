@@ -17,8 +17,18 @@ typedef struct {
   list_element_t* head;
   list_element_t* tail;
   size_t size;
+  // Bytes allocated for elements.
+  size_t node_bytes;
 } list_t;
 
+typedef struct {
+  // The list_t itself.
+  size_t metadata;
+  // Elements.
+  size_t nodes;
+  size_t total;
+} list_memory_usage_t;
+
 typedef struct {
   list_t* list;
   list_element_t** current;
@@ -82,6 +92,56 @@ void list_delete(list_t* list);
 error_t list_push_back(list_t* list, generic_value_t value);
 
 
+/**
+ * Adds an array of values to the end of the list.
+ *
+ * The elements for all values are allocated before any is linked, so
+ * either all values are added or none are. Elements are taken from the
+ * calling thread's node cache, which refills in batches, so most values
+ * cost no call to malloc.
+ *
+ * Args:
+ *  list: List to add values to.
+ *  values: Values to add to list.
+ *  count: Number of values.
+ *
+ * Returns:
+ *  0 on success
+ *  ERROR_OUT_OF_MEMORY: Could not add values because of memory error.
+ */
+error_t list_push_back_array(
+  list_t* list, const generic_value_t* values, size_t count);
+
+
+/**
+ * Moves every element from one list to the end of another.
+ *
+ * Elements are relinked, not copied, so this takes O(1) time. Values
+ * moved to dst are subject to dst's value deallocator.
+ *
+ * Args:
+ *  dst: List to add elements to.
+ *  src: List to take elements from. Left empty, but not deleted.
+ */
+void list_splice(list_t* dst, list_t* src);
+
+
+/**
+ * Sorts the list.
+ *
+ * Performs a bottom-up merge sort by relinking the existing elements, so
+ * no memory is allocated and only O(1) extra space is used. The sort is
+ * stable: equal values keep their relative order.
+ *
+ * Args:
+ *  list: List to sort.
+ *  compare: Returns a negative number, zero or a positive number if the
+ *   first value is less than, equal to or greater than the second.
+ */
+void list_sort(
+  list_t* list, int (*compare)(generic_value_t a, generic_value_t b));
+
+
 /**
  * Removes the last element from the list.
  *
@@ -180,6 +240,20 @@ inline size_t list_size(const list_t* list) { return list->size; }
 inline bool list_empty(const list_t* list) { return !list->size; }
 
 
+/**
+ * Reports the heap memory owned by a list.
+ *
+ * Sizes are the bytes requested from the allocator, not counting its
+ * overhead, and exclude whatever values point to. They are tracked as the
+ * list changes, so this takes O(1) time.
+ *
+ * Args:
+ *  list: The list to examine.
+ *  usage: Set to the bytes used, by category.
+ */
+void list_memory_usage(const list_t* list, list_memory_usage_t* usage);
+
+
 /**
  * Creates an iterator for a list.
  *
@@ -258,3 +332,30 @@ generic_value_t list_iterator_remove_current(list_iterator_t* iter);
 inline void list_iterator_next(list_iterator_t* iter) {
   iter->current = &(*iter->current)->next;
 }
+
+
+/**
+ * Loops over the values of a list, from front to back.
+ *
+ * Unlike list_iterator_t, no iterator is passed by address, so the loop
+ * compiles to a plain walk of the elements. value must be a
+ * generic_value_t declared by the caller, and is set before each run of
+ * the body. break and continue work as in any loop. The body must not
+ * modify the list.
+ *
+ * For example:
+ *
+ *   generic_value_t value;
+ *   LIST_FOR_EACH(list, value) {
+ *     sum += value.i64;
+ *   }
+ *
+ * Args:
+ *  list: List to traverse.
+ *  value: Variable set to each value.
+ */
+#define LIST_FOR_EACH(list, value)					\
+  for (list_element_t* list_for_each_element = (list)->head;		\
+       list_for_each_element &&						\
+	 ((value) = list_for_each_element->value,			\
+	  list_for_each_element = list_for_each_element->next, true);)
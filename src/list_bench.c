@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "list.h"
+
+
+#define BENCH_SORT_SIZE 1000000
+#define BENCH_BATCHES 20000
+#define BENCH_BATCH_SIZE 16
+
+
+static int bench_compare(generic_value_t a, generic_value_t b) {
+  return a.i64 < b.i64 ? -1 : a.i64 > b.i64;
+}
+
+
+static int bench_qsort_compare(const void* a, const void* b) {
+  return bench_compare(*(const generic_value_t*)a, *(const generic_value_t*)b);
+}
+
+
+static list_t* bench_random_list(size_t size) {
+  list_t* list;
+  if (list_create(&list)) {
+    abort();
+  }
+  uint64_t seed = 1;
+  for (size_t i = 0; i < size; i++) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    if (list_push_back(list, (generic_value_t)(seed >> 1))) {
+      abort();
+    }
+  }
+  return list;
+}
+
+
+static void bench_list_sort() {
+  list_t* list = bench_random_list(BENCH_SORT_SIZE);
+  uint64_t start = bench_now_ns();
+  list_sort(list, bench_compare);
+  bench_report("list_sort", BENCH_SORT_SIZE, bench_now_ns() - start);
+  bench_use(list_get_front(list).ui64);
+  list_delete(list);
+}
+
+
+static void bench_list_sort_copy_out() {
+  list_t* list = bench_random_list(BENCH_SORT_SIZE);
+  uint64_t start = bench_now_ns();
+  // Copy the values out, sort them and rebuild the list.
+  size_t size = list_size(list);
+  generic_value_t* values = malloc(size * sizeof(generic_value_t));
+  if (!values) {
+    abort();
+  }
+  for (size_t i = 0; i < size; i++) {
+    values[i] = list_pop_front(list);
+  }
+  qsort(values, size, sizeof(generic_value_t), bench_qsort_compare);
+  for (size_t i = 0; i < size; i++) {
+    if (list_push_back(list, values[i])) {
+      abort();
+    }
+  }
+  free(values);
+  bench_report("list_sort_copy_out_qsort", BENCH_SORT_SIZE,
+	       bench_now_ns() - start);
+  bench_use(list_get_front(list).ui64);
+  list_delete(list);
+}
+
+
+static void bench_list_push_pop(size_t size) {
+  list_t* list;
+  if (list_create(&list)) {
+    abort();
+  }
+  char name[64];
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < size; i++) {
+    if (list_push_back(list, (generic_value_t)i)) {
+      abort();
+    }
+  }
+  snprintf(name, sizeof(name), "list_push_back/%zu", size);
+  bench_report(name, size, bench_now_ns() - start);
+
+  uint64_t sum = 0;
+  start = bench_now_ns();
+  for (list_iterator_t iter = list_iterator_create(list);
+       list_iterator_has_current(&iter); list_iterator_next(&iter)) {
+    sum += list_iterator_get_current(&iter).ui64;
+  }
+  snprintf(name, sizeof(name), "list_iterate/%zu", size);
+  bench_report(name, size, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  generic_value_t value;
+  LIST_FOR_EACH(list, value) {
+    sum += value.ui64;
+  }
+  snprintf(name, sizeof(name), "list_for_each/%zu", size);
+  bench_report(name, size, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  while (!list_empty(list)) {
+    sum += list_pop_front(list).ui64;
+  }
+  snprintf(name, sizeof(name), "list_pop_front/%zu", size);
+  bench_report(name, size, bench_now_ns() - start);
+  bench_use(sum);
+  list_delete(list);
+}
+
+
+// Appends batches with list_push_back_array, then drains the list in FIFO
+// order, as a pipeline stage would.
+static void bench_list_push_back_array_drain() {
+  list_t* list;
+  if (list_create(&list)) {
+    abort();
+  }
+  generic_value_t values[BENCH_BATCH_SIZE];
+  for (uint64_t i = 0; i < BENCH_BATCH_SIZE; i++) {
+    values[i].ui64 = i;
+  }
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < BENCH_BATCHES; i++) {
+    if (list_push_back_array(list, values, BENCH_BATCH_SIZE)) {
+      abort();
+    }
+  }
+  uint64_t sum = 0;
+  while (!list_empty(list)) {
+    sum += list_pop_front(list).ui64;
+  }
+  bench_report("list_push_back_array_drain",
+	       BENCH_BATCHES * BENCH_BATCH_SIZE, bench_now_ns() - start);
+  bench_use(sum);
+  list_delete(list);
+}
+
+
+int main(int argc, char** argv) {
+  size_t sizes[BENCH_MAX_SIZES];
+  size_t count = bench_sizes(sizes, 1000000);
+  for (size_t i = 0; i < count; i++) {
+    bench_list_push_pop(sizes[i]);
+  }
+  bench_list_push_back_array_drain();
+  bench_list_sort();
+  bench_list_sort_copy_out();
+  return 0;
+}
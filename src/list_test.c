@@ -168,6 +168,269 @@ static void test_list_iterator_remove_current_two_elements_remove_second() {
 }
 
 
+static void test_list_push_back_array() {
+  list_t* list;
+  assert(!list_create(&list));
+  generic_value_t values[10];
+  for (uint64_t i = 0; i < 10; i++) {
+    values[i].i64 = i + 1;
+  }
+  assert(!list_push_back(list, (generic_value_t)(uint64_t)0));
+  assert(!list_push_back_array(list, values, 10));
+  assert(!list_push_back_array(list, values, 0));
+  assert(!list_push_back(list, (generic_value_t)(uint64_t)11));
+  assert(12 == list_size(list));
+  assert(11 == list_get_back(list).i64);
+
+  uint64_t value = 0;
+  for (list_iterator_t iter = list_iterator_create(list);
+       list_iterator_has_current(&iter); list_iterator_next(&iter)) {
+    assert(value++ == list_iterator_get_current(&iter).i64);
+  }
+  assert(12 == value);
+
+  // Each element is released as it is removed.
+  for (uint64_t i = 0; i < 11; i++) {
+    assert(i == list_pop_front(list).i64);
+  }
+  list_memory_usage_t usage;
+  list_memory_usage(list, &usage);
+  assert(sizeof(list_element_t) == usage.nodes);
+  assert(16 == sizeof(list_element_t));
+  assert(11 == list_pop_front(list).i64);
+  assert(!list->tail);
+  list_delete(list);
+}
+
+
+static void test_list_push_back_array_iterator_remove_current() {
+  list_t* list;
+  assert(!list_create(&list));
+  generic_value_t values[10];
+  for (uint64_t i = 0; i < 10; i++) {
+    values[i].i64 = i;
+  }
+  assert(!list_push_back_array(list, values, 10));
+
+  for (list_iterator_t iter = list_iterator_create(list);
+       list_iterator_has_current(&iter); ) {
+    // Remove odd numbers.
+    if (list_iterator_get_current(&iter).i64 % 2) {
+      (void)list_iterator_remove_current(&iter);
+    } else {
+      list_iterator_next(&iter);
+    }
+  }
+  assert(5 == list_size(list));
+  assert(8 == list_get_back(list).i64);
+  list_memory_usage_t usage;
+  list_memory_usage(list, &usage);
+  assert(5 * sizeof(list_element_t) == usage.nodes);
+  list_delete(list);
+}
+
+
+static void test_list_splice() {
+  list_t* dst;
+  list_t* src;
+  assert(!list_create(&dst));
+  assert(!list_create(&src));
+
+  // Splicing an empty list is a no-op.
+  list_splice(dst, src);
+  assert(list_empty(dst));
+
+  for (uint64_t i = 0; i < 10; i++) {
+    assert(!list_push_back(i < 4 ? dst : src, (generic_value_t)i));
+  }
+  list_splice(dst, src);
+  assert(10 == list_size(dst));
+  assert(9 == list_get_back(dst).i64);
+  assert(list_empty(src));
+  assert(!src->head);
+  assert(!src->tail);
+
+  uint64_t value = 0;
+  for (list_iterator_t iter = list_iterator_create(dst);
+       list_iterator_has_current(&iter); list_iterator_next(&iter)) {
+    assert(value++ == list_iterator_get_current(&iter).i64);
+  }
+  assert(10 == value);
+
+  // Splicing into an empty list moves everything.
+  list_splice(src, dst);
+  assert(10 == list_size(src));
+  assert(0 == list_get_front(src).i64);
+  assert(9 == list_get_back(src).i64);
+  assert(!dst->head);
+  list_delete(dst);
+  list_delete(src);
+}
+
+
+static void test_list_splice_arrays() {
+  list_t* dst;
+  list_t* src;
+  assert(!list_create_with_value_deallocator(&dst, free));
+  assert(!list_create_with_value_deallocator(&src, free));
+  for (int list = 0; list < 2; list++) {
+    for (int array = 0; array < 2; array++) {
+      generic_value_t values[5];
+      for (int i = 0; i < 5; i++) {
+	values[i].p = malloc(100);
+	assert(values[i].p);
+      }
+      assert(!list_push_back_array(list ? src : dst, values, 5));
+    }
+  }
+  list_splice(dst, src);
+  assert(20 == list_size(dst));
+  list_memory_usage_t usage;
+  list_memory_usage(src, &usage);
+  assert(!usage.nodes);
+
+  // Elements from the spliced arrays are released through dst.
+  for (int i = 0; i < 20; i++) {
+    free(list_pop_front(dst).p);
+  }
+  list_memory_usage(dst, &usage);
+  assert(!usage.nodes);
+  list_delete(dst);
+  list_delete(src);
+}
+
+
+static int test_compare_high_bits(generic_value_t a, generic_value_t b) {
+  // Compare on the high bits only, so the low bits can check stability.
+  int64_t x = a.i64 / 1000;
+  int64_t y = b.i64 / 1000;
+  return x < y ? -1 : x > y;
+}
+
+
+static void test_list_sort() {
+  list_t* list;
+  assert(!list_create(&list));
+  list_sort(list, test_compare_high_bits);
+  assert(list_empty(list));
+
+  // Values are key * 1000 + insertion order, with keys in [0, 10).
+  uint64_t seed = 1;
+  for (uint64_t i = 0; i < 100; i++) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    uint64_t key = (seed >> 33) % 10;
+    assert(!list_push_back(list, (generic_value_t)(key * 1000 + i)));
+  }
+  list_sort(list, test_compare_high_bits);
+  assert(100 == list_size(list));
+
+  int64_t previous = -1;
+  for (list_iterator_t iter = list_iterator_create(list);
+       list_iterator_has_current(&iter); list_iterator_next(&iter)) {
+    int64_t value = list_iterator_get_current(&iter).i64;
+    // Sorted by key, and by insertion order within a key.
+    assert(previous < value);
+    previous = value;
+  }
+  assert(previous == list_get_back(list).i64);
+  assert(!list->tail->next);
+
+  // The tail must still be usable after sorting.
+  assert(!list_push_back(list, (generic_value_t)(uint64_t)0));
+  assert(101 == list_size(list));
+  assert(0 == list_get_back(list).i64);
+  list_delete(list);
+}
+
+
+static void test_list_sort_single_element() {
+  list_t* list;
+  assert(!list_create(&list));
+  assert(!list_push_back(list, (generic_value_t)(uint64_t)5));
+  list_sort(list, test_compare_high_bits);
+  assert(list->head == list->tail);
+  assert(5 == list_get_front(list).i64);
+  list_delete(list);
+}
+
+
+static void test_list_memory_usage() {
+  list_t* list;
+  assert(!list_create(&list));
+  list_memory_usage_t usage;
+  list_memory_usage(list, &usage);
+  assert(sizeof(list_t) == usage.metadata);
+  assert(!usage.nodes);
+  assert(usage.metadata == usage.total);
+
+  assert(!list_push_back(list, (generic_value_t)(uint64_t)1));
+  assert(!list_push_front(list, (generic_value_t)(uint64_t)0));
+  generic_value_t values[4] = {{0}};
+  assert(!list_push_back_array(list, values, 4));
+  list_memory_usage(list, &usage);
+  assert(6 * sizeof(list_element_t) == usage.nodes);
+  assert(usage.metadata + usage.nodes == usage.total);
+
+  list_pop_front(list);
+  list_pop_front(list);
+  list_pop_front(list);
+  list_memory_usage(list, &usage);
+  assert(3 * sizeof(list_element_t) == usage.nodes);
+
+  list_t* other;
+  assert(!list_create(&other));
+  assert(!list_push_back(other, (generic_value_t)(uint64_t)2));
+  list_splice(list, other);
+  list_memory_usage(other, &usage);
+  assert(!usage.nodes);
+  list_memory_usage(list, &usage);
+  assert(4 * sizeof(list_element_t) == usage.nodes);
+  while (!list_empty(list)) {
+    list_pop_front(list);
+  }
+  list_memory_usage(list, &usage);
+  assert(!usage.nodes);
+  list_delete(list);
+  list_delete(other);
+}
+
+
+static void test_list_for_each() {
+  list_t* list;
+  assert(!list_create(&list));
+  generic_value_t value;
+  LIST_FOR_EACH(list, value) {
+    assert(false);
+  }
+
+  for (uint64_t i = 0; i < 10; i++) {
+    assert(!list_push_back(list, (generic_value_t)i));
+  }
+  generic_value_t values[5] = {{0}};
+  assert(!list_push_back_array(list, values, 5));
+  uint64_t expected = 0;
+  LIST_FOR_EACH(list, value) {
+    assert((expected < 10 ? expected : 0) == value.ui64);
+    expected++;
+  }
+  assert(15 == expected);
+
+  // break and continue apply to the loop itself.
+  uint64_t sum = 0;
+  LIST_FOR_EACH(list, value) {
+    if (value.ui64 % 2) {
+      continue;
+    }
+    if (value.ui64 == 8) {
+      break;
+    }
+    sum += value.ui64;
+  }
+  assert(0 + 2 + 4 + 6 == sum);
+  list_delete(list);
+}
+
+
 int main(int argc, char** argv) {
   test_list_create();
   test_list_delete();
@@ -179,4 +442,12 @@ int main(int argc, char** argv) {
   test_list_iterator_remove_current_single_element();  
   test_list_iterator_remove_current_two_elements_remove_first();
   test_list_iterator_remove_current_two_elements_remove_second();
+  test_list_push_back_array();
+  test_list_push_back_array_iterator_remove_current();
+  test_list_splice();
+  test_list_splice_arrays();
+  test_list_sort();
+  test_list_sort_single_element();
+  test_list_memory_usage();
+  test_list_for_each();
 }
@@ -0,0 +1,257 @@
+#include "lru_cache.h"
+
+#include <stdlib.h>
+
+#include "hash.h"
+
+
+// Provide external definitions of inline functions.
+extern inline size_t lru_cache_size(const lru_cache_t* cache);
+extern inline size_t lru_cache_charge(const lru_cache_t* cache);
+
+
+error_t lru_cache_create(lru_cache_t** cache, size_t capacity) {
+  return lru_cache_create_with_value_deallocator(cache, capacity, 0);
+}
+
+
+error_t lru_cache_create_with_value_deallocator(
+  lru_cache_t** cache, size_t capacity, void (*value_deallocator)(void*)) {
+  lru_cache_t* tmp = calloc(1, sizeof(lru_cache_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  if (map_create(&tmp->entries)) {
+    free(tmp);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->value_deallocator = value_deallocator;
+  tmp->capacity = capacity;
+  intrusive_list_init(&tmp->recency);
+  *cache = tmp;
+  return 0;
+}
+
+
+void lru_cache_delete(lru_cache_t* cache) {
+  if (!cache) {
+    return;
+  }
+  intrusive_list_link_t* link;
+  while ((link = intrusive_list_pop_front(&cache->recency))) {
+    lru_cache_entry_t* entry =
+      INTRUSIVE_LIST_ENTRY(link, lru_cache_entry_t, link);
+    if (cache->value_deallocator) {
+      cache->value_deallocator(entry->value.p);
+    }
+    free(entry);
+  }
+  map_delete(cache->entries);
+  free(cache);
+}
+
+
+// Unlinks an entry from the cache without deleting it.
+static void lru_cache_unlink(lru_cache_t* cache, lru_cache_entry_t* entry) {
+  map_remove_element(cache->entries, entry->element);
+  intrusive_list_remove(&cache->recency, &entry->link);
+  cache->charge -= entry->charge;
+}
+
+
+static void lru_cache_evict(lru_cache_t* cache) {
+  while (cache->charge > cache->capacity) {
+    lru_cache_entry_t* entry = INTRUSIVE_LIST_ENTRY(
+      intrusive_list_get_back(&cache->recency), lru_cache_entry_t, link);
+    lru_cache_unlink(cache, entry);
+    if (cache->value_deallocator) {
+      cache->value_deallocator(entry->value.p);
+    }
+    free(entry);
+  }
+}
+
+
+error_t lru_cache_put(lru_cache_t* cache, const char* key,
+		      generic_value_t value) {
+  return lru_cache_put_with_charge(cache, key, value, 1);
+}
+
+
+error_t lru_cache_put_with_charge(
+  lru_cache_t* cache, const char* key, generic_value_t value, size_t charge) {
+  generic_value_t found;
+  if (map_get(cache->entries, key, &found)) {
+    // Replace the existing entry's value and make it most recently used.
+    lru_cache_entry_t* entry = found.p;
+    if (cache->value_deallocator && entry->value.p != value.p) {
+      cache->value_deallocator(entry->value.p);
+    }
+    entry->value = value;
+    cache->charge += charge - entry->charge;
+    entry->charge = charge;
+    intrusive_list_remove(&cache->recency, &entry->link);
+    intrusive_list_push_front(&cache->recency, &entry->link);
+    lru_cache_evict(cache);
+    return 0;
+  }
+
+  lru_cache_entry_t* entry = calloc(1, sizeof(lru_cache_entry_t));
+  if (!entry) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  if (map_insert_element(cache->entries, key, (generic_value_t)(void*)entry,
+			 &entry->element)) {
+    free(entry);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  entry->value = value;
+  entry->charge = charge;
+  intrusive_list_push_front(&cache->recency, &entry->link);
+  cache->charge += charge;
+  lru_cache_evict(cache);
+  return 0;
+}
+
+
+bool lru_cache_get(lru_cache_t* cache, const char* key,
+		   generic_value_t* value) {
+  generic_value_t found;
+  if (!map_get(cache->entries, key, &found)) {
+    return false;
+  }
+  lru_cache_entry_t* entry = found.p;
+  intrusive_list_remove(&cache->recency, &entry->link);
+  intrusive_list_push_front(&cache->recency, &entry->link);
+  *value = entry->value;
+  return true;
+}
+
+
+bool lru_cache_remove(lru_cache_t* cache, const char* key,
+		      generic_value_t* value) {
+  generic_value_t found;
+  if (!map_get(cache->entries, key, &found)) {
+    return false;
+  }
+  lru_cache_entry_t* entry = found.p;
+  lru_cache_unlink(cache, entry);
+  *value = entry->value;
+  free(entry);
+  return true;
+}
+
+
+error_t sharded_lru_cache_create(
+  sharded_lru_cache_t** cache, size_t shard_count, size_t capacity) {
+  return sharded_lru_cache_create_with_value_deallocator(
+    cache, shard_count, capacity, 0);
+}
+
+
+error_t sharded_lru_cache_create_with_value_deallocator(
+  sharded_lru_cache_t** cache, size_t shard_count, size_t capacity,
+  void (*value_deallocator)(void*)) {
+  if (!shard_count) {
+    return ERROR_INVALID_ARGS;
+  }
+  size_t count = 1;
+  while (count < shard_count) {
+    count *= 2;
+  }
+  sharded_lru_cache_t* tmp = calloc(1, sizeof(sharded_lru_cache_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->shards = aligned_alloc(
+    _Alignof(lru_cache_shard_t), count * sizeof(lru_cache_shard_t));
+  if (!tmp->shards) {
+    free(tmp);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  size_t shard_capacity = (capacity + count - 1) / count;
+  for (; tmp->shard_count < count; tmp->shard_count++) {
+    lru_cache_shard_t* shard = &tmp->shards[tmp->shard_count];
+    if (lru_cache_create_with_value_deallocator(
+	  &shard->cache, shard_capacity, value_deallocator)) {
+      sharded_lru_cache_delete(tmp);
+      return ERROR_OUT_OF_MEMORY;
+    }
+    if (pthread_mutex_init(&shard->mutex, 0)) {
+      lru_cache_delete(shard->cache);
+      sharded_lru_cache_delete(tmp);
+      return ERROR_OUT_OF_MEMORY;
+    }
+  }
+  *cache = tmp;
+  return 0;
+}
+
+
+void sharded_lru_cache_delete(sharded_lru_cache_t* cache) {
+  if (!cache) {
+    return;
+  }
+  for (size_t i = 0; i < cache->shard_count; i++) {
+    pthread_mutex_destroy(&cache->shards[i].mutex);
+    lru_cache_delete(cache->shards[i].cache);
+  }
+  free(cache->shards);
+  free(cache);
+}
+
+
+static lru_cache_shard_t* sharded_lru_cache_find_shard(
+  sharded_lru_cache_t* cache, const char* key) {
+  uint64_t hash_code = hash_string_mixed(key);
+  return &cache->shards[hash_code & (cache->shard_count - 1)];
+}
+
+
+error_t sharded_lru_cache_put(
+  sharded_lru_cache_t* cache, const char* key, generic_value_t value) {
+  return sharded_lru_cache_put_with_charge(cache, key, value, 1);
+}
+
+
+error_t sharded_lru_cache_put_with_charge(
+  sharded_lru_cache_t* cache, const char* key, generic_value_t value,
+  size_t charge) {
+  lru_cache_shard_t* shard = sharded_lru_cache_find_shard(cache, key);
+  pthread_mutex_lock(&shard->mutex);
+  error_t result = lru_cache_put_with_charge(shard->cache, key, value, charge);
+  pthread_mutex_unlock(&shard->mutex);
+  return result;
+}
+
+
+bool sharded_lru_cache_get(
+  sharded_lru_cache_t* cache, const char* key, generic_value_t* value) {
+  lru_cache_shard_t* shard = sharded_lru_cache_find_shard(cache, key);
+  pthread_mutex_lock(&shard->mutex);
+  bool found = lru_cache_get(shard->cache, key, value);
+  pthread_mutex_unlock(&shard->mutex);
+  return found;
+}
+
+
+bool sharded_lru_cache_remove(
+  sharded_lru_cache_t* cache, const char* key, generic_value_t* value) {
+  lru_cache_shard_t* shard = sharded_lru_cache_find_shard(cache, key);
+  pthread_mutex_lock(&shard->mutex);
+  bool found = lru_cache_remove(shard->cache, key, value);
+  pthread_mutex_unlock(&shard->mutex);
+  return found;
+}
+
+
+size_t sharded_lru_cache_size(sharded_lru_cache_t* cache) {
+  size_t size = 0;
+  for (size_t i = 0; i < cache->shard_count; i++) {
+    lru_cache_shard_t* shard = &cache->shards[i];
+    pthread_mutex_lock(&shard->mutex);
+    size += lru_cache_size(shard->cache);
+    pthread_mutex_unlock(&shard->mutex);
+  }
+  return size;
+}
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "errors.h"
+#include "generic.h"
+#include "intrusive_list.h"
+#include "map.h"
+
+
+typedef struct {
+  intrusive_list_link_t link;
+  // The entry's element in lru_cache_t.entries, which holds the key.
+  map_element_t* element;
+  generic_value_t value;
+  size_t charge;
+} lru_cache_entry_t;
+
+typedef struct {
+  void (*value_deallocator)(void*);
+  size_t capacity;
+  // Sum of the charges of all entries.
+  size_t charge;
+  // Maps keys to their lru_cache_entry_t.
+  map_t* entries;
+  // Entries ordered from most to least recently used.
+  intrusive_list_t recency;
+} lru_cache_t;
+
+typedef struct {
+  _Alignas(64) pthread_mutex_t mutex;
+  lru_cache_t* cache;
+} lru_cache_shard_t;
+
+typedef struct {
+  size_t shard_count;
+  lru_cache_shard_t* shards;
+} sharded_lru_cache_t;
+
+
+/**
+ * Creates a new LRU cache.
+ *
+ * Each entry has a charge (1 unless given with lru_cache_put_with_charge)
+ * and the least recently used entries are evicted whenever the total
+ * charge exceeds the capacity. Pass 1 per entry for a count-based cache,
+ * or the entry size in bytes for a byte-based one.
+ *
+ * Args:
+ *  cache: Set to the newly allocated cache.
+ *  capacity: Maximum total charge of the entries.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create cache because of memory error.
+ */
+error_t lru_cache_create(lru_cache_t** cache, size_t capacity);
+
+
+/**
+ * Creates a new LRU cache with a value deallocator.
+ *
+ * The deallocation function is used to delete void* values
+ * (generic_value_t.p) when they are evicted, replaced by lru_cache_put,
+ * or left in the cache when lru_cache_delete is called.
+ *
+ * Args:
+ *  cache: Set to the newly allocated cache.
+ *  capacity: Maximum total charge of the entries.
+ *  deallocated: Function used to delete values.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create cache because of memory error.
+ */
+error_t lru_cache_create_with_value_deallocator(
+  lru_cache_t** cache, size_t capacity, void (*value_deallocator)(void*));
+
+
+/**
+ * Deletes an LRU cache.
+ *
+ * If a deallocation function was provided during creation, cache values
+ * will be treated as void* (generic_value_t.p) and sent to the function.
+ *
+ * Args:
+ *  cache: Cache to be deleted.
+ */
+void lru_cache_delete(lru_cache_t* cache);
+
+
+/**
+ * Inserts a key and value with a charge of 1 into the cache.
+ *
+ * See lru_cache_put_with_charge.
+ */
+error_t lru_cache_put(lru_cache_t* cache, const char* key,
+		      generic_value_t value);
+
+
+/**
+ * Inserts a key and value into the cache.
+ *
+ * The entry becomes the most recently used one. If the key already exists,
+ * its value and charge are replaced. Least recently used entries are then
+ * evicted until the total charge fits the capacity; an entry whose charge
+ * alone exceeds the capacity is evicted immediately.
+ *
+ * Args:
+ *  cache: Cache to update.
+ *  key: Key for cache entry.
+ *  value: Value for cache entry.
+ *  charge: Amount of the capacity used by the entry.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not insert into cache because of memory
+ *   errors.
+ */
+error_t lru_cache_put_with_charge(
+  lru_cache_t* cache, const char* key, generic_value_t value, size_t charge);
+
+
+/**
+ * Gets a value from the cache, marking it as most recently used.
+ *
+ * Args:
+ *  cache: The cache to examine.
+ *  key: The key to look up.
+ *  value: Set to any value found.
+ *
+ * Returns:
+ *  true if the value is found.
+ */
+bool lru_cache_get(lru_cache_t* cache, const char* key,
+		   generic_value_t* value);
+
+
+/**
+ * Removes a key and value from the cache.
+ *
+ * The value is returned to the caller and not deallocated.
+ *
+ * Args:
+ *  cache: The cache to examine.
+ *  key: The key to look up.
+ *  value: Set to any value found.
+ *
+ * Returns:
+ *  true if the value is found.
+ */
+bool lru_cache_remove(lru_cache_t* cache, const char* key,
+		      generic_value_t* value);
+
+
+/**
+ * Returns the number of entries in the cache.
+ *
+ * Args:
+ *  cache: The cache to examine.
+ *
+ * Returns:
+ *  Number of entries in the cache.
+ */
+inline size_t lru_cache_size(const lru_cache_t* cache) {
+  return intrusive_list_size(&cache->recency);
+}
+
+
+/**
+ * Returns the total charge of the entries in the cache.
+ *
+ * Args:
+ *  cache: The cache to examine.
+ *
+ * Returns:
+ *  Total charge of the entries in the cache.
+ */
+inline size_t lru_cache_charge(const lru_cache_t* cache) {
+  return cache->charge;
+}
+
+
+/**
+ * Creates a new sharded LRU cache for concurrent use.
+ *
+ * Keys are spread by hash over independent LRU caches, each guarded by
+ * its own mutex, so threads working on different shards do not contend.
+ * Recency and capacity are tracked per shard.
+ *
+ * Args:
+ *  cache: Set to the newly allocated cache.
+ *  shard_count: Number of shards. Rounded up to a power of two.
+ *  capacity: Maximum total charge of the entries, split evenly between
+ *   the shards.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_INVALID_ARGS: shard_count is 0.
+ *  ERROR_OUT_OF_MEMORY: Could not create cache because of memory error.
+ */
+error_t sharded_lru_cache_create(
+  sharded_lru_cache_t** cache, size_t shard_count, size_t capacity);
+
+
+/**
+ * Creates a new sharded LRU cache with a value deallocator.
+ *
+ * Values may be evicted and deallocated by other threads as soon as
+ * sharded_lru_cache_get returns, so pointer values need their own
+ * lifetime management (e.g. reference counts) when the cache is shared.
+ *
+ * Args:
+ *  cache: Set to the newly allocated cache.
+ *  shard_count: Number of shards. Rounded up to a power of two.
+ *  capacity: Maximum total charge of the entries, split evenly between
+ *   the shards.
+ *  deallocated: Function used to delete values.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_INVALID_ARGS: shard_count is 0.
+ *  ERROR_OUT_OF_MEMORY: Could not create cache because of memory error.
+ */
+error_t sharded_lru_cache_create_with_value_deallocator(
+  sharded_lru_cache_t** cache, size_t shard_count, size_t capacity,
+  void (*value_deallocator)(void*));
+
+
+/**
+ * Deletes a sharded LRU cache.
+ *
+ * No other thread may be using the cache.
+ *
+ * Args:
+ *  cache: Cache to be deleted.
+ */
+void sharded_lru_cache_delete(sharded_lru_cache_t* cache);
+
+
+/**
+ * Thread-safe version of lru_cache_put.
+ */
+error_t sharded_lru_cache_put(
+  sharded_lru_cache_t* cache, const char* key, generic_value_t value);
+
+
+/**
+ * Thread-safe version of lru_cache_put_with_charge.
+ */
+error_t sharded_lru_cache_put_with_charge(
+  sharded_lru_cache_t* cache, const char* key, generic_value_t value,
+  size_t charge);
+
+
+/**
+ * Thread-safe version of lru_cache_get.
+ */
+bool sharded_lru_cache_get(
+  sharded_lru_cache_t* cache, const char* key, generic_value_t* value);
+
+
+/**
+ * Thread-safe version of lru_cache_remove.
+ */
+bool sharded_lru_cache_remove(
+  sharded_lru_cache_t* cache, const char* key, generic_value_t* value);
+
+
+/**
+ * Returns the number of entries in the cache.
+ *
+ * Args:
+ *  cache: The cache to examine.
+ *
+ * Returns:
+ *  Number of entries across all shards.
+ */
+size_t sharded_lru_cache_size(sharded_lru_cache_t* cache);
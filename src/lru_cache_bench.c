@@ -0,0 +1,76 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "lru_cache.h"
+
+
+#define BENCH_KEYS 1000
+#define BENCH_GETS 1000000
+#define BENCH_MAX_THREADS 8
+
+
+static char bench_keys[BENCH_KEYS][16];
+
+
+static void* bench_get_worker(void* arg) {
+  sharded_lru_cache_t* cache = arg;
+  uint64_t seed = (uintptr_t)&seed;
+  uint64_t sum = 0;
+  for (int i = 0; i < BENCH_GETS; i++) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    generic_value_t value;
+    if (sharded_lru_cache_get(cache, bench_keys[(seed >> 33) % BENCH_KEYS],
+			      &value)) {
+      sum += value.ui64;
+    }
+  }
+  bench_use(sum);
+  return 0;
+}
+
+
+static void bench_hits(size_t shard_count, int threads) {
+  sharded_lru_cache_t* cache;
+  if (sharded_lru_cache_create(&cache, shard_count, BENCH_KEYS * 2)) {
+    abort();
+  }
+  for (uint64_t i = 0; i < BENCH_KEYS; i++) {
+    if (sharded_lru_cache_put(cache, bench_keys[i], (generic_value_t)i)) {
+      abort();
+    }
+  }
+
+  pthread_t workers[BENCH_MAX_THREADS];
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < threads; i++) {
+    if (pthread_create(&workers[i], 0, bench_get_worker, cache)) {
+      abort();
+    }
+  }
+  for (int i = 0; i < threads; i++) {
+    pthread_join(workers[i], 0);
+  }
+  uint64_t elapsed = bench_now_ns() - start;
+
+  char label[64];
+  snprintf(label, sizeof(label), "lru_cache_get_%zushards_%dthreads",
+	   shard_count, threads);
+  bench_report(label, (size_t)BENCH_GETS * threads, elapsed);
+  sharded_lru_cache_delete(cache);
+}
+
+
+int main(int argc, char** argv) {
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    snprintf(bench_keys[i], sizeof(bench_keys[i]), "key:%d", i);
+  }
+  int thread_counts[] = {1, 2, 4, 8};
+  for (size_t i = 0; i < sizeof(thread_counts) / sizeof(int); i++) {
+    // A single shard behaves like one cache behind a global lock.
+    bench_hits(1, thread_counts[i]);
+    bench_hits(16, thread_counts[i]);
+  }
+  return 0;
+}
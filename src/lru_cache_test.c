@@ -0,0 +1,199 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lru_cache.h"
+
+
+static void test_lru_cache_create() {
+  lru_cache_t* cache;
+  assert(!lru_cache_create(&cache, 10));
+  assert(!lru_cache_size(cache));
+  assert(!lru_cache_charge(cache));
+  lru_cache_delete(cache);
+}
+
+
+static void test_lru_cache_put_get() {
+  lru_cache_t* cache;
+  assert(!lru_cache_create(&cache, 10));
+  for (uint64_t i = 0; i < 10; i++) {
+    char key[2] = {(char)i + 'a'};
+    assert(!lru_cache_put(cache, key, (generic_value_t)i));
+  }
+  assert(10 == lru_cache_size(cache));
+  for (uint64_t i = 0; i < 10; i++) {
+    char key[2] = {(char)i + 'a'};
+    generic_value_t value;
+    assert(lru_cache_get(cache, key, &value));
+    assert(i == value.i64);
+  }
+  generic_value_t value;
+  assert(!lru_cache_get(cache, "z", &value));
+
+  // Putting an existing key replaces its value.
+  assert(!lru_cache_put(cache, "a", (generic_value_t)(uint64_t)100));
+  assert(10 == lru_cache_size(cache));
+  assert(lru_cache_get(cache, "a", &value));
+  assert(100 == value.i64);
+  lru_cache_delete(cache);
+}
+
+
+static void test_lru_cache_evicts_least_recently_used() {
+  lru_cache_t* cache;
+  assert(!lru_cache_create(&cache, 3));
+  generic_value_t value;
+  assert(!lru_cache_put(cache, "a", (generic_value_t)(uint64_t)1));
+  assert(!lru_cache_put(cache, "b", (generic_value_t)(uint64_t)2));
+  assert(!lru_cache_put(cache, "c", (generic_value_t)(uint64_t)3));
+  // Touch "a" so "b" becomes the least recently used.
+  assert(lru_cache_get(cache, "a", &value));
+  assert(!lru_cache_put(cache, "d", (generic_value_t)(uint64_t)4));
+  assert(3 == lru_cache_size(cache));
+  assert(!lru_cache_get(cache, "b", &value));
+  assert(lru_cache_get(cache, "a", &value));
+  assert(lru_cache_get(cache, "c", &value));
+  assert(lru_cache_get(cache, "d", &value));
+
+  // Replacing a value also counts as a use.
+  assert(!lru_cache_put(cache, "a", (generic_value_t)(uint64_t)5));
+  assert(!lru_cache_put(cache, "e", (generic_value_t)(uint64_t)6));
+  assert(!lru_cache_get(cache, "c", &value));
+  assert(lru_cache_get(cache, "a", &value));
+  assert(5 == value.i64);
+  lru_cache_delete(cache);
+}
+
+
+static void test_lru_cache_charge() {
+  lru_cache_t* cache;
+  assert(!lru_cache_create(&cache, 100));
+  generic_value_t value;
+  assert(!lru_cache_put_with_charge(cache, "a", (generic_value_t)0.0, 40));
+  assert(!lru_cache_put_with_charge(cache, "b", (generic_value_t)0.0, 40));
+  assert(80 == lru_cache_charge(cache));
+  // Needs room for 50, so "a" must go.
+  assert(!lru_cache_put_with_charge(cache, "c", (generic_value_t)0.0, 50));
+  assert(90 == lru_cache_charge(cache));
+  assert(!lru_cache_get(cache, "a", &value));
+  assert(lru_cache_get(cache, "b", &value));
+
+  // Growing an entry's charge evicts others.
+  assert(!lru_cache_put_with_charge(cache, "b", (generic_value_t)0.0, 60));
+  assert(60 == lru_cache_charge(cache));
+  assert(!lru_cache_get(cache, "c", &value));
+
+  // An entry larger than the whole cache is not kept.
+  assert(!lru_cache_put_with_charge(cache, "d", (generic_value_t)0.0, 200));
+  assert(!lru_cache_size(cache));
+  assert(!lru_cache_charge(cache));
+  lru_cache_delete(cache);
+}
+
+
+static void test_lru_cache_remove() {
+  lru_cache_t* cache;
+  assert(!lru_cache_create(&cache, 10));
+  assert(!lru_cache_put(cache, "a", (generic_value_t)(uint64_t)1));
+  assert(!lru_cache_put(cache, "b", (generic_value_t)(uint64_t)2));
+  generic_value_t value;
+  assert(lru_cache_remove(cache, "a", &value));
+  assert(1 == value.i64);
+  assert(!lru_cache_remove(cache, "a", &value));
+  assert(1 == lru_cache_size(cache));
+  assert(1 == lru_cache_charge(cache));
+  lru_cache_delete(cache);
+}
+
+
+static void test_lru_cache_with_value_deallocator() {
+  lru_cache_t* cache;
+  assert(!lru_cache_create_with_value_deallocator(&cache, 5, free));
+  // Evicted, replaced and remaining values are all freed.
+  for (uint64_t i = 0; i < 10; i++) {
+    char key[2] = {(char)i + 'a'};
+    void* p = malloc(100);
+    assert(p);
+    assert(!lru_cache_put(cache, key, (generic_value_t)p));
+  }
+  void* p = malloc(100);
+  assert(p);
+  assert(!lru_cache_put(cache, "j", (generic_value_t)p));
+  assert(5 == lru_cache_size(cache));
+  lru_cache_delete(cache);
+}
+
+
+static void test_sharded_lru_cache() {
+  sharded_lru_cache_t* cache;
+  assert(ERROR_INVALID_ARGS == sharded_lru_cache_create(&cache, 0, 100));
+  assert(!sharded_lru_cache_create(&cache, 3, 100));
+  assert(4 == cache->shard_count);
+  for (uint64_t i = 0; i < 20; i++) {
+    char key[8];
+    snprintf(key, sizeof(key), "key%d", (int)i);
+    assert(!sharded_lru_cache_put(cache, key, (generic_value_t)i));
+  }
+  assert(20 == sharded_lru_cache_size(cache));
+  for (uint64_t i = 0; i < 20; i++) {
+    char key[8];
+    snprintf(key, sizeof(key), "key%d", (int)i);
+    generic_value_t value;
+    assert(sharded_lru_cache_get(cache, key, &value));
+    assert(i == value.i64);
+  }
+  generic_value_t value;
+  assert(sharded_lru_cache_remove(cache, "key3", &value));
+  assert(3 == value.i64);
+  assert(!sharded_lru_cache_get(cache, "key3", &value));
+  assert(19 == sharded_lru_cache_size(cache));
+  sharded_lru_cache_delete(cache);
+}
+
+
+static void* test_sharded_lru_cache_worker(void* arg) {
+  sharded_lru_cache_t* cache = arg;
+  for (uint64_t i = 0; i < 1000; i++) {
+    char key[8];
+    snprintf(key, sizeof(key), "key%d", (int)(i % 50));
+    generic_value_t value;
+    if (!sharded_lru_cache_get(cache, key, &value)) {
+      assert(!sharded_lru_cache_put(cache, key, (generic_value_t)(i % 50)));
+    } else {
+      assert(i % 50 == value.i64);
+    }
+  }
+  return 0;
+}
+
+
+static void test_sharded_lru_cache_threads() {
+  sharded_lru_cache_t* cache;
+  // Small enough that threads also evict concurrently.
+  assert(!sharded_lru_cache_create(&cache, 4, 32));
+  pthread_t threads[4];
+  for (int i = 0; i < 4; i++) {
+    assert(!pthread_create(
+	     &threads[i], 0, test_sharded_lru_cache_worker, cache));
+  }
+  for (int i = 0; i < 4; i++) {
+    assert(!pthread_join(threads[i], 0));
+  }
+  assert(sharded_lru_cache_size(cache) <= 32);
+  sharded_lru_cache_delete(cache);
+}
+
+
+int main(int argc, char** argv) {
+  test_lru_cache_create();
+  test_lru_cache_put_get();
+  test_lru_cache_evicts_least_recently_used();
+  test_lru_cache_charge();
+  test_lru_cache_remove();
+  test_lru_cache_with_value_deallocator();
+  test_sharded_lru_cache();
+  test_sharded_lru_cache_threads();
+  return 0;
+}
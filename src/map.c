@@ -5,6 +5,7 @@
 #include <string.h>
 
 #include "hash.h"
+#include "node_cache.h"
 #include "string_util.h"
 
 
@@ -16,6 +17,9 @@ extern inline size_t map_size(const map_t* map);
 extern inline bool map_iterator_has_current(map_iterator_t* iter);
 extern inline void map_iterator_get_current(
   map_iterator_t* iter, const char** key, generic_value_t* value);
+extern inline map_for_each_t map_for_each_create(const map_t* map);
+extern inline bool map_for_each_next(
+  map_for_each_t* state, const char** key, generic_value_t* value);
 
 
 error_t map_create(map_t** map) {
@@ -31,7 +35,7 @@ error_t map_create_with_value_deallocator(
   }
   tmp->value_deallocator = value_deallocator;
   tmp->capacity = INITIAL_CAPACITY;
-  tmp->buckets = calloc(tmp->capacity, sizeof(list_t*));
+  tmp->buckets = calloc(tmp->capacity, sizeof(map_element_t*));
   if (!tmp->buckets) {
     free(tmp);
     return ERROR_OUT_OF_MEMORY;
@@ -41,118 +45,193 @@ error_t map_create_with_value_deallocator(
 }
 
 
+static void map_element_delete(map_element_t* element) {
+  if (!element) {
+    return;
+  }
+  free(element->key);
+  node_cache_free(element, sizeof(map_element_t));
+}
+
+
+static void map_element_deallocator(map_element_t* element) {
+  if (element->value_deallocator) {
+    element->value_deallocator(element->value.p);
+  }
+  map_element_delete(element);
+}
+
+
 void map_delete(map_t* map) {
   if (!map) {
     return;
   }
   for (size_t i = 0; i < map->capacity; i++) {
-    if (map->buckets[i]) {
-      list_delete(map->buckets[i]);
+    map_element_t* element = map->buckets[i];
+    while (element) {
+      map_element_t* next = element->next;
+      map_element_deallocator(element);
+      element = next;
     }
   }
   free(map->buckets);
+  bloom_filter_delete(map->filter);
   free(map);
 }
 
 
-static bool map_find_element(
-  list_t* bucket, const char* key, list_iterator_t* iter) {
-  for (list_iterator_t iter_tmp = list_iterator_create(bucket);
-       list_iterator_has_current(&iter_tmp); list_iterator_next(&iter_tmp)) {
-    map_element_t* tmp =
-      (map_element_t*)list_iterator_get_current(&iter_tmp).p;
-    if (!strcmp(tmp->key, key)) {
-      *iter = iter_tmp;
-      return true;
+// Returns the link pointing to the element for key in the chain starting
+// at link, or the null link ending the chain if key is absent.
+static map_element_t** map_find_link(
+  map_t* map, map_element_t** link, const char* key, size_t key_length,
+  uint64_t hash_code) {
+#ifdef MAP_PROBE_STATS
+  map->lookups++;
+#endif
+  for (; *link; link = &(*link)->next) {
+    map_element_t* tmp = *link;
+#ifdef MAP_PROBE_STATS
+    map->probes++;
+    map->key_comparisons +=
+      tmp->hash_code == hash_code && tmp->key_length == key_length;
+#endif
+    // Most other keys in the bucket differ in hash code or length, which
+    // rejects them without touching the key.
+    if (tmp->hash_code == hash_code &&
+	string_equal(tmp->key, tmp->key_length, key, key_length)) {
+      break;
     }
   }
-  return false;
+  return link;
 }
 
 
-static void map_element_delete(map_element_t* element) {
-  if (!element) {
-    return;
+error_t map_enable_filter(map_t* map, size_t capacity) {
+  if (capacity < map->size) {
+    capacity = map->size;
   }
-  free(element->key);
-  free(element);
+  bloom_filter_t* filter;
+  if (bloom_filter_create(&filter, capacity)) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  for (size_t i = 0; i < map->capacity; i++) {
+    for (map_element_t* element = map->buckets[i]; element;
+	 element = element->next) {
+      bloom_filter_add(filter, element->hash_code);
+    }
+  }
+  if (map->filter) {
+    // Keep the lookup statistics across rebuilds.
+    filter->negatives = map->filter->negatives;
+    filter->false_positives = map->filter->false_positives;
+    bloom_filter_delete(map->filter);
+  }
+  map->filter = filter;
+  return 0;
 }
 
 
-static void map_element_deallocator(map_element_t* element) {
-  if (element->value_deallocator) {
-    element->value_deallocator(element->value.p);
+// Returns true if the filter shows key is absent.
+static bool map_filter_rejects(map_t* map, uint64_t hash_code) {
+  if (map->filter && !bloom_filter_may_contain(map->filter, hash_code)) {
+    map->filter->negatives++;
+    return true;
   }
-  map_element_delete(element);
+  return false;
 }
 
 
-error_t map_insert(map_t* map, const char* key, generic_value_t value) {
-  // Find the associated bucket.
+// Inserts key, taking ownership of owned_key when given and copying key
+// otherwise. On failure the caller keeps ownership of owned_key. Sets
+// result, if given, to the key's element.
+static error_t map_insert_key(
+  map_t* map, const char* key, char* owned_key, generic_value_t value,
+  map_element_t** result) {
+  // Find the associated bucket and check to see if the key is already
+  // present.
   uint64_t hash_code = hash_string(key);
-  size_t index = hash_code % map->capacity;
-  list_t* bucket = map->buckets[index];
-  bool new_bucket = false;
-  if (!bucket) {
-    error_t error = list_create_with_value_deallocator(
-      &bucket, (void(*)(void*))map_element_deallocator);
-    if (error) {
-      return error;
-    }
-    map->buckets[index] = bucket;
-    new_bucket = true;
-  } else {
-    // Check to see if the key is already present.
-    list_iterator_t iter;
-    if (map_find_element(bucket, key, &iter)) {
-      map_element_t* element = (map_element_t*)
-	list_iterator_get_current(&iter).p;
-      element->value = value;
-      return 0;
+  size_t key_length = string_length(key);
+  map_element_t** link = map_find_link(
+    map, &map->buckets[hash_code % map->capacity], key, key_length,
+    hash_code);
+  if (*link) {
+    (*link)->value = value;
+    free(owned_key);
+    if (result) {
+      *result = *link;
     }
+    return 0;
   }
 
-  // Add new value.
-  map_element_t* element = calloc(1, sizeof(map_element_t));
+  // Add new value at the end of the chain.
+  map_element_t* element = node_cache_alloc(sizeof(map_element_t));
   if (!element) {
-    goto out_of_memory;
+    return ERROR_OUT_OF_MEMORY;
   }
-
-  if (string_copy(key, &element->key)) {
-    goto out_of_memory;
+  element->next = 0;
+  if (owned_key) {
+    element->key = owned_key;
+  } else {
+    if (!(element->key = malloc(key_length + 1))) {
+      node_cache_free(element, sizeof(map_element_t));
+      return ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(element->key, key, key_length + 1);
   }
+  element->key_length = key_length;
   element->hash_code = hash_code;
   element->value = value;
   element->value_deallocator = map->value_deallocator;
-
-  if (list_push_back(bucket, (generic_value_t)(void*)element)) {
-    goto out_of_memory;
+  *link = element;
+  if (result) {
+    *result = element;
   }
+
   map->size++;
+  map->key_bytes += key_length + 1;
+  if (map->filter) {
+    if (map->filter->count < map->filter->capacity) {
+      bloom_filter_add(map->filter, hash_code);
+    } else if (map_enable_filter(map, map->size * 2)) {
+      // Keep the old filter, which is still correct but less selective.
+      bloom_filter_add(map->filter, hash_code);
+    }
+  }
   return 0;
+}
 
- out_of_memory:
-  map_element_delete(element);
-  if (new_bucket) {
-    list_delete(bucket);
-    map->buckets[index] = 0;
-  }
-  return ERROR_OUT_OF_MEMORY;
+
+error_t map_insert(map_t* map, const char* key, generic_value_t value) {
+  return map_insert_key(map, key, 0, value, 0);
+}
+
+
+error_t map_insert_owned(map_t* map, char* key, generic_value_t value) {
+  return map_insert_key(map, key, key, value, 0);
+}
+
+
+error_t map_insert_element(
+  map_t* map, const char* key, generic_value_t value,
+  map_element_t** element) {
+  return map_insert_key(map, key, 0, value, element);
 }
 
 
 bool map_get(map_t* map, const char* key, generic_value_t* value) {
   uint64_t hash_code = hash_string(key);
-  size_t index = hash_code % map->capacity;
-  list_t* bucket = map->buckets[index];
-  if (bucket) {
-    list_iterator_t iter;
-    if (map_find_element(bucket, key, &iter)) {
-      map_element_t* element = (map_element_t*)
-	list_iterator_get_current(&iter).p;
-      *value = element->value;
-      return true;
-    }
+  if (map_filter_rejects(map, hash_code)) {
+    return false;
+  }
+  map_element_t* element = *map_find_link(
+    map, &map->buckets[hash_code % map->capacity], key, string_length(key),
+    hash_code);
+  if (element) {
+    *value = element->value;
+    return true;
+  }
+  if (map->filter) {
+    map->filter->false_positives++;
   }
   return false;
 }
@@ -160,37 +239,88 @@ bool map_get(map_t* map, const char* key, generic_value_t* value) {
 
 bool map_remove(map_t* map, const char* key, generic_value_t* value) {
   uint64_t hash_code = hash_string(key);
-  size_t index = hash_code % map->capacity;
-  list_t* bucket = map->buckets[index];
-  if (bucket) {
-    list_iterator_t iter;
-    if (map_find_element(bucket, key, &iter)) {
-      map_element_t* element = (map_element_t*)
-	list_iterator_remove_current(&iter).p;
-      *value = element->value;
-      map_element_delete(element);
-      map->size--;
-
-      // Delete empty bucket.
-      if (!list_size(bucket)) {
-	list_delete(bucket);
-	map->buckets[index] = 0;
-      }
-      return true;
+  if (map_filter_rejects(map, hash_code)) {
+    return false;
+  }
+  map_element_t** link = map_find_link(
+    map, &map->buckets[hash_code % map->capacity], key, string_length(key),
+    hash_code);
+  map_element_t* element = *link;
+  if (!element) {
+    return false;
+  }
+  *link = element->next;
+  *value = element->value;
+  map->key_bytes -= element->key_length + 1;
+  map_element_delete(element);
+  map->size--;
+  return true;
+}
+
+
+void map_remove_element(map_t* map, map_element_t* element) {
+  map_element_t** link = &map->buckets[element->hash_code % map->capacity];
+  while (*link != element) {
+    link = &(*link)->next;
+  }
+  *link = element->next;
+  map->key_bytes -= element->key_length + 1;
+  map_element_delete(element);
+  map->size--;
+}
+
+
+void map_get_stats(const map_t* map, map_stats_t* stats) {
+  memset(stats, 0, sizeof(*stats));
+  stats->capacity = map->capacity;
+  stats->size = map->size;
+  stats->load_factor = (double)map->size / map->capacity;
+  for (size_t i = 0; i < map->capacity; i++) {
+    size_t length = 0;
+    for (map_element_t* element = map->buckets[i]; element;
+	 element = element->next) {
+      length++;
+    }
+    if (!length) {
+      stats->empty_buckets++;
+    }
+    if (length > stats->max_chain_length) {
+      stats->max_chain_length = length;
     }
+    stats->chain_length_histogram[
+      length < MAP_STATS_HISTOGRAM_SIZE ? length :
+      MAP_STATS_HISTOGRAM_SIZE - 1]++;
   }
-  return false;
+  size_t used_buckets = map->capacity - stats->empty_buckets;
+  stats->mean_chain_length =
+    used_buckets ? (double)map->size / used_buckets : 0;
+  stats->lookups = map->lookups;
+  stats->probes = map->probes;
+  stats->key_comparisons = map->key_comparisons;
 }
 
 
+void map_memory_usage(const map_t* map, map_memory_usage_t* usage) {
+  usage->metadata = sizeof(map_t) + map->capacity * sizeof(map_element_t*);
+  if (map->filter) {
+    usage->metadata += sizeof(bloom_filter_t) +
+      (map->filter->mask + 1) * sizeof(bloom_filter_block_t);
+  }
+  usage->nodes = map->size * sizeof(map_element_t);
+  usage->keys = map->key_bytes;
+  usage->total = usage->metadata + usage->nodes + usage->keys;
+}
+
+
+// Positions the iterator at the first element of the first non-empty
+// bucket from bucket_index on.
 static void map_iterator_find_bucket(map_iterator_t* iter) {
   while (iter->bucket_index < iter->map->capacity) {
-      list_t* bucket = iter->map->buckets[iter->bucket_index];
-      if (bucket) {
-	iter->bucket_iter = list_iterator_create(bucket);
-	break;
-      }
-      iter->bucket_index++;    
+    if (iter->map->buckets[iter->bucket_index]) {
+      iter->current = &iter->map->buckets[iter->bucket_index];
+      break;
+    }
+    iter->bucket_index++;
   }
 }
 
@@ -204,27 +334,25 @@ map_iterator_t map_iterator_create(map_t* map) {
 
 
 generic_value_t map_iterator_remove_current(map_iterator_t* iter) {
-  generic_value_t value = list_iterator_remove_current(&iter->bucket_iter);
-  map_element_delete((map_element_t*)value.p);
-  if (!list_iterator_has_current(&iter->bucket_iter)) {
-    // Delete empty bucket.
-    list_t* bucket = iter->map->buckets[iter->bucket_index];
-    if (!list_size(bucket)) {
-      list_delete(bucket);
-      iter->map->buckets[iter->bucket_index] = 0;
-    }
-    // Find the next bucket.    
+  map_element_t* element = *iter->current;
+  generic_value_t value = element->value;
+  // Unlinking leaves current pointing to the next element of the bucket.
+  *iter->current = element->next;
+  iter->map->key_bytes -= element->key_length + 1;
+  map_element_delete(element);
+  iter->map->size--;
+  if (!*iter->current) {
+    // Find the next bucket.
     iter->bucket_index++;
     map_iterator_find_bucket(iter);
   }
-  iter->map->size--;
   return value;
 }
 
 
 void map_iterator_next(map_iterator_t* iter) {
-  list_iterator_next(&iter->bucket_iter);
-  if (!list_iterator_has_current(&iter->bucket_iter)) {
+  iter->current = &(*iter->current)->next;
+  if (!*iter->current) {
     // Find the next bucket.
     iter->bucket_index++;
     map_iterator_find_bucket(iter);
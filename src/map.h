@@ -3,13 +3,16 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "bloom_filter.h"
 #include "errors.h"
 #include "generic.h"
-#include "list.h"
 
 
-typedef struct {
+typedef struct map_element {
+  // Next element in the same bucket.
+  struct map_element* next;
   char* key;
+  size_t key_length;
   uint64_t hash_code;
   generic_value_t value;
   void (*value_deallocator)(void*);
@@ -19,14 +22,65 @@ typedef struct {
   void (*value_deallocator)(void*);
   size_t size;
   size_t capacity;
-  list_t** buckets;
+  // Heads of the bucket chains, linked through map_element_t.next.
+  map_element_t** buckets;
+  // Optional filter rejecting lookups of absent keys; see
+  // map_enable_filter.
+  bloom_filter_t* filter;
+  // Bucket searches, elements visited and key comparisons made by them.
+  // Only counted when built with MAP_PROBE_STATS defined.
+  size_t lookups;
+  size_t probes;
+  size_t key_comparisons;
+  // Bytes of key strings, for map_memory_usage.
+  size_t key_bytes;
 } map_t;
 
 typedef struct {
   map_t* map;
   size_t bucket_index;
-  list_iterator_t bucket_iter;
+  // Link pointing to the current element, so it can be unlinked.
+  map_element_t** current;
 } map_iterator_t;
+
+typedef struct {
+  // Next bucket to visit and the end of the bucket array.
+  map_element_t** bucket;
+  map_element_t** end;
+  // Element following the current one in its chain.
+  map_element_t* next;
+} map_for_each_t;
+
+typedef struct {
+  // The map_t, its bucket array and filter.
+  size_t metadata;
+  // A map_element_t per entry.
+  size_t nodes;
+  // Key strings.
+  size_t keys;
+  size_t total;
+} map_memory_usage_t;
+
+// Chain lengths counted separately by map_get_stats; longer chains are
+// counted together in the last histogram entry.
+#define MAP_STATS_HISTOGRAM_SIZE 16
+
+typedef struct {
+  size_t capacity;
+  size_t size;
+  // Elements per bucket.
+  double load_factor;
+  size_t empty_buckets;
+  size_t max_chain_length;
+  // Mean length of the non-empty chains.
+  double mean_chain_length;
+  // Entry i is the number of buckets holding i elements.
+  size_t chain_length_histogram[MAP_STATS_HISTOGRAM_SIZE];
+  // Counters from map_t; zero unless built with MAP_PROBE_STATS.
+  size_t lookups;
+  size_t probes;
+  size_t key_comparisons;
+} map_stats_t;
   
 
 /**
@@ -89,6 +143,26 @@ void map_delete(map_t* map);
 error_t map_insert(map_t* map, const char* key, generic_value_t value);
 
 
+/**
+ * Inserts a key and value into the map, taking ownership of the key.
+ *
+ * This avoids copying keys that were built on the heap, e.g. with
+ * strbuf_detach. If the key already exists in the map, the value is
+ * updated and the given key is freed.
+ *
+ * Args:
+ *  map: Map to update.
+ *  key: malloc'd key for map entry. Owned by the map on success; still
+ *   owned by the caller on failure.
+ *  value: Value for map entry.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not insert into map because of memory errors.
+ */
+error_t map_insert_owned(map_t* map, char* key, generic_value_t value);
+
+
 /**
  * Gets a value from the map.
  *
@@ -117,6 +191,100 @@ bool map_get(map_t* map, const char* key, generic_value_t* value);
 bool map_remove(map_t* map, const char* key, generic_value_t* value);
 
 
+/**
+ * Inserts a key and value into the map and returns the key's element.
+ *
+ * Behaves like map_insert. The element, and the key it holds, stay valid
+ * until the key is removed, so a caller keeping its own record per key
+ * can use element->key rather than a copy of the key, and remove the key
+ * with map_remove_element.
+ *
+ * Args:
+ *  map: Map to update.
+ *  key: Key for map entry.
+ *  value: Value for map entry.
+ *  element: Set to the element holding key.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not insert into map because of memory errors.
+ */
+error_t map_insert_element(
+  map_t* map, const char* key, generic_value_t value,
+  map_element_t** element);
+
+
+/**
+ * Removes an element returned by map_insert_element.
+ *
+ * The key is not hashed or compared again: the bucket comes from the
+ * element's hash code, and its chain is searched for the element itself.
+ * The value is not deallocated.
+ *
+ * Args:
+ *  map: The map to update.
+ *  element: Element to remove. Freed by this call.
+ */
+void map_remove_element(map_t* map, map_element_t* element);
+
+
+/**
+ * Attaches a Bloom filter to the map.
+ *
+ * The filter lets map_get and map_remove reject most absent keys with one
+ * cache line access, using the hash already computed for the lookup,
+ * instead of walking a bucket. It is rebuilt with twice the map size
+ * whenever more keys than it was sized for have been inserted; removed
+ * keys stay in the filter until then, so they may be let through.
+ *
+ * The measured false positive rate is available from
+ * bloom_filter_false_positive_rate(map->filter).
+ *
+ * Args:
+ *  map: Map to update.
+ *  capacity: Number of keys to size the filter for. The map size is used
+ *   if it is larger.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create filter because of memory error.
+ */
+error_t map_enable_filter(map_t* map, size_t capacity);
+
+
+/**
+ * Reports how the map's elements are spread over its buckets.
+ *
+ * Long chains or many empty buckets at a low load factor point to a poor
+ * hash distribution. This walks every bucket, so it takes O(capacity +
+ * size) time.
+ *
+ * When the library is built with MAP_PROBE_STATS defined, lookups also
+ * count the elements they visit and the keys they compare, so probes /
+ * lookups gives the mean probe length. Lookups rejected by the filter are
+ * not counted.
+ *
+ * Args:
+ *  map: The map to examine.
+ *  stats: Set to the statistics of the map.
+ */
+void map_get_stats(const map_t* map, map_stats_t* stats);
+
+
+/**
+ * Reports the heap memory owned by a map.
+ *
+ * Sizes are the bytes requested from the allocator, not counting its
+ * overhead, and exclude whatever values point to. They are tracked as the
+ * map changes, so this takes O(1) time.
+ *
+ * Args:
+ *  map: The map to examine.
+ *  usage: Set to the bytes used, by category.
+ */
+void map_memory_usage(const map_t* map, map_memory_usage_t* usage);
+
+
 /**
  * Returns the size of the map.
  *
@@ -175,8 +343,7 @@ inline bool map_iterator_has_current(map_iterator_t* iter) {
  */
 inline void map_iterator_get_current(
   map_iterator_t* iter, const char** key, generic_value_t* value) {
-  map_element_t* element =
-    (map_element_t*)list_iterator_get_current(&iter->bucket_iter).p;
+  map_element_t* element = *iter->current;
   *key = element->key;
   *value = element->value;
 }
@@ -210,3 +377,75 @@ generic_value_t map_iterator_remove_current(map_iterator_t* iter);
  *  iter: Iterator to update.
  */
 void map_iterator_next(map_iterator_t* iter);
+
+
+/**
+ * Starts a traversal for MAP_FOR_EACH.
+ *
+ * Args:
+ *  map: Map to traverse.
+ *
+ * Returns:
+ *  Traversal state positioned before the first element.
+ */
+inline map_for_each_t map_for_each_create(const map_t* map) {
+  return (map_for_each_t){map->buckets, map->buckets + map->capacity, 0};
+}
+
+
+/**
+ * Moves a MAP_FOR_EACH traversal to the next element.
+ *
+ * The element after it is found before returning, so the caller may remove
+ * the returned key.
+ *
+ * Args:
+ *  state: Traversal to update.
+ *  key: Set to the key for the element (owned by map).
+ *  value: Set to the value for the element.
+ *
+ * Returns:
+ *  true if there was another element.
+ */
+inline bool map_for_each_next(
+  map_for_each_t* state, const char** key, generic_value_t* value) {
+  map_element_t* element = state->next;
+  while (!element) {
+    if (state->bucket == state->end) {
+      return false;
+    }
+    element = *state->bucket++;
+  }
+  state->next = element->next;
+  *key = element->key;
+  *value = element->value;
+  return true;
+}
+
+
+/**
+ * Loops over the elements of a map.
+ *
+ * The traversal is written out in the loop rather than called through
+ * map_iterator_next, so the compiler can inline it into tight scans.
+ * key and value must be a const char* and a generic_value_t declared by
+ * the caller, and are set before each run of the body. break and continue
+ * work as in any loop. The body may remove the current key with
+ * map_remove but must not otherwise modify the map.
+ *
+ * For example:
+ *
+ *   const char* key;
+ *   generic_value_t value;
+ *   MAP_FOR_EACH(map, key, value) {
+ *     printf("%s: %f\n", key, value.d);
+ *   }
+ *
+ * Args:
+ *  map: Map to traverse.
+ *  key: Variable set to each key.
+ *  value: Variable set to each value.
+ */
+#define MAP_FOR_EACH(map, key, value)					\
+  for (map_for_each_t map_for_each_state = map_for_each_create(map);	\
+       map_for_each_next(&map_for_each_state, &(key), &(value));)
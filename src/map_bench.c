@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "map.h"
+
+
+#define BENCH_KEYS 10000
+#define BENCH_GETS 100000
+// map_t has a fixed number of buckets, so by default the size sweep stops
+// where operations are still fast enough to finish quickly.
+#define BENCH_DEFAULT_MAX_SIZE 10000
+#define BENCH_KEY_SIZE 24
+
+
+static char bench_keys[BENCH_KEYS][16];
+static char bench_absent_keys[BENCH_KEYS][16];
+
+
+// Looks up a mix of present and absent keys.
+static void bench_gets(map_t* map, const char* name, int miss_percent) {
+  uint64_t seed = 1;
+  uint64_t sum = 0;
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < BENCH_GETS; i++) {
+    uint64_t random = bench_random(&seed);
+    const char* key = (int)(random % 100) < miss_percent ?
+      bench_absent_keys[(random >> 7) % BENCH_KEYS] :
+      bench_keys[(random >> 7) % BENCH_KEYS];
+    generic_value_t value;
+    if (map_get(map, key, &value)) {
+      sum += value.ui64;
+    }
+  }
+  uint64_t elapsed = bench_now_ns() - start;
+  char label[64];
+  snprintf(label, sizeof(label), "%s_%dmiss", name, miss_percent);
+  bench_report(label, BENCH_GETS, elapsed);
+  bench_use(sum);
+}
+
+
+// Times each map operation on a map of the given size.
+static void bench_map_operations(size_t size) {
+  char* keys = bench_make_keys("key:", size, BENCH_KEY_SIZE);
+  char* absent_keys =
+    bench_make_keys("absent:", BENCH_GETS, BENCH_KEY_SIZE);
+  char name[64];
+  map_t* map;
+  if (map_create(&map)) {
+    abort();
+  }
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < size; i++) {
+    if (map_insert(map, keys + i * BENCH_KEY_SIZE, (generic_value_t)i)) {
+      abort();
+    }
+  }
+  snprintf(name, sizeof(name), "map_insert/%zu", size);
+  bench_report(name, size, bench_now_ns() - start);
+
+  map_stats_t stats;
+  map_get_stats(map, &stats);
+  snprintf(name, sizeof(name), "map_max_chain_length/%zu", size);
+  bench_report_value(name, stats.max_chain_length, "elements");
+  snprintf(name, sizeof(name), "map_mean_chain_length/%zu", size);
+  bench_report_value(name, stats.mean_chain_length, "elements");
+
+  uint64_t seed = 1;
+  uint64_t sum = 0;
+  generic_value_t value;
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_GETS; i++) {
+    size_t index = bench_random(&seed) % size;
+    sum += map_get(map, keys + index * BENCH_KEY_SIZE, &value);
+  }
+  snprintf(name, sizeof(name), "map_get_hit_uniform/%zu", size);
+  bench_report(name, BENCH_GETS, bench_now_ns() - start);
+
+  bench_zipf_t zipf;
+  bench_zipf_init(&zipf, size, 0.99, 1);
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_GETS; i++) {
+    size_t index = bench_zipf_next(&zipf);
+    sum += map_get(map, keys + index * BENCH_KEY_SIZE, &value);
+  }
+  snprintf(name, sizeof(name), "map_get_hit_zipf/%zu", size);
+  bench_report(name, BENCH_GETS, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_GETS; i++) {
+    sum += map_get(map, absent_keys + i * BENCH_KEY_SIZE, &value);
+  }
+  snprintf(name, sizeof(name), "map_get_miss/%zu", size);
+  bench_report(name, BENCH_GETS, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (map_iterator_t iter = map_iterator_create(map);
+       map_iterator_has_current(&iter); map_iterator_next(&iter)) {
+    const char* key;
+    map_iterator_get_current(&iter, &key, &value);
+    sum += value.ui64;
+  }
+  snprintf(name, sizeof(name), "map_iterate/%zu", size);
+  bench_report(name, size, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  const char* key;
+  MAP_FOR_EACH(map, key, value) {
+    sum += value.ui64;
+  }
+  snprintf(name, sizeof(name), "map_for_each/%zu", size);
+  bench_report(name, size, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (size_t i = 0; i < size; i++) {
+    sum += map_remove(map, keys + i * BENCH_KEY_SIZE, &value);
+  }
+  snprintf(name, sizeof(name), "map_remove/%zu", size);
+  bench_report(name, size, bench_now_ns() - start);
+  bench_use(sum);
+  map_delete(map);
+  free(keys);
+  free(absent_keys);
+}
+
+
+int main(int argc, char** argv) {
+  size_t sizes[BENCH_MAX_SIZES];
+  size_t count = bench_sizes(sizes, BENCH_DEFAULT_MAX_SIZE);
+  for (size_t i = 0; i < count; i++) {
+    bench_map_operations(sizes[i]);
+  }
+
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    snprintf(bench_keys[i], sizeof(bench_keys[i]), "key:%d", i);
+    snprintf(bench_absent_keys[i], sizeof(bench_absent_keys[i]), "absent:%d",
+	     i);
+  }
+  map_t* map;
+  if (map_create(&map)) {
+    abort();
+  }
+  for (uint64_t i = 0; i < BENCH_KEYS; i++) {
+    if (map_insert(map, bench_keys[i], (generic_value_t)i)) {
+      abort();
+    }
+  }
+
+  int miss_percents[] = {0, 50, 90};
+  for (size_t i = 0; i < sizeof(miss_percents) / sizeof(int); i++) {
+    bench_gets(map, "map_get", miss_percents[i]);
+  }
+  if (map_enable_filter(map, BENCH_KEYS)) {
+    abort();
+  }
+  for (size_t i = 0; i < sizeof(miss_percents) / sizeof(int); i++) {
+    bench_gets(map, "map_get_filtered", miss_percents[i]);
+  }
+  bench_report_value("map_filter_false_positive_rate",
+		     bloom_filter_false_positive_rate(map->filter), "ratio");
+  map_delete(map);
+  return 0;
+}
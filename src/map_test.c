@@ -1,6 +1,10 @@
 #include "map.h"
 
 #include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "string_util.h"
 
 
 static void test_map_create() {
@@ -30,6 +34,28 @@ static void test_map_insert() {
 }
 
 
+static void test_map_insert_owned() {
+  map_t* map;
+  assert(!map_create(&map));
+  char* key;
+  assert(!string_copy("owned", &key));
+  assert(!map_insert_owned(map, key, (generic_value_t)1.5));
+  // The map keeps the given string rather than a copy.
+  map_iterator_t iter = map_iterator_create(map);
+  const char* current_key;
+  generic_value_t value;
+  map_iterator_get_current(&iter, &current_key, &value);
+  assert(key == current_key);
+  // An existing key has its value updated and the new string freed.
+  assert(!string_copy("owned", &key));
+  assert(!map_insert_owned(map, key, (generic_value_t)2.5));
+  assert(1 == map_size(map));
+  assert(map_get(map, "owned", &value));
+  assert(2.5 == value.d);
+  map_delete(map);
+}
+
+
 static void test_map_get() {
   map_t* map;
   assert(!map_create(&map));
@@ -69,6 +95,42 @@ static void test_map_remove() {
 }
 
 
+static void test_map_remove_element() {
+  map_t* map;
+  assert(!map_create(&map));
+  map_element_t* elements[100];
+  for (uint64_t i = 0; i < 100; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    assert(!map_insert_element(map, key, (generic_value_t)i, &elements[i]));
+    assert(!strcmp(key, elements[i]->key));
+    assert(i == elements[i]->value.ui64);
+  }
+  // Inserting an existing key returns its element.
+  map_element_t* element;
+  assert(!map_insert_element(map, "key:7", (generic_value_t)(uint64_t)70,
+			     &element));
+  assert(elements[7] == element);
+  assert(70 == element->value.ui64);
+
+  // Remove every other element, which leaves the rest of each chain.
+  for (uint64_t i = 0; i < 100; i += 2) {
+    map_remove_element(map, elements[i]);
+  }
+  assert(50 == map_size(map));
+  map_memory_usage_t usage;
+  map_memory_usage(map, &usage);
+  assert(50 * sizeof(map_element_t) == usage.nodes);
+  for (uint64_t i = 0; i < 100; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    generic_value_t value;
+    assert((i % 2) == map_get(map, key, &value));
+  }
+  map_delete(map);
+}
+
+
 static void test_map_iterator_create() {
   map_t* map;
   assert(!map_create(&map));
@@ -149,7 +211,9 @@ static void test_map_iterator_next() {
 static void test_map_iterator_remove_current() {
   map_t* map;
   assert(!map_create(&map));
-  for (uint64_t i = 0; i < 10; i++) {
+  // Enough keys that buckets hold several, so elements are removed from
+  // the middle of chains.
+  for (uint64_t i = 0; i < 100; i++) {
     char key[2] = {(char)i + 1};
     assert(!map_insert(map, key, (generic_value_t)i));
   }
@@ -161,14 +225,14 @@ static void test_map_iterator_remove_current() {
     map_iterator_get_current(&iter, &key, &value);
     // Remove odd numbers.
     if (value.i64 % 2) {
-      (void)map_iterator_remove_current(&iter);
+      assert(value.i64 == map_iterator_remove_current(&iter).i64);
     } else {
       map_iterator_next(&iter);
     }
   }
-  assert(5 == map_size(map));
+  assert(50 == map_size(map));
   // Check for the even values.
-  for (uint64_t i = 0; i < 5; i++) {
+  for (uint64_t i = 0; i < 50; i++) {
     char key[2] = {(char)(i * 2) + 1};
     generic_value_t value;
     assert(map_get(map, key, &value));
@@ -187,17 +251,203 @@ static void test_map_iterator_empty_list() {
 }
 
 
+static void test_map_for_each() {
+  map_t* map;
+  assert(!map_create(&map));
+  const char* key;
+  generic_value_t value;
+  MAP_FOR_EACH(map, key, value) {
+    assert(false);
+  }
+
+  for (uint64_t i = 0; i < 100; i++) {
+    char name[2] = {(char)i + 1};
+    assert(!map_insert(map, name, (generic_value_t)i));
+  }
+
+  // Every value is seen once, and removing the current key is allowed.
+  bool seen[100] = {false};
+  MAP_FOR_EACH(map, key, value) {
+    assert(key[0] == value.i64 + 1);
+    assert(!seen[value.i64]);
+    seen[value.i64] = true;
+    if (value.i64 % 2) {
+      generic_value_t removed;
+      assert(map_remove(map, key, &removed));
+    }
+  }
+  for (int i = 0; i < 100; i++) {
+    assert(seen[i]);
+  }
+  assert(50 == map_size(map));
+
+  size_t count = 0;
+  MAP_FOR_EACH(map, key, value) {
+    assert(!(value.i64 % 2));
+    if (++count == 10) {
+      break;
+    }
+  }
+  assert(10 == count);
+  map_delete(map);
+}
+
+
+static void test_map_filter() {
+  map_t* map;
+  assert(!map_create(&map));
+  char key[32];
+  for (uint64_t i = 0; i < 100; i++) {
+    sprintf(key, "key:%lu", (unsigned long)i);
+    assert(!map_insert(map, key, (generic_value_t)i));
+  }
+  // Existing keys are added to the filter, which grows with the map.
+  assert(!map_enable_filter(map, 10));
+  assert(100 == map->filter->count);
+  for (uint64_t i = 100; i < 1000; i++) {
+    sprintf(key, "key:%lu", (unsigned long)i);
+    assert(!map_insert(map, key, (generic_value_t)i));
+  }
+  assert(map->filter->capacity >= 1000);
+  for (uint64_t i = 0; i < 1000; i++) {
+    generic_value_t value;
+    sprintf(key, "key:%lu", (unsigned long)i);
+    assert(map_get(map, key, &value));
+    assert(i == value.ui64);
+  }
+
+  // Absent keys are mostly rejected by the filter.
+  for (uint64_t i = 0; i < 1000; i++) {
+    generic_value_t value;
+    sprintf(key, "absent:%lu", (unsigned long)i);
+    assert(!map_get(map, key, &value));
+  }
+  assert(1000 == map->filter->negatives + map->filter->false_positives);
+  assert(bloom_filter_false_positive_rate(map->filter) < 0.05);
+
+  // Removed keys are still absent even if the filter lets them through.
+  generic_value_t value;
+  assert(map_remove(map, "key:5", &value));
+  assert(!map_get(map, "key:5", &value));
+  assert(!map_remove(map, "key:5", &value));
+  map_delete(map);
+}
+
+
+static void test_map_stats() {
+  map_t* map;
+  assert(!map_create(&map));
+  map_stats_t stats;
+  map_get_stats(map, &stats);
+  assert(!stats.size && !stats.max_chain_length);
+  assert(stats.empty_buckets == stats.capacity);
+  assert(stats.chain_length_histogram[0] == stats.capacity);
+  assert(0 == stats.mean_chain_length);
+
+  for (uint64_t i = 0; i < 100; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    assert(!map_insert(map, key, (generic_value_t)i));
+  }
+  map_get_stats(map, &stats);
+  assert(map->capacity == stats.capacity);
+  assert(100 == stats.size);
+  assert(100.0 / stats.capacity == stats.load_factor);
+  assert(stats.max_chain_length * stats.capacity >= 100);
+  size_t buckets = 0;
+  size_t short_chain_elements = 0;
+  for (size_t i = 0; i < MAP_STATS_HISTOGRAM_SIZE; i++) {
+    buckets += stats.chain_length_histogram[i];
+    if (i < MAP_STATS_HISTOGRAM_SIZE - 1) {
+      short_chain_elements += i * stats.chain_length_histogram[i];
+    }
+  }
+  assert(stats.capacity == buckets);
+  assert(short_chain_elements <= 100);
+  assert(stats.empty_buckets == stats.chain_length_histogram[0]);
+  assert(100.0 / (stats.capacity - stats.empty_buckets) ==
+	 stats.mean_chain_length);
+
+#ifdef MAP_PROBE_STATS
+  size_t lookups = stats.lookups;
+  size_t probes = stats.probes;
+  generic_value_t value;
+  assert(map_get(map, "key:7", &value));
+  map_get_stats(map, &stats);
+  assert(lookups + 1 == stats.lookups);
+  assert(probes < stats.probes);
+  assert(stats.key_comparisons >= 1);
+#endif
+  map_delete(map);
+}
+
+
+static void test_map_memory_usage() {
+  map_t* map;
+  assert(!map_create(&map));
+  map_memory_usage_t usage;
+  map_memory_usage(map, &usage);
+  size_t empty_metadata = usage.metadata;
+  assert(sizeof(map_t) <= empty_metadata);
+  assert(!usage.nodes && !usage.keys);
+
+  size_t key_bytes = 0;
+  for (int i = 0; i < 100; i++) {
+    char key[16];
+    sprintf(key, "key:%d", i);
+    assert(!map_insert(map, key, (generic_value_t)0.0));
+    key_bytes += strlen(key) + 1;
+  }
+  // Updating a value allocates nothing.
+  assert(!map_insert(map, "key:5", (generic_value_t)1.0));
+  map_memory_usage(map, &usage);
+  assert(key_bytes == usage.keys);
+  assert(100 * sizeof(map_element_t) == usage.nodes);
+  // Chains are linked through the elements, so only the fixed bucket array
+  // counts as metadata.
+  assert(usage.metadata == empty_metadata);
+  assert(usage.metadata + usage.nodes + usage.keys == usage.total);
+
+  generic_value_t value;
+  assert(map_remove(map, "key:42", &value));
+  map_memory_usage(map, &usage);
+  assert(key_bytes - strlen("key:42") - 1 == usage.keys);
+
+  size_t metadata = usage.metadata;
+  assert(!map_enable_filter(map, 100));
+  map_memory_usage(map, &usage);
+  size_t filter_bytes = usage.metadata - metadata;
+  assert(filter_bytes > sizeof(bloom_filter_t));
+
+  // Removing everything returns to the empty map plus the filter.
+  for (map_iterator_t iter = map_iterator_create(map);
+       map_iterator_has_current(&iter);) {
+    map_iterator_remove_current(&iter);
+  }
+  map_memory_usage(map, &usage);
+  assert(!usage.nodes && !usage.keys);
+  assert(empty_metadata + filter_bytes == usage.metadata);
+  map_delete(map);
+}
+
+
 int main(int argc, char** argv) {
   test_map_create();
   test_map_delete();
   test_map_insert();
+  test_map_insert_owned();
   test_map_get();
   test_map_remove();
+  test_map_remove_element();
   test_map_iterator_create();
   test_map_iterator_has_current();
   test_map_iterator_get_current();
   test_map_iterator_next();
   test_map_iterator_remove_current();
   test_map_iterator_empty_list();
+  test_map_for_each();
+  test_map_filter();
+  test_map_stats();
+  test_map_memory_usage();
   return 0;
 }
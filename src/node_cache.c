@@ -0,0 +1,204 @@
+#include "node_cache.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+
+// A free node. Every size class holds at least two pointers.
+typedef struct node_cache_node {
+  struct node_cache_node* next;
+  // In the first node of a batch in the global pool, the next batch.
+  struct node_cache_node* next_batch;
+} node_cache_node_t;
+
+typedef struct {
+  // Nodes ready to be allocated. count is at least their number and at
+  // most NODE_CACHE_BATCH; it overcounts batches flushed before they were
+  // full.
+  node_cache_node_t* loaded;
+  size_t count;
+  // A batch held back so that alternating frees and allocations at a
+  // batch boundary do not go to the pool every time.
+  node_cache_node_t* spare;
+} node_cache_class_t;
+
+typedef struct {
+  pthread_mutex_t mutex;
+  node_cache_node_t* batches[NODE_CACHE_CLASSES];
+  size_t counts[NODE_CACHE_CLASSES];
+} node_cache_pool_t;
+
+
+#ifndef NODE_CACHE_DISABLE
+
+static node_cache_pool_t pool = {PTHREAD_MUTEX_INITIALIZER, {0}, {0}};
+static pthread_once_t thread_exit_once = PTHREAD_ONCE_INIT;
+static pthread_key_t thread_exit_key;
+static bool thread_exit_key_created;
+
+static _Thread_local node_cache_class_t thread_cache[NODE_CACHE_CLASSES];
+static _Thread_local bool thread_registered;
+
+
+// Frees the nodes of a batch.
+static void node_cache_free_batch(node_cache_node_t* node) {
+  while (node) {
+    node_cache_node_t* next = node->next;
+    free(node);
+    node = next;
+  }
+}
+
+
+static void node_cache_pool_push(
+  size_t size_class, node_cache_node_t* batch) {
+  pthread_mutex_lock(&pool.mutex);
+  bool full = pool.counts[size_class] == NODE_CACHE_POOL_BATCHES;
+  if (!full) {
+    batch->next_batch = pool.batches[size_class];
+    pool.batches[size_class] = batch;
+    pool.counts[size_class]++;
+  }
+  pthread_mutex_unlock(&pool.mutex);
+  if (full) {
+    node_cache_free_batch(batch);
+  }
+}
+
+
+static node_cache_node_t* node_cache_pool_pop(size_t size_class) {
+  pthread_mutex_lock(&pool.mutex);
+  node_cache_node_t* batch = pool.batches[size_class];
+  if (batch) {
+    pool.batches[size_class] = batch->next_batch;
+    pool.counts[size_class]--;
+  }
+  pthread_mutex_unlock(&pool.mutex);
+  return batch;
+}
+
+
+static void node_cache_thread_exit(void* arg) {
+  node_cache_flush();
+  // Nodes freed by later destructors register the thread again, which
+  // makes this run once more.
+  thread_registered = false;
+}
+
+
+static void node_cache_create_thread_exit_key(void) {
+  thread_exit_key_created =
+    !pthread_key_create(&thread_exit_key, node_cache_thread_exit);
+}
+
+
+// Arranges for the calling thread's cache to be flushed when it exits.
+// Returns false if that is not possible, in which case the thread must
+// not cache nodes.
+static bool node_cache_register_thread(void) {
+  pthread_once(&thread_exit_once, node_cache_create_thread_exit_key);
+  // The destructor only runs for threads with a non-null value.
+  thread_registered = thread_exit_key_created &&
+    !pthread_setspecific(thread_exit_key, thread_cache);
+  return thread_registered;
+}
+
+#endif
+
+
+void* node_cache_alloc(size_t size) {
+#ifndef NODE_CACHE_DISABLE
+  if (size && size <= NODE_CACHE_MAX_SIZE) {
+    size_t size_class = (size - 1) / NODE_CACHE_GRANULE;
+    node_cache_class_t* cache = &thread_cache[size_class];
+    if (!cache->loaded) {
+      if (cache->spare) {
+	cache->loaded = cache->spare;
+	cache->spare = 0;
+      } else if (thread_registered || node_cache_register_thread()) {
+	// Registered first, so the rest of the batch goes back to the pool
+	// if the thread exits without freeing anything.
+	cache->loaded = node_cache_pool_pop(size_class);
+      }
+      cache->count = cache->loaded ? NODE_CACHE_BATCH : 0;
+    }
+    node_cache_node_t* node = cache->loaded;
+    if (node) {
+      cache->loaded = node->next;
+      cache->count--;
+      return node;
+    }
+    // Round up so the node can be reused for any size in its class.
+    size = (size_class + 1) * NODE_CACHE_GRANULE;
+  }
+#endif
+  return malloc(size);
+}
+
+
+void node_cache_free(void* node, size_t size) {
+  if (!node) {
+    return;
+  }
+#ifndef NODE_CACHE_DISABLE
+  if (size && size <= NODE_CACHE_MAX_SIZE &&
+      (thread_registered || node_cache_register_thread())) {
+    size_t size_class = (size - 1) / NODE_CACHE_GRANULE;
+    node_cache_class_t* cache = &thread_cache[size_class];
+    if (cache->count == NODE_CACHE_BATCH) {
+      if (cache->spare) {
+	node_cache_pool_push(size_class, cache->spare);
+      }
+      cache->spare = cache->loaded;
+      cache->loaded = 0;
+      cache->count = 0;
+    }
+    node_cache_node_t* tmp = node;
+    tmp->next = cache->loaded;
+    cache->loaded = tmp;
+    cache->count++;
+    return;
+  }
+#endif
+  free(node);
+}
+
+
+void node_cache_flush(void) {
+#ifndef NODE_CACHE_DISABLE
+  for (size_t i = 0; i < NODE_CACHE_CLASSES; i++) {
+    node_cache_class_t* cache = &thread_cache[i];
+    if (cache->loaded) {
+      node_cache_pool_push(i, cache->loaded);
+    }
+    if (cache->spare) {
+      node_cache_pool_push(i, cache->spare);
+    }
+    cache->loaded = cache->spare = 0;
+    cache->count = 0;
+  }
+#endif
+}
+
+
+void node_cache_trim(void) {
+#ifndef NODE_CACHE_DISABLE
+  node_cache_node_t* batches[NODE_CACHE_CLASSES];
+  pthread_mutex_lock(&pool.mutex);
+  for (size_t i = 0; i < NODE_CACHE_CLASSES; i++) {
+    batches[i] = pool.batches[i];
+    pool.batches[i] = 0;
+    pool.counts[i] = 0;
+  }
+  pthread_mutex_unlock(&pool.mutex);
+
+  for (size_t i = 0; i < NODE_CACHE_CLASSES; i++) {
+    while (batches[i]) {
+      node_cache_node_t* batch = batches[i];
+      batches[i] = batch->next_batch;
+      node_cache_free_batch(batch);
+    }
+  }
+#endif
+}
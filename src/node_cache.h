@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stddef.h>
+
+
+// Nodes are cached in size classes of this many bytes, up to
+// NODE_CACHE_MAX_SIZE; larger requests go straight to malloc.
+#define NODE_CACHE_GRANULE 16
+#define NODE_CACHE_CLASSES 4
+#define NODE_CACHE_MAX_SIZE (NODE_CACHE_GRANULE * NODE_CACHE_CLASSES)
+// Nodes moved between a thread's cache and the global pool at a time.
+#define NODE_CACHE_BATCH 64
+// Batches the global pool keeps per size class. Batches returned to a full
+// pool are freed.
+#define NODE_CACHE_POOL_BATCHES 64
+
+
+/**
+ * Allocates a small fixed-size node, such as a list or map element.
+ *
+ * Each thread keeps its freed nodes in per-size-class caches and reuses
+ * them without locking. Full batches of NODE_CACHE_BATCH nodes are moved
+ * to and from a global pool under a mutex, so threads that free more
+ * than they allocate pass memory to threads that allocate more than they
+ * free. A thread's cache is returned to the pool when it exits.
+ *
+ * Cached memory is not returned to the system on its own: each thread
+ * keeps up to two batches per size class, and the pool up to
+ * NODE_CACHE_POOL_BATCHES, until node_cache_trim is called.
+ *
+ * When built with NODE_CACHE_DISABLE defined, nodes are allocated and
+ * freed with malloc and free, so memory checkers can see every use. The
+ * tests are built this way.
+ *
+ * Args:
+ *  size: Size of the node in bytes.
+ *
+ * Returns:
+ *  Uninitialized memory for the node, or null if out of memory.
+ */
+void* node_cache_alloc(size_t size);
+
+
+/**
+ * Frees a node allocated by node_cache_alloc.
+ *
+ * The node may be freed by any thread.
+ *
+ * Args:
+ *  node: Node to free, or null.
+ *  size: Size passed to node_cache_alloc for the node.
+ */
+void node_cache_free(void* node, size_t size);
+
+
+/**
+ * Returns the nodes cached by the calling thread to the global pool.
+ */
+void node_cache_flush(void);
+
+
+/**
+ * Frees the nodes in the global pool.
+ *
+ * Nodes cached by threads are kept; call node_cache_flush first to
+ * release those too.
+ */
+void node_cache_trim(void);
@@ -0,0 +1,121 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "list.h"
+#include "map.h"
+#include "node_cache.h"
+
+
+// Build with BENCH_CFLAGS+=-DNODE_CACHE_DISABLE to compare list and map
+// churn against malloc and free. Threads only contend for the allocator
+// when they run at once, so runs with more threads than the online CPUs
+// reported first measure time slicing, not contention.
+#define BENCH_ROUNDS 20000
+#define BENCH_NODES 64
+#define BENCH_MAP_KEYS 16
+#define BENCH_MAX_THREADS 8
+
+
+static char bench_keys[BENCH_MAP_KEYS][16];
+
+
+// Allocates and frees batches of nodes, directly or through the cache.
+static void* bench_alloc_worker(void* arg) {
+  bool cached = arg;
+  void* nodes[BENCH_NODES];
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    for (int j = 0; j < BENCH_NODES; j++) {
+      nodes[j] = cached ? node_cache_alloc(32) : malloc(32);
+      if (!nodes[j]) {
+	abort();
+      }
+      *(int*)nodes[j] = j;
+    }
+    for (int j = 0; j < BENCH_NODES; j++) {
+      if (cached) {
+	node_cache_free(nodes[j], 32);
+      } else {
+	free(nodes[j]);
+      }
+    }
+  }
+  return 0;
+}
+
+
+// Creates, fills and deletes short-lived lists and maps.
+static void* bench_churn_worker(void* arg) {
+  uint64_t sum = 0;
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    list_t* list;
+    if (list_create(&list)) {
+      abort();
+    }
+    for (int j = 0; j < BENCH_NODES; j++) {
+      if (list_push_back(list, (generic_value_t)(uint64_t)j)) {
+	abort();
+      }
+    }
+    sum += list_size(list);
+    list_delete(list);
+
+    map_t* map;
+    if (map_create(&map)) {
+      abort();
+    }
+    for (int j = 0; j < BENCH_MAP_KEYS; j++) {
+      if (map_insert(map, bench_keys[j], (generic_value_t)(uint64_t)j)) {
+	abort();
+      }
+    }
+    sum += map_size(map);
+    map_delete(map);
+  }
+  bench_use(sum);
+  return 0;
+}
+
+
+static void bench_threads(
+  const char* name, void* (*worker)(void*), void* arg, int threads,
+  size_t ops_per_thread) {
+  pthread_t workers[BENCH_MAX_THREADS];
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < threads; i++) {
+    if (pthread_create(&workers[i], 0, worker, arg)) {
+      abort();
+    }
+  }
+  for (int i = 0; i < threads; i++) {
+    pthread_join(workers[i], 0);
+  }
+  uint64_t elapsed = bench_now_ns() - start;
+
+  char label[64];
+  snprintf(label, sizeof(label), "%s_%dthreads", name, threads);
+  bench_report(label, ops_per_thread * threads, elapsed);
+}
+
+
+int main(int argc, char** argv) {
+  for (int i = 0; i < BENCH_MAP_KEYS; i++) {
+    snprintf(bench_keys[i], sizeof(bench_keys[i]), "key:%d", i);
+  }
+  bench_report_value("online_cpus", sysconf(_SC_NPROCESSORS_ONLN), "cpus");
+  int thread_counts[] = {1, 2, 4, 8};
+  for (size_t i = 0; i < sizeof(thread_counts) / sizeof(int); i++) {
+    size_t nodes = (size_t)BENCH_ROUNDS * BENCH_NODES;
+    bench_threads("malloc_free", bench_alloc_worker, (void*)0,
+		  thread_counts[i], nodes);
+    bench_threads("node_cache_alloc_free", bench_alloc_worker, (void*)1,
+		  thread_counts[i], nodes);
+    // Each round is one list and one map.
+    bench_threads("list_map_churn", bench_churn_worker, 0, thread_counts[i],
+		  BENCH_ROUNDS);
+  }
+  node_cache_trim();
+  return 0;
+}
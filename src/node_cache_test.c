@@ -0,0 +1,175 @@
+#include "node_cache.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+
+#define TEST_NODES (NODE_CACHE_BATCH * 4)
+// More nodes than the global pool keeps in one size class.
+#define TEST_POOL_NODES (NODE_CACHE_BATCH * (NODE_CACHE_POOL_BATCHES + 2))
+
+
+static void* freed_by_thread[TEST_NODES];
+static void* pool_nodes[TEST_POOL_NODES];
+
+
+static void test_node_cache_reuse() {
+  // Nodes freed by a thread are handed out again in the same size class.
+  void* node = node_cache_alloc(24);
+  assert(node);
+  memset(node, 0xab, 24);
+  node_cache_free(node, 24);
+#ifndef NODE_CACHE_DISABLE
+  assert(node == node_cache_alloc(32));
+  void* other = node_cache_alloc(17);
+  assert(other != node);
+  node_cache_free(node, 32);
+  node_cache_free(other, 17);
+
+  // Nodes in other size classes are not reused.
+  void* small = node_cache_alloc(16);
+  assert(small != node && small != other);
+  node_cache_free(small, 16);
+#endif
+
+  // Large nodes and null bypass the cache.
+  void* large = node_cache_alloc(NODE_CACHE_MAX_SIZE + 1);
+  assert(large);
+  memset(large, 0, NODE_CACHE_MAX_SIZE + 1);
+  node_cache_free(large, NODE_CACHE_MAX_SIZE + 1);
+  node_cache_free(0, 16);
+  node_cache_flush();
+  node_cache_trim();
+}
+
+
+static void test_node_cache_many() {
+  // Enough nodes to move batches to and from the global pool.
+  void* nodes[TEST_NODES];
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < TEST_NODES; i++) {
+      assert((nodes[i] = node_cache_alloc(48)));
+      memset(nodes[i], i, 48);
+    }
+    for (int i = 0; i < TEST_NODES; i++) {
+      for (int j = 0; j < 48; j++) {
+	assert((uint8_t)i == ((uint8_t*)nodes[i])[j]);
+      }
+    }
+    for (int i = 0; i < TEST_NODES; i++) {
+      node_cache_free(nodes[i], 48);
+    }
+  }
+  node_cache_flush();
+  node_cache_trim();
+}
+
+
+static void test_node_cache_pool_cap() {
+  // Batches beyond what the pool keeps are freed, and the nodes still
+  // cached stay intact.
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < TEST_POOL_NODES; i++) {
+      assert((pool_nodes[i] = node_cache_alloc(64)));
+      memset(pool_nodes[i], i, 64);
+    }
+    for (int i = 0; i < TEST_POOL_NODES; i++) {
+      assert((uint8_t)i == ((uint8_t*)pool_nodes[i])[63]);
+      node_cache_free(pool_nodes[i], 64);
+    }
+    node_cache_flush();
+  }
+  node_cache_trim();
+}
+
+
+static void* free_nodes(void* arg) {
+  for (int i = 0; i < TEST_NODES; i++) {
+    assert((freed_by_thread[i] = node_cache_alloc(16)));
+  }
+  for (int i = 0; i < TEST_NODES; i++) {
+    node_cache_free(freed_by_thread[i], 16);
+  }
+  return 0;
+}
+
+
+static void test_node_cache_thread_exit() {
+  node_cache_flush();
+  node_cache_trim();
+  pthread_t thread;
+  assert(!pthread_create(&thread, 0, free_nodes, 0));
+  assert(!pthread_join(thread, 0));
+
+  // The exiting thread returned its nodes to the pool, where this thread
+  // finds them.
+#ifndef NODE_CACHE_DISABLE
+  void* nodes[TEST_NODES];
+  size_t reused = 0;
+  for (int i = 0; i < TEST_NODES; i++) {
+    assert((nodes[i] = node_cache_alloc(16)));
+    for (int j = 0; j < TEST_NODES; j++) {
+      reused += nodes[i] == freed_by_thread[j];
+    }
+  }
+  assert(TEST_NODES == reused);
+  for (int i = 0; i < TEST_NODES; i++) {
+    node_cache_free(nodes[i], 16);
+  }
+#endif
+  node_cache_flush();
+  node_cache_trim();
+}
+
+
+static void* allocate_node(void* arg) {
+  return node_cache_alloc(16);
+}
+
+
+static void test_node_cache_allocating_thread_exit() {
+  node_cache_flush();
+  node_cache_trim();
+  // A thread that only frees fills the pool, and one that only allocates
+  // takes a batch from it and hands its node back.
+  pthread_t thread;
+  assert(!pthread_create(&thread, 0, free_nodes, 0));
+  assert(!pthread_join(thread, 0));
+  void* node;
+  assert(!pthread_create(&thread, 0, allocate_node, 0));
+  assert(!pthread_join(thread, &node));
+  assert(node);
+  node_cache_free(node, 16);
+  node_cache_flush();
+
+#ifndef NODE_CACHE_DISABLE
+  // The rest of the allocating thread's batch went back to the pool.
+  void* nodes[TEST_NODES];
+  size_t reused = 0;
+  for (int i = 0; i < TEST_NODES; i++) {
+    assert((nodes[i] = node_cache_alloc(16)));
+    for (int j = 0; j < TEST_NODES; j++) {
+      reused += nodes[i] == freed_by_thread[j];
+    }
+  }
+  assert(TEST_NODES == reused);
+  for (int i = 0; i < TEST_NODES; i++) {
+    node_cache_free(nodes[i], 16);
+  }
+#endif
+  node_cache_flush();
+  node_cache_trim();
+}
+
+
+int main(int argc, char** argv) {
+  test_node_cache_reuse();
+  test_node_cache_many();
+  test_node_cache_pool_cap();
+  test_node_cache_thread_exit();
+  test_node_cache_allocating_thread_exit();
+  return 0;
+}
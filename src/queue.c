@@ -0,0 +1,184 @@
+#include "queue.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+static size_t queue_round_capacity(size_t capacity) {
+  size_t result = 2;
+  while (result < capacity) {
+    result *= 2;
+  }
+  return result;
+}
+
+
+error_t mpmc_queue_create(mpmc_queue_t** queue, size_t capacity) {
+  if (!capacity) {
+    return ERROR_INVALID_ARGS;
+  }
+  capacity = queue_round_capacity(capacity);
+  mpmc_queue_t* tmp =
+    aligned_alloc(QUEUE_CACHE_LINE_SIZE, sizeof(mpmc_queue_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  // Round the cell array up to whole cache lines so neighboring
+  // allocations cannot share its lines.
+  size_t size = capacity * sizeof(mpmc_queue_cell_t);
+  size = (size + QUEUE_CACHE_LINE_SIZE - 1) /
+    QUEUE_CACHE_LINE_SIZE * QUEUE_CACHE_LINE_SIZE;
+  tmp->cells = aligned_alloc(QUEUE_CACHE_LINE_SIZE, size);
+  if (!tmp->cells) {
+    free(tmp);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->mask = capacity - 1;
+  // A cell is ready for the producer at position p when its sequence is p,
+  // and ready for the consumer when its sequence is p + 1.
+  for (size_t i = 0; i < capacity; i++) {
+    atomic_init(&tmp->cells[i].sequence, i);
+  }
+  atomic_init(&tmp->enqueue_position, 0);
+  atomic_init(&tmp->dequeue_position, 0);
+  *queue = tmp;
+  return 0;
+}
+
+
+void mpmc_queue_delete(mpmc_queue_t* queue) {
+  if (!queue) {
+    return;
+  }
+  free(queue->cells);
+  free(queue);
+}
+
+
+bool mpmc_queue_try_push(mpmc_queue_t* queue, generic_value_t value) {
+  mpmc_queue_cell_t* cell;
+  size_t position =
+    atomic_load_explicit(&queue->enqueue_position, memory_order_relaxed);
+  for (;;) {
+    cell = &queue->cells[position & queue->mask];
+    size_t sequence =
+      atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+    if (!difference) {
+      // The cell is free; try to claim it.
+      if (atomic_compare_exchange_weak_explicit(
+	    &queue->enqueue_position, &position, position + 1,
+	    memory_order_relaxed, memory_order_relaxed)) {
+	break;
+      }
+    } else if (difference < 0) {
+      // The cell still holds a value from the previous lap: full.
+      return false;
+    } else {
+      // Another producer claimed the cell; catch up.
+      position =
+	atomic_load_explicit(&queue->enqueue_position, memory_order_relaxed);
+    }
+  }
+  cell->value = value;
+  atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+  return true;
+}
+
+
+bool mpmc_queue_try_pop(mpmc_queue_t* queue, generic_value_t* value) {
+  mpmc_queue_cell_t* cell;
+  size_t position =
+    atomic_load_explicit(&queue->dequeue_position, memory_order_relaxed);
+  for (;;) {
+    cell = &queue->cells[position & queue->mask];
+    size_t sequence =
+      atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+    if (!difference) {
+      // The cell holds a value; try to claim it.
+      if (atomic_compare_exchange_weak_explicit(
+	    &queue->dequeue_position, &position, position + 1,
+	    memory_order_relaxed, memory_order_relaxed)) {
+	break;
+      }
+    } else if (difference < 0) {
+      // The cell has not been written yet: empty.
+      return false;
+    } else {
+      // Another consumer claimed the cell; catch up.
+      position =
+	atomic_load_explicit(&queue->dequeue_position, memory_order_relaxed);
+    }
+  }
+  *value = cell->value;
+  // Make the cell ready for the producer on the next lap.
+  atomic_store_explicit(
+    &cell->sequence, position + queue->mask + 1, memory_order_release);
+  return true;
+}
+
+
+error_t spsc_queue_create(spsc_queue_t** queue, size_t capacity) {
+  if (!capacity) {
+    return ERROR_INVALID_ARGS;
+  }
+  capacity = queue_round_capacity(capacity);
+  spsc_queue_t* tmp =
+    aligned_alloc(QUEUE_CACHE_LINE_SIZE, sizeof(spsc_queue_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->values = malloc(capacity * sizeof(generic_value_t));
+  if (!tmp->values) {
+    free(tmp);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->mask = capacity - 1;
+  atomic_init(&tmp->head, 0);
+  atomic_init(&tmp->tail, 0);
+  tmp->cached_head = tmp->cached_tail = 0;
+  *queue = tmp;
+  return 0;
+}
+
+
+void spsc_queue_delete(spsc_queue_t* queue) {
+  if (!queue) {
+    return;
+  }
+  free(queue->values);
+  free(queue);
+}
+
+
+bool spsc_queue_try_push(spsc_queue_t* queue, generic_value_t value) {
+  size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  if (tail - queue->cached_head > queue->mask) {
+    // Looks full; refresh our view of the consumer's position.
+    queue->cached_head =
+      atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (tail - queue->cached_head > queue->mask) {
+      return false;
+    }
+  }
+  queue->values[tail & queue->mask] = value;
+  atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+
+bool spsc_queue_try_pop(spsc_queue_t* queue, generic_value_t* value) {
+  size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+  if (head == queue->cached_tail) {
+    // Looks empty; refresh our view of the producer's position.
+    queue->cached_tail =
+      atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head == queue->cached_tail) {
+      return false;
+    }
+  }
+  *value = queue->values[head & queue->mask];
+  atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+  return true;
+}
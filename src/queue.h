@@ -0,0 +1,161 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "errors.h"
+#include "generic.h"
+
+
+// Size used to pad fields written by different threads onto separate
+// cache lines.
+#define QUEUE_CACHE_LINE_SIZE 64
+
+typedef struct {
+  atomic_size_t sequence;
+  generic_value_t value;
+} mpmc_queue_cell_t;
+
+typedef struct {
+  size_t mask;
+  mpmc_queue_cell_t* cells;
+  _Alignas(QUEUE_CACHE_LINE_SIZE) atomic_size_t enqueue_position;
+  _Alignas(QUEUE_CACHE_LINE_SIZE) atomic_size_t dequeue_position;
+} mpmc_queue_t;
+
+typedef struct {
+  size_t mask;
+  generic_value_t* values;
+  // Written by the consumer.
+  _Alignas(QUEUE_CACHE_LINE_SIZE) atomic_size_t head;
+  size_t cached_tail;
+  // Written by the producer.
+  _Alignas(QUEUE_CACHE_LINE_SIZE) atomic_size_t tail;
+  size_t cached_head;
+} spsc_queue_t;
+
+
+/**
+ * Creates a new bounded multi-producer/multi-consumer queue.
+ *
+ * The queue is lock-free: each cell of a ring buffer carries a sequence
+ * number that tells producers and consumers whether it is ready for them,
+ * so threads only contend on a compare-and-swap of the enqueue or dequeue
+ * position. No memory is allocated after creation.
+ *
+ * Args:
+ *  queue: Set to the newly allocated queue.
+ *  capacity: Minimum number of values the queue can hold. Rounded up to
+ *   a power of two.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_INVALID_ARGS: capacity is 0.
+ *  ERROR_OUT_OF_MEMORY: Could not create queue because of memory error.
+ */
+error_t mpmc_queue_create(mpmc_queue_t** queue, size_t capacity);
+
+
+/**
+ * Deletes a multi-producer/multi-consumer queue.
+ *
+ * No other thread may be using the queue. Values still in the queue are
+ * not deallocated.
+ *
+ * Args:
+ *  queue: Queue to be deleted.
+ */
+void mpmc_queue_delete(mpmc_queue_t* queue);
+
+
+/**
+ * Adds a value to the queue, if there is room.
+ *
+ * Safe to call from any number of threads.
+ *
+ * Args:
+ *  queue: Queue to add value to.
+ *  value: Value to add.
+ *
+ * Returns:
+ *  true if the value was added, false if the queue was full.
+ */
+bool mpmc_queue_try_push(mpmc_queue_t* queue, generic_value_t value);
+
+
+/**
+ * Removes the oldest value from the queue, if there is one.
+ *
+ * Safe to call from any number of threads.
+ *
+ * Args:
+ *  queue: Queue to remove value from.
+ *  value: Set to the removed value.
+ *
+ * Returns:
+ *  true if a value was removed, false if the queue was empty.
+ */
+bool mpmc_queue_try_pop(mpmc_queue_t* queue, generic_value_t* value);
+
+
+/**
+ * Creates a new bounded single-producer/single-consumer queue.
+ *
+ * A faster alternative to mpmc_queue_t when exactly one thread pushes and
+ * exactly one thread pops: no compare-and-swap is needed, and each side
+ * caches the other's position so it rarely touches the other's cache line.
+ *
+ * Args:
+ *  queue: Set to the newly allocated queue.
+ *  capacity: Minimum number of values the queue can hold. Rounded up to
+ *   a power of two.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_INVALID_ARGS: capacity is 0.
+ *  ERROR_OUT_OF_MEMORY: Could not create queue because of memory error.
+ */
+error_t spsc_queue_create(spsc_queue_t** queue, size_t capacity);
+
+
+/**
+ * Deletes a single-producer/single-consumer queue.
+ *
+ * No other thread may be using the queue. Values still in the queue are
+ * not deallocated.
+ *
+ * Args:
+ *  queue: Queue to be deleted.
+ */
+void spsc_queue_delete(spsc_queue_t* queue);
+
+
+/**
+ * Adds a value to the queue, if there is room.
+ *
+ * Must only be called from the producer thread.
+ *
+ * Args:
+ *  queue: Queue to add value to.
+ *  value: Value to add.
+ *
+ * Returns:
+ *  true if the value was added, false if the queue was full.
+ */
+bool spsc_queue_try_push(spsc_queue_t* queue, generic_value_t value);
+
+
+/**
+ * Removes the oldest value from the queue, if there is one.
+ *
+ * Must only be called from the consumer thread.
+ *
+ * Args:
+ *  queue: Queue to remove value from.
+ *  value: Set to the removed value.
+ *
+ * Returns:
+ *  true if a value was removed, false if the queue was empty.
+ */
+bool spsc_queue_try_pop(spsc_queue_t* queue, generic_value_t* value);
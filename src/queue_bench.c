@@ -0,0 +1,246 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "list.h"
+#include "queue.h"
+
+
+#define BENCH_ITEMS 1000000
+#define BENCH_ROUND_TRIPS 100000
+#define BENCH_QUEUE_CAPACITY 1024
+#define BENCH_MAX_THREADS 8
+
+
+// The mutex-guarded list these queues replace.
+typedef struct {
+  pthread_mutex_t mutex;
+  list_t* list;
+} locked_list_t;
+
+typedef enum {
+  BENCH_LOCKED_LIST,
+  BENCH_MPMC,
+  BENCH_SPSC
+} bench_queue_kind_t;
+
+typedef struct {
+  bench_queue_kind_t kind;
+  void* queue;
+  size_t items;
+} bench_thread_args_t;
+
+
+static bool bench_try_push(
+  bench_queue_kind_t kind, void* queue, generic_value_t value) {
+  switch (kind) {
+  case BENCH_LOCKED_LIST: {
+    locked_list_t* locked = queue;
+    pthread_mutex_lock(&locked->mutex);
+    error_t error = list_push_back(locked->list, value);
+    pthread_mutex_unlock(&locked->mutex);
+    if (error) {
+      abort();
+    }
+    return true;
+  }
+  case BENCH_MPMC:
+    return mpmc_queue_try_push(queue, value);
+  case BENCH_SPSC:
+    return spsc_queue_try_push(queue, value);
+  }
+  return false;
+}
+
+
+static bool bench_try_pop(
+  bench_queue_kind_t kind, void* queue, generic_value_t* value) {
+  switch (kind) {
+  case BENCH_LOCKED_LIST: {
+    locked_list_t* locked = queue;
+    pthread_mutex_lock(&locked->mutex);
+    bool found = !list_empty(locked->list);
+    if (found) {
+      *value = list_pop_front(locked->list);
+    }
+    pthread_mutex_unlock(&locked->mutex);
+    return found;
+  }
+  case BENCH_MPMC:
+    return mpmc_queue_try_pop(queue, value);
+  case BENCH_SPSC:
+    return spsc_queue_try_pop(queue, value);
+  }
+  return false;
+}
+
+
+static void* bench_producer(void* arg) {
+  bench_thread_args_t* args = arg;
+  for (uint64_t i = 0; i < args->items; i++) {
+    while (!bench_try_push(args->kind, args->queue, (generic_value_t)i)) {
+      sched_yield();
+    }
+  }
+  return 0;
+}
+
+
+static void* bench_consumer(void* arg) {
+  bench_thread_args_t* args = arg;
+  uint64_t sum = 0;
+  for (uint64_t i = 0; i < args->items; i++) {
+    generic_value_t value;
+    while (!bench_try_pop(args->kind, args->queue, &value)) {
+      sched_yield();
+    }
+    sum += value.ui64;
+  }
+  bench_use(sum);
+  return 0;
+}
+
+
+static void bench_throughput(
+  const char* name, bench_queue_kind_t kind, void* queue, int threads) {
+  pthread_t producers[BENCH_MAX_THREADS];
+  pthread_t consumers[BENCH_MAX_THREADS];
+  bench_thread_args_t args = {kind, queue, BENCH_ITEMS / threads};
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < threads; i++) {
+    if (pthread_create(&producers[i], 0, bench_producer, &args) ||
+	pthread_create(&consumers[i], 0, bench_consumer, &args)) {
+      abort();
+    }
+  }
+  for (int i = 0; i < threads; i++) {
+    pthread_join(producers[i], 0);
+    pthread_join(consumers[i], 0);
+  }
+  uint64_t elapsed = bench_now_ns() - start;
+
+  char label[64];
+  snprintf(label, sizeof(label), "%s_%dp%dc", name, threads, threads);
+  bench_report(label, args.items * threads, elapsed);
+}
+
+
+typedef struct {
+  bench_queue_kind_t kind;
+  void* requests;
+  void* responses;
+} bench_echo_args_t;
+
+
+static void* bench_echo(void* arg) {
+  bench_echo_args_t* args = arg;
+  for (int i = 0; i < BENCH_ROUND_TRIPS; i++) {
+    generic_value_t value;
+    while (!bench_try_pop(args->kind, args->requests, &value)) {
+      sched_yield();
+    }
+    while (!bench_try_push(args->kind, args->responses, value)) {
+      sched_yield();
+    }
+  }
+  return 0;
+}
+
+
+static void bench_latency(
+  const char* name, bench_queue_kind_t kind, void* requests,
+  void* responses) {
+  bench_echo_args_t args = {kind, requests, responses};
+  pthread_t echo;
+  if (pthread_create(&echo, 0, bench_echo, &args)) {
+    abort();
+  }
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_ROUND_TRIPS; i++) {
+    generic_value_t value;
+    while (!bench_try_push(kind, requests, (generic_value_t)i)) {
+      sched_yield();
+    }
+    while (!bench_try_pop(kind, responses, &value)) {
+      sched_yield();
+    }
+  }
+  uint64_t elapsed = bench_now_ns() - start;
+  pthread_join(echo, 0);
+
+  char label[64];
+  snprintf(label, sizeof(label), "%s_round_trip", name);
+  bench_report(label, BENCH_ROUND_TRIPS, elapsed);
+}
+
+
+static locked_list_t* bench_locked_list_create() {
+  locked_list_t* locked = malloc(sizeof(locked_list_t));
+  if (!locked || list_create(&locked->list) ||
+      pthread_mutex_init(&locked->mutex, 0)) {
+    abort();
+  }
+  return locked;
+}
+
+
+static void bench_locked_list_delete(locked_list_t* locked) {
+  pthread_mutex_destroy(&locked->mutex);
+  list_delete(locked->list);
+  free(locked);
+}
+
+
+int main(int argc, char** argv) {
+  int thread_counts[] = {1, 2, 4};
+  for (size_t i = 0; i < sizeof(thread_counts) / sizeof(int); i++) {
+    locked_list_t* locked = bench_locked_list_create();
+    bench_throughput("locked_list", BENCH_LOCKED_LIST, locked,
+		     thread_counts[i]);
+    bench_locked_list_delete(locked);
+
+    mpmc_queue_t* mpmc;
+    if (mpmc_queue_create(&mpmc, BENCH_QUEUE_CAPACITY)) {
+      abort();
+    }
+    bench_throughput("mpmc_queue", BENCH_MPMC, mpmc, thread_counts[i]);
+    mpmc_queue_delete(mpmc);
+  }
+
+  spsc_queue_t* spsc;
+  if (spsc_queue_create(&spsc, BENCH_QUEUE_CAPACITY)) {
+    abort();
+  }
+  bench_throughput("spsc_queue", BENCH_SPSC, spsc, 1);
+  spsc_queue_delete(spsc);
+
+  locked_list_t* locked_requests = bench_locked_list_create();
+  locked_list_t* locked_responses = bench_locked_list_create();
+  bench_latency("locked_list", BENCH_LOCKED_LIST, locked_requests,
+		locked_responses);
+  bench_locked_list_delete(locked_requests);
+  bench_locked_list_delete(locked_responses);
+
+  mpmc_queue_t* mpmc_requests;
+  mpmc_queue_t* mpmc_responses;
+  if (mpmc_queue_create(&mpmc_requests, BENCH_QUEUE_CAPACITY) ||
+      mpmc_queue_create(&mpmc_responses, BENCH_QUEUE_CAPACITY)) {
+    abort();
+  }
+  bench_latency("mpmc_queue", BENCH_MPMC, mpmc_requests, mpmc_responses);
+  mpmc_queue_delete(mpmc_requests);
+  mpmc_queue_delete(mpmc_responses);
+
+  spsc_queue_t* spsc_requests;
+  spsc_queue_t* spsc_responses;
+  if (spsc_queue_create(&spsc_requests, BENCH_QUEUE_CAPACITY) ||
+      spsc_queue_create(&spsc_responses, BENCH_QUEUE_CAPACITY)) {
+    abort();
+  }
+  bench_latency("spsc_queue", BENCH_SPSC, spsc_requests, spsc_responses);
+  spsc_queue_delete(spsc_requests);
+  spsc_queue_delete(spsc_responses);
+  return 0;
+}
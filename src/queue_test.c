@@ -0,0 +1,177 @@
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#include "queue.h"
+
+
+#define TEST_THREADS 4
+#define TEST_VALUES_PER_THREAD 10000
+
+
+static void test_mpmc_queue_create() {
+  mpmc_queue_t* queue;
+  assert(ERROR_INVALID_ARGS == mpmc_queue_create(&queue, 0));
+  assert(!mpmc_queue_create(&queue, 5));
+  // Capacity is rounded up to a power of two.
+  assert(7 == queue->mask);
+  mpmc_queue_delete(queue);
+}
+
+
+static void test_mpmc_queue_push_pop() {
+  mpmc_queue_t* queue;
+  assert(!mpmc_queue_create(&queue, 8));
+  generic_value_t value;
+  assert(!mpmc_queue_try_pop(queue, &value));
+
+  // Fill and drain several times so the positions wrap around the ring.
+  for (int round = 0; round < 3; round++) {
+    for (uint64_t i = 0; i < 8; i++) {
+      assert(mpmc_queue_try_push(queue, (generic_value_t)i));
+    }
+    assert(!mpmc_queue_try_push(queue, (generic_value_t)(uint64_t)8));
+    for (uint64_t i = 0; i < 8; i++) {
+      assert(mpmc_queue_try_pop(queue, &value));
+      assert(i == value.i64);
+    }
+    assert(!mpmc_queue_try_pop(queue, &value));
+  }
+  mpmc_queue_delete(queue);
+}
+
+
+static void test_spsc_queue_create() {
+  spsc_queue_t* queue;
+  assert(ERROR_INVALID_ARGS == spsc_queue_create(&queue, 0));
+  assert(!spsc_queue_create(&queue, 5));
+  assert(7 == queue->mask);
+  spsc_queue_delete(queue);
+}
+
+
+static void test_spsc_queue_push_pop() {
+  spsc_queue_t* queue;
+  assert(!spsc_queue_create(&queue, 8));
+  generic_value_t value;
+  assert(!spsc_queue_try_pop(queue, &value));
+
+  for (int round = 0; round < 3; round++) {
+    for (uint64_t i = 0; i < 8; i++) {
+      assert(spsc_queue_try_push(queue, (generic_value_t)i));
+    }
+    assert(!spsc_queue_try_push(queue, (generic_value_t)(uint64_t)8));
+    for (uint64_t i = 0; i < 8; i++) {
+      assert(spsc_queue_try_pop(queue, &value));
+      assert(i == value.i64);
+    }
+    assert(!spsc_queue_try_pop(queue, &value));
+  }
+  spsc_queue_delete(queue);
+}
+
+
+typedef struct {
+  mpmc_queue_t* queue;
+  uint64_t first_value;
+  // Counts how often each value was popped, indexed by value.
+  _Atomic int* seen;
+} test_thread_args_t;
+
+
+static void* test_mpmc_producer(void* arg) {
+  test_thread_args_t* args = arg;
+  for (uint64_t i = 0; i < TEST_VALUES_PER_THREAD; i++) {
+    while (!mpmc_queue_try_push(
+	     args->queue, (generic_value_t)(args->first_value + i))) {
+      sched_yield();
+    }
+  }
+  return 0;
+}
+
+
+static void* test_mpmc_consumer(void* arg) {
+  test_thread_args_t* args = arg;
+  for (uint64_t i = 0; i < TEST_VALUES_PER_THREAD; i++) {
+    generic_value_t value;
+    while (!mpmc_queue_try_pop(args->queue, &value)) {
+      sched_yield();
+    }
+    args->seen[value.i64]++;
+  }
+  return 0;
+}
+
+
+static void test_mpmc_queue_threads() {
+  mpmc_queue_t* queue;
+  assert(!mpmc_queue_create(&queue, 64));
+  _Atomic int* seen = calloc(TEST_THREADS * TEST_VALUES_PER_THREAD,
+			     sizeof(_Atomic int));
+  assert(seen);
+
+  pthread_t producers[TEST_THREADS];
+  pthread_t consumers[TEST_THREADS];
+  test_thread_args_t args[TEST_THREADS];
+  for (int i = 0; i < TEST_THREADS; i++) {
+    args[i] = (test_thread_args_t){queue, i * TEST_VALUES_PER_THREAD, seen};
+    assert(!pthread_create(&producers[i], 0, test_mpmc_producer, &args[i]));
+    assert(!pthread_create(&consumers[i], 0, test_mpmc_consumer, &args[i]));
+  }
+  for (int i = 0; i < TEST_THREADS; i++) {
+    assert(!pthread_join(producers[i], 0));
+    assert(!pthread_join(consumers[i], 0));
+  }
+
+  // Every value was delivered exactly once.
+  for (int i = 0; i < TEST_THREADS * TEST_VALUES_PER_THREAD; i++) {
+    assert(1 == seen[i]);
+  }
+  generic_value_t value;
+  assert(!mpmc_queue_try_pop(queue, &value));
+  free(seen);
+  mpmc_queue_delete(queue);
+}
+
+
+static void* test_spsc_producer(void* arg) {
+  spsc_queue_t* queue = arg;
+  for (uint64_t i = 0; i < TEST_VALUES_PER_THREAD; i++) {
+    while (!spsc_queue_try_push(queue, (generic_value_t)i)) {
+      sched_yield();
+    }
+  }
+  return 0;
+}
+
+
+static void test_spsc_queue_threads() {
+  spsc_queue_t* queue;
+  assert(!spsc_queue_create(&queue, 64));
+  pthread_t producer;
+  assert(!pthread_create(&producer, 0, test_spsc_producer, queue));
+
+  // Values arrive in order.
+  for (uint64_t i = 0; i < TEST_VALUES_PER_THREAD; i++) {
+    generic_value_t value;
+    while (!spsc_queue_try_pop(queue, &value)) {
+      sched_yield();
+    }
+    assert(i == value.i64);
+  }
+  assert(!pthread_join(producer, 0));
+  spsc_queue_delete(queue);
+}
+
+
+int main(int argc, char** argv) {
+  test_mpmc_queue_create();
+  test_mpmc_queue_push_pop();
+  test_spsc_queue_create();
+  test_spsc_queue_push_pop();
+  test_mpmc_queue_threads();
+  test_spsc_queue_threads();
+  return 0;
+}
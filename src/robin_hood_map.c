@@ -0,0 +1,246 @@
+#include "robin_hood_map.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+#include "string_util.h"
+
+
+static const size_t INITIAL_CAPACITY = 16;
+// Slots are chosen by 32 bits of hash, so more are never used.
+static const size_t MAX_CAPACITY = (size_t)1 << 32;
+
+
+// Provide external definitions of inline functions.
+extern inline size_t robin_hood_map_size(const robin_hood_map_t* map);
+extern inline bool robin_hood_map_iterator_has_current(
+  robin_hood_map_iterator_t* iter);
+extern inline void robin_hood_map_iterator_get_current(
+  robin_hood_map_iterator_t* iter, const char** key, generic_value_t* value);
+
+
+error_t robin_hood_map_create(robin_hood_map_t** map) {
+  return robin_hood_map_create_with_value_deallocator(map, 0);
+}
+
+
+error_t robin_hood_map_create_with_value_deallocator(
+  robin_hood_map_t** map, void (*value_deallocator)(void*)) {
+  robin_hood_map_t* tmp = calloc(1, sizeof(robin_hood_map_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->value_deallocator = value_deallocator;
+  tmp->capacity = INITIAL_CAPACITY;
+  tmp->max_load_factor = ROBIN_HOOD_MAP_DEFAULT_MAX_LOAD_FACTOR;
+  tmp->slots = calloc(tmp->capacity, sizeof(robin_hood_map_slot_t));
+  if (!tmp->slots) {
+    free(tmp);
+    return ERROR_OUT_OF_MEMORY;
+  }
+  *map = tmp;
+  return 0;
+}
+
+
+void robin_hood_map_delete(robin_hood_map_t* map) {
+  if (!map) {
+    return;
+  }
+  for (size_t i = 0; i < map->capacity; i++) {
+    robin_hood_map_slot_t* slot = &map->slots[i];
+    if (!slot->probe_length) {
+      continue;
+    }
+    if (map->value_deallocator) {
+      map->value_deallocator(slot->value.p);
+    }
+    free(slot->key);
+  }
+  free(map->slots);
+  free(map);
+}
+
+
+// Places an entry known to be absent, taking the slot of the first entry
+// closer to its home slot and placing that entry further on in turn.
+static void robin_hood_map_place(
+  robin_hood_map_t* map, robin_hood_map_slot_t entry) {
+  size_t mask = map->capacity - 1;
+  size_t index = entry.hash & mask;
+  entry.probe_length = 1;
+  for (;; index = (index + 1) & mask, entry.probe_length++) {
+    robin_hood_map_slot_t* slot = &map->slots[index];
+    if (!slot->probe_length) {
+      *slot = entry;
+      return;
+    }
+    if (slot->probe_length < entry.probe_length) {
+      robin_hood_map_slot_t tmp = *slot;
+      *slot = entry;
+      entry = tmp;
+    }
+  }
+}
+
+
+// Moves the entries to a new array of slots.
+static error_t robin_hood_map_rehash(robin_hood_map_t* map, size_t capacity) {
+  robin_hood_map_slot_t* slots =
+    calloc(capacity, sizeof(robin_hood_map_slot_t));
+  if (!slots) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  robin_hood_map_slot_t* old_slots = map->slots;
+  size_t old_capacity = map->capacity;
+  map->slots = slots;
+  map->capacity = capacity;
+  for (size_t i = 0; i < old_capacity; i++) {
+    if (old_slots[i].probe_length) {
+      robin_hood_map_place(map, old_slots[i]);
+    }
+  }
+  free(old_slots);
+  return 0;
+}
+
+
+error_t robin_hood_map_reserve(robin_hood_map_t* map, size_t count) {
+  size_t capacity = map->capacity;
+  while (count > capacity * map->max_load_factor) {
+    if (capacity >= MAX_CAPACITY) {
+      return ERROR_OUT_OF_MEMORY;
+    }
+    capacity *= 2;
+  }
+  if (capacity == map->capacity) {
+    return 0;
+  }
+  return robin_hood_map_rehash(map, capacity);
+}
+
+
+error_t robin_hood_map_set_max_load_factor(
+  robin_hood_map_t* map, double max_load_factor) {
+  if (!(max_load_factor > 0 && max_load_factor < 1)) {
+    return ERROR_INVALID_ARGS;
+  }
+  map->max_load_factor = max_load_factor;
+  return robin_hood_map_reserve(map, map->size);
+}
+
+
+// Returns the slot holding key, or NULL if key is absent.
+static robin_hood_map_slot_t* robin_hood_map_find(
+  const robin_hood_map_t* map, const char* key, size_t key_length,
+  uint32_t hash) {
+  size_t mask = map->capacity - 1;
+  size_t index = hash & mask;
+  for (uint32_t probe_length = 1;;
+       index = (index + 1) & mask, probe_length++) {
+    robin_hood_map_slot_t* slot = &map->slots[index];
+    // Entries are ordered by distance from their home slots, so once they
+    // are closer than key would be, key is absent. Empty slots stop the
+    // search the same way.
+    if (slot->probe_length < probe_length) {
+      return 0;
+    }
+    if (slot->hash == hash &&
+	string_equal(slot->key, slot->key_length, key, key_length)) {
+      return slot;
+    }
+  }
+}
+
+
+error_t robin_hood_map_insert(
+  robin_hood_map_t* map, const char* key, generic_value_t value) {
+  uint32_t hash = (uint32_t)hash_string_mixed(key);
+  size_t key_length = string_length(key);
+  robin_hood_map_slot_t* slot =
+    robin_hood_map_find(map, key, key_length, hash);
+  if (slot) {
+    slot->value = value;
+    return 0;
+  }
+  if (robin_hood_map_reserve(map, map->size + 1)) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  robin_hood_map_slot_t entry = {0};
+  if (!(entry.key = malloc(key_length + 1))) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  memcpy(entry.key, key, key_length + 1);
+  entry.key_length = key_length;
+  entry.value = value;
+  entry.hash = hash;
+  robin_hood_map_place(map, entry);
+  map->size++;
+  return 0;
+}
+
+
+bool robin_hood_map_get(
+  const robin_hood_map_t* map, const char* key, generic_value_t* value) {
+  robin_hood_map_slot_t* slot = robin_hood_map_find(
+    map, key, string_length(key), (uint32_t)hash_string_mixed(key));
+  if (!slot) {
+    return false;
+  }
+  *value = slot->value;
+  return true;
+}
+
+
+bool robin_hood_map_remove(
+  robin_hood_map_t* map, const char* key, generic_value_t* value) {
+  robin_hood_map_slot_t* slot = robin_hood_map_find(
+    map, key, string_length(key), (uint32_t)hash_string_mixed(key));
+  if (!slot) {
+    return false;
+  }
+  *value = slot->value;
+  free(slot->key);
+  map->size--;
+
+  // Shift the following entries back a slot until one is empty or already
+  // in its home slot, leaving no tombstone behind.
+  size_t mask = map->capacity - 1;
+  size_t index = slot - map->slots;
+  for (;;) {
+    size_t next = (index + 1) & mask;
+    if (map->slots[next].probe_length <= 1) {
+      break;
+    }
+    map->slots[index] = map->slots[next];
+    map->slots[index].probe_length--;
+    index = next;
+  }
+  memset(&map->slots[index], 0, sizeof(robin_hood_map_slot_t));
+  return true;
+}
+
+
+// Moves the iterator to the first entry from its index on.
+static void robin_hood_map_iterator_find_entry(
+  robin_hood_map_iterator_t* iter) {
+  while (iter->index < iter->map->capacity &&
+	 !iter->map->slots[iter->index].probe_length) {
+    iter->index++;
+  }
+}
+
+
+robin_hood_map_iterator_t robin_hood_map_iterator_create(
+  robin_hood_map_t* map) {
+  robin_hood_map_iterator_t iter = {map, 0};
+  robin_hood_map_iterator_find_entry(&iter);
+  return iter;
+}
+
+
+void robin_hood_map_iterator_next(robin_hood_map_iterator_t* iter) {
+  iter->index++;
+  robin_hood_map_iterator_find_entry(iter);
+}
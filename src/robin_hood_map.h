@@ -0,0 +1,252 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "errors.h"
+#include "generic.h"
+
+
+// Largest allowed ratio of size to capacity when a map is created; see
+// robin_hood_map_set_max_load_factor.
+#define ROBIN_HOOD_MAP_DEFAULT_MAX_LOAD_FACTOR 0.875
+
+typedef struct {
+  char* key;
+  size_t key_length;
+  generic_value_t value;
+  // Low 32 bits of the key's hash. They choose the home slot, and keys
+  // whose bits differ are rejected without comparing them.
+  uint32_t hash;
+  // One more than the distance from the home slot, or 0 for an empty slot.
+  uint32_t probe_length;
+} robin_hood_map_slot_t;
+
+typedef struct {
+  void (*value_deallocator)(void*);
+  size_t size;
+  // Number of slots, a power of two.
+  size_t capacity;
+  double max_load_factor;
+  robin_hood_map_slot_t* slots;
+} robin_hood_map_t;
+
+typedef struct {
+  robin_hood_map_t* map;
+  size_t index;
+} robin_hood_map_iterator_t;
+
+
+/**
+ * Creates a new Robin Hood map.
+ *
+ * A Robin Hood map stores its entries in a single array of slots, probing
+ * linearly from each key's home slot. Inserting takes a slot from any
+ * entry closer to its own home slot than the new entry is, which keeps
+ * probe lengths short and nearly equal even at high load factors.
+ * Removing shifts the following entries back instead of leaving a
+ * tombstone, so mixed insert and remove workloads do not degrade lookups.
+ *
+ * Unlike map_t, the map grows as keys are inserted, so lookups take O(1)
+ * expected time at any size.
+ *
+ * Args:
+ *  map: Set to the newly allocated map.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create map because of memory error.
+ */
+error_t robin_hood_map_create(robin_hood_map_t** map);
+
+
+/**
+ * Creates a new Robin Hood map with a value deallocator.
+ *
+ * The deallocation function is used to delete void* values
+ * (generic_value_t.p) when robin_hood_map_delete is called.
+ *
+ * Args:
+ *  map: Set to the newly allocated map.
+ *  deallocated: Function used to delete values.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create map because of memory error.
+ */
+error_t robin_hood_map_create_with_value_deallocator(
+  robin_hood_map_t** map, void (*value_deallocator)(void*));
+
+
+/**
+ * Deletes a Robin Hood map.
+ *
+ * If a deallocation function was provided during creation, map values
+ * will be treated as void* (generic_value_t.p) and sent to the function.
+ *
+ * Args:
+ *  map: Map to be deleted.
+ */
+void robin_hood_map_delete(robin_hood_map_t* map);
+
+
+/**
+ * Sets the largest ratio of size to capacity before the map grows.
+ *
+ * Higher load factors use less memory at the cost of longer probes; the
+ * map grows immediately if it is already fuller than the new limit.
+ *
+ * Args:
+ *  map: Map to update.
+ *  max_load_factor: New limit, greater than 0 and less than 1.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_INVALID_ARGS: max_load_factor is out of range.
+ *  ERROR_OUT_OF_MEMORY: Could not grow map because of memory error.
+ */
+error_t robin_hood_map_set_max_load_factor(
+  robin_hood_map_t* map, double max_load_factor);
+
+
+/**
+ * Grows the map so it holds count keys without growing again.
+ *
+ * Args:
+ *  map: Map to update.
+ *  count: Number of keys to make room for.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not grow map because of memory error.
+ */
+error_t robin_hood_map_reserve(robin_hood_map_t* map, size_t count);
+
+
+/**
+ * Inserts a key and value into the map.
+ *
+ * If the key already exists in the map, the value is updated.
+ *
+ * Args:
+ *  map: Map to update.
+ *  key: Key for map entry.
+ *  value: Value for map entry.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not insert into map because of memory errors.
+ */
+error_t robin_hood_map_insert(
+  robin_hood_map_t* map, const char* key, generic_value_t value);
+
+
+/**
+ * Gets a value from the map.
+ *
+ * Args:
+ *  map: The map to examine.
+ *  key: The key to look up.
+ *  value: Set to any value found.
+ *
+ * Returns:
+ *  true if the value is found.
+ */
+bool robin_hood_map_get(
+  const robin_hood_map_t* map, const char* key, generic_value_t* value);
+
+
+/**
+ * Removes a key and value from the map.
+ *
+ * Args:
+ *  map: The map to examine.
+ *  key: The key to look up.
+ *  value: Set to any value found.
+ *
+ * Returns:
+ *  true if the value is found.
+ */
+bool robin_hood_map_remove(
+  robin_hood_map_t* map, const char* key, generic_value_t* value);
+
+
+/**
+ * Returns the size of the map.
+ *
+ * Args:
+ *  map: The map to examine.
+ *
+ * Returns:
+ *  Size of the map.
+ */
+inline size_t robin_hood_map_size(const robin_hood_map_t* map) {
+  return map->size;
+}
+
+
+/**
+ * Creates an iterator for a map.
+ *
+ * Entries are visited in slot order. Removing an entry moves others, so
+ * the map must not be modified while it is being iterated.
+ *
+ * Args:
+ *  map: Map to create iterator for.
+ *
+ * Returns:
+ *  Iterator for the given map.
+ */
+robin_hood_map_iterator_t robin_hood_map_iterator_create(
+  robin_hood_map_t* map);
+
+
+/**
+ * Returns true if the iterator has a current element.
+ *
+ * If this function returns true, it is safe to call
+ * robin_hood_map_iterator_get_current and robin_hood_map_iterator_next.
+ *
+ * Args:
+ *  iter: Iterator to examine
+ *
+ * Returns:
+ *  true if the iterator has a current element.
+ */
+inline bool robin_hood_map_iterator_has_current(
+  robin_hood_map_iterator_t* iter) {
+  return iter->index < iter->map->capacity;
+}
+
+
+/**
+ * Gets the current element for the iterator.
+ *
+ * This call should be proceeded by a successful call to
+ * robin_hood_map_iterator_has_current.
+ *
+ * Args:
+ *  iter: Iterator to examine.
+ *  key: Set to the key for the current element (owned by map and only valid
+ *   while map has not been modified).
+ *  value: Set to the value for the current element.
+ */
+inline void robin_hood_map_iterator_get_current(
+  robin_hood_map_iterator_t* iter, const char** key, generic_value_t* value) {
+  robin_hood_map_slot_t* slot = &iter->map->slots[iter->index];
+  *key = slot->key;
+  *value = slot->value;
+}
+
+
+/**
+ * Moves the iterator to the next value.
+ *
+ * This call should be proceeded by a successful call to
+ * robin_hood_map_iterator_has_current.
+ *
+ * Args:
+ *  iter: Iterator to update.
+ */
+void robin_hood_map_iterator_next(robin_hood_map_iterator_t* iter);
@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "map.h"
+#include "robin_hood_map.h"
+
+
+// Slots in the Robin Hood maps; the number of keys is set by the load
+// factor. map_t is given the same keys, though its fixed buckets mean
+// its own load factor is far higher.
+#define BENCH_CAPACITY (1 << 14)
+#define BENCH_SAMPLES 20000
+#define BENCH_KEY_SIZE 24
+
+
+// Operations of a map under test, so both maps run the same loops.
+typedef struct {
+  const char* name;
+  bool (*get)(void* map, const char* key, generic_value_t* value);
+  error_t (*insert)(void* map, const char* key, generic_value_t value);
+  bool (*remove)(void* map, const char* key, generic_value_t* value);
+} bench_map_ops_t;
+
+
+static bool bench_map_get(void* map, const char* key, generic_value_t* value) {
+  return map_get(map, key, value);
+}
+
+
+static error_t bench_map_insert(
+  void* map, const char* key, generic_value_t value) {
+  return map_insert(map, key, value);
+}
+
+
+static bool bench_map_remove(
+  void* map, const char* key, generic_value_t* value) {
+  return map_remove(map, key, value);
+}
+
+
+static bool bench_robin_hood_map_get(
+  void* map, const char* key, generic_value_t* value) {
+  return robin_hood_map_get(map, key, value);
+}
+
+
+static error_t bench_robin_hood_map_insert(
+  void* map, const char* key, generic_value_t value) {
+  return robin_hood_map_insert(map, key, value);
+}
+
+
+static bool bench_robin_hood_map_remove(
+  void* map, const char* key, generic_value_t* value) {
+  return robin_hood_map_remove(map, key, value);
+}
+
+
+static const bench_map_ops_t bench_map_ops = {
+  "map", bench_map_get, bench_map_insert, bench_map_remove
+};
+
+static const bench_map_ops_t bench_robin_hood_map_ops = {
+  "robin_hood_map", bench_robin_hood_map_get, bench_robin_hood_map_insert,
+  bench_robin_hood_map_remove
+};
+
+
+// Times single lookups and removals with inserts on a map holding size
+// keys, whose indexes are kept in ids.
+static void bench_latencies(
+  const bench_map_ops_t* ops, void* map, const char* keys,
+  const char* absent_keys, size_t* ids, size_t size, int load_percent) {
+  uint64_t* samples = malloc(BENCH_SAMPLES * sizeof(uint64_t));
+  if (!samples) {
+    abort();
+  }
+  char name[64];
+  uint64_t seed = 1;
+  uint64_t sum = 0;
+  generic_value_t value;
+  for (int i = 0; i < BENCH_SAMPLES; i++) {
+    const char* key = keys + ids[bench_random(&seed) % size] * BENCH_KEY_SIZE;
+    uint64_t start = bench_now_ns();
+    sum += ops->get(map, key, &value);
+    samples[i] = bench_now_ns() - start;
+  }
+  snprintf(name, sizeof(name), "%s_get_hit/%d%%", ops->name, load_percent);
+  bench_report_latencies(name, samples, BENCH_SAMPLES);
+
+  for (int i = 0; i < BENCH_SAMPLES; i++) {
+    const char* key = absent_keys + i * BENCH_KEY_SIZE;
+    uint64_t start = bench_now_ns();
+    sum += ops->get(map, key, &value);
+    samples[i] = bench_now_ns() - start;
+  }
+  snprintf(name, sizeof(name), "%s_get_miss/%d%%", ops->name, load_percent);
+  bench_report_latencies(name, samples, BENCH_SAMPLES);
+
+  // Replace random keys with new ones, keeping the size and load factor
+  // steady, and time the removals and the inserts separately.
+  uint64_t* insert_samples = malloc(BENCH_SAMPLES * sizeof(uint64_t));
+  if (!insert_samples) {
+    abort();
+  }
+  for (int i = 0; i < BENCH_SAMPLES; i++) {
+    size_t* id = &ids[bench_random(&seed) % size];
+    const char* key = keys + *id * BENCH_KEY_SIZE;
+    uint64_t start = bench_now_ns();
+    sum += ops->remove(map, key, &value);
+    samples[i] = bench_now_ns() - start;
+    *id = size + i;
+    key = keys + *id * BENCH_KEY_SIZE;
+    start = bench_now_ns();
+    if (ops->insert(map, key, (generic_value_t)*id)) {
+      abort();
+    }
+    insert_samples[i] = bench_now_ns() - start;
+  }
+  snprintf(name, sizeof(name), "%s_churn_remove/%d%%", ops->name,
+	   load_percent);
+  bench_report_latencies(name, samples, BENCH_SAMPLES);
+  snprintf(name, sizeof(name), "%s_churn_insert/%d%%", ops->name,
+	   load_percent);
+  bench_report_latencies(name, insert_samples, BENCH_SAMPLES);
+  bench_use(sum);
+  free(samples);
+  free(insert_samples);
+}
+
+
+// Reports the mean and longest probe lengths of a Robin Hood map.
+static void bench_report_probe_lengths(
+  robin_hood_map_t* map, const char* when, int load_percent) {
+  size_t total = 0, max = 0;
+  for (size_t i = 0; i < map->capacity; i++) {
+    size_t probe_length = map->slots[i].probe_length;
+    total += probe_length;
+    if (probe_length > max) {
+      max = probe_length;
+    }
+  }
+  char name[64];
+  snprintf(name, sizeof(name), "robin_hood_map_mean_probe_length_%s/%d%%",
+	   when, load_percent);
+  bench_report_value(name, (double)total / map->size, "slots");
+  snprintf(name, sizeof(name), "robin_hood_map_max_probe_length_%s/%d%%",
+	   when, load_percent);
+  bench_report_value(name, max, "slots");
+}
+
+
+int main(int argc, char** argv) {
+  int load_percents[] = {50, 60, 70, 80, 90, 95};
+  size_t max_size = BENCH_CAPACITY;
+  char* keys =
+    bench_make_keys("key:", max_size + BENCH_SAMPLES, BENCH_KEY_SIZE);
+  char* absent_keys =
+    bench_make_keys("absent:", BENCH_SAMPLES, BENCH_KEY_SIZE);
+  size_t* ids = malloc(max_size * sizeof(size_t));
+  if (!ids) {
+    abort();
+  }
+
+  for (size_t i = 0; i < sizeof(load_percents) / sizeof(int); i++) {
+    size_t size = (size_t)BENCH_CAPACITY * load_percents[i] / 100;
+    robin_hood_map_t* robin_hood_map;
+    // The limit is above every load factor measured, so the map keeps its
+    // capacity throughout.
+    if (robin_hood_map_create(&robin_hood_map) ||
+	robin_hood_map_set_max_load_factor(robin_hood_map, 0.96) ||
+	robin_hood_map_reserve(robin_hood_map, size)) {
+      abort();
+    }
+    map_t* map;
+    if (map_create(&map)) {
+      abort();
+    }
+    for (size_t j = 0; j < size; j++) {
+      if (robin_hood_map_insert(robin_hood_map, keys + j * BENCH_KEY_SIZE,
+				(generic_value_t)j) ||
+	  map_insert(map, keys + j * BENCH_KEY_SIZE, (generic_value_t)j)) {
+	abort();
+      }
+    }
+    if (robin_hood_map->capacity != BENCH_CAPACITY) {
+      abort();
+    }
+    bench_report_probe_lengths(robin_hood_map, "filled", load_percents[i]);
+
+    for (size_t j = 0; j < size; j++) {
+      ids[j] = j;
+    }
+    bench_latencies(&bench_robin_hood_map_ops, robin_hood_map, keys,
+		    absent_keys, ids, size, load_percents[i]);
+    // Backward-shift deletion leaves no tombstones, so churn should not
+    // lengthen probes.
+    bench_report_probe_lengths(robin_hood_map, "churned", load_percents[i]);
+    for (size_t j = 0; j < size; j++) {
+      ids[j] = j;
+    }
+    bench_latencies(&bench_map_ops, map, keys, absent_keys, ids, size,
+		    load_percents[i]);
+    robin_hood_map_delete(robin_hood_map);
+    map_delete(map);
+  }
+  free(keys);
+  free(absent_keys);
+  free(ids);
+  return 0;
+}
@@ -0,0 +1,215 @@
+#include "robin_hood_map.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Checks that every entry is where Robin Hood insertion puts it: its probe
+// length matches its distance from home, and no entry is more than one
+// slot further from home than the entry before it.
+static void check_invariants(robin_hood_map_t* map) {
+  size_t mask = map->capacity - 1;
+  size_t size = 0;
+  for (size_t i = 0; i < map->capacity; i++) {
+    robin_hood_map_slot_t* slot = &map->slots[i];
+    if (!slot->probe_length) {
+      continue;
+    }
+    size++;
+    assert(((i - (slot->hash & mask)) & mask) + 1 == slot->probe_length);
+    assert(slot->probe_length <=
+	   map->slots[(i - 1) & mask].probe_length + 1);
+  }
+  assert(size == map->size);
+  assert(map->size <= map->capacity * map->max_load_factor);
+}
+
+
+static void test_robin_hood_map_create() {
+  robin_hood_map_t* map;
+  assert(!robin_hood_map_create(&map));
+  assert(!map->value_deallocator);
+  assert(!robin_hood_map_size(map));
+  assert(ROBIN_HOOD_MAP_DEFAULT_MAX_LOAD_FACTOR == map->max_load_factor);
+  robin_hood_map_delete(map);
+}
+
+
+static void test_robin_hood_map_insert_get() {
+  robin_hood_map_t* map;
+  assert(!robin_hood_map_create(&map));
+  generic_value_t value;
+  assert(!robin_hood_map_get(map, "a", &value));
+  assert(!robin_hood_map_insert(map, "a", (generic_value_t)1.0));
+  assert(!robin_hood_map_insert(map, "", (generic_value_t)2.0));
+  assert(2 == robin_hood_map_size(map));
+  assert(robin_hood_map_get(map, "a", &value));
+  assert(1.0 == value.d);
+  assert(robin_hood_map_get(map, "", &value));
+  assert(2.0 == value.d);
+
+  // Inserting an existing key updates its value.
+  assert(!robin_hood_map_insert(map, "a", (generic_value_t)3.0));
+  assert(2 == robin_hood_map_size(map));
+  assert(robin_hood_map_get(map, "a", &value));
+  assert(3.0 == value.d);
+  robin_hood_map_delete(map);
+}
+
+
+static void test_robin_hood_map_grow() {
+  robin_hood_map_t* map;
+  assert(!robin_hood_map_create(&map));
+  for (int64_t i = 0; i < 10000; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    assert(!robin_hood_map_insert(map, key, (generic_value_t)i));
+  }
+  assert(10000 == robin_hood_map_size(map));
+  check_invariants(map);
+  for (int64_t i = 0; i < 10000; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    generic_value_t value;
+    assert(robin_hood_map_get(map, key, &value));
+    assert(i == value.i64);
+    sprintf(key, "absent:%d", (int)i);
+    assert(!robin_hood_map_get(map, key, &value));
+  }
+  robin_hood_map_delete(map);
+}
+
+
+static void test_robin_hood_map_remove() {
+  robin_hood_map_t* map;
+  assert(!robin_hood_map_create(&map));
+  assert(!robin_hood_map_set_max_load_factor(map, 0.95));
+  bool present[1000] = {false};
+  srand(1);
+  // Churn at a high load factor, so removals shift long runs back.
+  for (int i = 0; i < 20000; i++) {
+    int k = rand() % 1000;
+    char key[16];
+    sprintf(key, "key:%d", k);
+    generic_value_t value;
+    if (present[k]) {
+      assert(robin_hood_map_remove(map, key, &value));
+      assert(k == value.i64);
+    } else {
+      assert(!robin_hood_map_remove(map, key, &value));
+      assert(!robin_hood_map_insert(map, key, (generic_value_t)(int64_t)k));
+    }
+    present[k] = !present[k];
+    if (i % 1000 == 0) {
+      check_invariants(map);
+    }
+  }
+  check_invariants(map);
+  for (int k = 0; k < 1000; k++) {
+    char key[16];
+    sprintf(key, "key:%d", k);
+    generic_value_t value;
+    assert(present[k] == robin_hood_map_get(map, key, &value));
+  }
+  robin_hood_map_delete(map);
+}
+
+
+static void test_robin_hood_map_set_max_load_factor() {
+  robin_hood_map_t* map;
+  assert(!robin_hood_map_create(&map));
+  assert(ERROR_INVALID_ARGS == robin_hood_map_set_max_load_factor(map, 0));
+  assert(ERROR_INVALID_ARGS == robin_hood_map_set_max_load_factor(map, 1));
+  for (int64_t i = 0; i < 100; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    assert(!robin_hood_map_insert(map, key, (generic_value_t)i));
+  }
+  // Lowering the limit grows the map right away.
+  size_t capacity = map->capacity;
+  assert(!robin_hood_map_set_max_load_factor(map, 0.25));
+  assert(capacity < map->capacity);
+  check_invariants(map);
+  generic_value_t value;
+  assert(robin_hood_map_get(map, "key:42", &value));
+  assert(42 == value.i64);
+  robin_hood_map_delete(map);
+}
+
+
+static void test_robin_hood_map_reserve() {
+  robin_hood_map_t* map;
+  assert(!robin_hood_map_create(&map));
+  assert(!robin_hood_map_reserve(map, 1000));
+  size_t capacity = map->capacity;
+  assert(1000 <= capacity * map->max_load_factor);
+  for (int64_t i = 0; i < 1000; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    assert(!robin_hood_map_insert(map, key, (generic_value_t)i));
+  }
+  assert(capacity == map->capacity);
+  robin_hood_map_delete(map);
+}
+
+
+static void test_robin_hood_map_with_value_deallocator() {
+  robin_hood_map_t* map;
+  assert(!robin_hood_map_create_with_value_deallocator(&map, free));
+  for (int i = 0; i < 100; i++) {
+    char key[16];
+    sprintf(key, "key:%d", i);
+    assert(!robin_hood_map_insert(map, key, (generic_value_t)malloc(8)));
+  }
+  // Removed values belong to the caller.
+  generic_value_t value;
+  assert(robin_hood_map_remove(map, "key:7", &value));
+  free(value.p);
+  robin_hood_map_delete(map);
+}
+
+
+static void test_robin_hood_map_iterator() {
+  robin_hood_map_t* map;
+  assert(!robin_hood_map_create(&map));
+  robin_hood_map_iterator_t iter = robin_hood_map_iterator_create(map);
+  assert(!robin_hood_map_iterator_has_current(&iter));
+
+  bool seen[100] = {false};
+  for (int64_t i = 0; i < 100; i++) {
+    char key[16];
+    sprintf(key, "key:%d", (int)i);
+    assert(!robin_hood_map_insert(map, key, (generic_value_t)i));
+  }
+  size_t count = 0;
+  for (iter = robin_hood_map_iterator_create(map);
+       robin_hood_map_iterator_has_current(&iter);
+       robin_hood_map_iterator_next(&iter)) {
+    const char* key;
+    generic_value_t value;
+    robin_hood_map_iterator_get_current(&iter, &key, &value);
+    char expected[16];
+    sprintf(expected, "key:%d", (int)value.i64);
+    assert(!strcmp(expected, key));
+    assert(!seen[value.i64]);
+    seen[value.i64] = true;
+    count++;
+  }
+  assert(100 == count);
+  robin_hood_map_delete(map);
+}
+
+
+int main(int argc, char** argv) {
+  test_robin_hood_map_create();
+  test_robin_hood_map_insert_get();
+  test_robin_hood_map_grow();
+  test_robin_hood_map_remove();
+  test_robin_hood_map_set_max_load_factor();
+  test_robin_hood_map_reserve();
+  test_robin_hood_map_with_value_deallocator();
+  test_robin_hood_map_iterator();
+  return 0;
+}
@@ -0,0 +1,151 @@
+#include "strbuf.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Provide external definitions of inline functions.
+extern inline void strbuf_init(strbuf_t* buf);
+extern inline const char* strbuf_string(const strbuf_t* buf);
+extern inline size_t strbuf_length(const strbuf_t* buf);
+extern inline void strbuf_clear(strbuf_t* buf);
+
+
+void strbuf_release(strbuf_t* buf) {
+  free(buf->heap);
+  strbuf_init(buf);
+}
+
+
+error_t strbuf_reserve(strbuf_t* buf, size_t length) {
+  if (length < buf->capacity) {
+    return 0;
+  }
+  size_t capacity = buf->capacity * 2;
+  if (capacity <= length) {
+    capacity = length + 1;
+  }
+  char* heap = realloc(buf->heap, capacity);
+  if (!heap) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  if (!buf->heap) {
+    memcpy(heap, buf->inline_data, buf->length + 1);
+  }
+  buf->heap = heap;
+  buf->capacity = capacity;
+  return 0;
+}
+
+
+// Returns the storage of the buffer.
+static char* strbuf_data(strbuf_t* buf) {
+  return buf->heap ? buf->heap : buf->inline_data;
+}
+
+
+error_t strbuf_append(strbuf_t* buf, const char* bytes, size_t length) {
+  // Bytes from the buffer itself move if it grows, so find them again by
+  // their offset afterwards.
+  uintptr_t offset = (uintptr_t)bytes - (uintptr_t)strbuf_data(buf);
+  bool inside = offset < buf->capacity;
+  error_t error = strbuf_reserve(buf, buf->length + length);
+  if (error) {
+    return error;
+  }
+  char* data = strbuf_data(buf);
+  if (inside) {
+    bytes = data + offset;
+  }
+  memcpy(data + buf->length, bytes, length);
+  buf->length += length;
+  data[buf->length] = 0;
+  return 0;
+}
+
+
+error_t strbuf_append_string(strbuf_t* buf, const char* s) {
+  return strbuf_append(buf, s, strlen(s));
+}
+
+
+error_t strbuf_append_char(strbuf_t* buf, char c) {
+  return strbuf_append(buf, &c, 1);
+}
+
+
+// Writes the digits of value ending just before end and returns a
+// pointer to the first one.
+static char* strbuf_digits(uint64_t value, char* end) {
+  do {
+    *--end = '0' + value % 10;
+    value /= 10;
+  } while (value);
+  return end;
+}
+
+
+error_t strbuf_append_int(strbuf_t* buf, int64_t value) {
+  char digits[21];
+  char* end = digits + sizeof(digits);
+  // Negate in unsigned arithmetic so INT64_MIN does not overflow.
+  uint64_t magnitude = value < 0 ? -(uint64_t)value : (uint64_t)value;
+  char* start = strbuf_digits(magnitude, end);
+  if (value < 0) {
+    *--start = '-';
+  }
+  return strbuf_append(buf, start, end - start);
+}
+
+
+error_t strbuf_append_uint(strbuf_t* buf, uint64_t value) {
+  char digits[20];
+  char* end = digits + sizeof(digits);
+  char* start = strbuf_digits(value, end);
+  return strbuf_append(buf, start, end - start);
+}
+
+
+error_t strbuf_format(strbuf_t* buf, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  size_t available = buf->capacity - buf->length;
+  int length = vsnprintf(strbuf_data(buf) + buf->length, available, format,
+			 args);
+  va_end(args);
+  if (length < 0) {
+    // vsnprintf may have written part of the output.
+    strbuf_data(buf)[buf->length] = 0;
+    return ERROR_INVALID_ARGS;
+  }
+  if ((size_t)length >= available) {
+    // The output was truncated, so grow and format it again.
+    error_t error = strbuf_reserve(buf, buf->length + length);
+    if (error) {
+      strbuf_data(buf)[buf->length] = 0;
+      return error;
+    }
+    va_start(args, format);
+    vsnprintf(strbuf_data(buf) + buf->length, length + 1, format, args);
+    va_end(args);
+  }
+  buf->length += length;
+  return 0;
+}
+
+
+error_t strbuf_detach(strbuf_t* buf, char** result) {
+  char* string = buf->heap;
+  if (!string) {
+    string = malloc(buf->length + 1);
+    if (!string) {
+      return ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(string, buf->inline_data, buf->length + 1);
+  }
+  strbuf_init(buf);
+  *result = string;
+  return 0;
+}
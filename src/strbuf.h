@@ -0,0 +1,238 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "errors.h"
+
+
+// Bytes stored inside strbuf_t itself, including the terminator, which
+// makes the whole struct one cache line.
+#define STRBUF_INLINE_CAPACITY 40
+
+// Lets compilers that support it check strbuf_format's arguments.
+#if defined(__GNUC__)
+#define STRBUF_PRINTF_FORMAT(format_index, first_arg) \
+  __attribute__((format(printf, format_index, first_arg)))
+#else
+#define STRBUF_PRINTF_FORMAT(format_index, first_arg)
+#endif
+
+typedef struct {
+  // Heap storage, or NULL while the string fits in inline_data.
+  char* heap;
+  // Length of the string, not counting the terminator.
+  size_t length;
+  // Bytes available in the current storage, including the terminator.
+  size_t capacity;
+  char inline_data[STRBUF_INLINE_CAPACITY];
+} strbuf_t;
+
+
+/**
+ * Initializes an empty string buffer.
+ *
+ * A string buffer builds a NUL-terminated string by appending to it.
+ * Short strings are kept inside the strbuf_t, so a buffer on the stack
+ * needs no allocation for them; longer strings move to heap storage that
+ * doubles when full. The buffer must be released with strbuf_release.
+ *
+ * Args:
+ *  buf: Buffer to initialize.
+ */
+inline void strbuf_init(strbuf_t* buf) {
+  buf->heap = 0;
+  buf->length = 0;
+  buf->capacity = STRBUF_INLINE_CAPACITY;
+  buf->inline_data[0] = 0;
+}
+
+
+/**
+ * Frees the storage of a string buffer.
+ *
+ * The buffer may be initialized again with strbuf_init.
+ *
+ * Args:
+ *  buf: Buffer to release.
+ */
+void strbuf_release(strbuf_t* buf);
+
+
+/**
+ * Returns the string built so far.
+ *
+ * The pointer stays valid until the buffer is next changed.
+ *
+ * Args:
+ *  buf: Buffer to examine.
+ *
+ * Returns:
+ *  NUL-terminated contents of the buffer.
+ */
+inline const char* strbuf_string(const strbuf_t* buf) {
+  return buf->heap ? buf->heap : buf->inline_data;
+}
+
+
+/**
+ * Returns the length of the string built so far.
+ *
+ * Args:
+ *  buf: Buffer to examine.
+ *
+ * Returns:
+ *  Length of the string, not counting the terminator.
+ */
+inline size_t strbuf_length(const strbuf_t* buf) { return buf->length; }
+
+
+/**
+ * Empties the buffer, keeping its storage for reuse.
+ *
+ * Args:
+ *  buf: Buffer to update.
+ */
+inline void strbuf_clear(strbuf_t* buf) {
+  buf->length = 0;
+  (buf->heap ? buf->heap : buf->inline_data)[0] = 0;
+}
+
+
+/**
+ * Ensures the buffer can hold a string of a given length without
+ * reallocating.
+ *
+ * Args:
+ *  buf: Buffer to update.
+ *  length: String length, not counting the terminator.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not grow buffer because of memory error.
+ */
+error_t strbuf_reserve(strbuf_t* buf, size_t length);
+
+
+/**
+ * Appends bytes to the buffer.
+ *
+ * On failure the buffer is left unchanged.
+ *
+ * Args:
+ *  buf: Buffer to update.
+ *  bytes: Bytes to append. These should not include a NUL byte, and may
+ *   come from the buffer itself.
+ *  length: Number of bytes.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not grow buffer because of memory error.
+ */
+error_t strbuf_append(strbuf_t* buf, const char* bytes, size_t length);
+
+
+/**
+ * Appends a string to the buffer.
+ *
+ * On failure the buffer is left unchanged.
+ *
+ * Args:
+ *  buf: Buffer to update.
+ *  s: String to append.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not grow buffer because of memory error.
+ */
+error_t strbuf_append_string(strbuf_t* buf, const char* s);
+
+
+/**
+ * Appends a character to the buffer.
+ *
+ * On failure the buffer is left unchanged.
+ *
+ * Args:
+ *  buf: Buffer to update.
+ *  c: Character to append. This should not be NUL.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not grow buffer because of memory error.
+ */
+error_t strbuf_append_char(strbuf_t* buf, char c);
+
+
+/**
+ * Appends the decimal form of a signed integer to the buffer.
+ *
+ * This is much faster than formatting with "%" PRId64.
+ * On failure the buffer is left unchanged.
+ *
+ * Args:
+ *  buf: Buffer to update.
+ *  value: Integer to append.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not grow buffer because of memory error.
+ */
+error_t strbuf_append_int(strbuf_t* buf, int64_t value);
+
+
+/**
+ * Appends the decimal form of an unsigned integer to the buffer.
+ *
+ * On failure the buffer is left unchanged.
+ *
+ * Args:
+ *  buf: Buffer to update.
+ *  value: Integer to append.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not grow buffer because of memory error.
+ */
+error_t strbuf_append_uint(strbuf_t* buf, uint64_t value);
+
+
+/**
+ * Appends printf-style formatted output to the buffer.
+ *
+ * On failure the buffer is left unchanged. Unlike strbuf_append, the
+ * arguments must not point into the buffer.
+ *
+ * Args:
+ *  buf: Buffer to update.
+ *  format: printf format string.
+ *  ...: Arguments for the format.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not grow buffer because of memory error.
+ *  ERROR_INVALID_ARGS: The format could not be applied.
+ */
+error_t strbuf_format(strbuf_t* buf, const char* format, ...)
+  STRBUF_PRINTF_FORMAT(2, 3);
+
+
+/**
+ * Takes the string out of the buffer as a malloc'd string.
+ *
+ * Heap storage is handed over without copying; a string still held
+ * inline is copied, which is cheap since it is short. The result can be
+ * given to map_insert_owned to use it as a key without another copy.
+ * On success the buffer is left empty, as if just initialized.
+ *
+ * Args:
+ *  buf: Buffer to take the string from.
+ *  result: Set to the string, to be freed by the caller.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not allocate string. The buffer is left
+ *   unchanged.
+ */
+error_t strbuf_detach(strbuf_t* buf, char** result);
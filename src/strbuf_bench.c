@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "strbuf.h"
+#include "string_util.h"
+
+
+#define BENCH_KEYS 1000000
+
+
+// Builds "user:<i>:session" keys as heap strings, as map keys need.
+static void bench_snprintf_copy() {
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "user:%d:session", i);
+    char* key;
+    if (string_copy(buffer, &key)) {
+      abort();
+    }
+    bench_use((uintptr_t)key);
+    free(key);
+  }
+  bench_report("snprintf_string_copy", BENCH_KEYS, bench_now_ns() - start);
+}
+
+
+static void bench_strbuf_format() {
+  strbuf_t buf;
+  strbuf_init(&buf);
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    char* key;
+    if (strbuf_format(&buf, "user:%d:session", i) ||
+	strbuf_detach(&buf, &key)) {
+      abort();
+    }
+    bench_use((uintptr_t)key);
+    free(key);
+  }
+  bench_report("strbuf_format_detach", BENCH_KEYS, bench_now_ns() - start);
+  strbuf_release(&buf);
+}
+
+
+static void bench_strbuf_append() {
+  strbuf_t buf;
+  strbuf_init(&buf);
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    char* key;
+    if (strbuf_append(&buf, "user:", 5) || strbuf_append_int(&buf, i) ||
+	strbuf_append(&buf, ":session", 8) || strbuf_detach(&buf, &key)) {
+      abort();
+    }
+    bench_use((uintptr_t)key);
+    free(key);
+  }
+  bench_report("strbuf_append_detach", BENCH_KEYS, bench_now_ns() - start);
+
+  // Reusing one buffer for keys that are only looked up needs no
+  // allocation at all.
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    strbuf_clear(&buf);
+    if (strbuf_append(&buf, "user:", 5) || strbuf_append_int(&buf, i) ||
+	strbuf_append(&buf, ":session", 8)) {
+      abort();
+    }
+    bench_use(strbuf_length(&buf));
+  }
+  bench_report("strbuf_append_reuse", BENCH_KEYS, bench_now_ns() - start);
+  strbuf_release(&buf);
+}
+
+
+int main(int argc, char** argv) {
+  bench_snprintf_copy();
+  bench_strbuf_format();
+  bench_strbuf_append();
+  return 0;
+}
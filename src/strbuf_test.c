@@ -0,0 +1,186 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "map.h"
+#include "strbuf.h"
+
+
+static void test_strbuf_init() {
+  strbuf_t buf;
+  strbuf_init(&buf);
+  assert(!strbuf_length(&buf));
+  assert(!strcmp("", strbuf_string(&buf)));
+  strbuf_release(&buf);
+}
+
+
+static void test_strbuf_append() {
+  strbuf_t buf;
+  strbuf_init(&buf);
+  assert(!strbuf_append_string(&buf, "user:"));
+  assert(!strbuf_append(&buf, "42xyz", 2));
+  assert(!strbuf_append_char(&buf, ':'));
+  assert(!strbuf_append_string(&buf, "session"));
+  assert(!strcmp("user:42:session", strbuf_string(&buf)));
+  assert(15 == strbuf_length(&buf));
+  // Short strings stay inline.
+  assert(!buf.heap);
+  strbuf_release(&buf);
+}
+
+
+static void test_strbuf_append_self() {
+  strbuf_t buf;
+  strbuf_init(&buf);
+  assert(!strbuf_append_string(&buf, "ab"));
+  // Each append doubles the string, moving it inline to heap and then to
+  // larger heap storage while the bytes are read from it.
+  for (int i = 0; i < 8; i++) {
+    assert(!strbuf_append(&buf, strbuf_string(&buf), strbuf_length(&buf)));
+  }
+  assert(512 == strbuf_length(&buf));
+  for (size_t i = 0; i < 512; i++) {
+    assert("ab"[i % 2] == strbuf_string(&buf)[i]);
+  }
+  assert(!strbuf_append_string(&buf, strbuf_string(&buf) + 510));
+  assert(!strcmp("abab", strbuf_string(&buf) + 510));
+  strbuf_release(&buf);
+}
+
+
+static void test_strbuf_growth() {
+  strbuf_t buf;
+  strbuf_init(&buf);
+  char expected[1001] = {0};
+  for (int i = 0; i < 1000; i++) {
+    expected[i] = 'a' + i % 26;
+    assert(!strbuf_append_char(&buf, expected[i]));
+    assert(i + 1 == strbuf_length(&buf));
+  }
+  assert(buf.heap);
+  assert(buf.capacity > 1000);
+  assert(!strcmp(expected, strbuf_string(&buf)));
+
+  // Clearing keeps the storage.
+  char* heap = buf.heap;
+  strbuf_clear(&buf);
+  assert(!strbuf_length(&buf));
+  assert(!strcmp("", strbuf_string(&buf)));
+  assert(!strbuf_append_string(&buf, "again"));
+  assert(heap == buf.heap);
+  assert(!strcmp("again", strbuf_string(&buf)));
+  strbuf_release(&buf);
+  assert(!buf.heap);
+}
+
+
+static void test_strbuf_reserve() {
+  strbuf_t buf;
+  strbuf_init(&buf);
+  assert(!strbuf_append_string(&buf, "abc"));
+  assert(!strbuf_reserve(&buf, 100));
+  assert(buf.capacity > 100);
+  char* heap = buf.heap;
+  for (int i = 0; i < 97; i++) {
+    assert(!strbuf_append_char(&buf, 'x'));
+  }
+  assert(heap == buf.heap);
+  assert(!strncmp("abcxx", strbuf_string(&buf), 5));
+  strbuf_release(&buf);
+}
+
+
+static void test_strbuf_append_int() {
+  strbuf_t buf;
+  strbuf_init(&buf);
+  assert(!strbuf_append_int(&buf, 0));
+  assert(!strbuf_append_char(&buf, ' '));
+  assert(!strbuf_append_int(&buf, -17));
+  assert(!strbuf_append_char(&buf, ' '));
+  assert(!strbuf_append_int(&buf, INT64_MIN));
+  assert(!strbuf_append_char(&buf, ' '));
+  assert(!strbuf_append_int(&buf, INT64_MAX));
+  assert(!strbuf_append_char(&buf, ' '));
+  assert(!strbuf_append_uint(&buf, UINT64_MAX));
+  assert(!strcmp("0 -17 -9223372036854775808 9223372036854775807 "
+		 "18446744073709551615", strbuf_string(&buf)));
+  strbuf_release(&buf);
+}
+
+
+static void test_strbuf_format() {
+  strbuf_t buf;
+  strbuf_init(&buf);
+  assert(!strbuf_format(&buf, "user:%d:%s", 7, "session"));
+  assert(!strcmp("user:7:session", strbuf_string(&buf)));
+  assert(!buf.heap);
+  // Output that does not fit is formatted again after growing.
+  assert(!strbuf_format(&buf, "/%0100d", 5));
+  assert(115 == strbuf_length(&buf));
+  assert(!strncmp("user:7:session/000", strbuf_string(&buf), 18));
+  assert('5' == strbuf_string(&buf)[114]);
+  assert(!strbuf_string(&buf)[115]);
+  strbuf_release(&buf);
+}
+
+
+static void test_strbuf_detach() {
+  strbuf_t buf;
+  strbuf_init(&buf);
+  char* result;
+  assert(!strbuf_append_string(&buf, "short"));
+  assert(!strbuf_detach(&buf, &result));
+  assert(!strcmp("short", result));
+  assert(!strbuf_length(&buf));
+  free(result);
+
+  for (int i = 0; i < 100; i++) {
+    assert(!strbuf_append_char(&buf, 'x'));
+  }
+  char* heap = buf.heap;
+  assert(!strbuf_detach(&buf, &result));
+  // Heap storage is handed over as is.
+  assert(heap == result);
+  assert(100 == strlen(result));
+  assert(!buf.heap);
+  free(result);
+  strbuf_release(&buf);
+}
+
+
+static void test_strbuf_map_key() {
+  map_t* map;
+  assert(!map_create(&map));
+  strbuf_t buf;
+  strbuf_init(&buf);
+  for (int64_t i = 0; i < 20; i++) {
+    assert(!strbuf_append_string(&buf, "user:"));
+    assert(!strbuf_append_int(&buf, i));
+    assert(!strbuf_append_string(&buf, ":session"));
+    char* key;
+    assert(!strbuf_detach(&buf, &key));
+    assert(!map_insert_owned(map, key, (generic_value_t)i));
+  }
+  strbuf_release(&buf);
+  assert(20 == map_size(map));
+  generic_value_t value;
+  assert(map_get(map, "user:13:session", &value));
+  assert(13 == value.i64);
+  map_delete(map);
+}
+
+
+int main(int argc, char** argv) {
+  test_strbuf_init();
+  test_strbuf_append();
+  test_strbuf_append_self();
+  test_strbuf_growth();
+  test_strbuf_reserve();
+  test_strbuf_append_int();
+  test_strbuf_format();
+  test_strbuf_detach();
+  test_strbuf_map_key();
+  return 0;
+}
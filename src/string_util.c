@@ -1,17 +1,289 @@
 #include "string_util.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// AVX2 kernels are compiled with a target attribute and only called after
+// checking the CPU, so the library still runs on machines without AVX2.
+#if defined(__SSE2__) && defined(__GNUC__) && defined(__x86_64__)
+#define STRING_UTIL_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) && !defined(STRING_LENGTH_EXACT)
+#define STRING_LENGTH_SIMD
+#endif
+
+
+// Provide external definitions of inline functions.
+extern inline bool string_equal(
+  const char* a, size_t a_length, const char* b, size_t b_length);
+extern inline bool string_has_prefix(
+  const char* s, size_t length, const char* prefix, size_t prefix_length);
+
 
 error_t string_copy(const char* s, char** result) {
-  char* tmp = malloc(strlen(s) + 1);
+  size_t length;
+  return string_copy_with_length(s, result, &length);
+}
+
+
+error_t string_copy_with_length(const char* s, char** result, size_t* length) {
+  size_t tmp_length = string_length(s);
+  char* tmp = malloc(tmp_length + 1);
   if (!tmp) {
     return ERROR_OUT_OF_MEMORY;
   }
-  strcpy(tmp, s);
+  memcpy(tmp, s, tmp_length + 1);
   *result = tmp;
+  *length = tmp_length;
   return 0;
 }
 
 
+#ifdef STRING_UTIL_AVX2
+static bool string_util_has_avx2(void) {
+  return __builtin_cpu_supports("avx2");
+}
+#endif
+
+
+#ifdef STRING_LENGTH_SIMD
+// The length kernels read whole aligned blocks, which may extend past the
+// terminator. Aligned loads never cross a page boundary, so this cannot
+// fault, but AddressSanitizer would flag the bytes past the allocation.
+__attribute__((no_sanitize_address))
+static size_t string_length_sse2(const char* s) {
+  const char* block = (const char*)((uintptr_t)s & ~(uintptr_t)15);
+  __m128i zero = _mm_setzero_si128();
+  unsigned mask = _mm_movemask_epi8(
+    _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)block), zero));
+  // Ignore bytes before the start of the string.
+  mask >>= s - block;
+  if (mask) {
+    return __builtin_ctz(mask);
+  }
+  for (;;) {
+    block += 16;
+    mask = _mm_movemask_epi8(
+      _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)block), zero));
+    if (mask) {
+      return block - s + __builtin_ctz(mask);
+    }
+  }
+}
+#endif
+
+
+#if defined(STRING_LENGTH_SIMD) && defined(STRING_UTIL_AVX2)
+__attribute__((no_sanitize_address, target("avx2")))
+static size_t string_length_avx2(const char* s) {
+  const char* block = (const char*)((uintptr_t)s & ~(uintptr_t)31);
+  __m256i zero = _mm256_setzero_si256();
+  unsigned mask = _mm256_movemask_epi8(
+    _mm256_cmpeq_epi8(_mm256_load_si256((const __m256i*)block), zero));
+  mask >>= s - block;
+  if (mask) {
+    return __builtin_ctz(mask);
+  }
+  // Check single blocks up to a 128 byte boundary, then four blocks per
+  // iteration: the minimum of the four bytes at each position is zero
+  // only if one of them is.
+  for (;;) {
+    block += 32;
+    if (!((uintptr_t)block & 127)) {
+      break;
+    }
+    mask = _mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(_mm256_load_si256((const __m256i*)block), zero));
+    if (mask) {
+      return block - s + __builtin_ctz(mask);
+    }
+  }
+  for (;; block += 128) {
+    const __m256i* blocks = (const __m256i*)block;
+    __m256i min = _mm256_min_epu8(
+      _mm256_min_epu8(_mm256_load_si256(blocks),
+		      _mm256_load_si256(blocks + 1)),
+      _mm256_min_epu8(_mm256_load_si256(blocks + 2),
+		      _mm256_load_si256(blocks + 3)));
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(min, zero))) {
+      break;
+    }
+  }
+  for (;; block += 32) {
+    mask = _mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(_mm256_load_si256((const __m256i*)block), zero));
+    if (mask) {
+      return block - s + __builtin_ctz(mask);
+    }
+  }
+}
+#endif
+
+
+size_t string_length(const char* s) {
+#if defined(STRING_LENGTH_SIMD) && defined(STRING_UTIL_AVX2)
+  if (string_util_has_avx2()) {
+    return string_length_avx2(s);
+  }
+#endif
+#ifdef STRING_LENGTH_SIMD
+  return string_length_sse2(s);
+#else
+  return strlen(s);
+#endif
+}
+
+
+// Compares fewer than 16 bytes, 8 at a time where possible.
+static size_t string_mismatch_scalar(
+  const char* a, const char* b, size_t length) {
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t x, y;
+    memcpy(&x, a + i, 8);
+    memcpy(&y, b + i, 8);
+    if (x != y) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      return i + __builtin_ctzll(x ^ y) / 8;
+#else
+      break;
+#endif
+    }
+  }
+  for (; i < length && a[i] == b[i]; i++) {
+  }
+  return i;
+}
+
+
+#ifdef __SSE2__
+static size_t string_mismatch_sse2(
+  const char* a, const char* b, size_t length) {
+  if (length < 16) {
+    return string_mismatch_scalar(a, b, length);
+  }
+  size_t i = 0;
+  for (;; i += 16) {
+    // Finish with a block ending at the last byte, overlapping the one
+    // before rather than reading past the ranges.
+    if (i + 16 > length) {
+      i = length - 16;
+    }
+    unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+      _mm_loadu_si128((const __m128i*)(a + i)),
+      _mm_loadu_si128((const __m128i*)(b + i))));
+    if (mask != 0xffff) {
+      return i + __builtin_ctz(~mask);
+    }
+    if (i + 16 == length) {
+      return length;
+    }
+  }
+}
+#endif
+
+
+#ifdef STRING_UTIL_AVX2
+__attribute__((target("avx2")))
+static size_t string_mismatch_avx2(
+  const char* a, const char* b, size_t length) {
+  size_t i = 0;
+  // Skip 128 equal bytes per iteration, then locate any difference one
+  // block at a time.
+  for (; i + 128 <= length; i += 128) {
+    const __m256i* x = (const __m256i*)(a + i);
+    const __m256i* y = (const __m256i*)(b + i);
+    __m256i diff = _mm256_or_si256(
+      _mm256_or_si256(
+	_mm256_xor_si256(_mm256_loadu_si256(x), _mm256_loadu_si256(y)),
+	_mm256_xor_si256(_mm256_loadu_si256(x + 1),
+			 _mm256_loadu_si256(y + 1))),
+      _mm256_or_si256(
+	_mm256_xor_si256(_mm256_loadu_si256(x + 2),
+			 _mm256_loadu_si256(y + 2)),
+	_mm256_xor_si256(_mm256_loadu_si256(x + 3),
+			 _mm256_loadu_si256(y + 3))));
+    if (!_mm256_testz_si256(diff, diff)) {
+      break;
+    }
+  }
+  if (i == length) {
+    return length;
+  }
+  for (;; i += 32) {
+    if (i + 32 > length) {
+      i = length - 32;
+    }
+    unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+      _mm256_loadu_si256((const __m256i*)(a + i)),
+      _mm256_loadu_si256((const __m256i*)(b + i))));
+    if (mask != 0xffffffffU) {
+      return i + __builtin_ctz(~mask);
+    }
+    if (i + 32 == length) {
+      return length;
+    }
+  }
+}
+#endif
+
+
+size_t string_mismatch(const char* a, const char* b, size_t length) {
+#ifdef STRING_UTIL_AVX2
+  if (length >= 32 && string_util_has_avx2()) {
+    return string_mismatch_avx2(a, b, length);
+  }
+#endif
+#ifdef __SSE2__
+  return string_mismatch_sse2(a, b, length);
+#else
+  return string_mismatch_scalar(a, b, length);
+#endif
+}
+
+
+size_t string_match_prefix(
+  const char* prefix, size_t prefix_length, const char* const* keys,
+  const size_t* lengths, size_t count, size_t* matches) {
+  size_t matched = 0;
+#ifdef __SSE2__
+  if (prefix_length <= 16) {
+    // Compare every key against one register holding the prefix.
+    char padded[16] = {0};
+    memcpy(padded, prefix, prefix_length);
+    __m128i needle = _mm_loadu_si128((const __m128i*)padded);
+    unsigned wanted = (1U << prefix_length) - 1;
+    for (size_t i = 0; i < count; i++) {
+      if (lengths[i] < prefix_length) {
+	continue;
+      }
+      __m128i key;
+      if (lengths[i] >= 16) {
+	key = _mm_loadu_si128((const __m128i*)keys[i]);
+      } else {
+	char tmp[16] = {0};
+	memcpy(tmp, keys[i], lengths[i]);
+	key = _mm_loadu_si128((const __m128i*)tmp);
+      }
+      unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(key, needle));
+      if ((mask & wanted) == wanted) {
+	matches[matched++] = i;
+      }
+    }
+    return matched;
+  }
+#endif
+  for (size_t i = 0; i < count; i++) {
+    if (string_has_prefix(keys[i], lengths[i], prefix, prefix_length)) {
+      matches[matched++] = i;
+    }
+  }
+  return matched;
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "errors.h"
 
 
@@ -15,3 +18,118 @@
  *  ERROR_OUT_OF_MEMORY: Could not allocate new string.
  */
 error_t string_copy(const char* s, char** result);
+
+
+/**
+ * Copys a string using malloc and returns its length.
+ *
+ * This is string_length followed by memcpy, not a fused scan-and-copy:
+ * the destination cannot be allocated until the length is known. It only
+ * saves callers that need the length from scanning the string again.
+ *
+ * Args:
+ *  s: String to be copied.
+ *  result: Set to the newly allocated string.
+ *  length: Set to the length of the string, not counting the terminator.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not allocate new string.
+ */
+error_t string_copy_with_length(const char* s, char** result, size_t* length);
+
+
+/**
+ * Returns the length of a string.
+ *
+ * Uses AVX2 when the CPU supports it and SSE2 otherwise, falling back to
+ * strlen on other targets. The SIMD kernels read whole aligned blocks, up
+ * to the 128 byte boundary after the terminator, so memory checkers flag
+ * their reads past the end of a string's allocation. When built with
+ * STRING_LENGTH_EXACT defined, strlen is always used, which memory
+ * checkers intercept, so reads past the terminator are still reported for
+ * callers' strings. The tests are built this way.
+ *
+ * Args:
+ *  s: String to examine.
+ *
+ * Returns:
+ *  Length of the string, not counting the terminator.
+ */
+size_t string_length(const char* s);
+
+
+/**
+ * Finds the first position at which two byte ranges differ.
+ *
+ * Args:
+ *  a: First range.
+ *  b: Second range.
+ *  length: Number of bytes in each range.
+ *
+ * Returns:
+ *  Index of the first differing byte, or length if the ranges are equal.
+ */
+size_t string_mismatch(const char* a, const char* b, size_t length);
+
+
+/**
+ * Checks whether two strings of known length are equal.
+ *
+ * Strings of different lengths are rejected without reading them.
+ *
+ * Args:
+ *  a: First string.
+ *  a_length: Length of a.
+ *  b: Second string.
+ *  b_length: Length of b.
+ *
+ * Returns:
+ *  true if the strings are equal.
+ */
+inline bool string_equal(
+  const char* a, size_t a_length, const char* b, size_t b_length) {
+  return a_length == b_length && string_mismatch(a, b, a_length) == a_length;
+}
+
+
+/**
+ * Checks whether a string of known length starts with a prefix.
+ *
+ * Args:
+ *  s: String to examine.
+ *  length: Length of s.
+ *  prefix: Prefix to look for.
+ *  prefix_length: Length of prefix.
+ *
+ * Returns:
+ *  true if s starts with prefix.
+ */
+inline bool string_has_prefix(
+  const char* s, size_t length, const char* prefix, size_t prefix_length) {
+  return length >= prefix_length &&
+    string_mismatch(s, prefix, prefix_length) == prefix_length;
+}
+
+
+/**
+ * Finds which of a set of strings start with a prefix.
+ *
+ * The prefix is loaded once for all keys, so this is faster than calling
+ * string_has_prefix for each key when the prefix is short.
+ *
+ * Args:
+ *  prefix: Prefix to look for.
+ *  prefix_length: Length of prefix.
+ *  keys: Strings to examine.
+ *  lengths: Length of each key.
+ *  count: Number of keys.
+ *  matches: Set to the indices of the matching keys, in order. Must have
+ *   room for count indices.
+ *
+ * Returns:
+ *  Number of matching keys.
+ */
+size_t string_match_prefix(
+  const char* prefix, size_t prefix_length, const char* const* keys,
+  const size_t* lengths, size_t count, size_t* matches);
@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "string_util.h"
+
+
+#define BENCH_STRINGS 1024
+#define BENCH_OPS 4000000
+
+
+static char* bench_strings[BENCH_STRINGS];
+static char* bench_copies[BENCH_STRINGS];
+static size_t bench_lengths[BENCH_STRINGS];
+
+
+static void bench_fill(size_t length) {
+  uint64_t seed = length;
+  for (int i = 0; i < BENCH_STRINGS; i++) {
+    bench_strings[i] = malloc(length + 1);
+    if (!bench_strings[i]) {
+      abort();
+    }
+    // Keys share a prefix, as generated keys tend to.
+    for (size_t j = 0; j < length; j++) {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      bench_strings[i][j] = j < length / 2 ? 'k' : 'a' + (seed >> 33) % 26;
+    }
+    bench_strings[i][length] = 0;
+    bench_lengths[i] = length;
+    if (string_copy(bench_strings[i], &bench_copies[i])) {
+      abort();
+    }
+  }
+}
+
+
+static void bench_free() {
+  for (int i = 0; i < BENCH_STRINGS; i++) {
+    free(bench_strings[i]);
+    free(bench_copies[i]);
+  }
+}
+
+
+static void bench_length(size_t length) {
+  char name[64];
+  uint64_t sum = 0;
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < BENCH_OPS; i++) {
+    sum += strlen(bench_strings[i % BENCH_STRINGS]);
+  }
+  snprintf(name, sizeof(name), "strlen/%zu", length);
+  bench_report(name, BENCH_OPS, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_OPS; i++) {
+    sum += string_length(bench_strings[i % BENCH_STRINGS]);
+  }
+  snprintf(name, sizeof(name), "string_length/%zu", length);
+  bench_report(name, BENCH_OPS, bench_now_ns() - start);
+  bench_use(sum);
+}
+
+
+static void bench_equal(size_t length) {
+  char name[64];
+  uint64_t sum = 0;
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < BENCH_OPS; i++) {
+    int j = i % BENCH_STRINGS;
+    sum += !strcmp(bench_strings[j], bench_copies[j]);
+  }
+  snprintf(name, sizeof(name), "strcmp/%zu", length);
+  bench_report(name, BENCH_OPS, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (int i = 0; i < BENCH_OPS; i++) {
+    int j = i % BENCH_STRINGS;
+    sum += string_equal(bench_strings[j], bench_lengths[j], bench_copies[j],
+			bench_lengths[j]);
+  }
+  snprintf(name, sizeof(name), "string_equal/%zu", length);
+  bench_report(name, BENCH_OPS, bench_now_ns() - start);
+  bench_use(sum);
+}
+
+
+static void bench_copy(size_t length) {
+  char name[64];
+  int ops = BENCH_OPS / 4;
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < ops; i++) {
+    const char* s = bench_strings[i % BENCH_STRINGS];
+    char* copy = malloc(strlen(s) + 1);
+    if (!copy) {
+      abort();
+    }
+    strcpy(copy, s);
+    bench_use((uintptr_t)copy);
+    free(copy);
+  }
+  snprintf(name, sizeof(name), "strlen_strcpy/%zu", length);
+  bench_report(name, ops, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (int i = 0; i < ops; i++) {
+    char* copy;
+    size_t copy_length;
+    if (string_copy_with_length(bench_strings[i % BENCH_STRINGS], &copy,
+				&copy_length)) {
+      abort();
+    }
+    bench_use((uintptr_t)copy);
+    free(copy);
+  }
+  snprintf(name, sizeof(name), "string_copy_with_length/%zu", length);
+  bench_report(name, ops, bench_now_ns() - start);
+}
+
+
+static void bench_prefix(size_t length) {
+  char name[64];
+  size_t matches[BENCH_STRINGS];
+  // Matches keys whose generated part starts with "a".
+  size_t prefix_length = length / 2 + 1;
+  char* prefix = malloc(prefix_length + 1);
+  if (!prefix) {
+    abort();
+  }
+  memset(prefix, 'k', prefix_length);
+  prefix[prefix_length - 1] = 'a';
+  prefix[prefix_length] = 0;
+  int rounds = BENCH_OPS / BENCH_STRINGS;
+
+  uint64_t sum = 0;
+  uint64_t start = bench_now_ns();
+  for (int round = 0; round < rounds; round++) {
+    for (int i = 0; i < BENCH_STRINGS; i++) {
+      if (!strncmp(bench_strings[i], prefix, prefix_length)) {
+	matches[sum++ % BENCH_STRINGS] = i;
+      }
+    }
+  }
+  snprintf(name, sizeof(name), "strncmp_prefix/%zu", prefix_length);
+  bench_report(name, rounds * BENCH_STRINGS, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (int round = 0; round < rounds; round++) {
+    sum += string_match_prefix(prefix, prefix_length,
+			       (const char* const*)bench_strings,
+			       bench_lengths, BENCH_STRINGS, matches);
+  }
+  snprintf(name, sizeof(name), "string_match_prefix/%zu", prefix_length);
+  bench_report(name, rounds * BENCH_STRINGS, bench_now_ns() - start);
+  bench_use(sum + matches[0]);
+  free(prefix);
+}
+
+
+int main(int argc, char** argv) {
+  size_t lengths[] = {8, 16, 31, 64, 256, 1024};
+  for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+    bench_fill(lengths[i]);
+    bench_length(lengths[i]);
+    bench_equal(lengths[i]);
+    bench_copy(lengths[i]);
+    bench_prefix(lengths[i]);
+    bench_free();
+  }
+  return 0;
+}
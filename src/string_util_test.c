@@ -14,7 +14,120 @@ static void test_string_copy() {
 }
 
 
+static void test_string_copy_with_length() {
+  char* s_copy;
+  size_t length;
+  assert(!string_copy_with_length("", &s_copy, &length));
+  assert(!length && !*s_copy);
+  free(s_copy);
+  const char* s = "a string longer than one 32 byte block";
+  assert(!string_copy_with_length(s, &s_copy, &length));
+  assert(strlen(s) == length);
+  assert(!strcmp(s, s_copy));
+  free(s_copy);
+}
+
+
+static void test_string_length() {
+  // Every length at every alignment. The SIMD kernels read up to the 128
+  // byte boundary after the terminator, so the buffer is aligned and
+  // initialized past it, which keeps valgrind's checks of the test clean.
+  char* buffer = aligned_alloc(128, 256);
+  assert(buffer);
+  for (size_t offset = 0; offset < 32; offset++) {
+    for (size_t length = 0; length < 100; length++) {
+      memset(buffer, 'x', 256);
+      buffer[offset + length] = 0;
+      assert(length == string_length(buffer + offset));
+    }
+  }
+  free(buffer);
+}
+
+
+static void test_string_mismatch() {
+  char a[100], b[100];
+  for (size_t i = 0; i < 100; i++) {
+    a[i] = b[i] = 'a' + i % 26;
+  }
+  for (size_t length = 0; length <= 100; length++) {
+    assert(length == string_mismatch(a, b, length));
+    for (size_t i = 0; i < length; i++) {
+      b[i] = '#';
+      assert(i == string_mismatch(a, b, length));
+      // Only the first difference counts.
+      if (i + 1 < length) {
+	b[length - 1] = '#';
+	assert(i == string_mismatch(a, b, length));
+	b[length - 1] = a[length - 1];
+      }
+      b[i] = a[i];
+    }
+  }
+  // Unaligned ranges.
+  assert(40 == string_mismatch(a + 1, b + 1, 40));
+  assert(60 == string_mismatch(a + 3, b + 3, 60));
+}
+
+
+static void test_string_equal() {
+  assert(string_equal("", 0, "", 0));
+  assert(string_equal("abc", 3, "abc", 3));
+  assert(!string_equal("abc", 3, "abd", 3));
+  assert(!string_equal("abc", 3, "abcd", 4));
+  const char* s = "/api/v1/tenants/17/services/42/routes/1234";
+  char copy[64];
+  strcpy(copy, s);
+  assert(string_equal(s, strlen(s), copy, strlen(copy)));
+  copy[40] = 'x';
+  assert(!string_equal(s, strlen(s), copy, strlen(copy)));
+}
+
+
+static void test_string_has_prefix() {
+  assert(string_has_prefix("user:42", 7, "user:", 5));
+  assert(string_has_prefix("user:42", 7, "", 0));
+  assert(string_has_prefix("user:42", 7, "user:42", 7));
+  assert(!string_has_prefix("user", 4, "user:", 5));
+  assert(!string_has_prefix("users:42", 8, "user:", 5));
+}
+
+
+static void test_string_match_prefix() {
+  const char* keys[] = {
+    "user:1", "user", "session:1", "user:2:session", "", "user:",
+    "user:1234567890123456789", "usex:1234567890123456789",
+    "user:1234567890123456789:profile"
+  };
+  size_t count = sizeof(keys) / sizeof(keys[0]);
+  size_t lengths[sizeof(keys) / sizeof(keys[0])];
+  for (size_t i = 0; i < count; i++) {
+    lengths[i] = strlen(keys[i]);
+  }
+  size_t matches[sizeof(keys) / sizeof(keys[0])];
+
+  assert(5 == string_match_prefix("user:", 5, keys, lengths, count, matches));
+  assert(0 == matches[0] && 3 == matches[1] && 5 == matches[2] &&
+	 6 == matches[3] && 8 == matches[4]);
+  assert(count == string_match_prefix("", 0, keys, lengths, count, matches));
+  // Prefixes of exactly 16 bytes and longer.
+  assert(2 == string_match_prefix("user:12345678901", 16, keys, lengths,
+				  count, matches));
+  assert(6 == matches[0] && 8 == matches[1]);
+  assert(2 == string_match_prefix("user:1234567890123456789", 24, keys,
+				  lengths, count, matches));
+  assert(6 == matches[0] && 8 == matches[1]);
+  assert(0 == string_match_prefix("zzz", 3, keys, lengths, count, matches));
+}
+
+
 int main(int argc, char** argv) {
   test_string_copy();
+  test_string_copy_with_length();
+  test_string_length();
+  test_string_mismatch();
+  test_string_equal();
+  test_string_has_prefix();
+  test_string_match_prefix();
   return 0;
 }
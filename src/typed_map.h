@@ -0,0 +1,235 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "errors.h"
+#include "hash.h"
+
+
+/**
+ * Type-specialized maps.
+ *
+ * DEFINE_MAP instantiates a map for fixed-size keys and values that are
+ * stored inline in a single open-addressing slot array (linear probing,
+ * power-of-two capacity, backward-shift deletion). Because the hash and
+ * equality functions are expanded into the generated code, the compiler
+ * can inline them, and no generic_value_t boxing or per-entry allocation
+ * is needed.
+ *
+ * For example:
+ *
+ *   DEFINE_MAP(fd_map, int, connection_t*, hash_uint64, TYPED_MAP_EQUALS)
+ *
+ * generates the types fd_map_t and fd_map_iterator_t and the functions:
+ *
+ *   error_t fd_map_create(fd_map_t** map);
+ *   void fd_map_delete(fd_map_t* map);
+ *   error_t fd_map_insert(fd_map_t* map, int key, connection_t* value);
+ *   bool fd_map_get(const fd_map_t* map, int key, connection_t** value);
+ *   bool fd_map_remove(fd_map_t* map, int key, connection_t** value);
+ *   size_t fd_map_size(const fd_map_t* map);
+ *   fd_map_iterator_t fd_map_iterator_create(fd_map_t* map);
+ *   bool fd_map_iterator_has_current(fd_map_iterator_t* iter);
+ *   void fd_map_iterator_get_current(
+ *     fd_map_iterator_t* iter, int* key, connection_t** value);
+ *   void fd_map_iterator_next(fd_map_iterator_t* iter);
+ *
+ * These behave like their map.h counterparts. Removing entries while
+ * iterating is not supported, since backward-shift deletion may move
+ * entries the iterator has already visited.
+ *
+ * Args:
+ *  name: Prefix for the generated types and functions.
+ *  key_type: Type of the keys.
+ *  value_type: Type of the values.
+ *  hash_fn: Function or macro taking a key and returning a uint64_t hash.
+ *   All bits of the result should be well mixed (e.g. hash_uint64).
+ *  eq_fn: Function or macro taking two keys and returning true if they
+ *   are equal (e.g. TYPED_MAP_EQUALS).
+ */
+#define DEFINE_MAP(name, key_type, value_type, hash_fn, eq_fn)		\
+  typedef struct {							\
+    key_type key;							\
+    value_type value;							\
+    bool used;								\
+  } name##_slot_t;							\
+									\
+  typedef struct {							\
+    size_t size;							\
+    size_t capacity;							\
+    name##_slot_t* slots;						\
+  } name##_t;								\
+									\
+  typedef struct {							\
+    name##_t* map;							\
+    size_t index;							\
+  } name##_iterator_t;							\
+									\
+  TYPED_MAP_FUNCTION error_t name##_create(name##_t** map) {		\
+    name##_t* tmp = calloc(1, sizeof(name##_t));			\
+    if (!tmp) {								\
+      return ERROR_OUT_OF_MEMORY;					\
+    }									\
+    tmp->capacity = TYPED_MAP_INITIAL_CAPACITY;				\
+    tmp->slots = calloc(tmp->capacity, sizeof(name##_slot_t));		\
+    if (!tmp->slots) {							\
+      free(tmp);							\
+      return ERROR_OUT_OF_MEMORY;					\
+    }									\
+    *map = tmp;								\
+    return 0;								\
+  }									\
+									\
+  TYPED_MAP_FUNCTION void name##_delete(name##_t* map) {			\
+    if (!map) {								\
+      return;								\
+    }									\
+    free(map->slots);							\
+    free(map);								\
+  }									\
+									\
+  /* Finds the slot holding key, or the empty slot ending its probe. */ \
+  TYPED_MAP_FUNCTION size_t name##_find_slot(				\
+    const name##_t* map, key_type key) {				\
+    size_t mask = map->capacity - 1;					\
+    size_t index = (size_t)hash_fn(key) & mask;				\
+    while (map->slots[index].used &&					\
+	   !eq_fn(map->slots[index].key, key)) {			\
+      index = (index + 1) & mask;					\
+    }									\
+    return index;							\
+  }									\
+									\
+  TYPED_MAP_FUNCTION error_t name##_grow(name##_t* map) {			\
+    size_t capacity = map->capacity * 2;				\
+    size_t mask = capacity - 1;						\
+    name##_slot_t* slots = calloc(capacity, sizeof(name##_slot_t));	\
+    if (!slots) {							\
+      return ERROR_OUT_OF_MEMORY;					\
+    }									\
+    for (size_t i = 0; i < map->capacity; i++) {			\
+      if (map->slots[i].used) {						\
+	size_t index = (size_t)hash_fn(map->slots[i].key) & mask;	\
+	while (slots[index].used) {					\
+	  index = (index + 1) & mask;					\
+	}								\
+	slots[index] = map->slots[i];					\
+      }									\
+    }									\
+    free(map->slots);							\
+    map->slots = slots;							\
+    map->capacity = capacity;						\
+    return 0;								\
+  }									\
+									\
+  TYPED_MAP_FUNCTION error_t name##_insert(					\
+    name##_t* map, key_type key, value_type value) {			\
+    size_t index = name##_find_slot(map, key);				\
+    if (map->slots[index].used) {					\
+      map->slots[index].value = value;					\
+      return 0;								\
+    }									\
+    /* Keep the load factor at or below 3/4. */				\
+    if ((map->size + 1) * 4 > map->capacity * 3) {			\
+      error_t error = name##_grow(map);					\
+      if (error) {							\
+	return error;							\
+      }									\
+      index = name##_find_slot(map, key);				\
+    }									\
+    map->slots[index].key = key;					\
+    map->slots[index].value = value;					\
+    map->slots[index].used = true;					\
+    map->size++;							\
+    return 0;								\
+  }									\
+									\
+  static inline bool name##_get(					\
+    const name##_t* map, key_type key, value_type* value) {		\
+    size_t index = name##_find_slot(map, key);				\
+    if (!map->slots[index].used) {					\
+      return false;							\
+    }									\
+    *value = map->slots[index].value;					\
+    return true;							\
+  }									\
+									\
+  TYPED_MAP_FUNCTION bool name##_remove(					\
+    name##_t* map, key_type key, value_type* value) {			\
+    size_t index = name##_find_slot(map, key);				\
+    if (!map->slots[index].used) {					\
+      return false;							\
+    }									\
+    *value = map->slots[index].value;					\
+    /* Shift following entries back so no tombstone is needed. */	\
+    size_t mask = map->capacity - 1;					\
+    size_t hole = index;						\
+    for (size_t next = (hole + 1) & mask; map->slots[next].used;	\
+	 next = (next + 1) & mask) {					\
+      size_t home = (size_t)hash_fn(map->slots[next].key) & mask;	\
+      if (((next - home) & mask) >= ((next - hole) & mask)) {		\
+	map->slots[hole] = map->slots[next];				\
+	hole = next;							\
+      }									\
+    }									\
+    map->slots[hole].used = false;					\
+    map->size--;							\
+    return true;							\
+  }									\
+									\
+  static inline size_t name##_size(const name##_t* map) {		\
+    return map->size;							\
+  }									\
+									\
+  static inline void name##_iterator_next(name##_iterator_t* iter) {	\
+    do {								\
+      iter->index++;							\
+    } while (iter->index < iter->map->capacity &&			\
+	     !iter->map->slots[iter->index].used);			\
+  }									\
+									\
+  TYPED_MAP_FUNCTION name##_iterator_t name##_iterator_create(		\
+    name##_t* map) {							\
+    name##_iterator_t iter = {map, 0};					\
+    if (!map->slots[0].used) {						\
+      name##_iterator_next(&iter);					\
+    }									\
+    return iter;							\
+  }									\
+									\
+  static inline bool name##_iterator_has_current(			\
+    name##_iterator_t* iter) {						\
+    return iter->index < iter->map->capacity;				\
+  }									\
+									\
+  static inline void name##_iterator_get_current(			\
+    name##_iterator_t* iter, key_type* key, value_type* value) {	\
+    *key = iter->map->slots[iter->index].key;				\
+    *value = iter->map->slots[iter->index].value;			\
+  }
+
+
+/**
+ * Linkage for the larger generated functions, which are left to the
+ * compiler's inlining heuristics; unused instantiations do not warn.
+ */
+#if defined(__GNUC__)
+#define TYPED_MAP_FUNCTION static __attribute__((unused))
+#else
+#define TYPED_MAP_FUNCTION static
+#endif
+
+
+/**
+ * Initial number of slots in a typed map; must be a power of two.
+ */
+#define TYPED_MAP_INITIAL_CAPACITY 16
+
+
+/**
+ * Equality for scalar keys (integers and pointers), for use as eq_fn.
+ */
+#define TYPED_MAP_EQUALS(a, b) ((a) == (b))
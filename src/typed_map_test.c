@@ -0,0 +1,137 @@
+#include "typed_map.h"
+
+#include <assert.h>
+
+
+DEFINE_MAP(int_map, int64_t, int64_t, hash_uint64, TYPED_MAP_EQUALS)
+DEFINE_MAP(pointer_map, const void*, int, hash_pointer, TYPED_MAP_EQUALS)
+
+
+static void test_typed_map_create() {
+  int_map_t* map;
+  assert(!int_map_create(&map));
+  assert(!int_map_size(map));
+  int_map_delete(map);
+}
+
+
+static void test_typed_map_insert() {
+  int_map_t* map;
+  assert(!int_map_create(&map));
+  for (int64_t i = 0; i < 10; i++) {
+    assert(!int_map_insert(map, i, i * 10));
+  }
+  assert(10 == int_map_size(map));
+
+  // Inserting an existing key updates the value.
+  assert(!int_map_insert(map, 5, 500));
+  assert(10 == int_map_size(map));
+  int64_t value;
+  assert(int_map_get(map, 5, &value));
+  assert(500 == value);
+  int_map_delete(map);
+}
+
+
+static void test_typed_map_get() {
+  int_map_t* map;
+  assert(!int_map_create(&map));
+  // Enough entries to force the map to grow several times.
+  for (int64_t i = 0; i < 1000; i++) {
+    assert(!int_map_insert(map, i * 7, i));
+  }
+  assert(1000 == int_map_size(map));
+
+  for (int64_t i = 0; i < 1000; i++) {
+    int64_t value;
+    assert(int_map_get(map, i * 7, &value));
+    assert(i == value);
+    assert(!int_map_get(map, i * 7 + 1, &value));
+  }
+  int_map_delete(map);
+}
+
+
+static void test_typed_map_remove() {
+  int_map_t* map;
+  assert(!int_map_create(&map));
+  for (int64_t i = 0; i < 1000; i++) {
+    assert(!int_map_insert(map, i, i));
+  }
+
+  // Remove odd keys, checking that shifted entries stay reachable.
+  for (int64_t i = 1; i < 1000; i += 2) {
+    int64_t value;
+    assert(int_map_remove(map, i, &value));
+    assert(i == value);
+    assert(!int_map_remove(map, i, &value));
+  }
+  assert(500 == int_map_size(map));
+  for (int64_t i = 0; i < 1000; i++) {
+    int64_t value;
+    assert(int_map_get(map, i, &value) == !(i % 2));
+  }
+  int_map_delete(map);
+}
+
+
+static void test_typed_map_pointer_keys() {
+  pointer_map_t* map;
+  assert(!pointer_map_create(&map));
+  int objects[10];
+  for (int i = 0; i < 10; i++) {
+    assert(!pointer_map_insert(map, &objects[i], i));
+  }
+  for (int i = 0; i < 10; i++) {
+    int value;
+    assert(pointer_map_get(map, &objects[i], &value));
+    assert(i == value);
+  }
+  pointer_map_delete(map);
+}
+
+
+static void test_typed_map_iterator() {
+  int_map_t* map;
+  assert(!int_map_create(&map));
+  for (int64_t i = 0; i < 100; i++) {
+    assert(!int_map_insert(map, i, i + 1));
+  }
+
+  // We iterate through the map, making sure that we see every value once.
+  bool seen[100] = {false};
+  size_t count = 0;
+  for (int_map_iterator_t iter = int_map_iterator_create(map);
+       int_map_iterator_has_current(&iter); int_map_iterator_next(&iter)) {
+    int64_t key;
+    int64_t value;
+    int_map_iterator_get_current(&iter, &key, &value);
+    assert(key + 1 == value);
+    assert(!seen[key]);
+    seen[key] = true;
+    count++;
+  }
+  assert(100 == count);
+  int_map_delete(map);
+}
+
+
+static void test_typed_map_iterator_empty_map() {
+  int_map_t* map;
+  assert(!int_map_create(&map));
+  int_map_iterator_t iter = int_map_iterator_create(map);
+  assert(!int_map_iterator_has_current(&iter));
+  int_map_delete(map);
+}
+
+
+int main(int argc, char** argv) {
+  test_typed_map_create();
+  test_typed_map_insert();
+  test_typed_map_get();
+  test_typed_map_remove();
+  test_typed_map_pointer_keys();
+  test_typed_map_iterator();
+  test_typed_map_iterator_empty_map();
+  return 0;
+}
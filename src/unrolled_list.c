@@ -0,0 +1,181 @@
+#include "unrolled_list.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Nodes are aligned so each one spans whole cache lines.
+#define UNROLLED_LIST_NODE_ALIGNMENT 64
+
+_Static_assert(
+  sizeof(unrolled_list_node_t) % UNROLLED_LIST_NODE_ALIGNMENT == 0,
+  "unrolled_list_node_t must be a multiple of the cache line size");
+
+
+// Provide external definitions of inline functions.
+extern inline generic_value_t unrolled_list_get_back(unrolled_list_t* list);
+extern inline generic_value_t unrolled_list_get_front(unrolled_list_t* list);
+extern inline size_t unrolled_list_size(const unrolled_list_t* list);
+extern inline bool unrolled_list_empty(const unrolled_list_t* list);
+
+extern inline unrolled_list_iterator_t unrolled_list_iterator_create(
+  unrolled_list_t* list);
+extern inline bool unrolled_list_iterator_has_current(
+  unrolled_list_iterator_t* iter);
+extern inline generic_value_t unrolled_list_iterator_get_current(
+  unrolled_list_iterator_t* iter);
+extern inline void unrolled_list_iterator_next(unrolled_list_iterator_t* iter);
+
+
+error_t unrolled_list_create(unrolled_list_t** list) {
+  return unrolled_list_create_with_value_deallocator(list, 0);
+}
+
+
+error_t unrolled_list_create_with_value_deallocator(
+  unrolled_list_t** list, void (*value_deallocator)(void*)) {
+  unrolled_list_t* tmp = calloc(1, sizeof(unrolled_list_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->value_deallocator = value_deallocator;
+  *list = tmp;
+  return 0;
+}
+
+
+void unrolled_list_delete(unrolled_list_t* list) {
+  if (!list) {
+    return;
+  }
+  while (list->head) {
+    unrolled_list_node_t* current = list->head;
+    if (list->value_deallocator) {
+      for (uint32_t i = current->begin; i < current->end; i++) {
+	list->value_deallocator(current->values[i].p);
+      }
+    }
+    list->head = current->next;
+    free(current);
+  }
+  free(list);
+}
+
+
+static error_t unrolled_list_node_create(
+  unrolled_list_node_t** node, uint32_t position) {
+  unrolled_list_node_t* tmp = aligned_alloc(
+    UNROLLED_LIST_NODE_ALIGNMENT, sizeof(unrolled_list_node_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->next = 0;
+  tmp->begin = tmp->end = position;
+  *node = tmp;
+  return 0;
+}
+
+
+error_t unrolled_list_push_back(unrolled_list_t* list, generic_value_t value) {
+  unrolled_list_node_t* node = list->tail;
+  if (!node || node->end == UNROLLED_LIST_NODE_CAPACITY) {
+    // Start a new node, filling it from the front.
+    error_t result = unrolled_list_node_create(&node, 0);
+    if (result) {
+      return result;
+    }
+    if (!list->head) {
+      list->head = list->tail = node;
+    } else {
+      list->tail->next = node;
+      list->tail = node;
+    }
+  }
+  node->values[node->end++] = value;
+  list->size++;
+  return 0;
+}
+
+
+error_t unrolled_list_push_front(
+  unrolled_list_t* list, generic_value_t value) {
+  unrolled_list_node_t* node = list->head;
+  if (!node || !node->begin) {
+    // Start a new node, filling it from the back.
+    error_t result =
+      unrolled_list_node_create(&node, UNROLLED_LIST_NODE_CAPACITY);
+    if (result) {
+      return result;
+    }
+    if (!list->head) {
+      list->head = list->tail = node;
+    } else {
+      node->next = list->head;
+      list->head = node;
+    }
+  }
+  node->values[--node->begin] = value;
+  list->size++;
+  return 0;
+}
+
+
+generic_value_t unrolled_list_pop_front(unrolled_list_t* list) {
+  unrolled_list_node_t* node = list->head;
+  generic_value_t value = node->values[node->begin++];
+  if (node->begin == node->end) {
+    list->head = node->next;
+    if (!list->head) {
+      list->tail = 0;
+    }
+    free(node);
+  }
+  list->size--;
+  return value;
+}
+
+
+generic_value_t unrolled_list_iterator_remove_current(
+  unrolled_list_iterator_t* iter) {
+  unrolled_list_t* list = iter->list;
+  unrolled_list_node_t* node = *iter->current;
+  uint32_t index = iter->index;
+  generic_value_t value = node->values[index];
+
+  // Close the gap by moving whichever side of the node is shorter.
+  if (index - node->begin < node->end - index - 1) {
+    memmove(&node->values[node->begin + 1], &node->values[node->begin],
+	    (index - node->begin) * sizeof(generic_value_t));
+    node->begin++;
+    iter->index++;
+  } else {
+    memmove(&node->values[index], &node->values[index + 1],
+	    (node->end - index - 1) * sizeof(generic_value_t));
+    node->end--;
+  }
+  list->size--;
+
+  if (node->begin == node->end) {
+    // Unlink and free the empty node.
+    *iter->current = node->next;
+    if (list->tail == node) {
+      // If we removed the only node, set tail to null.
+      if (!list->head) {
+	list->tail = 0;
+      } else {
+	// Otherwise, find previous node from pointer to its next field.
+	list->tail =
+	  (unrolled_list_node_t*)((char*)iter->current -
+				  offsetof(unrolled_list_node_t, next));
+      }
+    }
+    free(node);
+    iter->index = *iter->current ? (*iter->current)->begin : 0;
+  } else if (iter->index == node->end) {
+    // The removed value was the last one in its node.
+    iter->current = &node->next;
+    iter->index = node->next ? node->next->begin : 0;
+  }
+  return value;
+}
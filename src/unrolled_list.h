@@ -0,0 +1,272 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "errors.h"
+#include "generic.h"
+
+
+// Number of values stored in each node. With the node header this makes
+// each node exactly 128 bytes, i.e. two cache lines.
+#define UNROLLED_LIST_NODE_CAPACITY 14
+
+typedef struct unrolled_list_node {
+  struct unrolled_list_node* next;
+  // Values are stored in values[begin, end).
+  uint32_t begin;
+  uint32_t end;
+  generic_value_t values[UNROLLED_LIST_NODE_CAPACITY];
+} unrolled_list_node_t;
+
+typedef struct {
+  void (*value_deallocator)(void*);
+  unrolled_list_node_t* head;
+  unrolled_list_node_t* tail;
+  size_t size;
+} unrolled_list_t;
+
+typedef struct {
+  unrolled_list_t* list;
+  unrolled_list_node_t** current;
+  uint32_t index;
+} unrolled_list_iterator_t;
+
+
+/**
+ * Creates a new unrolled list.
+ *
+ * An unrolled list has the same interface as list_t, but stores up to
+ * UNROLLED_LIST_NODE_CAPACITY values per node, so it needs far fewer
+ * allocations and cache misses when values are pushed and iterated.
+ *
+ * Args:
+ *  list: Set to the newly allocated list.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create list because of memory error.
+ */
+error_t unrolled_list_create(unrolled_list_t** list);
+
+
+/**
+ * Creates a new unrolled list with a value deallocator.
+ *
+ * The deallocation function is used to delete void* values
+ * (generic_value_t.p) when unrolled_list_delete is called.
+ *
+ * Args:
+ *  list: Set to the newly allocated list.
+ *  deallocated: Function used to delete values.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create list because of memory error.
+ */
+error_t unrolled_list_create_with_value_deallocator(
+  unrolled_list_t** list, void (*value_deallocator)(void*));
+
+
+/**
+ * Deletes an unrolled list.
+ *
+ * If a deallocation function was provided during creation, list values
+ * will be treated as void* (generic_value_t.p) and sent to the function.
+ *
+ * Args:
+ *  list: List to be deleted.
+ */
+void unrolled_list_delete(unrolled_list_t* list);
+
+
+/**
+ * Adds a value to the end of the list.
+ *
+ * Args:
+ *  list: List to add value to.
+ *  value: Value to add to list.
+ *
+ * Returns:
+ *  0 on success
+ *  ERROR_OUT_OF_MEMORY: Could not add value because of memory error.
+ */
+error_t unrolled_list_push_back(unrolled_list_t* list, generic_value_t value);
+
+
+/**
+ * Gets the last value in the list.
+ *
+ * Calling this on an empty list is undefined.
+ *
+ * Args:
+ *  list: The list to examine.
+ *
+ * Returns:
+ *  This last value in the list.
+ */
+inline generic_value_t unrolled_list_get_back(unrolled_list_t* list) {
+  return list->tail->values[list->tail->end - 1];
+}
+
+
+/**
+ * Adds a value to the beginning of the list.
+ *
+ * Args:
+ *  list: List to add value to.
+ *  value: Value to add to list.
+ *
+ * Returns:
+ *  0 on success
+ *  ERROR_OUT_OF_MEMORY: Could not add value because of memory error.
+ */
+error_t unrolled_list_push_front(unrolled_list_t* list, generic_value_t value);
+
+
+/**
+ * Removes the first element from the list.
+ *
+ * Calling this on an empty list is undefined.
+ *
+ * Args:
+ *  list: The list to pop element from.
+ *
+ * Returns:
+ *  The first element in the list.
+ */
+generic_value_t unrolled_list_pop_front(unrolled_list_t* list);
+
+
+/**
+ * Gets the first value in the list.
+ *
+ * Calling this on an empty list is undefined.
+ *
+ * Args:
+ *  list: The list to examine.
+ *
+ * Returns:
+ *  This first value in the list.
+ */
+inline generic_value_t unrolled_list_get_front(unrolled_list_t* list) {
+  return list->head->values[list->head->begin];
+}
+
+
+/**
+ * Returns the size of the list.
+ *
+ * Args:
+ *  list: List to examine.
+ *
+ * Returns:
+ *  Size of the list.
+ */
+inline size_t unrolled_list_size(const unrolled_list_t* list) {
+  return list->size;
+}
+
+
+/**
+ * Returns true if list is empty.
+ *
+ * Args:
+ *  list: List to examine.
+ *
+ * Returns:
+ *  true if list is empty.
+ */
+inline bool unrolled_list_empty(const unrolled_list_t* list) {
+  return !list->size;
+}
+
+
+/**
+ * Creates an iterator for a list.
+ *
+ * Args:
+ *  list: List to create iterator for.
+ *
+ * Returns:
+ *  Iterator for the given list.
+ */
+inline unrolled_list_iterator_t unrolled_list_iterator_create(
+  unrolled_list_t* list) {
+  return (unrolled_list_iterator_t){
+    list, &list->head, list->head ? list->head->begin : 0};
+}
+
+
+/**
+ * Returns true if the iterator has a current value.
+ *
+ * If this function returns true, it is safe to call
+ * unrolled_list_iterator_get_current and unrolled_list_iterator_next.
+ *
+ * Args:
+ *  iter: Iterator to examine
+ *
+ * Returns:
+ *  true if the iterator has a current value.
+ */
+inline bool unrolled_list_iterator_has_current(
+  unrolled_list_iterator_t* iter) {
+  return *iter->current;
+}
+
+
+/**
+ * Gets the current value for the iterator.
+ *
+ * This call should be proceeded by a successful call to
+ * unrolled_list_iterator_has_current.
+ *
+ * Args:
+ *  iter: Iterator to examine.
+ *
+ * Returns.
+ *  Current value for the iterator.
+ */
+inline generic_value_t unrolled_list_iterator_get_current(
+  unrolled_list_iterator_t* iter) {
+  return (*iter->current)->values[iter->index];
+}
+
+
+/**
+ * Removes the current value of the iterator.
+ *
+ * This call should be proceeded by a successful call to
+ * unrolled_list_iterator_has_current.
+ *
+ * After this call returns, the iterator will be positioned at
+ * the next element in the list. Nodes are freed once they become empty.
+ *
+ * Args:
+ *  iter: Iterator to examine.
+ *
+ * Returns:
+ *  Current value for the iterator.
+ */
+generic_value_t unrolled_list_iterator_remove_current(
+  unrolled_list_iterator_t* iter);
+
+
+/**
+ * Moves the iterator to the next value.
+ *
+ * This call should be proceeded by a successful call to
+ * unrolled_list_iterator_has_current.
+ *
+ * Args:
+ *  iter: Iterator to update.
+ */
+inline void unrolled_list_iterator_next(unrolled_list_iterator_t* iter) {
+  unrolled_list_node_t* node = *iter->current;
+  if (++iter->index == node->end) {
+    iter->current = &node->next;
+    iter->index = node->next ? node->next->begin : 0;
+  }
+}
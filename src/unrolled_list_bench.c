@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "list.h"
+#include "unrolled_list.h"
+
+
+#define BENCH_SIZE 1000000
+#define BENCH_ROUNDS 10
+
+
+static void bench_list() {
+  list_t* list;
+  if (list_create(&list)) {
+    abort();
+  }
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_SIZE; i++) {
+    if (list_push_back(list, (generic_value_t)i)) {
+      abort();
+    }
+  }
+  bench_report("list_push_back", BENCH_SIZE, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  uint64_t sum = 0;
+  for (int round = 0; round < BENCH_ROUNDS; round++) {
+    for (list_iterator_t iter = list_iterator_create(list);
+	 list_iterator_has_current(&iter); list_iterator_next(&iter)) {
+      sum += list_iterator_get_current(&iter).ui64;
+    }
+  }
+  bench_report("list_iterate", (size_t)BENCH_SIZE * BENCH_ROUNDS,
+	       bench_now_ns() - start);
+  bench_use(sum);
+
+  start = bench_now_ns();
+  while (!list_empty(list)) {
+    bench_use(list_pop_front(list).ui64);
+  }
+  bench_report("list_pop_front", BENCH_SIZE, bench_now_ns() - start);
+  list_delete(list);
+}
+
+
+static void bench_unrolled_list() {
+  unrolled_list_t* list;
+  if (unrolled_list_create(&list)) {
+    abort();
+  }
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_SIZE; i++) {
+    if (unrolled_list_push_back(list, (generic_value_t)i)) {
+      abort();
+    }
+  }
+  bench_report("unrolled_list_push_back", BENCH_SIZE, bench_now_ns() - start);
+
+  start = bench_now_ns();
+  uint64_t sum = 0;
+  for (int round = 0; round < BENCH_ROUNDS; round++) {
+    for (unrolled_list_iterator_t iter = unrolled_list_iterator_create(list);
+	 unrolled_list_iterator_has_current(&iter);
+	 unrolled_list_iterator_next(&iter)) {
+      sum += unrolled_list_iterator_get_current(&iter).ui64;
+    }
+  }
+  bench_report("unrolled_list_iterate", (size_t)BENCH_SIZE * BENCH_ROUNDS,
+	       bench_now_ns() - start);
+  bench_use(sum);
+
+  start = bench_now_ns();
+  while (!unrolled_list_empty(list)) {
+    bench_use(unrolled_list_pop_front(list).ui64);
+  }
+  bench_report("unrolled_list_pop_front", BENCH_SIZE, bench_now_ns() - start);
+  unrolled_list_delete(list);
+}
+
+
+int main(int argc, char** argv) {
+  bench_list();
+  bench_unrolled_list();
+  return 0;
+}
@@ -0,0 +1,191 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "unrolled_list.h"
+
+
+// Enough values to span several nodes.
+#define TEST_SIZE 100
+
+
+static void test_unrolled_list_create() {
+  unrolled_list_t* list;
+  assert(!unrolled_list_create(&list));
+  assert(!list->value_deallocator);
+  assert(!list->head);
+  assert(!list->tail);
+  assert(!list->size);
+  unrolled_list_delete(list);
+}
+
+
+static void test_unrolled_list_push_back() {
+  unrolled_list_t* list;
+  assert(!unrolled_list_create(&list));
+  for (uint64_t i = 0; i < TEST_SIZE; i++) {
+    assert(!unrolled_list_push_back(list, (generic_value_t)i));
+  }
+  assert(TEST_SIZE == unrolled_list_size(list));
+  assert(0 == unrolled_list_get_front(list).i64);
+  assert(TEST_SIZE - 1 == unrolled_list_get_back(list).i64);
+
+  uint64_t value = 0;
+  unrolled_list_iterator_t iter = unrolled_list_iterator_create(list);
+  while (unrolled_list_iterator_has_current(&iter)) {
+    assert(value == unrolled_list_iterator_get_current(&iter).i64);
+    unrolled_list_iterator_next(&iter);
+    value++;
+  }
+  assert(TEST_SIZE == value);
+  unrolled_list_delete(list);
+}
+
+
+static void test_unrolled_list_push_front() {
+  unrolled_list_t* list;
+  assert(!unrolled_list_create(&list));
+  for (uint64_t i = 0; i < TEST_SIZE; i++) {
+    assert(!unrolled_list_push_front(list, (generic_value_t)i));
+  }
+  assert(TEST_SIZE == unrolled_list_size(list));
+  assert(TEST_SIZE - 1 == unrolled_list_get_front(list).i64);
+  assert(0 == unrolled_list_get_back(list).i64);
+
+  int64_t value = TEST_SIZE - 1;
+  unrolled_list_iterator_t iter = unrolled_list_iterator_create(list);
+  while (unrolled_list_iterator_has_current(&iter)) {
+    assert(value == unrolled_list_iterator_get_current(&iter).i64);
+    unrolled_list_iterator_next(&iter);
+    value--;
+  }
+  assert(-1 == value);
+  unrolled_list_delete(list);
+}
+
+
+static void test_unrolled_list_pop_front() {
+  unrolled_list_t* list;
+  assert(!unrolled_list_create(&list));
+  // Mix pushes at both ends.
+  for (uint64_t i = 0; i < TEST_SIZE; i++) {
+    assert(!unrolled_list_push_back(list, (generic_value_t)(i + TEST_SIZE)));
+    assert(!unrolled_list_push_front(
+	     list, (generic_value_t)(TEST_SIZE - 1 - i)));
+  }
+
+  uint64_t value = 0;
+  while (!unrolled_list_empty(list)) {
+    assert(value == unrolled_list_pop_front(list).i64);
+    value++;
+  }
+  assert(2 * TEST_SIZE == value);
+  assert(!list->head);
+  assert(!list->tail);
+  unrolled_list_delete(list);
+}
+
+
+static void test_unrolled_list_with_value_deallocator() {
+  unrolled_list_t* list;
+  assert(!unrolled_list_create_with_value_deallocator(&list, free));
+  for (uint64_t i = 0; i < TEST_SIZE; i++) {
+    void* p = malloc(100);
+    assert(p);
+    assert(!unrolled_list_push_front(list, (generic_value_t)p));
+  }
+  assert(TEST_SIZE == unrolled_list_size(list));
+  unrolled_list_delete(list);
+}
+
+
+static void test_unrolled_list_iterator_remove_current() {
+  unrolled_list_t* list;
+  assert(!unrolled_list_create(&list));
+  for (uint64_t i = 0; i < TEST_SIZE; i++) {
+    assert(!unrolled_list_push_back(list, (generic_value_t)i));
+  }
+
+  for (unrolled_list_iterator_t iter = unrolled_list_iterator_create(list);
+       unrolled_list_iterator_has_current(&iter); ) {
+    // Remove odd numbers.
+    if (unrolled_list_iterator_get_current(&iter).i64 % 2) {
+      (void)unrolled_list_iterator_remove_current(&iter);
+    } else {
+      unrolled_list_iterator_next(&iter);
+    }
+  }
+  assert(0 == unrolled_list_get_front(list).i64);
+  assert(TEST_SIZE - 2 == unrolled_list_get_back(list).i64);
+  assert(TEST_SIZE / 2 == unrolled_list_size(list));
+  // Check for the even values.
+  uint64_t expected = 0;
+  for (unrolled_list_iterator_t iter = unrolled_list_iterator_create(list);
+       unrolled_list_iterator_has_current(&iter);
+       unrolled_list_iterator_next(&iter)) {
+    assert(expected == unrolled_list_iterator_get_current(&iter).i64);
+    expected += 2;
+  }
+  assert(TEST_SIZE == expected);
+  unrolled_list_delete(list);
+}
+
+
+static void test_unrolled_list_iterator_remove_current_all() {
+  unrolled_list_t* list;
+  assert(!unrolled_list_create(&list));
+  for (uint64_t i = 0; i < TEST_SIZE; i++) {
+    assert(!unrolled_list_push_back(list, (generic_value_t)i));
+  }
+
+  // Removing every value frees every node and updates the tail.
+  uint64_t expected = 0;
+  unrolled_list_iterator_t iter = unrolled_list_iterator_create(list);
+  while (unrolled_list_iterator_has_current(&iter)) {
+    assert(expected++ == unrolled_list_iterator_remove_current(&iter).i64);
+  }
+  assert(TEST_SIZE == expected);
+  assert(!unrolled_list_size(list));
+  assert(!list->head);
+  assert(!list->tail);
+  unrolled_list_delete(list);
+}
+
+
+static void test_unrolled_list_iterator_remove_current_last_node() {
+  unrolled_list_t* list;
+  assert(!unrolled_list_create(&list));
+  // Fill one node and put a single value in a second node.
+  for (uint64_t i = 0; i <= UNROLLED_LIST_NODE_CAPACITY; i++) {
+    assert(!unrolled_list_push_back(list, (generic_value_t)i));
+  }
+  assert(list->head != list->tail);
+
+  unrolled_list_iterator_t iter = unrolled_list_iterator_create(list);
+  for (uint64_t i = 0; i < UNROLLED_LIST_NODE_CAPACITY; i++) {
+    unrolled_list_iterator_next(&iter);
+  }
+  assert(UNROLLED_LIST_NODE_CAPACITY ==
+	 unrolled_list_iterator_remove_current(&iter).i64);
+  assert(!unrolled_list_iterator_has_current(&iter));
+  assert(list->head == list->tail);
+  assert(UNROLLED_LIST_NODE_CAPACITY - 1 == unrolled_list_get_back(list).i64);
+
+  // The tail must still accept new values.
+  assert(!unrolled_list_push_back(list, (generic_value_t)(uint64_t)100));
+  assert(100 == unrolled_list_get_back(list).i64);
+  assert(UNROLLED_LIST_NODE_CAPACITY + 1 == unrolled_list_size(list));
+  unrolled_list_delete(list);
+}
+
+
+int main(int argc, char** argv) {
+  test_unrolled_list_create();
+  test_unrolled_list_push_back();
+  test_unrolled_list_push_front();
+  test_unrolled_list_pop_front();
+  test_unrolled_list_with_value_deallocator();
+  test_unrolled_list_iterator_remove_current();
+  test_unrolled_list_iterator_remove_current_all();
+  test_unrolled_list_iterator_remove_current_last_node();
+  return 0;
+}
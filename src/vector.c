@@ -0,0 +1,125 @@
+#include "vector.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+static const size_t INITIAL_CAPACITY = 16;
+
+
+// Provide external definitions of inline functions.
+extern inline generic_value_t vector_get(const vector_t* vector, size_t index);
+extern inline void vector_set(
+  vector_t* vector, size_t index, generic_value_t value);
+extern inline generic_value_t vector_get_back(const vector_t* vector);
+extern inline generic_value_t vector_pop_back(vector_t* vector);
+extern inline generic_value_t vector_swap_remove(
+  vector_t* vector, size_t index);
+extern inline size_t vector_size(const vector_t* vector);
+extern inline bool vector_empty(const vector_t* vector);
+
+
+error_t vector_create(vector_t** vector) {
+  return vector_create_with_value_deallocator(vector, 0);
+}
+
+
+error_t vector_create_with_value_deallocator(
+  vector_t** vector, void (*value_deallocator)(void*)) {
+  vector_t* tmp = calloc(1, sizeof(vector_t));
+  if (!tmp) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  tmp->value_deallocator = value_deallocator;
+  *vector = tmp;
+  return 0;
+}
+
+
+void vector_delete(vector_t* vector) {
+  if (!vector) {
+    return;
+  }
+  if (vector->value_deallocator) {
+    for (size_t i = 0; i < vector->size; i++) {
+      vector->value_deallocator(vector->values[i].p);
+    }
+  }
+  free(vector->values);
+  free(vector);
+}
+
+
+static error_t vector_resize_capacity(vector_t* vector, size_t capacity) {
+  generic_value_t* values = realloc(
+    vector->values, capacity * sizeof(generic_value_t));
+  if (!values) {
+    return ERROR_OUT_OF_MEMORY;
+  }
+  vector->values = values;
+  vector->capacity = capacity;
+  return 0;
+}
+
+
+error_t vector_reserve(vector_t* vector, size_t capacity) {
+  if (capacity <= vector->capacity) {
+    return 0;
+  }
+  return vector_resize_capacity(vector, capacity);
+}
+
+
+error_t vector_shrink_to_fit(vector_t* vector) {
+  if (vector->size == vector->capacity) {
+    return 0;
+  }
+  if (!vector->size) {
+    free(vector->values);
+    vector->values = 0;
+    vector->capacity = 0;
+    return 0;
+  }
+  return vector_resize_capacity(vector, vector->size);
+}
+
+
+// Grows the vector geometrically so it can hold at least capacity values.
+static error_t vector_grow(vector_t* vector, size_t capacity) {
+  size_t new_capacity =
+    vector->capacity ? vector->capacity * 2 : INITIAL_CAPACITY;
+  if (new_capacity < capacity) {
+    new_capacity = capacity;
+  }
+  return vector_resize_capacity(vector, new_capacity);
+}
+
+
+error_t vector_push_back(vector_t* vector, generic_value_t value) {
+  if (vector->size == vector->capacity) {
+    error_t error = vector_grow(vector, vector->size + 1);
+    if (error) {
+      return error;
+    }
+  }
+  vector->values[vector->size++] = value;
+  return 0;
+}
+
+
+error_t vector_push_back_array(
+  vector_t* vector, const generic_value_t* values, size_t count) {
+  if (!count) {
+    return 0;
+  }
+  if (vector->size + count > vector->capacity) {
+    error_t error = vector_grow(vector, vector->size + count);
+    if (error) {
+      return error;
+    }
+  }
+  memcpy(vector->values + vector->size, values,
+	 count * sizeof(generic_value_t));
+  vector->size += count;
+  return 0;
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "errors.h"
+#include "generic.h"
+
+
+typedef struct {
+  void (*value_deallocator)(void*);
+  // Contiguous values; values[0] to values[size - 1] are in use.
+  generic_value_t* values;
+  size_t capacity;
+  size_t size;
+} vector_t;
+
+
+/**
+ * Creates a new vector.
+ *
+ * A vector stores its values contiguously in a single array that doubles
+ * when full, so pushing at the end is amortized O(1), access by index is
+ * O(1) and loops over the values run over sequential memory.
+ *
+ * Args:
+ *  vector: Set to the newly allocated vector.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create vector because of memory error.
+ */
+error_t vector_create(vector_t** vector);
+
+
+/**
+ * Creates a new vector with a value deallocator.
+ *
+ * The deallocation function is used to delete void* values
+ * (generic_value_t.p) when vector_delete is called.
+ *
+ * Args:
+ *  vector: Set to the newly allocated vector.
+ *  deallocated: Function used to delete values.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not create vector because of memory error.
+ */
+error_t vector_create_with_value_deallocator(
+  vector_t** vector, void (*value_deallocator)(void*));
+
+
+/**
+ * Deletes a vector.
+ *
+ * If a deallocation function was provided during creation, vector values
+ * will be treated as void* (generic_value_t.p) and sent to the function.
+ *
+ * Args:
+ *  vector: Vector to be deleted.
+ */
+void vector_delete(vector_t* vector);
+
+
+/**
+ * Ensures the vector can hold a number of values without reallocating.
+ *
+ * Args:
+ *  vector: Vector to update.
+ *  capacity: Number of values the vector should be able to hold.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not grow vector because of memory error.
+ */
+error_t vector_reserve(vector_t* vector, size_t capacity);
+
+
+/**
+ * Releases the capacity the vector is not using.
+ *
+ * Args:
+ *  vector: Vector to update.
+ *
+ * Returns:
+ *  0 on success.
+ *  ERROR_OUT_OF_MEMORY: Could not reallocate vector because of memory
+ *   error. The vector is left unchanged.
+ */
+error_t vector_shrink_to_fit(vector_t* vector);
+
+
+/**
+ * Adds a value to the end of the vector.
+ *
+ * Args:
+ *  vector: Vector to add value to.
+ *  value: Value to add to vector.
+ *
+ * Returns:
+ *  0 on success
+ *  ERROR_OUT_OF_MEMORY: Could not add value because of memory error.
+ */
+error_t vector_push_back(vector_t* vector, generic_value_t value);
+
+
+/**
+ * Adds an array of values to the end of the vector.
+ *
+ * The vector grows at most once. Either all values are added or none are.
+ *
+ * Args:
+ *  vector: Vector to add values to.
+ *  values: Values to add to vector.
+ *  count: Number of values.
+ *
+ * Returns:
+ *  0 on success
+ *  ERROR_OUT_OF_MEMORY: Could not add values because of memory error.
+ */
+error_t vector_push_back_array(
+  vector_t* vector, const generic_value_t* values, size_t count);
+
+
+/**
+ * Gets a value by its position in the vector.
+ *
+ * Calling this with an index outside of the vector is undefined.
+ *
+ * Args:
+ *  vector: The vector to examine.
+ *  index: Position of the value.
+ *
+ * Returns:
+ *  The value at the given position.
+ */
+inline generic_value_t vector_get(const vector_t* vector, size_t index) {
+  return vector->values[index];
+}
+
+
+/**
+ * Replaces a value by its position in the vector.
+ *
+ * Calling this with an index outside of the vector is undefined.
+ *
+ * Args:
+ *  vector: The vector to update.
+ *  index: Position of the value.
+ *  value: New value.
+ */
+inline void vector_set(vector_t* vector, size_t index, generic_value_t value) {
+  vector->values[index] = value;
+}
+
+
+/**
+ * Gets the last value in the vector.
+ *
+ * Calling this on an empty vector is undefined.
+ *
+ * Args:
+ *  vector: The vector to examine.
+ *
+ * Returns:
+ *  The last value in the vector.
+ */
+inline generic_value_t vector_get_back(const vector_t* vector) {
+  return vector->values[vector->size - 1];
+}
+
+
+/**
+ * Removes the last value from the vector.
+ *
+ * Calling this on an empty vector is undefined.
+ *
+ * Args:
+ *  vector: The vector to pop value from.
+ *
+ * Returns:
+ *  The last value in the vector.
+ */
+inline generic_value_t vector_pop_back(vector_t* vector) {
+  return vector->values[--vector->size];
+}
+
+
+/**
+ * Removes a value by its position, moving the last value into its place.
+ *
+ * This takes O(1) time but does not preserve the order of the values.
+ * Calling this with an index outside of the vector is undefined.
+ *
+ * Args:
+ *  vector: The vector to update.
+ *  index: Position of the value to remove.
+ *
+ * Returns:
+ *  The removed value.
+ */
+inline generic_value_t vector_swap_remove(vector_t* vector, size_t index) {
+  generic_value_t value = vector->values[index];
+  vector->values[index] = vector->values[--vector->size];
+  return value;
+}
+
+
+/**
+ * Returns the size of the vector.
+ *
+ * Args:
+ *  vector: Vector to examine.
+ *
+ * Returns:
+ *  Size of the vector.
+ */
+inline size_t vector_size(const vector_t* vector) { return vector->size; }
+
+
+/**
+ * Returns true if vector is empty.
+ *
+ * Args:
+ *  vector: Vector to examine.
+ *
+ * Returns:
+ *  true if vector is empty.
+ */
+inline bool vector_empty(const vector_t* vector) { return !vector->size; }
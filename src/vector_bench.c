@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "list.h"
+#include "vector.h"
+
+
+#define BENCH_SIZE 1000000
+#define BENCH_SCANS 20
+
+
+static void bench_list() {
+  list_t* list;
+  if (list_create(&list)) {
+    abort();
+  }
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_SIZE; i++) {
+    if (list_push_back(list, (generic_value_t)i)) {
+      abort();
+    }
+  }
+  bench_report("list_push_back", BENCH_SIZE, bench_now_ns() - start);
+
+  uint64_t sum = 0;
+  start = bench_now_ns();
+  for (int scan = 0; scan < BENCH_SCANS; scan++) {
+    list_iterator_t iter = list_iterator_create(list);
+    for (; list_iterator_has_current(&iter); list_iterator_next(&iter)) {
+      sum += list_iterator_get_current(&iter).ui64;
+    }
+  }
+  bench_report("list_scan", (size_t)BENCH_SIZE * BENCH_SCANS,
+	       bench_now_ns() - start);
+  bench_use(sum);
+  list_delete(list);
+}
+
+
+static void bench_vector() {
+  vector_t* vector;
+  if (vector_create(&vector)) {
+    abort();
+  }
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < BENCH_SIZE; i++) {
+    if (vector_push_back(vector, (generic_value_t)i)) {
+      abort();
+    }
+  }
+  bench_report("vector_push_back", BENCH_SIZE, bench_now_ns() - start);
+
+  uint64_t sum = 0;
+  start = bench_now_ns();
+  for (int scan = 0; scan < BENCH_SCANS; scan++) {
+    for (size_t i = 0; i < vector_size(vector); i++) {
+      sum += vector_get(vector, i).ui64;
+    }
+  }
+  bench_report("vector_scan", (size_t)BENCH_SIZE * BENCH_SCANS,
+	       bench_now_ns() - start);
+  bench_use(sum);
+
+  vector_t* copy;
+  if (vector_create(&copy)) {
+    abort();
+  }
+  start = bench_now_ns();
+  if (vector_push_back_array(copy, vector->values, vector_size(vector))) {
+    abort();
+  }
+  bench_report("vector_push_back_array", BENCH_SIZE, bench_now_ns() - start);
+  vector_delete(copy);
+
+  // Remove every value from random positions.
+  uint64_t seed = 1;
+  start = bench_now_ns();
+  while (!vector_empty(vector)) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    size_t index = (seed >> 33) % vector_size(vector);
+    bench_use(vector_swap_remove(vector, index).ui64);
+  }
+  bench_report("vector_swap_remove", BENCH_SIZE, bench_now_ns() - start);
+  vector_delete(vector);
+}
+
+
+int main(int argc, char** argv) {
+  bench_list();
+  bench_vector();
+  return 0;
+}
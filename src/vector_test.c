@@ -0,0 +1,170 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "vector.h"
+
+
+static void test_vector_create() {
+  vector_t* vector;
+  assert(!vector_create(&vector));
+  assert(!vector->value_deallocator);
+  assert(!vector_size(vector));
+  assert(vector_empty(vector));
+  assert(!vector_shrink_to_fit(vector));
+  vector_delete(vector);
+}
+
+
+static void test_vector_push_back() {
+  vector_t* vector;
+  assert(!vector_create(&vector));
+  for (uint64_t i = 0; i < 1000; i++) {
+    assert(!vector_push_back(vector, (generic_value_t)i));
+    assert(i == vector_get_back(vector).i64);
+  }
+  assert(1000 == vector_size(vector));
+  assert(1000 <= vector->capacity);
+  for (uint64_t i = 0; i < 1000; i++) {
+    assert(i == vector_get(vector, i).i64);
+  }
+  vector_delete(vector);
+}
+
+
+static void test_vector_pop_back() {
+  vector_t* vector;
+  assert(!vector_create(&vector));
+  for (uint64_t i = 0; i < 100; i++) {
+    assert(!vector_push_back(vector, (generic_value_t)i));
+  }
+  for (uint64_t i = 100; i > 0; i--) {
+    assert(i - 1 == vector_pop_back(vector).i64);
+    assert(i - 1 == vector_size(vector));
+  }
+  assert(vector_empty(vector));
+  vector_delete(vector);
+}
+
+
+static void test_vector_set() {
+  vector_t* vector;
+  assert(!vector_create(&vector));
+  for (uint64_t i = 0; i < 10; i++) {
+    assert(!vector_push_back(vector, (generic_value_t)i));
+  }
+  vector_set(vector, 3, (generic_value_t)(uint64_t)100);
+  assert(100 == vector_get(vector, 3).i64);
+  assert(9 == vector_get_back(vector).i64);
+  vector_delete(vector);
+}
+
+
+static void test_vector_swap_remove() {
+  vector_t* vector;
+  assert(!vector_create(&vector));
+  for (uint64_t i = 0; i < 5; i++) {
+    assert(!vector_push_back(vector, (generic_value_t)i));
+  }
+  assert(1 == vector_swap_remove(vector, 1).i64);
+  assert(4 == vector_size(vector));
+  assert(4 == vector_get(vector, 1).i64);
+  assert(3 == vector_get_back(vector).i64);
+  // Removing the last value just shrinks the vector.
+  assert(3 == vector_swap_remove(vector, 3).i64);
+  assert(3 == vector_size(vector));
+  assert(0 == vector_get(vector, 0).i64);
+  assert(4 == vector_get(vector, 1).i64);
+  assert(2 == vector_get(vector, 2).i64);
+  vector_delete(vector);
+}
+
+
+static void test_vector_push_back_array() {
+  vector_t* vector;
+  assert(!vector_create(&vector));
+  generic_value_t values[100];
+  for (uint64_t i = 0; i < 100; i++) {
+    values[i].ui64 = i;
+  }
+  assert(!vector_push_back_array(vector, values, 0));
+  assert(vector_empty(vector));
+  assert(!vector_push_back_array(vector, values, 10));
+  assert(!vector_push_back_array(vector, values, 100));
+  assert(110 == vector_size(vector));
+  for (uint64_t i = 0; i < 110; i++) {
+    assert((i < 10 ? i : i - 10) == vector_get(vector, i).ui64);
+  }
+  vector_delete(vector);
+}
+
+
+static void test_vector_reserve() {
+  vector_t* vector;
+  assert(!vector_create(&vector));
+  assert(!vector_reserve(vector, 100));
+  assert(100 == vector->capacity);
+  generic_value_t* values = vector->values;
+  for (uint64_t i = 0; i < 100; i++) {
+    assert(!vector_push_back(vector, (generic_value_t)i));
+  }
+  // No reallocation was needed.
+  assert(values == vector->values);
+  // Reserving less than the capacity does nothing.
+  assert(!vector_reserve(vector, 10));
+  assert(100 == vector->capacity);
+  vector_delete(vector);
+}
+
+
+static void test_vector_shrink_to_fit() {
+  vector_t* vector;
+  assert(!vector_create(&vector));
+  for (uint64_t i = 0; i < 100; i++) {
+    assert(!vector_push_back(vector, (generic_value_t)i));
+  }
+  while (vector_size(vector) > 10) {
+    vector_pop_back(vector);
+  }
+  assert(!vector_shrink_to_fit(vector));
+  assert(10 == vector->capacity);
+  for (uint64_t i = 0; i < 10; i++) {
+    assert(i == vector_get(vector, i).i64);
+  }
+  while (!vector_empty(vector)) {
+    vector_pop_back(vector);
+  }
+  assert(!vector_shrink_to_fit(vector));
+  assert(!vector->capacity);
+  assert(!vector->values);
+  assert(!vector_push_back(vector, (generic_value_t)1.5));
+  assert(1.5 == vector_get(vector, 0).d);
+  vector_delete(vector);
+}
+
+
+static void test_vector_with_value_deallocator() {
+  vector_t* vector;
+  assert(!vector_create_with_value_deallocator(&vector, free));
+  for (uint64_t i = 0; i < 10; i++) {
+    void* p = malloc(100);
+    assert(p);
+    assert(!vector_push_back(vector, (generic_value_t)p));
+  }
+  free(vector_swap_remove(vector, 2).p);
+  assert(9 == vector_size(vector));
+  vector_delete(vector);
+}
+
+
+int main(int argc, char** argv) {
+  test_vector_create();
+  test_vector_push_back();
+  test_vector_pop_back();
+  test_vector_set();
+  test_vector_swap_remove();
+  test_vector_push_back_array();
+  test_vector_reserve();
+  test_vector_shrink_to_fit();
+  test_vector_with_value_deallocator();
+  return 0;
+}